@@ -0,0 +1,86 @@
+/*
+ * Toggles the LED pin, and writes bytes to a group of 8 pins, through
+ * digitalWrite(), gpio_write_bit(), FastPin and PinGroup, and times
+ * shiftOut() against a copy of the old one (digitalWrite() and a
+ * read-modify-write toggle per bit).
+ *
+ * The group is the first 8 pins on the LED's port that the board
+ * doesn't use itself; they are all driven, so leave them unconnected.
+ */
+
+#include <Benchmarks.h>
+
+#define COUNT 100000UL
+
+static uint8 groupPins[8];
+static uint8 nrGroupPins;
+
+static FastPin led;
+static PinGroup group;
+
+/* shiftOut() as it was. */
+static void legacyShiftOut(uint8 dataPin, uint8 clockPin, uint8 bitOrder, uint8 value)
+{
+    digitalWrite(clockPin, LOW);
+    for (int i = 0; i < 8; i++) {
+        int bit = bitOrder == LSBFIRST ? i : (7 - i);
+        digitalWrite(dataPin, (value >> bit) & 0x1);
+        gpio_toggle_bit(PIN_MAP[clockPin].gpio_device, PIN_MAP[clockPin].gpio_bit);
+        gpio_toggle_bit(PIN_MAP[clockPin].gpio_device, PIN_MAP[clockPin].gpio_bit);
+    }
+}
+
+/* The group pins one at a time, as LiquidCrystal used to. */
+static void digitalWriteGroup(uint8 value)
+{
+    for (uint8 i = 0; i < nrGroupPins; i++) {
+        digitalWrite(groupPins[i], (value >> i) & 0x1);
+    }
+}
+
+void setup()
+{
+    gpio_dev *port = PIN_MAP[BOARD_LED_PIN].gpio_device;
+
+    for (uint8 pin = 0; pin < BOARD_NR_GPIO_PINS && nrGroupPins < 8; pin++) {
+        if (PIN_MAP[pin].gpio_device == port && pin != BOARD_LED_PIN &&
+            !boardUsesPin(pin)) {
+            groupPins[nrGroupPins++] = pin;
+            pinMode(pin, OUTPUT);
+        }
+    }
+    pinMode(BOARD_LED_PIN, OUTPUT);
+    led.attach(BOARD_LED_PIN);
+    group.attach(groupPins, nrGroupPins);
+
+    Serial.begin(115200);
+    benchBegin();
+}
+
+void loop()
+{
+    gpio_dev *port = PIN_MAP[BOARD_LED_PIN].gpio_device;
+    uint8 bit = PIN_MAP[BOARD_LED_PIN].gpio_bit;
+    uint8 clockPin = groupPins[0];
+    uint8 dataPin = groupPins[1];
+
+    delay(3000);
+    Serial.println("Toggling the LED pin 100000 times:");
+    BENCH_RUN("digitalWrite      ", COUNT, digitalWrite(BOARD_LED_PIN, i & 1));
+    BENCH_RUN("gpio_write_bit    ", COUNT, gpio_write_bit(port, bit, i & 1));
+    BENCH_RUN("gpio_toggle_bit   ", COUNT, gpio_toggle_bit(port, bit));
+    BENCH_RUN("FastPin::write    ", COUNT, led.write(i & 1));
+    BENCH_RUN("FastPin::toggle   ", COUNT, led.toggle());
+
+    Serial.print("Writing 100000 bytes to ");
+    Serial.print(nrGroupPins);
+    Serial.println(group.onePort() ? " pins on one port:" : " pins:");
+    BENCH_RUN("digitalWrite x8   ", COUNT, digitalWriteGroup(i));
+    BENCH_RUN("PinGroup::write   ", COUNT, group.write(i));
+
+    if (nrGroupPins >= 2) {
+        Serial.println("Shifting out 100000 bytes:");
+        BENCH_RUN("legacy shiftOut   ", COUNT, legacyShiftOut(dataPin, clockPin, MSBFIRST, i));
+        BENCH_RUN("shiftOut          ", COUNT, shiftOut(dataPin, clockPin, MSBFIRST, i));
+    }
+}
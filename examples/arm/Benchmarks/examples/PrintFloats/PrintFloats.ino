@@ -0,0 +1,138 @@
+/*
+ * Formats doubles with two and six decimals through Print and
+ * dtostrf(), and through copies of the old Print::printFloat() (one
+ * print() per digit, "<large double>" past 9.1e18) and the old
+ * dtostrf() (two sprintf() calls), into a sink that only counts bytes.
+ * Also counts how many of the old results differ from the correctly
+ * rounded ones.
+ *
+ * For the flash cost of the old dtostrf(), which pulls in newlib's
+ * float printf, build once as is and once with LEGACY_DTOSTRF set to
+ * 0, and compare the sizes the build reports.
+ */
+
+#include <Benchmarks.h>
+#include <stdio.h>
+
+#define COUNT 10000UL
+#define LEGACY_DTOSTRF 1
+
+class NullPrint : public Print
+{
+public:
+    NullPrint() : bytes(0) {}
+    size_t write(uint8 ch) { bytes++; return 1; }
+    size_t write(const void *buf, uint32 len) { bytes += len; return len; }
+    using Print::write;
+    uint32 bytes;
+};
+
+static NullPrint sink;
+
+/* Print::printFloat() as it was. */
+static size_t legacyPrintFloat(Print &p, double number, uint8 digits)
+{
+    size_t s = 0;
+    if (abs(number) >= 9.1e18) {
+        if (number < 0.0) {
+            s = p.print('-');
+        }
+        s += p.print("<large double>");
+        return s;
+    }
+    if (number < 0.0) {
+        s += p.print('-');
+        number = -number;
+    }
+    double rounding = 0.5;
+    for (uint8 i = 0; i < digits; i++) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+    long long int_part = (long long)number;
+    double remainder = number - int_part;
+    s += p.print(int_part);
+    if (digits > 0) {
+        s += p.print(".");
+    }
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        int to_print = (int)remainder;
+        s += p.print(to_print);
+        remainder -= to_print;
+    }
+    return s;
+}
+
+#if LEGACY_DTOSTRF
+/* dtostrf() as it was. */
+static char *legacyDtostrf(double val, signed char width, unsigned char prec, char *sout)
+{
+    char fmt[20];
+    sprintf(fmt, "%%%d.%df", width, prec);
+    sprintf(sout, fmt, val);
+    return sout;
+}
+#endif
+
+/* Collects what a Print writes, to compare the two printFloat()s. */
+class BufferPrint : public Print
+{
+public:
+    BufferPrint() : len(0) { buf[0] = 0; }
+    size_t write(uint8 ch) {
+        if (len + 1 < sizeof(buf)) {
+            buf[len++] = ch;
+            buf[len] = 0;
+        }
+        return 1;
+    }
+    using Print::write;
+    void clear() { len = 0; buf[0] = 0; }
+    char buf[48];
+    unsigned len;
+};
+
+/* Magnitudes from 1e-3 to 1e6, both signs. */
+static inline double sample(uint32 i)
+{
+    uint32 r = i * 2654435761UL;
+    double v = (double)(r >> 8) / (1 << (r & 15));
+    return (r & 0x10) ? -v : v;
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    benchBegin();
+}
+
+void loop()
+{
+    static char buf[48];
+    static BufferPrint a, b;
+    uint32 differ = 0;
+
+    delay(3000);
+    Serial.println("Formatting 10000 doubles:");
+    BENCH_RUN("legacy printFloat, 2 places", COUNT, legacyPrintFloat(sink, sample(i), 2));
+    BENCH_RUN("Print,             2 places", COUNT, sink.print(sample(i), 2));
+    BENCH_RUN("legacy printFloat, 6 places", COUNT, legacyPrintFloat(sink, sample(i), 6));
+    BENCH_RUN("Print,             6 places", COUNT, sink.print(sample(i), 6));
+#if LEGACY_DTOSTRF
+    BENCH_RUN("legacy dtostrf,    2 places", COUNT, legacyDtostrf(sample(i), 4, 2, buf));
+#endif
+    BENCH_RUN("dtostrf,           2 places", COUNT, dtostrf(sample(i), 4, 2, buf));
+
+    for (uint32 i = 0; i < COUNT; i++) {
+        a.clear();
+        b.clear();
+        legacyPrintFloat(a, sample(i), 6);
+        b.print(sample(i), 6);
+        if (strcmp(a.buf, b.buf) != 0) {
+            differ++;
+        }
+    }
+    Serial.print(differ);
+    Serial.println(" of the old printFloat() results differ, 6 places");
+}
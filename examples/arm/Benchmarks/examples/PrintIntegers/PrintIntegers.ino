@@ -0,0 +1,70 @@
+/*
+ * Prints a million integers, in decimal and in hex, through Print
+ * and through a copy of the old Print::printNumber() (64-bit
+ * division, one write() per digit), into a sink that only counts
+ * bytes. This times the formatting alone; the transport is left out.
+ */
+
+#include <Benchmarks.h>
+
+#define COUNT 1000000UL
+
+class NullPrint : public Print
+{
+public:
+    NullPrint() : bytes(0) {}
+    size_t write(uint8 ch) { bytes++; return 1; }
+    size_t write(const void *buf, uint32 len) { bytes += len; return len; }
+    using Print::write;
+    uint32 bytes;
+};
+
+static NullPrint sink;
+
+/* Print::printNumber() as it was. */
+static size_t legacyPrintNumber(Print &p, unsigned long long n, uint8 base)
+{
+    unsigned char buf[64];
+    unsigned long i = 0;
+    size_t s = 0;
+    if (n == 0) {
+        p.print('0');
+        return 1;
+    }
+    while (n > 0) {
+        buf[i++] = n % base;
+        n /= base;
+    }
+    for (; i > 0; i--) {
+        s += p.print((char)(buf[i - 1] < 10 ?
+                            '0' + buf[i - 1] :
+                            'A' + buf[i - 1] - 10));
+    }
+    return s;
+}
+
+/* A spread of magnitudes, from one digit to ten. */
+static inline uint32 sample(uint32 i)
+{
+    return (i * 2654435761UL) >> (i & 31);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    benchBegin();
+}
+
+void loop()
+{
+    delay(3000);
+    Serial.println("Printing 1000000 integers:");
+    BENCH_RUN("legacy, DEC", COUNT, legacyPrintNumber(sink, sample(i), DEC));
+    BENCH_RUN("Print,  DEC", COUNT, sink.print(sample(i)));
+    BENCH_RUN("legacy, HEX", COUNT, legacyPrintNumber(sink, sample(i), HEX));
+    BENCH_RUN("Print,  HEX", COUNT, sink.print(sample(i), HEX));
+    BENCH_RUN("Print,  DEC, signed", COUNT, sink.print((long)sample(i)));
+    BENCH_RUN("Print,  DEC, 64-bit", COUNT, sink.print((unsigned long long)sample(i) * 1000003));
+    Serial.print(sink.bytes);
+    Serial.println(" bytes formatted");
+}
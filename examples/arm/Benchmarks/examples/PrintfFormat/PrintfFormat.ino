@@ -0,0 +1,76 @@
+/*
+ * Formats a telemetry line with snprintf() into a buffer and then
+ * print() (what sketches had to do before), with Print::printf(), and
+ * with PRINTF(), which parses the format at compile time, into a sink
+ * that counts bytes and write() calls.
+ *
+ * snprintf() brings in newlib's printf; build once as is and once
+ * with LEGACY_SNPRINTF set to 0, and compare the sizes the build
+ * reports.
+ */
+
+#include <Benchmarks.h>
+#include <stdio.h>
+
+#define COUNT 10000UL
+#define LEGACY_SNPRINTF 1
+
+class NullPrint : public Print
+{
+public:
+    NullPrint() : bytes(0) {}
+    size_t write(uint8 ch) { bytes++; benchCount++; return 1; }
+    size_t write(const void *buf, uint32 len) { bytes += len; benchCount++; return len; }
+    using Print::write;
+    uint32 bytes;
+};
+
+static NullPrint sink;
+
+static const char name[] = "vbat";
+
+#if LEGACY_SNPRINTF
+static void legacyLine(uint32 i)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "t=%lu %s=%4d.%02d id=%08lx\n",
+             (unsigned long)i, name, (int)(i % 5000), (int)(i % 100), (unsigned long)i * 2654435761UL);
+    sink.print(buf);
+}
+#endif
+
+static void printfLine(uint32 i)
+{
+    sink.printf("t=%lu %s=%4d.%02d id=%08lx\n",
+                (unsigned long)i, name, (int)(i % 5000), (int)(i % 100), (unsigned long)i * 2654435761UL);
+}
+
+static void checkedLine(uint32 i)
+{
+    PRINTF(sink, "t=%lu %s=%4d.%02d id=%08lx\n",
+           i, name, (int)(i % 5000), (int)(i % 100), i * 2654435761UL);
+}
+
+static void floatLine(uint32 i)
+{
+    PRINTF(sink, "t=%lu %s=%7.3f\n", i, name, i * 0.001);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    benchBegin();
+    benchCountLabel = "writes";
+}
+
+void loop()
+{
+    delay(3000);
+    Serial.println("Formatting 10000 lines:");
+#if LEGACY_SNPRINTF
+    BENCH_RUN("snprintf + print", COUNT, legacyLine(i));
+#endif
+    BENCH_RUN("Print::printf   ", COUNT, printfLine(i));
+    BENCH_RUN("PRINTF          ", COUNT, checkedLine(i));
+    BENCH_RUN("PRINTF, %7.3f   ", COUNT, floatLine(i));
+}
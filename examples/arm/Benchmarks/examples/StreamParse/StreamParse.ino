@@ -0,0 +1,115 @@
+/*
+ * Parses G-code lines ("G1 X12.345 Y-6.7") held in a Stream that
+ * reads from memory: with parseInt()/parseFloat(), and with a
+ * StreamReader, once through read() a byte at a time and once in
+ * place through readSpan(), the way it reads a serial port's buffer.
+ * Also times find() on the same text.
+ */
+
+#include <Benchmarks.h>
+
+#define COUNT 400UL
+
+/* Reads text from memory, optionally in place like the serial ports. */
+class MemoryStream : public Stream
+{
+public:
+    MemoryStream() : text(""), len(0), pos(0), spans(false) {}
+    void begin(const char *s, size_t n, bool inPlace)
+    {
+        text = s;
+        len = n;
+        pos = 0;
+        spans = inPlace;
+    }
+    int available() { return len - pos; }
+    int read() { return pos < len ? (uint8)text[pos++] : -1; }
+    int peek() { return pos < len ? (uint8)text[pos] : -1; }
+    void flush() {}
+    size_t write(uint8 ch) { return 0; }
+    using Print::write;
+    size_t readSpan(const uint8 **span)
+    {
+        *span = (const uint8 *)text + pos;
+        return spans ? len - pos : 0;
+    }
+    bool readCommit(size_t n) { pos += n; return true; }
+
+private:
+    const char *text;
+    size_t len;
+    size_t pos;
+    bool spans;
+};
+
+static MemoryStream in;
+static char text[COUNT * 24];
+static size_t textLen;
+static volatile long sink;
+
+static void makeText()
+{
+    StringBuilder out(text, sizeof(text));
+    for (uint32 i = 0; i < COUNT; i++) {
+        uint32 r = i * 2654435761UL;
+        PRINTF(out, "G1 X%ld.%03lu Y%lu.%lu\n",
+               (long)(r % 200) - 100, (r >> 8) % 1000, (r >> 16) % 500, (r >> 4) % 10);
+    }
+    textLen = out.length();
+}
+
+static void parseStream()
+{
+    in.begin(text, textLen, false);
+    in.setTimeout(0);
+    for (uint32 i = 0; i < COUNT; i++) {
+        sink += in.parseInt();                      // G
+        sink += (long)(in.parseFloat() * 1000);     // X
+        sink += (long)(in.parseFloat() * 1000);     // Y
+    }
+}
+
+static void parseReader(bool inPlace)
+{
+    char buf[32];
+    StreamReader reader(in, buf, sizeof(buf));
+    Span line, word;
+    long v;
+
+    in.begin(text, textLen, inPlace);
+    while (reader.readLine(line)) {
+        while (reader.nextToken(word)) {
+            if (word.sub(1).toFixed(v, 3)) {
+                sink += v;
+            }
+        }
+    }
+}
+
+static void findAll()
+{
+    in.begin(text, textLen, true);
+    in.setTimeout(0);
+    while (in.find((char *)"Y4")) {
+        sink++;
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    benchBegin();
+    makeText();
+}
+
+void loop()
+{
+    delay(3000);
+    Serial.print("Parsing ");
+    Serial.print(COUNT);
+    Serial.println(" lines:");
+    BENCH_TIME("parseInt/parseFloat   ", COUNT, parseStream());
+    BENCH_TIME("StreamReader, read()  ", COUNT, parseReader(false));
+    BENCH_TIME("StreamReader, in place", COUNT, parseReader(true));
+    BENCH_TIME("find()                ", COUNT, findAll());
+}
@@ -0,0 +1,70 @@
+/*
+ * Builds a JSON line a character at a time with String, growing the
+ * buffer geometrically (plain +=) and to the exact length each time
+ * (reserveExact() before every +=, which is what concat() used to
+ * do), and makes short Strings from numbers. Counts the reallocations
+ * and the Strings that needed the heap.
+ */
+
+#include <Benchmarks.h>
+
+#define COUNT 2000UL
+
+static const char line[] =
+    "{\"time\":123456,\"temperature\":21.5,\"humidity\":48,"
+    "\"samples\":[512,498,530,541,507,499,515,520],\"status\":\"ok\"}";
+
+/* Exposes the capacity, to see when the buffer is reallocated. */
+class CountingString : public String
+{
+public:
+    unsigned int cap() const { return capacity; }
+    bool onHeap() const
+    {
+        const char *p = c_str();
+        return p < (const char *)this || p >= (const char *)(this + 1);
+    }
+};
+
+static void buildLine(bool exact)
+{
+    CountingString s;
+    for (const char *p = line; *p; p++) {
+        unsigned int cap = s.cap();
+        if (exact) {
+            s.reserveExact(s.length() + 1);
+        }
+        s += *p;
+        if (s.cap() != cap) {
+            benchCount++;
+        }
+    }
+}
+
+static void shortString(uint32 i)
+{
+    CountingString s;
+    s += (long)(i * 7919);
+    if (s.onHeap()) {
+        benchCount++;
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    benchBegin();
+    benchCountLabel = "allocations";
+}
+
+void loop()
+{
+    delay(3000);
+    Serial.print("Appending ");
+    Serial.print(sizeof(line) - 1);
+    Serial.println(" characters:");
+    BENCH_RUN("exact growth    ", COUNT, buildLine(true));
+    BENCH_RUN("geometric growth", COUNT, buildLine(false));
+    Serial.println("Short Strings from numbers:");
+    BENCH_RUN("String += long  ", COUNT, shortString(i));
+}
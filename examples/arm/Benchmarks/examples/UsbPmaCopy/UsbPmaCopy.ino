@@ -0,0 +1,135 @@
+/*
+ * Times the USB packet memory (PMA) copy routines against the
+ * halfword-at-a-time versions they replaced, for one 64-byte packet,
+ * with aligned and unaligned user buffers. The "RX callback" lines
+ * compare the old vcomDataRxCb() path (copy to the stack, then byte
+ * by byte into the ring buffer) with copying straight into the ring
+ * buffer.
+ *
+ * Results are printed on Serial every few seconds, in CPU cycles.
+ */
+
+#include <Benchmarks.h>
+
+extern "C" {
+#include <libmaple/rcc.h>
+#include <usb_reg_map.h>
+}
+
+#define PACKET      64
+#define RUNS        1000
+/* Free PMA space past the CDC ACM endpoint buffers. */
+#define SCRATCH_PMA 0x1A0
+#define RING_SIZE   512
+
+static uint8 src[PACKET + 4] __attribute__((aligned(4)));
+static uint8 dst[PACKET + 4] __attribute__((aligned(4)));
+static uint8 ring[RING_SIZE];
+
+static void legacyCopyToPma(const uint8 *buf, uint16 len, uint16 pma_offset)
+{
+    uint16 *dst = (uint16*)usb_pma_ptr(pma_offset);
+    uint16 n = len >> 1;
+    uint16 i;
+    for (i = 0; i < n; i++) {
+        *dst = (uint16)(*buf) | *(buf + 1) << 8;
+        buf += 2;
+        dst += 2;
+    }
+    if (len & 1) {
+        *dst = *buf;
+    }
+}
+
+static void legacyCopyFromPma(uint8 *buf, uint16 len, uint16 pma_offset)
+{
+    uint32 *src = (uint32*)usb_pma_ptr(pma_offset);
+    uint16 *dst = (uint16*)buf;
+    uint16 n = len >> 1;
+    uint16 i;
+    for (i = 0; i < n; i++) {
+        *dst++ = *src++;
+    }
+    if (len & 1) {
+        *dst = *src & 0xFF;
+    }
+}
+
+static void legacyRx(uint32 tail)
+{
+    uint8 data[PACKET];
+    uint32 i;
+
+    legacyCopyFromPma(data, PACKET, SCRATCH_PMA);
+    for (i = 0; i < PACKET; i++) {
+        ring[tail] = data[i];
+        tail = (tail + 1) % RING_SIZE;
+    }
+}
+
+static void directRx(uint32 tail)
+{
+    uint32 span = RING_SIZE - tail;
+
+    if (span > PACKET) {
+        span = PACKET;
+    }
+    usb_copy_from_pma(&ring[tail], span, SCRATCH_PMA);
+    if (span < PACKET) {
+        usb_copy_from_pma(ring, PACKET - span, SCRATCH_PMA + span);
+    }
+}
+
+/* Average cycles per call of the statement, interrupts off. */
+#define TIME(stmt) ({                                   \
+        uint32 total = 0;                               \
+        for (int run = 0; run < RUNS; run++) {          \
+            noInterrupts();                             \
+            uint32 start = benchCycles();               \
+            stmt;                                       \
+            total += benchCycles() - start;             \
+            interrupts();                               \
+        }                                               \
+        total / RUNS;                                   \
+    })
+
+static void report(const char *what, uint32 before, uint32 after)
+{
+    Serial.print(what);
+    Serial.print(": ");
+    Serial.print(before);
+    Serial.print(" -> ");
+    Serial.print(after);
+    Serial.println(" cycles");
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    rcc_clk_enable(RCC_USB);    // The PMA needs the USB clock.
+    benchBegin();
+    for (int i = 0; i < PACKET + 4; i++) {
+        src[i] = i;
+    }
+}
+
+void loop()
+{
+    delay(3000);
+    Serial.println("PMA copy, 64 bytes:");
+    report("to PMA, aligned",
+           TIME(legacyCopyToPma(src, PACKET, SCRATCH_PMA)),
+           TIME(usb_copy_to_pma(src, PACKET, SCRATCH_PMA)));
+    report("to PMA, unaligned",
+           TIME(legacyCopyToPma(src + 1, PACKET, SCRATCH_PMA)),
+           TIME(usb_copy_to_pma(src + 1, PACKET, SCRATCH_PMA)));
+    report("from PMA, aligned",
+           TIME(legacyCopyFromPma(dst, PACKET, SCRATCH_PMA)),
+           TIME(usb_copy_from_pma(dst, PACKET, SCRATCH_PMA)));
+    report("RX callback, no wrap",
+           TIME(legacyRx(0)),
+           TIME(directRx(0)));
+    report("RX callback, wrapping",
+           TIME(legacyRx(RING_SIZE - 21)),
+           TIME(directRx(RING_SIZE - 21)));
+}
@@ -0,0 +1,22 @@
+#include "Benchmarks.h"
+
+uint32 benchCount;
+const char *benchCountLabel;
+
+void benchReport(const char *what, uint32 ms, uint32 cycles, uint32 ops)
+{
+    Serial.print(what);
+    Serial.print(": ");
+    Serial.print(ms);
+    Serial.print(" ms, ");
+    Serial.print(cycles / ops);
+    Serial.print(" cycles/op");
+    if (benchCountLabel) {
+        Serial.print(", ");
+        Serial.print((float)benchCount / ops);
+        Serial.print(' ');
+        Serial.print(benchCountLabel);
+        Serial.print("/op");
+    }
+    Serial.println();
+}
@@ -0,0 +1,62 @@
+/*
+ * Helpers for timing short pieces of code with the Cortex-M3 DWT
+ * cycle counter. The counter runs at the CPU clock and wraps every
+ * 2^32 cycles (about 60 seconds at 72 MHz); use cycles() for a 64-bit
+ * count. The core starts the counter and keeps the timebase on it, so
+ * only take differences.
+ *
+ *     benchBegin();
+ *     uint32 start = benchCycles();
+ *     ...
+ *     uint32 cycles = benchCycles() - start;
+ *
+ * The sketches time each candidate with BENCH_RUN() and print the
+ * results on Serial every few seconds: milliseconds per batch of
+ * operations and average CPU cycles per operation.
+ */
+
+#ifndef _BENCHMARKS_H_
+#define _BENCHMARKS_H_
+
+#include <Arduino.h>
+
+#include <libmaple/dwt.h>
+
+/* Start the cycle counter. */
+static inline void benchBegin(void)
+{
+    dwt_cycle_counter_enable();
+}
+
+/* Current cycle count. */
+static inline uint32 benchCycles(void)
+{
+    return dwt_cycles();
+}
+
+/*
+ * Something else the code under test counts, e.g. heap allocations,
+ * reported per operation under benchCountLabel unless that is NULL.
+ * BENCH_RUN() clears it first.
+ */
+extern uint32 benchCount;
+extern const char *benchCountLabel;
+
+/* Print a line of results for ops operations on Serial. */
+void benchReport(const char *what, uint32 ms, uint32 cycles, uint32 ops);
+
+/* Time stmt, run ops times with i counting from 0, and report it. */
+#define BENCH_RUN(what, ops, stmt)                                  \
+    BENCH_TIME(what, ops, for (uint32 i = 0; i < (ops); i++) { stmt; })
+
+/* Time stmt, which does ops operations in one go, and report it. */
+#define BENCH_TIME(what, ops, stmt) do {                            \
+        benchCount = 0;                                             \
+        uint32 bench_ms = millis();                                 \
+        uint32 bench_start = benchCycles();                         \
+        stmt;                                                       \
+        uint32 bench_cycles = benchCycles() - bench_start;          \
+        benchReport(what, millis() - bench_ms, bench_cycles, ops);  \
+    } while (0)
+
+#endif
@@ -21,8 +21,8 @@
  * is known to be erroneous.
  */
 
-#ifndef __fixmatrix_h_
-#define __fixmatrix_h_
+#ifndef __fixmath_h_
+#define __fixmath_h_
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -31,7 +31,12 @@
 #include "utility/math/int64.h"
 #include "utility/math/fract32.h"
 #include "utility/math/fix16.h"
-#include "utility/matrix/libmatrix.h"
+#include "utility/matrix/fixmatrix.h"
 #include "utility/filter/fixkalman.h"
 
+#ifdef __cplusplus
+#include "utility/matrix/Matrix.h"
+#include "utility/filter/KalmanFilter.h"
+#endif
+
 #endif
@@ -0,0 +1,121 @@
+/* Accuracy and speed of the fix16 trig backends, on the build host.
+ *
+ *   cd utility/math
+ *   gcc -O2 -I. -o fix16_trig_benchmark ../../unit/fix16_trig_benchmark.c \
+ *       fix16.c fix16_sqrt.c fix16_trig.c -lm
+ *
+ * Errors are against libm, in fix16 LSBs (2^-16); timings are in TSC
+ * ticks on x86 and nanoseconds elsewhere. Add -DFIXMATH_NO_CACHE to
+ * time fix16_sin() and fix16_atan2() without their caches.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "fix16.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS "cycles"
+static uint64_t ticks(void) { return __rdtsc(); }
+#else
+#define TICKS "ns"
+static uint64_t ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+#define CALLS 1000000
+
+typedef fix16_t (*fn1)(fix16_t);
+typedef fix16_t (*fn2)(fix16_t, fix16_t);
+
+static double lsb(fix16_t got, double want)
+{
+    return fabs(got / 65536.0 - want) * 65536.0;
+}
+
+/* Angles from -pi to pi, the domain of fix16_sin_parabola(), at a
+ * step that isn't a multiple of the table steps. */
+static void bench_sin(const char *name, fn1 f)
+{
+    double max = 0, sum = 0;
+    uint64_t start, end;
+    volatile fix16_t sink;
+    fix16_t a;
+    int n = 0, i;
+
+    for (a = -fix16_pi; a <= fix16_pi; a += 7)
+    {
+        double e = lsb(f(a), sin(a / 65536.0));
+        if (e > max) max = e;
+        sum += e * e;
+        n++;
+    }
+
+    start = ticks();
+    for (i = 0, a = 0; i < CALLS; i++, a += 1237)
+        sink = f(a & 0x7FFFF);
+    end = ticks();
+    (void)sink;
+
+    printf("%-28s max %6.2f  rms %5.2f LSB  %6.1f %s/call\n", name, max,
+           sqrt(sum / n), (double)(end - start) / CALLS, TICKS);
+}
+
+/* Points on circles of several radii. fix16_atan2() overflows
+ * beyond about 20000. */
+static void bench_atan2(const char *name, fn2 f)
+{
+    static const double radii[] = { 0.001, 0.5, 1, 100, 16000 };
+    double max = 0, sum = 0;
+    uint64_t start, end;
+    volatile fix16_t sink;
+    unsigned r, i;
+    int n = 0;
+
+    for (r = 0; r < sizeof(radii) / sizeof(radii[0]); r++)
+    {
+        for (i = 0; i < 4096; i++)
+        {
+            double t = 2 * M_PI * i / 4096;
+            fix16_t y = (fix16_t)lround(radii[r] * sin(t) * 65536);
+            fix16_t x = (fix16_t)lround(radii[r] * cos(t) * 65536);
+            double e = lsb(f(y, x), atan2(y, x));
+            /* +-pi are the same angle */
+            if (e > 2 * M_PI * 65536 - 1000)
+                e = fabs(e - 2 * M_PI * 65536);
+            if (e > max) max = e;
+            sum += e * e;
+            n++;
+        }
+    }
+
+    start = ticks();
+    for (i = 0; i < CALLS; i++)
+        sink = f((i * 7919) & 0x3FFFF, (fix16_t)((i * 104729) & 0x3FFFF) - 0x20000);
+    end = ticks();
+    (void)sink;
+
+    printf("%-28s max %6.2f  rms %5.2f LSB  %6.1f %s/call\n", name, max,
+           sqrt(sum / n), (double)(end - start) / CALLS, TICKS);
+}
+
+int main()
+{
+    printf("sin, -pi to pi:\n");
+    bench_sin("fix16_sin", fix16_sin);
+    bench_sin("fix16_sin_parabola", fix16_sin_parabola);
+    bench_sin("fix16_sin_qlut", fix16_sin_qlut);
+    bench_sin("fix16_sin_qlut_quadratic", fix16_sin_qlut_quadratic);
+    bench_sin("fix16_sin_cordic", fix16_sin_cordic);
+
+    printf("\natan2, radius 0.001 to 16000:\n");
+    bench_atan2("fix16_atan2", fix16_atan2);
+    bench_atan2("fix16_atan2_cordic", fix16_atan2_cordic);
+    return 0;
+}
@@ -0,0 +1,35 @@
+// Builds examples/kalman through the library's main header, the way a
+// sketch does, as C++ against the C sources.
+#include <stdio.h>
+#include "unittests.h"
+#include "../examples/kalman/kalman-basic.ino"
+
+int main()
+{
+    int status = 0;
+
+    {
+        COMMENT("Test kalman-basic through fixmath.h");
+        // One pass over the measurements; loop() asserts on g itself
+        setup();
+        loop();
+
+        float g = fix16_to_float(kalman_get_state_vector_uc(&kf)->data[2][0]);
+        printf("g = %f\n", g);
+        TEST(g > 9.7 && g < 10);
+        TEST(kalman_get_state_vector_uc(&kf)->errors == 0);
+    }
+
+    {
+        COMMENT("Test the C matrix API from C++");
+        mf16 a = {2, 2, 0, {{F16(1), F16(2)}, {F16(3), F16(4)}}};
+        mf16 c;
+        mf16_mul(&c, &a, &a);
+        TEST(c.data[0][0] == F16(7) && c.data[1][1] == F16(22) && c.errors == 0);
+    }
+
+    if (status != 0)
+        fprintf(stdout, "\n\nSome tests FAILED!\n");
+
+    return status;
+}
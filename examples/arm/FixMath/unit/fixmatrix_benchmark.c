@@ -0,0 +1,112 @@
+/* Speed of the matrix multiplications, on the build host.
+ *
+ *   gcc -O2 -Iutility/math -Iutility/matrix -o fixmatrix_benchmark \
+ *       unit/fixmatrix_benchmark.c utility/matrix/fixarray.c \
+ *       utility/matrix/fixmatrix.c utility/math/fix16.c \
+ *       utility/math/fix16_sqrt.c
+ *
+ * "strided" is the plain loop of one strided fa16_dot() per entry that
+ * mf16_mul() used to be. Timings are in TSC ticks on x86 and
+ * nanoseconds elsewhere; on a Cortex-M3 build, read DWT->CYCCNT instead.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "fixmatrix.h"
+#include "fixarray.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TICKS "cycles"
+static uint64_t ticks(void) { return __rdtsc(); }
+#else
+#define TICKS "ns"
+static uint64_t ticks(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+#define CALLS 200000
+
+typedef void (*mul_fn)(mf16 *dest, const mf16 *a, const mf16 *b);
+
+static void mul_strided(mf16 *dest, const mf16 *a, const mf16 *b)
+{
+    int row, column;
+
+    dest->rows = a->rows;
+    dest->columns = b->columns;
+    dest->errors = a->errors | b->errors;
+
+    for (row = 0; row < dest->rows; row++) {
+        for (column = 0; column < dest->columns; column++) {
+            dest->data[row][column] = fa16_dot(
+                                          &a->data[row][0], 1,
+                                          &b->data[0][column], FIXMATRIX_MAX_SIZE,
+                                          a->columns);
+
+            if (dest->data[row][column] == fix16_overflow)
+                dest->errors |= FIXMATRIX_OVERFLOW;
+        }
+    }
+}
+
+static void fill(mf16 *dest, int size, uint32_t seed)
+{
+    int i, j;
+
+    dest->rows = dest->columns = size;
+    dest->errors = 0;
+    for (i = 0; i < size; i++)
+    {
+        for (j = 0; j < size; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            dest->data[i][j] = (fix16_t)((seed >> 8) & 0x3FFFF) - 0x20000;
+        }
+    }
+}
+
+static void bench(const char *name, mul_fn f, int size)
+{
+    static mf16 a, b, r;
+    uint64_t start, end;
+    int i;
+
+    fill(&a, size, 1);
+    fill(&b, size, 2);
+    fill(&r, size, 3);
+
+    start = ticks();
+    for (i = 0; i < CALLS; i++)
+    {
+        f(&r, &a, &b);
+        // Keep the inputs changing so the calls can't be hoisted
+        a.data[0][0] = r.data[size - 1][size - 1] & 0xFFFF;
+    }
+    end = ticks();
+
+    printf("%dx%d %-14s %8.1f %s/call\n", size, size, name,
+           (double)(end - start) / CALLS, TICKS);
+}
+
+int main()
+{
+    static const int sizes[] = { 4, 8 };
+    unsigned i;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        bench("strided", mul_strided, sizes[i]);
+        bench("mf16_mul", mf16_mul, sizes[i]);
+        bench("mf16_mul_at", mf16_mul_at, sizes[i]);
+        bench("mf16_mul_bt", mf16_mul_bt, sizes[i]);
+        bench("mf16_mul_add", mf16_mul_add, sizes[i]);
+        printf("\n");
+    }
+    return 0;
+}
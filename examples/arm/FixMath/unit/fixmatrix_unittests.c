@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include "unittests.h"
 #include "fixmatrix.h"
+#include "fixarray.h"
 #include "fixstring.h"
 
 fix16_t max_delta(const mf16 *a, const mf16 *b)
@@ -27,6 +28,58 @@ fix16_t max_delta(const mf16 *a, const mf16 *b)
     return max;
 }
 
+// Pseudo-random entries from -4 to 4, with fractional parts
+static uint32_t rand_state = 12345;
+static fix16_t rand_fix16(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (fix16_t)((rand_state >> 8) & 0x7FFFF) - 0x40000;
+}
+
+static void fill_random(mf16 *dest, int rows, int columns)
+{
+    int i, j;
+    dest->rows = rows;
+    dest->columns = columns;
+    dest->errors = 0;
+    for (i = 0; i < rows; i++)
+        for (j = 0; j < columns; j++)
+            dest->data[i][j] = rand_fix16();
+}
+
+// Exact sum of the products, rounded half away from zero like fa16_dot()
+static fix16_t ref_dot(const mf16 *a, int row, const mf16 *b, int column)
+{
+    int64_t sum = 0;
+    int k;
+    for (k = 0; k < a->columns; k++)
+        sum += (int64_t)a->data[row][k] * b->data[k][column];
+    
+    if (sum >= 0)
+        return (fix16_t)((sum + 0x8000) >> 16);
+    else
+        return (fix16_t)-((-sum + 0x8000) >> 16);
+}
+
+// Number of entries of dest that differ from ref_dot() + sign * base
+static int ref_mismatches(const mf16 *dest, const mf16 *a, const mf16 *b,
+                          const mf16 *base, int sign)
+{
+    int i, j, count = 0;
+    for (i = 0; i < a->rows; i++)
+    {
+        for (j = 0; j < b->columns; j++)
+        {
+            fix16_t want = ref_dot(a, i, b, j);
+            if (base)
+                want = base->data[i][j] + sign * want;
+            if (dest->data[i][j] != want)
+                count++;
+        }
+    }
+    return count;
+}
+
 int main()
 {
     int status = 0;
@@ -619,6 +672,90 @@ int main()
         
         TEST(max_delta(&a, &identity) < 10);
     }
+    {
+        mf16 a, b, at, bt, base, r;
+        int size, i;
+        
+        COMMENT("Test bit-exactness of multiplication against a reference");
+        for (size = 1; size <= FIXMATRIX_MAX_SIZE; size++)
+        {
+            int mismatches = 0;
+            
+            for (i = 0; i < 20; i++)
+            {
+                fill_random(&a, size, size);
+                fill_random(&b, size, size);
+                fill_random(&base, size, size);
+                mf16_transpose(&at, &a);
+                mf16_transpose(&bt, &b);
+                
+                mf16_mul(&r, &a, &b);
+                mismatches += r.errors + ref_mismatches(&r, &a, &b, NULL, 0);
+                mf16_mul_at(&r, &at, &b);
+                mismatches += r.errors + ref_mismatches(&r, &a, &b, NULL, 0);
+                mf16_mul_bt(&r, &a, &bt);
+                mismatches += r.errors + ref_mismatches(&r, &a, &b, NULL, 0);
+                
+                r = base;
+                mf16_mul_add(&r, &a, &b);
+                mismatches += r.errors + ref_mismatches(&r, &a, &b, &base, 1);
+                r = base;
+                mf16_mul_sub(&r, &a, &b);
+                mismatches += r.errors + ref_mismatches(&r, &a, &b, &base, -1);
+            }
+            
+            printf("%dx%d: %d mismatches\n", size, size, mismatches);
+            TEST(mismatches == 0);
+        }
+        
+        COMMENT("Test non-square multiplication against a reference");
+        fill_random(&a, 5, 7);
+        fill_random(&b, 7, 3);
+        mf16_mul(&r, &a, &b);
+        TEST(r.rows == 5 && r.columns == 3 && r.errors == 0);
+        TEST(ref_mismatches(&r, &a, &b, NULL, 0) == 0);
+        mf16_transpose(&bt, &b);
+        mf16_mul_bt(&r, &a, &bt);
+        TEST(ref_mismatches(&r, &a, &b, NULL, 0) == 0);
+        
+        COMMENT("Test strided and contiguous dot products agree");
+        fill_random(&a, 8, 8);
+        mf16_transpose(&at, &a);
+        TEST(fa16_dot(&a.data[2][0], 1, &a.data[0][5], FIXMATRIX_MAX_SIZE, 8) ==
+             fa16_dot(&a.data[2][0], 1, &at.data[5][0], 1, 8));
+        
+        COMMENT("Test mf16_mul_add with aliasing and wrong dimensions");
+        fill_random(&a, 4, 4);
+        base = a;
+        mf16_mul_add(&a, &a, &a);
+        TEST(ref_mismatches(&a, &base, &base, &base, 1) == 0);
+        fill_random(&r, 3, 4);
+        mf16_mul_add(&r, &a, &a);
+        TEST(r.errors & FIXMATRIX_DIMERR);
+        
+        COMMENT("Test mf16_mul_sub overflow");
+        a.rows = a.columns = r.rows = r.columns = 2;
+        mf16_fill(&a, fix16_from_int(200));
+        mf16_fill(&r, fix16_minimum);
+        mf16_mul_sub(&r, &a, &a);
+        TEST(r.errors & FIXMATRIX_OVERFLOW);
+        
+        COMMENT("Test mf16_mul_add/sub rounding products of half an LSB");
+        a.rows = a.columns = b.rows = b.columns = 1;
+        a.errors = b.errors = 0;
+        a.data[0][0] = 1;
+        for (i = -1; i <= 1; i += 2)
+        {
+            b.data[0][0] = i * 0x8000;
+            mf16_fill(&r, 1);
+            r.rows = r.columns = 1;
+            mf16_mul_add(&r, &a, &b);
+            TEST(r.data[0][0] == 1 + i && r.errors == 0);
+            mf16_fill(&r, 1);
+            mf16_mul_sub(&r, &a, &b);
+            TEST(r.data[0][0] == 1 - i && r.errors == 0);
+        }
+    }
         
     if (status != 0)
         fprintf(stdout, "\n\nSome tests FAILED!\n");
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include "unittests.h"
+#include "Matrix.h"
+#include "KalmanFilter.h"
+
+template <uint8_t R, uint8_t C>
+fix16_t max_delta(const Matrix<R, C> &a, const Matrix<R, C> &b)
+{
+    fix16_t max = 0;
+
+    if (a.errors || b.errors)
+        return fix16_maximum;
+
+    for (int i = 0; i < R; i++)
+    {
+        for (int j = 0; j < C; j++)
+        {
+            fix16_t delta = fix16_abs(a.data[i][j] - b.data[i][j]);
+            if (delta > max)
+                max = delta;
+        }
+    }
+
+    return max;
+}
+
+// Same gravity estimate as examples/kalman/kalman-basic.ino
+static const float real_distance[] = {
+    4.905, 19.62, 44.145, 78.48, 122.63, 176.58, 240.35, 313.92,
+    397.31, 490.5, 593.51, 706.32, 828.94, 961.38, 1103.6
+};
+static const float measurement_error[] = {
+    0.13442, 0.45847, -0.56471, 0.21554, 0.079691, -0.32692, -0.1084,
+    0.085656, 0.8946, 0.69236, -0.33747, 0.75873, 0.18135, -0.015764,
+    0.17869
+};
+
+int main()
+{
+    int status = 0;
+
+    {
+        COMMENT("Test multiplication");
+        Matrix<2, 3> a = {{{F16(1), F16(2), F16(3)},
+                           {F16(4), F16(5), F16(6)}}, 0};
+        Matrix<3, 2> b = {{{F16(7), F16(8)},
+                           {F16(9), F16(10)},
+                           {F16(11), F16(12)}}, 0};
+        Matrix<2, 2> ab = {{{F16(58), F16(64)},
+                            {F16(139), F16(154)}}, 0};
+        Matrix<2, 2> c;
+        Matrix<3, 2> at;
+        Matrix<2, 3> bt;
+
+        mul(c, a, b);
+        TEST(max_delta(c, ab) == 0);
+
+        c = a * b;
+        TEST(max_delta(c, ab) == 0);
+
+        transpose(at, a);
+        TEST(at.data[2][1] == F16(6) && at.data[0][1] == F16(4));
+        mul_at(c, at, b);
+        TEST(max_delta(c, ab) == 0);
+
+        transpose(bt, b);
+        mul_bt(c, a, bt);
+        TEST(max_delta(c, ab) == 0);
+
+        COMMENT("Test overflow detection");
+        Matrix<1, 1> big = {{{F16(30000)}}, 0};
+        Matrix<1, 1> prod, prod2;
+        mul(prod, big, big);
+        TEST(prod.errors & FIXMATRIX_OVERFLOW);
+        mul(prod2, prod, big);
+        TEST(prod2.errors & FIXMATRIX_OVERFLOW);
+    }
+
+    {
+        COMMENT("Test Cholesky decomposition and solving");
+        Matrix<3, 3> A = {{{F16(4), F16(12), F16(-16)},
+                           {F16(12), F16(37), F16(-43)},
+                           {F16(-16), F16(-43), F16(98)}}, 0};
+        Matrix<3, 3> L_expected = {{{F16(2), 0, 0},
+                                    {F16(6), F16(1), 0},
+                                    {F16(-8), F16(5), F16(3)}}, 0};
+        Matrix<3, 3> L, LLt;
+        cholesky(L, A);
+        TEST(max_delta(L, L_expected) < 2);
+
+        mul_bt(LLt, L, L);
+        TEST(max_delta(LLt, A) < 10);
+
+        Matrix<3, 1> x = {{{F16(1)}, {F16(-2)}, {F16(0.5)}}, 0};
+        Matrix<3, 1> b, solved;
+        mul(b, A, x);
+        cholesky_solve(solved, L, b);
+        TEST(max_delta(solved, x) < 20);
+
+        cholesky(A, A);
+        TEST(max_delta(A, L_expected) < 2);
+
+        Matrix<2, 2> negative = {{{F16(-1), 0}, {0, F16(1)}}, 0};
+        cholesky(negative, negative);
+        TEST(negative.errors & FIXMATRIX_NEGATIVE);
+    }
+
+    {
+        COMMENT("Test Kalman filter");
+        KalmanFilter<3, 0, 1> kf;
+
+        kf.x(2, 0) = F16(6);
+
+        kf.A.fill_diagonal(fix16_one);
+        kf.A(0, 1) = fix16_one;
+        kf.A(0, 2) = F16(0.5);
+        kf.A(1, 2) = fix16_one;
+
+        kf.P(0, 0) = F16(0.5);
+        kf.P(1, 1) = fix16_one;
+        kf.P(2, 2) = fix16_one;
+
+        kf.Q.fill(F16(0.0001));
+        kf.H(0, 0) = fix16_one;
+        kf.R(0, 0) = F16(0.5);
+
+        for (unsigned i = 0; i < sizeof(real_distance) / sizeof(real_distance[0]); i++)
+        {
+            kf.predict();
+            kf.z(0, 0) = fix16_from_float(real_distance[i] + measurement_error[i]);
+            kf.correct();
+        }
+
+        float g = fix16_to_float(kf.x(2, 0));
+        printf("g = %f\n", g);
+        TEST(g > 9.7 && g < 10);
+        TEST(kf.x.errors == 0 && kf.P.errors == 0);
+    }
+
+    {
+        COMMENT("Test Kalman filter with a control input");
+        // Position and velocity, with acceleration as the input
+        KalmanFilter<2, 1, 1> kf;
+
+        kf.A.fill_diagonal(fix16_one);
+        kf.A(0, 1) = fix16_one;
+        kf.B(0, 0) = F16(0.5);
+        kf.B(1, 0) = fix16_one;
+        kf.Qu(0, 0) = F16(0.01);
+        kf.P.fill_diagonal(fix16_one);
+        kf.H(0, 0) = fix16_one;
+        kf.R(0, 0) = F16(0.25);
+
+        kf.u(0, 0) = F16(2);
+        for (int t = 1; t <= 10; t++)
+        {
+            kf.predict();
+            kf.z(0, 0) = fix16_from_int(t * t);
+            kf.correct();
+        }
+
+        TEST(fix16_abs(kf.x(0, 0) - F16(100)) < F16(0.5));
+        TEST(fix16_abs(kf.x(1, 0) - F16(20)) < F16(1));
+        TEST(sizeof(kf) < 2 * sizeof(Matrix<8, 8>));
+    }
+
+    if (status != 0)
+        fprintf(stdout, "\n\nSome tests FAILED!\n");
+
+    return status;
+}
@@ -0,0 +1,208 @@
+/*!
+* \file KalmanFilter.h
+* \brief Kalman filter on compile-time sized matrices, for C++
+*
+* KalmanFilter<States, Inputs, Obs> does the work of kalman16_t (or
+* kalman16_uc_t, with no inputs) and one kalman16_observation_t, on
+* Matrix<R, C> instead of mf16. Each filter holds its own temporaries,
+* so filters can run concurrently, e.g. in separate tasks, and
+* storage is only as large as the dimensions need.
+*/
+
+#ifndef _KALMAN_FILTER_H_
+#define _KALMAN_FILTER_H_
+
+#include <stdint.h>
+#include "../matrix/Matrix.h"
+
+/*!
+* \brief Control input part of a KalmanFilter
+*/
+template <uint8_t States, uint8_t Inputs>
+class KalmanInputs
+{
+public:
+    /*!
+    * \brief Input vector (#inputs x 1)
+    */
+    Matrix<Inputs, 1> u;
+
+    /*!
+    * \brief Input matrix (#states x #inputs)
+    */
+    Matrix<States, Inputs> B;
+
+    /*!
+    * \brief Input covariance/uncertainty matrix (#inputs x #inputs)
+    */
+    Matrix<Inputs, Inputs> Qu;
+
+protected:
+    void init()
+    {
+        u.fill(0);
+        B.fill(0);
+        Qu.fill(0);
+    }
+
+    // x += B*u
+    void predict_x(Matrix<States, 1> &x, Matrix<States, 1> &temp)
+    {
+        mul(temp, B, u);
+        add(x, x, temp);
+    }
+
+    // P += B*Qu*B'
+    void predict_P(Matrix<States, States> &P, Matrix<States, States> &temp)
+    {
+        Matrix<States, Inputs> BQ;
+        mul(BQ, B, Qu);
+        mul_bt(temp, BQ, B);
+        add(P, P, temp);
+    }
+};
+
+template <uint8_t States>
+class KalmanInputs<States, 0>
+{
+protected:
+    void init() {}
+    void predict_x(Matrix<States, 1> &, Matrix<States, 1> &) {}
+    void predict_P(Matrix<States, States> &, Matrix<States, States> &) {}
+};
+
+/*!
+* \brief Kalman filter with States state variables, Inputs control
+* inputs and Obs measurements
+*
+* Set up A, P, Q, H and R (and B and Qu with inputs) and the initial x.
+* Then, for each time step, call predict(), store the measurements in
+* z and call correct(). Any errors in the computations collect in the
+* FIXMATRIX_* flags of x and P.
+*/
+template <uint8_t States, uint8_t Inputs = 0, uint8_t Obs = 1>
+class KalmanFilter : public KalmanInputs<States, Inputs>
+{
+public:
+    /*!
+    * \brief State vector (#states x 1)
+    */
+    Matrix<States, 1> x;
+
+    /*!
+    * \brief State transition matrix (#states x #states)
+    */
+    Matrix<States, States> A;
+
+    /*!
+    * \brief System covariance matrix (#states x #states)
+    */
+    Matrix<States, States> P;
+
+    /*!
+    * \brief System process noise matrix (#states x #states)
+    */
+    Matrix<States, States> Q;
+
+    /*!
+    * \brief Measurement vector (#measurements x 1)
+    */
+    Matrix<Obs, 1> z;
+
+    /*!
+    * \brief Measurement transformation matrix (#measurements x #states)
+    */
+    Matrix<Obs, States> H;
+
+    /*!
+    * \brief Observation process noise covariance matrix (#measurements x #measurements)
+    */
+    Matrix<Obs, Obs> R;
+
+    KalmanFilter() { init(); }
+
+    /*!
+    * \brief Zeroes all the matrices and clears their errors
+    */
+    void init()
+    {
+        KalmanInputs<States, Inputs>::init();
+        x.fill(0);
+        A.fill(0);
+        P.fill(0);
+        Q.fill(0);
+        z.fill(0);
+        H.fill(0);
+        R.fill(0);
+    }
+
+    /*!
+    * \brief Performs the time update / prediction step
+    * \param[in] lambda Lambda factor (\c 0 < {\ref lambda} <= \c 1) to forcibly reduce prediction certainty. Smaller values mean larger uncertainty.
+    *
+    * x = A*x + B*u
+    * P = A*P*A' * 1/lambda^2 + Q + B*Qu*B'
+    */
+    void predict(fix16_t lambda = fix16_one)
+    {
+        // x = A*x + B*u
+        mul(s.x, A, x);
+        x = s.x;
+        this->predict_x(x, s.x);
+
+        // P = A*P*A' * 1/lambda^2
+        mul(s.SS, A, P);
+        mul_bt(P, s.SS, A);
+        if (lambda != fix16_one)
+            mul_s(P, P, fix16_div(fix16_one, fix16_sq(lambda)));
+
+        // P += Q + B*Qu*B'
+        add(P, P, Q);
+        this->predict_P(P, s.SS);
+    }
+
+    /*!
+    * \brief Performs the measurement update / correction step with z
+    *
+    * y = z - H*x
+    * S = H*P*H' + R
+    * K = P*H' * S^-1
+    * x = x + K*y
+    * P = P - K*(H*P)
+    */
+    void correct()
+    {
+        // y = z - H*x
+        mul(s.y, H, x);
+        sub(s.y, z, s.y);
+
+        // S = H*P*H' + R
+        mul(s.HP, H, P);
+        mul_bt(s.S, s.HP, H);
+        add(s.S, s.S, R);
+
+        // K' = S^-1 * (H*P), as S and P are symmetric
+        cholesky(s.S, s.S);
+        cholesky_solve(s.Kt, s.S, s.HP);
+
+        // x = x + K*y
+        mul_at(s.x, s.Kt, s.y);
+        add(x, x, s.x);
+
+        // P = P - K*(H*P)
+        mul_at(s.SS, s.Kt, s.HP);
+        sub(P, P, s.SS);
+    }
+
+private:
+    struct {
+        Matrix<States, 1> x;
+        Matrix<States, States> SS;
+        Matrix<Obs, 1> y;
+        Matrix<Obs, States> HP;
+        Matrix<Obs, Obs> S;
+        Matrix<Obs, States> Kt;
+    } s;
+};
+
+#endif
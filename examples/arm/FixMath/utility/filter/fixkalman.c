@@ -60,96 +60,6 @@ STATIC_INLINE void mf16_add_and_scale(mf16 *dest, const mf16 *RESTRICT a, const
     }
 }
 
-// Calculates dest = dest + A * B
-HOT NONNULL
-STATIC_INLINE void mf16_mul_add(mf16 *dest, const mf16 *RESTRICT a, const mf16 *RESTRICT b)
-{
-    int row, column;
-    const int
-    acolumns = a->columns,
-    drows = dest->rows,
-    dcolumns = dest->columns;
-
-    // If dest and input matrices alias, we have to use a temp matrix.
-    mf16 tmp;
-    fa16_unalias(dest, (void**)&a, (void**)&b, &tmp, sizeof(tmp));
-
-    dest->errors = a->errors | b->errors;
-
-    if (a->columns != b->rows)
-        dest->errors |= FIXMATRIX_DIMERR;
-
-    dest->rows = a->rows;
-    dest->columns = b->columns;
-
-    for (row = drows - 1; row >= 0; --row) {
-        const fix16_t *aptr = &a->data[row][0];
-        const fix16_t *bptr = &b->data[0][0];
-        fix16_t *rowptr = &dest->data[row][0];
-
-        for (column = dcolumns - 1; column >= 0; --column) {
-            fix16_t value = fa16_dot(
-                                aptr, 1,
-                                bptr + column, FIXMATRIX_MAX_SIZE,
-                                acolumns);
-
-            // fetch and modify current value
-            rowptr[column] = fix16_add(rowptr[column], value);
-
-#ifndef FIXMATH_NO_OVERFLOW
-            // test for overflows
-            if (rowptr[column] == fix16_overflow)
-                dest->errors |= FIXMATRIX_OVERFLOW;
-#endif
-        }
-    }
-}
-
-// Calculates dest = dest +/- A * B
-HOT NONNULL
-STATIC_INLINE void mf16_mul_sub(mf16 *dest, const mf16 *RESTRICT a, const mf16 *RESTRICT b)
-{
-    int row, column;
-    const int
-    acolumns = a->columns,
-    drows = dest->rows,
-    dcolumns = dest->columns;
-
-    // If dest and input matrices alias, we have to use a temp matrix.
-    mf16 tmp;
-    fa16_unalias(dest, (void**)&a, (void**)&b, &tmp, sizeof(tmp));
-
-    dest->errors = a->errors | b->errors;
-
-    if (a->columns != b->rows)
-        dest->errors |= FIXMATRIX_DIMERR;
-
-    dest->rows = a->rows;
-    dest->columns = b->columns;
-
-    for (row = drows - 1; row >= 0; --row) {
-        const fix16_t *aptr = &a->data[row][0];
-        const fix16_t *bptr = &b->data[0][0];
-        fix16_t *rowptr = &dest->data[row][0];
-
-        for (column = dcolumns - 1; column >= 0; --column) {
-            fix16_t value = fa16_dot(
-                                aptr, 1,
-                                bptr + column, FIXMATRIX_MAX_SIZE,
-                                acolumns);
-
-            // fetch and modify current value
-            rowptr[column] = fix16_sub(rowptr[column], value);
-
-#ifndef FIXMATH_NO_OVERFLOW
-            // test for overflows
-            if (rowptr[column] == fix16_overflow)
-                dest->errors |= FIXMATRIX_OVERFLOW;
-#endif
-        }
-    }
-}
-
 // Calculates dest = dest + (A * B) * s
 HOT NONNULL
 STATIC_INLINE void mf16_mul_add_scaled(mf16 *dest, const mf16 *RESTRICT a, const mf16 *RESTRICT b, const register fix16_t scale)
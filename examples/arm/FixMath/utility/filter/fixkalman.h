@@ -3,7 +3,12 @@
 
 #include <stdint.h>
 #include "compiler.h"
-#include "../../fixmath.h"
+#include "../matrix/fixmatrix.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 
 /*!
 * \def KALMAN_DISABLE_UC Global define to disable functions for systems without control inputs
@@ -169,7 +174,7 @@ void kalman_filter_initialize(kalman16_t *const kf, uint_fast8_t num_states, uin
 * \see kalman_predict_tuned
 */
 HOT NONNULL
-void kalman_predict_x(register kalman16_t *const kf);
+void kalman_predict_x(kalman16_t *const kf);
 
 /*!
 * \brief Performs the time update / prediction step of only the state covariance matrix
@@ -179,7 +184,7 @@ void kalman_predict_x(register kalman16_t *const kf);
 * \see kalman_predict_P_tuned
 */
 HOT NONNULL
-void kalman_predict_P(register kalman16_t *const kf);
+void kalman_predict_P(kalman16_t *const kf);
 
 #ifndef KALMAN_DISABLE_LAMBDA
 
@@ -191,7 +196,7 @@ void kalman_predict_P(register kalman16_t *const kf);
 * \see kalman_predict_P
 */
 HOT NONNULL
-void kalman_predict_P_tuned(register kalman16_t *const kf, fix16_t lambda);
+void kalman_predict_P_tuned(kalman16_t *const kf, fix16_t lambda);
 
 #endif // KALMAN_DISABLE_LAMBDA
 
@@ -402,7 +407,7 @@ void kalman_filter_initialize_uc(kalman16_uc_t *const kf, uint_fast8_t num_state
 * \see kalman_predict_tuned_uc
 */
 HOT NONNULL
-void kalman_predict_x_uc(register kalman16_uc_t *const kf);
+void kalman_predict_x_uc(kalman16_uc_t *const kf);
 
 /*!
 * \brief Performs the time update / prediction step of only the state vector with integration.
@@ -413,7 +418,7 @@ void kalman_predict_x_uc(register kalman16_uc_t *const kf);
 * \see kalman_predict_tuned_uc
 */
 HOT NONNULL
-void kalman_cpredict_x_uc(register kalman16_uc_t *const kf, register fix16_t deltaT);
+void kalman_cpredict_x_uc(kalman16_uc_t *const kf, fix16_t deltaT);
 
 /*!
 * \brief Performs the time update / prediction step of only the state covariance matrix
@@ -423,7 +428,7 @@ void kalman_cpredict_x_uc(register kalman16_uc_t *const kf, register fix16_t del
 * \see kalman_predict_P_tuned_uc
 */
 HOT NONNULL
-void kalman_predict_P_uc(register kalman16_uc_t *const kf);
+void kalman_predict_P_uc(kalman16_uc_t *const kf);
 
 /*!
 * \brief Performs the continuous-time time update / prediction step of only the state covariance matrix with integration.
@@ -434,7 +439,7 @@ void kalman_predict_P_uc(register kalman16_uc_t *const kf);
 * \see kalman_predict_P_tuned_uc
 */
 HOT NONNULL
-void kalman_cpredict_P_uc(register kalman16_uc_t *const kf, register fix16_t deltaT);
+void kalman_cpredict_P_uc(kalman16_uc_t *const kf, fix16_t deltaT);
 
 #ifndef KALMAN_DISABLE_LAMBDA
 
@@ -446,7 +451,7 @@ void kalman_cpredict_P_uc(register kalman16_uc_t *const kf, register fix16_t del
 * \see kalman_predict_P_uc
 */
 HOT NONNULL
-void kalman_predict_P_tuned_uc(register kalman16_uc_t *const kf, fix16_t lambda);
+void kalman_predict_P_tuned_uc(kalman16_uc_t *const kf, fix16_t lambda);
 
 #endif // KALMAN_DISABLE_LAMBDA
 
@@ -489,7 +494,7 @@ EXTERN_INLINE_KALMAN void kalman_predict_uc(kalman16_uc_t *kf)
 * \see kalman_predict_P
 */
 NONNULL
-EXTERN_INLINE_KALMAN void kalman_cpredict_uc(kalman16_uc_t *kf, register fix16_t deltaT)
+EXTERN_INLINE_KALMAN void kalman_cpredict_uc(kalman16_uc_t *kf, fix16_t deltaT)
 {
     /************************************************************************/
     /* Predict next state using system dynamics                             */
@@ -596,4 +601,9 @@ EXTERN_INLINE_KALMAN mf16* kalman_get_system_process_noise_uc(kalman16_uc_t *kf)
 #endif // KALMAN_DISABLE_UC
 
 #undef EXTERN_INLINE_KALMAN
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -154,7 +154,39 @@ extern fix16_t fix16_lerp32(fix16_t inArg0, fix16_t inArg1, uint32_t inFract) FI
 */
 extern fix16_t fix16_sin_parabola(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
 
+/*! Returns the sine of the given fix16_t, interpolating linearly in a
+    quarter wave table of 256 steps (1 KB of flash). Within 1.5 LSB.
+*/
+extern fix16_t fix16_sin_qlut(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
+
+/*! Returns the sine of the given fix16_t, interpolating quadratically in
+    a quarter wave table of 32 steps (140 bytes of flash). Within 2 LSB.
+*/
+extern fix16_t fix16_sin_qlut_quadratic(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
+
+/*! Returns the sine of the given fix16_t, by CORDIC rotation. Takes
+    FIXMATH_CORDIC_ITERATIONS steps (20 by default, at most 24).
+*/
+extern fix16_t fix16_sin_cordic(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
+
+/*! Returns the cosine of the given fix16_t, by CORDIC rotation.
+*/
+extern fix16_t fix16_cos_cordic(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
+
 /*! Returns the sine of the given fix16_t.
+
+    The implementation is chosen at build time:
+    - FIXMATH_SIN_LUT: a table of every angle up to pi/2 (200 KB of flash)
+    - FIXMATH_CORDIC: fix16_sin_cordic(); fix16_cos() and fix16_atan2()
+      use CORDIC as well
+    - FIXMATH_SIN_QLUT_QUADRATIC: fix16_sin_qlut_quadratic()
+    - FIXMATH_SIN_QLUT: fix16_sin_qlut()
+    - otherwise, a Taylor series (a shorter polynomial with
+      FIXMATH_FAST_SIN), whose results are cached
+
+    Unless FIXMATH_NO_CACHE is defined, the series and fix16_atan2()
+    remember their last results in direct mapped caches of
+    2^FIXMATH_CACHE_BITS entries (6 by default, for 1.25 KB of RAM).
 */
 extern fix16_t fix16_sin(fix16_t inAngle) FIXMATH_FUNC_ATTRS;
 
@@ -182,6 +214,10 @@ extern fix16_t fix16_atan(fix16_t inValue) FIXMATH_FUNC_ATTRS;
 */
 extern fix16_t fix16_atan2(fix16_t inY, fix16_t inX) FIXMATH_FUNC_ATTRS;
 
+/*! Returns the arctangent of inY/inX, by CORDIC vectoring.
+*/
+extern fix16_t fix16_atan2_cordic(fix16_t inY, fix16_t inX) FIXMATH_FUNC_ATTRS;
+
 static const fix16_t fix16_rad_to_deg_mult = 3754936;
 static inline fix16_t fix16_rad_to_deg(fix16_t radians)
 { return fix16_mul(radians, fix16_rad_to_deg_mult); }
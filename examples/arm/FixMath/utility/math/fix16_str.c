@@ -35,13 +35,29 @@ void fix16_to_str(fix16_t value, char *buf, int decimals)
     unsigned intpart = uvalue >> 16;
     uint32_t fracpart = uvalue & 0xFFFF;
     uint32_t scale = scales[decimals & 7];
-    fracpart = fix16_mul(fracpart, scale);
     
-    if (fracpart >= scale)
+    /* Take the exact decimal digits of the fraction, one at a time, and
+     * round what is left like printf() does: to nearest, ties to even. */
+    uint32_t fracdigits = 0;
+    uint32_t s;
+    for (s = 1; s < scale; s *= 10)
+    {
+        fracpart *= 10;
+        fracdigits = fracdigits * 10 + (fracpart >> 16);
+        fracpart &= 0xFFFF;
+    }
+    
+    if (fracpart > 0x8000 ||
+        (fracpart == 0x8000 && ((scale == 1 ? intpart : fracdigits) & 1)))
+    {
+        fracdigits++;
+    }
+    
+    if (fracdigits >= scale)
     {
         /* Handle carry from decimal part */
         intpart++;
-        fracpart -= scale;    
+        fracdigits -= scale;    
     }
     
     /* Format integer part */
@@ -51,7 +67,7 @@ void fix16_to_str(fix16_t value, char *buf, int decimals)
     if (scale != 1)
     {
         *buf++ = '.';
-        buf = itoa_loop(buf, scale / 10, fracpart, false);
+        buf = itoa_loop(buf, scale / 10, fracdigits, false);
     }
     
     *buf = '\0';
@@ -1,18 +1,60 @@
 #include <limits.h>
 #include "fix16.h"
+#include "fix16_trig_qlut.h"
+
+/* Backends for fix16_sin(), fix16_cos() and fix16_atan2(); see fix16.h. */
+#if defined(FIXMATH_CORDIC) || defined(FIXMATH_SIN_QLUT) || \
+    defined(FIXMATH_SIN_QLUT_QUADRATIC)
+#define FIXMATH_SIN_NO_POLY
+#endif
+
+#ifndef FIXMATH_CACHE_BITS
+#define FIXMATH_CACHE_BITS 6
+#endif
+#define FIXMATH_CACHE_SIZE (1 << FIXMATH_CACHE_BITS)
 
 #if defined(FIXMATH_SIN_LUT)
 #include "fix16_trig_sin_lut.h"
-#elif !defined(FIXMATH_NO_CACHE)
-static fix16_t _fix16_sin_cache_index[4096]  = { 0 };
-static fix16_t _fix16_sin_cache_value[4096]  = { 0 };
+#elif !defined(FIXMATH_NO_CACHE) && !defined(FIXMATH_SIN_NO_POLY)
+static fix16_t _fix16_sin_cache_index[FIXMATH_CACHE_SIZE]  = { 0 };
+static fix16_t _fix16_sin_cache_value[FIXMATH_CACHE_SIZE]  = { 0 };
 #endif
 
 #ifndef FIXMATH_NO_CACHE
-static fix16_t _fix16_atan_cache_index[2][4096] = { { 0 }, { 0 } };
-static fix16_t _fix16_atan_cache_value[4096] = { 0 };
+static fix16_t _fix16_atan_cache_index[2][FIXMATH_CACHE_SIZE] = { { 0 }, { 0 } };
+static fix16_t _fix16_atan_cache_value[FIXMATH_CACHE_SIZE] = { 0 };
+#endif
+
+#ifndef FIXMATH_CORDIC_ITERATIONS
+#define FIXMATH_CORDIC_ITERATIONS 20
+#endif
+
+#ifdef __GNUC__
+// Count leading zeros, using processor-specific instruction if available.
+#define clz(x) (__builtin_clzl(x) - (8 * sizeof(long) - 32))
+#else
+static uint8_t clz(uint32_t x)
+{
+	uint8_t result = 0;
+	if (x == 0) return 32;
+	while (!(x & 0xF0000000)) { result += 4; x <<= 4; }
+	while (!(x & 0x80000000)) { result += 1; x <<= 1; }
+	return result;
+}
 #endif
 
+/* Angle in radians to a binary angle: 2^32ths of a turn, modulo one
+ * turn. */
+static inline uint32_t fix16_to_turns(fix16_t inAngle)
+{
+	return (uint32_t)(((int64_t)inAngle * 683565276) >> 16);
+}
+
+/* Binary angle, from -1/2 to 1/2 turn, to radians. */
+static inline fix16_t fix16_from_turns(int32_t inTurns)
+{
+	return (fix16_t)(((int64_t)inTurns * 105414357 + ((int64_t)1 << 39)) >> 40);
+}
 
 fix16_t fix16_sin_parabola(fix16_t inAngle)
 {
@@ -44,11 +86,100 @@ fix16_t fix16_sin_parabola(fix16_t inAngle)
 	return retval;
 }
 
+/* sin() from a quarter wave table with 2^bits steps, interpolating
+ * linearly or through three entries. */
+static fix16_t fix16_sin_qlut_interp(fix16_t inAngle, const fix16_t *lut,
+                                     uint32_t bits, int quadratic)
+{
+	uint32_t turns = fix16_to_turns(inAngle);
+	uint32_t pos = (turns & 0x3FFFFFFF) >> (14 - bits);
+
+	/* Second and fourth quarters mirror the first */
+	if(turns & 0x40000000)
+		pos = (1U << (bits + 16)) - pos;
+
+	uint32_t index = pos >> 16;
+	int32_t frac = pos & 0xFFFF;
+	fix16_t y0 = lut[index];
+	fix16_t y1 = lut[index + 1];
+	fix16_t tempOut = y0 + (((y1 - y0) * frac + 0x8000) >> 16);
+	if(quadratic) {
+		fix16_t d2 = lut[index + 2] - 2 * y1 + y0;
+		tempOut += ((((frac * (frac - 0x10000)) >> 17) * d2) + 0x8000) >> 16;
+	}
+
+	return (turns & 0x80000000) ? -tempOut : tempOut;
+}
+
+fix16_t fix16_sin_qlut(fix16_t inAngle)
+{
+	return fix16_sin_qlut_interp(inAngle, _fix16_sin_qlut,
+	                             _FIX16_SIN_QLUT_BITS, 0);
+}
+
+fix16_t fix16_sin_qlut_quadratic(fix16_t inAngle)
+{
+	return fix16_sin_qlut_interp(inAngle, _fix16_sin_qlut_quad,
+	                             _FIX16_SIN_QLUT_QUAD_BITS, 1);
+}
+
+/* Rotate (1, 0) by a binary angle; the results are in Q2.30. */
+static void fix16_cordic_rotate(uint32_t inTurns, int32_t *outCos, int32_t *outSin)
+{
+	int32_t x = 652032874; /* 1/gain, so the result has length 1 */
+	int32_t y = 0;
+	int32_t z;
+	int i, flip = 0;
+
+	/* CORDIC converges up to about +-1/4 turn; rotate the rest by
+	 * half a turn and negate the result. */
+	if((inTurns + 0x40000000) & 0x80000000) {
+		inTurns += 0x80000000;
+		flip = 1;
+	}
+	z = (int32_t)inTurns;
+
+	for(i = 0; i < FIXMATH_CORDIC_ITERATIONS; i++) {
+		int32_t dx = y >> i;
+		int32_t dy = x >> i;
+		if(z >= 0) {
+			x -= dx;
+			y += dy;
+			z -= _fix16_cordic_atan[i];
+		} else {
+			x += dx;
+			y -= dy;
+			z += _fix16_cordic_atan[i];
+		}
+	}
+
+	if(flip) {
+		x = -x;
+		y = -y;
+	}
+	*outCos = x;
+	*outSin = y;
+}
+
+fix16_t fix16_sin_cordic(fix16_t inAngle)
+{
+	int32_t c, s;
+	fix16_cordic_rotate(fix16_to_turns(inAngle), &c, &s);
+	return (s + (1 << 13)) >> 14;
+}
+
+fix16_t fix16_cos_cordic(fix16_t inAngle)
+{
+	int32_t c, s;
+	fix16_cordic_rotate(fix16_to_turns(inAngle), &c, &s);
+	return (c + (1 << 13)) >> 14;
+}
+
 fix16_t fix16_sin(fix16_t inAngle)
 {
+	#if defined(FIXMATH_SIN_LUT)
 	fix16_t tempAngle = inAngle % (fix16_pi << 1);
 
-	#ifdef FIXMATH_SIN_LUT
 	if(tempAngle < 0)
 		tempAngle += (fix16_pi << 1);
 
@@ -63,14 +194,22 @@ fix16_t fix16_sin(fix16_t inAngle)
 			tempAngle = fix16_pi - tempAngle;
 		tempOut = (tempAngle >= _fix16_sin_lut_count ? fix16_one : _fix16_sin_lut[tempAngle]);
 	}
+	#elif defined(FIXMATH_CORDIC)
+	fix16_t tempOut = fix16_sin_cordic(inAngle);
+	#elif defined(FIXMATH_SIN_QLUT_QUADRATIC)
+	fix16_t tempOut = fix16_sin_qlut_quadratic(inAngle);
+	#elif defined(FIXMATH_SIN_QLUT)
+	fix16_t tempOut = fix16_sin_qlut(inAngle);
 	#else
+	fix16_t tempAngle = inAngle % (fix16_pi << 1);
+
 	if(tempAngle > fix16_pi)
 		tempAngle -= (fix16_pi << 1);
 	else if(tempAngle < -fix16_pi)
 		tempAngle += (fix16_pi << 1);
 
 	#ifndef FIXMATH_NO_CACHE
-	fix16_t tempIndex = ((inAngle >> 5) & 0x00000FFF);
+	fix16_t tempIndex = ((inAngle >> 5) & (FIXMATH_CACHE_SIZE - 1));
 	if(_fix16_sin_cache_index[tempIndex] == inAngle)
 		return _fix16_sin_cache_value[tempIndex];
 	#endif
@@ -108,7 +247,11 @@ fix16_t fix16_sin(fix16_t inAngle)
 
 fix16_t fix16_cos(fix16_t inAngle)
 {
+	#ifdef FIXMATH_CORDIC
+	return fix16_cos_cordic(inAngle);
+	#else
 	return fix16_sin(inAngle + (fix16_pi >> 1));
+	#endif
 }
 
 fix16_t fix16_tan(fix16_t inAngle)
@@ -134,18 +277,70 @@ fix16_t fix16_acos(fix16_t x)
 	return ((fix16_pi >> 1) - fix16_asin(x));
 }
 
-fix16_t fix16_atan2(fix16_t inY , fix16_t inX)
+fix16_t fix16_atan2_cordic(fix16_t inY, fix16_t inX)
 {
-	fix16_t abs_inY, mask, angle, r, r_3;
+	int32_t x, y;
+	uint32_t z = 0;
+	uint32_t absX, absY, mag;
+	int i, shift;
+
+	if(inY == 0)
+		return inX < 0 ? fix16_pi : 0;
+
+	/* Scale the vector to 28-29 bits: enough headroom for the CORDIC
+	 * gain, and enough bits for the last iterations to matter. Shift
+	 * the magnitudes, as shifting a negative value left is undefined. */
+	absX = inX < 0 ? -(uint32_t)inX : (uint32_t)inX;
+	absY = inY < 0 ? -(uint32_t)inY : (uint32_t)inY;
+	mag = absX | absY;
+	shift = (int)clz(mag) - 3;
+	if(shift >= 0) {
+		absX <<= shift;
+		absY <<= shift;
+	} else {
+		absX >>= -shift;
+		absY >>= -shift;
+	}
+
+	/* Vectoring converges in the right half plane, so turn a vector
+	 * in the left half by half a turn */
+	x = (int32_t)absX;
+	y = (inY < 0) != (inX < 0) ? -(int32_t)absY : (int32_t)absY;
+	if(inX < 0)
+		z = 0x80000000;
+
+	for(i = 0; i < FIXMATH_CORDIC_ITERATIONS; i++) {
+		int32_t dx = y >> i;
+		int32_t dy = x >> i;
+		if(y > 0) {
+			x += dx;
+			y -= dy;
+			z += _fix16_cordic_atan[i];
+		} else {
+			x -= dx;
+			y += dy;
+			z -= _fix16_cordic_atan[i];
+		}
+	}
 
+	return fix16_from_turns((int32_t)z);
+}
+
+fix16_t fix16_atan2(fix16_t inY , fix16_t inX)
+{
 	#ifndef FIXMATH_NO_CACHE
 	uintptr_t hash = (inX ^ inY);
 	hash ^= hash >> 20;
-	hash &= 0x0FFF;
+	hash &= (FIXMATH_CACHE_SIZE - 1);
 	if((_fix16_atan_cache_index[0][hash] == inX) && (_fix16_atan_cache_index[1][hash] == inY))
 		return _fix16_atan_cache_value[hash];
 	#endif
 
+	#ifdef FIXMATH_CORDIC
+	fix16_t angle = fix16_atan2_cordic(inY, inX);
+	#else
+	fix16_t abs_inY, mask, angle, r, r_3;
+
 	/* Absolute inY */
 	mask = (inY >> (sizeof(fix16_t)*CHAR_BIT-1));
 	abs_inY = (inY + mask) ^ mask;
@@ -166,6 +361,7 @@ fix16_t fix16_atan2(fix16_t inY , fix16_t inX)
 	{
 		angle = -angle;
 	}
+	#endif
 
 	#ifndef FIXMATH_NO_CACHE
 	_fix16_atan_cache_index[0][hash] = inX;
@@ -0,0 +1,63 @@
+#ifndef __fix16_trig_qlut_h__
+#define __fix16_trig_qlut_h__
+
+/* sin() over a quarter wave in 2^bits steps, and a few steps past
+ * pi/2 so that interpolating near the peak needs no special case. */
+
+#define _FIX16_SIN_QLUT_BITS 8
+static const fix16_t _fix16_sin_qlut[259] = {
+	0, 402, 804, 1206, 1608, 2010, 2412, 2814,
+	3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+	6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218,
+	9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+	12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+	15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+	19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+	22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+	25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+	28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+	30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+	33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+	36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+	39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+	41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+	44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+	46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+	48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+	50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+	52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+	54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+	56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+	57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+	59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+	60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+	61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+	62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+	63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+	64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+	64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+	65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+	65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+	65536, 65535, 65531,
+};
+
+#define _FIX16_SIN_QLUT_QUAD_BITS 5
+static const fix16_t _fix16_sin_qlut_quad[35] = {
+	0, 3216, 6424, 9616, 12785, 15924, 19024, 22078,
+	25080, 28020, 30893, 33692, 36410, 39040, 41576, 44011,
+	46341, 48559, 50660, 52639, 54491, 56212, 57798, 59244,
+	60547, 61705, 62714, 63572, 64277, 64827, 65220, 65457,
+	65536, 65457, 65220,
+};
+
+/* atan(2^-i), in 2^32ths of a turn */
+static const int32_t _fix16_cordic_atan[24] = {
+	536870912, 316933406, 167458907, 85004756,
+	42667331, 21354465, 10679838, 5340245,
+	2670163, 1335087, 667544, 333772,
+	166886, 83443, 41722, 20861,
+	10430, 5215, 2608, 1304,
+	652, 326, 163, 81,
+};
+
+#endif
@@ -0,0 +1,363 @@
+/* Fixed-size matrices atop libfixmath fixed point numbers, for C++.
+ *
+ * Matrix<R, C> is the compile-time sized counterpart of mf16: it
+ * stores exactly R x C entries, and the multiply, transpose and
+ * Cholesky kernels are unrolled by template recursion, so they run
+ * without loops, runtime strides or aliasing checks. A 4x4 matrix
+ * takes 68 bytes instead of the 260 of an mf16. The kernels use 64-bit
+ * sums, as fa16_dot() does unless FIXMATH_NO_64BIT is defined.
+ *
+ * Error handling is the same as in fixmatrix.h: each matrix carries
+ * FIXMATRIX_* flags, which results inherit from their operands.
+ *
+ * Destinations must not alias operands, except in the element-wise
+ * functions (add, sub, mul_s) and where noted.
+ */
+
+#ifndef __fixmath_Matrix_h_
+#define __fixmath_Matrix_h_
+
+#include <stdint.h>
+
+#include "../math/fix16.h"
+
+#ifndef FIXMATRIX_OVERFLOW
+#define FIXMATRIX_OVERFLOW 0x01
+#define FIXMATRIX_DIMERR   0x02
+#define FIXMATRIX_USEERR   0x04
+#define FIXMATRIX_SINGULAR 0x08
+#define FIXMATRIX_NEGATIVE 0x10
+#endif
+
+#ifdef __GNUC__
+#define FIXMATRIX_INLINE inline __attribute__((always_inline))
+#else
+#define FIXMATRIX_INLINE inline
+#endif
+
+template <uint8_t R, uint8_t C>
+class Matrix
+{
+public:
+    enum { rows = R, columns = C };
+
+    /* Row-major: entry at (row, column) is data[row][column] */
+    fix16_t data[R][C];
+    uint8_t errors;
+
+    fix16_t &operator()(uint8_t row, uint8_t column) { return data[row][column]; }
+    fix16_t operator()(uint8_t row, uint8_t column) const { return data[row][column]; }
+
+    // Fill all the entries with the same value, and clear error status.
+    void fill(fix16_t value)
+    {
+        for (uint8_t i = 0; i < R; i++)
+            for (uint8_t j = 0; j < C; j++)
+                data[i][j] = value;
+        errors = 0;
+    }
+
+    // Fill the diagonal entries with the given value and everything else
+    // with zeroes, and clear error status.
+    void fill_diagonal(fix16_t value)
+    {
+        fill(0);
+        for (uint8_t i = 0; i < R && i < C; i++)
+            data[i][i] = value;
+    }
+};
+
+namespace fixmatrix_priv
+{
+
+/* Sum of N products, a[k * SA] * b[k * SB], at full precision. */
+template <int N, int SA, int SB>
+struct Dot
+{
+    static FIXMATRIX_INLINE int64_t sum(const fix16_t *a, const fix16_t *b)
+    {
+        return (int64_t)a[0] * b[0] + Dot<N - 1, SA, SB>::sum(a + SA, b + SB);
+    }
+};
+
+template <int SA, int SB>
+struct Dot<0, SA, SB>
+{
+    static FIXMATRIX_INLINE int64_t sum(const fix16_t *, const fix16_t *) { return 0; }
+};
+
+// Round a sum of products back to fix16, as fa16_dot() does.
+static FIXMATRIX_INLINE fix16_t round_sum(int64_t sum, uint8_t &errors)
+{
+    // The upper 17 bits should all be the same (the sign).
+    uint32_t upper = sum >> 47;
+    if (sum < 0)
+    {
+        upper = ~upper;
+
+        #ifndef FIXMATH_NO_ROUNDING
+        // This adjustment is required in order to round -1/2 correctly
+        sum--;
+        #endif
+    }
+
+    #ifndef FIXMATH_NO_OVERFLOW
+    if (upper)
+    {
+        errors |= FIXMATRIX_OVERFLOW;
+        return fix16_overflow;
+    }
+    #endif
+
+    fix16_t result = sum >> 16;
+
+    #ifndef FIXMATH_NO_ROUNDING
+    result += (sum & 0x8000) >> 15;
+    #endif
+
+    return result;
+}
+
+/* Entries I-1 down to 0 of an R x C product with K terms per entry.
+ * Entry (r, c) takes a[r * AR + k * AK] and b[k * BK + c * BC], which
+ * covers a * b, a' * b and a * b'. */
+template <int R, int C, int K, int AR, int AK, int BK, int BC, int I>
+struct Mul
+{
+    static FIXMATRIX_INLINE void run(fix16_t *dest, const fix16_t *a,
+                                     const fix16_t *b, uint8_t &errors)
+    {
+        Mul<R, C, K, AR, AK, BK, BC, I - 1>::run(dest, a, b, errors);
+        const int r = (I - 1) / C, c = (I - 1) % C;
+        dest[I - 1] = round_sum(Dot<K, AK, BK>::sum(a + r * AR, b + c * BC), errors);
+    }
+};
+
+template <int R, int C, int K, int AR, int AK, int BK, int BC>
+struct Mul<R, C, K, AR, AK, BK, BC, 0>
+{
+    static FIXMATRIX_INLINE void run(fix16_t *, const fix16_t *, const fix16_t *, uint8_t &) {}
+};
+
+/* Entries I-1 down to 0 of the transpose of an R x C matrix. */
+template <int R, int C, int I>
+struct Transpose
+{
+    static FIXMATRIX_INLINE void run(fix16_t *dest, const fix16_t *src)
+    {
+        Transpose<R, C, I - 1>::run(dest, src);
+        const int r = (I - 1) / C, c = (I - 1) % C;
+        dest[c * R + r] = src[I - 1];
+    }
+};
+
+template <int R, int C>
+struct Transpose<R, C, 0>
+{
+    static FIXMATRIX_INLINE void run(fix16_t *, const fix16_t *) {}
+};
+
+/* Entry (I, J) of the Cholesky-Banachiewicz algorithm, then the rest
+ * of the lower triangle row by row. */
+template <int N, int I, int J>
+struct Cholesky
+{
+    static FIXMATRIX_INLINE void run(fix16_t *L, const fix16_t *A, uint8_t &errors)
+    {
+        // Aij - sum(Lik Ljk, k = 1..(j-1))
+        int64_t sum = ((int64_t)A[I * N + J] << 16) - Dot<J, 1, 1>::sum(L + I * N, L + J * N);
+        fix16_t value = round_sum(sum, errors);
+
+        if (I == J)
+        {
+            // Ljj = sqrt(...)
+            if (value < 0)
+            {
+                if (value < -65)
+                    errors |= FIXMATRIX_NEGATIVE;
+                value = 0;
+            }
+            L[I * N + I] = fix16_sqrt(value);
+        }
+        else
+        {
+            // Lij = 1/Ljj (...)
+            value = fix16_div(value, L[J * N + J]);
+            if (value == fix16_overflow)
+                errors |= FIXMATRIX_OVERFLOW;
+            L[I * N + J] = value;
+            L[J * N + I] = 0;
+        }
+
+        Cholesky<N, (J < I) ? I : I + 1, (J < I) ? J + 1 : 0>::run(L, A, errors);
+    }
+};
+
+template <int N>
+struct Cholesky<N, N, 0>
+{
+    static FIXMATRIX_INLINE void run(fix16_t *, const fix16_t *, uint8_t &) {}
+};
+
+}
+
+// dest = a * b
+template <uint8_t R, uint8_t K, uint8_t C>
+void mul(Matrix<R, C> &dest, const Matrix<R, K> &a, const Matrix<K, C> &b)
+{
+    dest.errors = a.errors | b.errors;
+    fixmatrix_priv::Mul<R, C, K, K, 1, C, 1, R * C>::run(
+        &dest.data[0][0], &a.data[0][0], &b.data[0][0], dest.errors);
+}
+
+// dest = transpose(at) * b
+template <uint8_t R, uint8_t K, uint8_t C>
+void mul_at(Matrix<R, C> &dest, const Matrix<K, R> &at, const Matrix<K, C> &b)
+{
+    dest.errors = at.errors | b.errors;
+    fixmatrix_priv::Mul<R, C, K, 1, R, C, 1, R * C>::run(
+        &dest.data[0][0], &at.data[0][0], &b.data[0][0], dest.errors);
+}
+
+// dest = a * transpose(bt)
+template <uint8_t R, uint8_t K, uint8_t C>
+void mul_bt(Matrix<R, C> &dest, const Matrix<R, K> &a, const Matrix<C, K> &bt)
+{
+    dest.errors = a.errors | bt.errors;
+    fixmatrix_priv::Mul<R, C, K, K, 1, 1, K, R * C>::run(
+        &dest.data[0][0], &a.data[0][0], &bt.data[0][0], dest.errors);
+}
+
+// dest = transpose(matrix)
+template <uint8_t R, uint8_t C>
+void transpose(Matrix<C, R> &dest, const Matrix<R, C> &matrix)
+{
+    dest.errors = matrix.errors;
+    fixmatrix_priv::Transpose<R, C, R * C>::run(&dest.data[0][0], &matrix.data[0][0]);
+}
+
+// In addition and subtraction, a = dest and b = dest are allowed.
+template <uint8_t R, uint8_t C>
+void add(Matrix<R, C> &dest, const Matrix<R, C> &a, const Matrix<R, C> &b)
+{
+    dest.errors = a.errors | b.errors;
+    for (uint8_t i = 0; i < R; i++)
+    {
+        for (uint8_t j = 0; j < C; j++)
+        {
+            fix16_t sum = fix16_add(a.data[i][j], b.data[i][j]);
+            if (sum == fix16_overflow)
+                dest.errors |= FIXMATRIX_OVERFLOW;
+            dest.data[i][j] = sum;
+        }
+    }
+}
+
+template <uint8_t R, uint8_t C>
+void sub(Matrix<R, C> &dest, const Matrix<R, C> &a, const Matrix<R, C> &b)
+{
+    dest.errors = a.errors | b.errors;
+    for (uint8_t i = 0; i < R; i++)
+    {
+        for (uint8_t j = 0; j < C; j++)
+        {
+            fix16_t diff = fix16_sub(a.data[i][j], b.data[i][j]);
+            if (diff == fix16_overflow)
+                dest.errors |= FIXMATRIX_OVERFLOW;
+            dest.data[i][j] = diff;
+        }
+    }
+}
+
+// matrix and dest can alias.
+template <uint8_t R, uint8_t C>
+void mul_s(Matrix<R, C> &dest, const Matrix<R, C> &matrix, fix16_t scalar)
+{
+    dest.errors = matrix.errors;
+    for (uint8_t i = 0; i < R; i++)
+    {
+        for (uint8_t j = 0; j < C; j++)
+        {
+            fix16_t value = fix16_mul(matrix.data[i][j], scalar);
+            if (value == fix16_overflow)
+                dest.errors |= FIXMATRIX_OVERFLOW;
+            dest.data[i][j] = value;
+        }
+    }
+}
+
+// Cholesky decomposition of a symmetric positive-definite matrix, as
+// mf16_cholesky(): finds lower triangular L so that L L' = A. Only the
+// lower left triangle of A is used. Dest and matrix can alias.
+template <uint8_t N>
+void cholesky(Matrix<N, N> &dest, const Matrix<N, N> &matrix)
+{
+    dest.errors = matrix.errors;
+    fixmatrix_priv::Cholesky<N, 0, 0>::run(&dest.data[0][0], &matrix.data[0][0], dest.errors);
+}
+
+// Solve A x = b, given the Cholesky factor L of A, by forward and back
+// substitution. b may have several columns, which are solved
+// independently. Dest and b can alias.
+template <uint8_t N, uint8_t C>
+void cholesky_solve(Matrix<N, C> &dest, const Matrix<N, N> &L, const Matrix<N, C> &b)
+{
+    uint8_t errors = L.errors | b.errors;
+
+    for (uint8_t c = 0; c < C; c++)
+    {
+        // L y = b
+        for (uint8_t i = 0; i < N; i++)
+        {
+            int64_t sum = (int64_t)b.data[i][c] << 16;
+            for (uint8_t k = 0; k < i; k++)
+                sum -= (int64_t)L.data[i][k] * dest.data[k][c];
+            dest.data[i][c] = fix16_div(fixmatrix_priv::round_sum(sum, errors), L.data[i][i]);
+        }
+
+        // L' x = y
+        for (int8_t i = N - 1; i >= 0; i--)
+        {
+            int64_t sum = (int64_t)dest.data[i][c] << 16;
+            for (uint8_t k = i + 1; k < N; k++)
+                sum -= (int64_t)L.data[k][i] * dest.data[k][c];
+            dest.data[i][c] = fix16_div(fixmatrix_priv::round_sum(sum, errors), L.data[i][i]);
+        }
+    }
+
+    for (uint8_t i = 0; i < N; i++)
+    {
+        if (L.data[i][i] == 0)
+            errors |= FIXMATRIX_SINGULAR;
+        for (uint8_t c = 0; c < C; c++)
+            if (dest.data[i][c] == fix16_overflow)
+                errors |= FIXMATRIX_OVERFLOW;
+    }
+    dest.errors = errors;
+}
+
+template <uint8_t R, uint8_t K, uint8_t C>
+Matrix<R, C> operator*(const Matrix<R, K> &a, const Matrix<K, C> &b)
+{
+    Matrix<R, C> dest;
+    mul(dest, a, b);
+    return dest;
+}
+
+template <uint8_t R, uint8_t C>
+Matrix<R, C> operator+(const Matrix<R, C> &a, const Matrix<R, C> &b)
+{
+    Matrix<R, C> dest;
+    add(dest, a, b);
+    return dest;
+}
+
+template <uint8_t R, uint8_t C>
+Matrix<R, C> operator-(const Matrix<R, C> &a, const Matrix<R, C> &b)
+{
+    Matrix<R, C> dest;
+    sub(dest, a, b);
+    return dest;
+}
+
+#endif
@@ -37,24 +37,41 @@ fix16_t fa16_dot(const fix16_t *a, uint_fast8_t a_stride,
 // it has a specialized 64-bit routine in addition to the normal
 // fix16_mul()-based one. This is especially efficient on ARM processors
 // which have SMLAL instruction.
-fix16_t fa16_dot(const fix16_t *a, uint_fast8_t a_stride,
-                 const fix16_t *b, uint_fast8_t b_stride,
-                 uint_fast8_t n)
+#if defined(__GNUC__) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+static inline int64_t fa16_mac(int64_t acc, fix16_t a, fix16_t b)
 {
-    int64_t sum = 0;
-    
-    while (n--)
+    __asm__ ("smlal %Q0, %R0, %1, %2" : "+r" (acc) : "r" (a), "r" (b));
+    return acc;
+}
+#else
+static inline int64_t fa16_mac(int64_t acc, fix16_t a, fix16_t b)
+{
+    return acc + (int64_t)a * b;
+}
+#endif
+
+int64_t fa16_dot_acc(int64_t acc, const fix16_t *a, const fix16_t *b,
+                     uint_fast8_t n)
+{
+    while (n >= 4)
     {
-        if (*a != 0 && *b != 0)
-        {
-            sum += (int64_t)(*a) * (*b);
-        }
-        
-        // Go to next item
-        a += a_stride;
-        b += b_stride;
+        acc = fa16_mac(acc, a[0], b[0]);
+        acc = fa16_mac(acc, a[1], b[1]);
+        acc = fa16_mac(acc, a[2], b[2]);
+        acc = fa16_mac(acc, a[3], b[3]);
+        a += 4;
+        b += 4;
+        n -= 4;
     }
-    
+
+    while (n--)
+        acc = fa16_mac(acc, *a++, *b++);
+
+    return acc;
+}
+
+fix16_t fa16_from_acc(int64_t sum)
+{
     // The upper 17 bits should all be the same (the sign).
     uint32_t upper = sum >> 47;
     if (sum < 0)
@@ -80,6 +97,27 @@ fix16_t fa16_dot(const fix16_t *a, uint_fast8_t a_stride,
     
     return result;
 }
+
+fix16_t fa16_dot(const fix16_t *a, uint_fast8_t a_stride,
+                 const fix16_t *b, uint_fast8_t b_stride,
+                 uint_fast8_t n)
+{
+    int64_t sum = 0;
+    
+    if (a_stride == 1 && b_stride == 1)
+        return fa16_from_acc(fa16_dot_acc(0, a, b, n));
+    
+    while (n--)
+    {
+        sum = fa16_mac(sum, *a, *b);
+        
+        // Go to next item
+        a += a_stride;
+        b += b_stride;
+    }
+    
+    return fa16_from_acc(sum);
+}
 #endif
 
 #ifdef __GNUC__
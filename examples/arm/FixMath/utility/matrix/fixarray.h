@@ -11,6 +11,17 @@ fix16_t fa16_dot(const fix16_t *a, uint_fast8_t a_stride,
                  const fix16_t *b, uint_fast8_t b_stride,
                  uint_fast8_t n);
 
+#ifndef FIXMATH_NO_64BIT
+// Adds the products of two contiguous vectors of size n to acc, a sum
+// with 32 fractional bits, without rounding or overflow in between.
+int64_t fa16_dot_acc(int64_t acc, const fix16_t *a, const fix16_t *b,
+                     uint_fast8_t n);
+
+// Rounds a sum from fa16_dot_acc() to fix16_t.
+// If it doesn't fit, returns fix16_overflow.
+fix16_t fa16_from_acc(int64_t sum);
+#endif
+
 // Calculates the norm of a vector of size n.
 fix16_t fa16_norm(const fix16_t *a, uint_fast8_t a_stride, uint_fast8_t n);
 
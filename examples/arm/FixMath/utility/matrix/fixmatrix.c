@@ -1,4 +1,5 @@
-#include "../../fixmath.h"
+#include "fixmatrix.h"
+#include "fixarray.h"
 
 
 /****************************
@@ -33,92 +34,123 @@ void mf16_fill_diagonal(mf16 *dest, fix16_t value)
  * Operations between 2 matrices *
  *********************************/
 
-void mf16_mul(mf16 *dest, const mf16 *a, const mf16 *b)
+// Common kernel of the multiplications: dest = a * b, dest += a * b or
+// dest -= a * b, where a may be given transposed (at) and b transposed (bt).
+// Each column of b is copied to a contiguous buffer once, and at is
+// transposed once, so that all the dot products run over contiguous rows.
+#define MF16_MUL_AT 1
+#define MF16_MUL_BT 2
+
+#define MF16_MUL_SET 0
+#define MF16_MUL_ADD 1
+#define MF16_MUL_SUB 2
+
+static void mf16_mul_kernel(mf16 *dest, const mf16 *a, const mf16 *b,
+                            uint8_t transposed, uint8_t op)
 {
-    int row, column;
+    int row, column, k;
+    int rows, columns, n;
+    fix16_t bcolumn[FIXMATRIX_MAX_SIZE];
+    const fix16_t *bptr;
 
     // If dest and input matrices alias, we have to use a temp matrix.
     mf16 tmp;
     fa16_unalias(dest, (void**)&a, (void**)&b, &tmp, sizeof(tmp));
 
-    dest->errors = a->errors | b->errors;
+    rows = (transposed & MF16_MUL_AT) ? a->columns : a->rows;
+    n = (transposed & MF16_MUL_AT) ? a->rows : a->columns;
+    columns = (transposed & MF16_MUL_BT) ? b->rows : b->columns;
 
-    if (a->columns != b->rows)
-        dest->errors |= FIXMATRIX_DIMERR;
+    if (op == MF16_MUL_SET)
+        dest->errors = 0;
 
-    dest->rows = a->rows;
-    dest->columns = b->columns;
+    dest->errors |= a->errors | b->errors;
 
-    for (row = 0; row < dest->rows; row++) {
-        for (column = 0; column < dest->columns; column++) {
-            dest->data[row][column] = fa16_dot(
-                                          &a->data[row][0], 1,
-                                          &b->data[0][column], FIXMATRIX_MAX_SIZE,
-                                          a->columns);
+    if (n != ((transposed & MF16_MUL_BT) ? b->columns : b->rows))
+        dest->errors |= FIXMATRIX_DIMERR;
 
-            if (dest->data[row][column] == fix16_overflow)
-                dest->errors |= FIXMATRIX_OVERFLOW;
-        }
+    if (op == MF16_MUL_SET)
+    {
+        dest->rows = rows;
+        dest->columns = columns;
     }
-}
-
-// Multiply transpose of at with b
-void mf16_mul_at(mf16 *dest, const mf16 *at, const mf16 *b)
-{
-    int row, column;
-
-    // If dest and input matrices alias, we have to use a temp matrix.
-    mf16 tmp;
-    fa16_unalias(dest, (void**)&at, (void**)&b, &tmp, sizeof(tmp));
-
-    dest->errors = at->errors | b->errors;
-
-    if (at->rows != b->rows)
+    else if (dest->rows != rows || dest->columns != columns)
+    {
         dest->errors |= FIXMATRIX_DIMERR;
+        return;
+    }
 
-    dest->rows = at->columns;
-    dest->columns = b->columns;
+    mf16 at;
+    if (transposed & MF16_MUL_AT)
+    {
+        mf16_transpose(&at, a);
+        a = &at;
+    }
 
-    for (row = 0; row < dest->rows; row++) {
-        for (column = 0; column < dest->columns; column++) {
-            dest->data[row][column] = fa16_dot(
-                                          &at->data[0][row], FIXMATRIX_MAX_SIZE,
-                                          &b->data[0][column], FIXMATRIX_MAX_SIZE,
-                                          at->rows);
+    for (column = 0; column < columns; column++) {
+        if (transposed & MF16_MUL_BT)
+        {
+            bptr = &b->data[column][0];
+        }
+        else
+        {
+            for (k = 0; k < n; k++)
+                bcolumn[k] = b->data[k][column];
+            bptr = bcolumn;
+        }
+
+        for (row = 0; row < rows; row++) {
+            fix16_t *cell = &dest->data[row][column];
+            fix16_t value;
+
+#ifndef FIXMATH_NO_64BIT
+            value = fa16_from_acc(fa16_dot_acc(0, &a->data[row][0], bptr, n));
+#else
+            value = fa16_dot(&a->data[row][0], 1, bptr, 1, n);
+#endif
+
+            // Round the product before adding it to dest, so the result
+            // is the same as mf16_mul() followed by mf16_add()/mf16_sub().
+            if (value != fix16_overflow)
+            {
+                if (op == MF16_MUL_ADD)
+                    value = fix16_add(*cell, value);
+                else if (op == MF16_MUL_SUB)
+                    value = fix16_sub(*cell, value);
+            }
 
-            if (dest->data[row][column] == fix16_overflow)
+            if (value == fix16_overflow)
                 dest->errors |= FIXMATRIX_OVERFLOW;
+
+            *cell = value;
         }
     }
 }
 
-void mf16_mul_bt(mf16 *dest, const mf16 *a, const mf16 *bt)
+void mf16_mul(mf16 *dest, const mf16 *a, const mf16 *b)
 {
-    int row, column;
-
-    // If dest and input matrices alias, we have to use a temp matrix.
-    mf16 tmp;
-    fa16_unalias(dest, (void**)&a, (void**)&bt, &tmp, sizeof(tmp));
-
-    dest->errors = a->errors | bt->errors;
+    mf16_mul_kernel(dest, a, b, 0, MF16_MUL_SET);
+}
 
-    if (a->columns != bt->columns)
-        dest->errors |= FIXMATRIX_DIMERR;
+// Multiply transpose of at with b
+void mf16_mul_at(mf16 *dest, const mf16 *at, const mf16 *b)
+{
+    mf16_mul_kernel(dest, at, b, MF16_MUL_AT, MF16_MUL_SET);
+}
 
-    dest->rows = a->rows;
-    dest->columns = bt->rows;
+void mf16_mul_bt(mf16 *dest, const mf16 *a, const mf16 *bt)
+{
+    mf16_mul_kernel(dest, a, bt, MF16_MUL_BT, MF16_MUL_SET);
+}
 
-    for (row = 0; row < dest->rows; row++) {
-        for (column = 0; column < dest->columns; column++) {
-            dest->data[row][column] = fa16_dot(
-                                          &a->data[row][0], 1,
-                                          &bt->data[column][0], 1,
-                                          a->columns);
+void mf16_mul_add(mf16 *dest, const mf16 *a, const mf16 *b)
+{
+    mf16_mul_kernel(dest, a, b, 0, MF16_MUL_ADD);
+}
 
-            if (dest->data[row][column] == fix16_overflow)
-                dest->errors |= FIXMATRIX_OVERFLOW;
-        }
-    }
+void mf16_mul_sub(mf16 *dest, const mf16 *a, const mf16 *b)
+{
+    mf16_mul_kernel(dest, a, b, 0, MF16_MUL_SUB);
 }
 
 static void mf16_addsub(mf16 *dest, const mf16 *a, const mf16 *b, uint8_t add)
@@ -26,7 +26,12 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "../../fixmath.h"
+#include "../math/fix16.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
 
 // Maximum size of matrices.
 #ifndef FIXMATRIX_MAX_SIZE
@@ -77,6 +82,12 @@ void mf16_mul_at(mf16 *dest, const mf16 *at, const mf16 *b);
 // Multiply a with transpose of bt
 void mf16_mul_bt(mf16 *dest, const mf16 *a, const mf16 *bt);
 
+// dest += a * b and dest -= a * b, with the same result as mf16_mul()
+// followed by mf16_add() or mf16_sub() but no temporary matrix.
+// dest must already have the dimensions of the product.
+void mf16_mul_add(mf16 *dest, const mf16 *a, const mf16 *b);
+void mf16_mul_sub(mf16 *dest, const mf16 *a, const mf16 *b);
+
 // In addition and subtraction, a = dest and b = dest are allowed.
 void mf16_add(mf16 *dest, const mf16 *a, const mf16 *b);
 void mf16_sub(mf16 *dest, const mf16 *a, const mf16 *b);
@@ -151,4 +162,8 @@ void mf16_cholesky(mf16 *dest, const mf16 *matrix);
 // Dest and matrix can alias.
 void mf16_invert_lt(mf16 *dest, const mf16 *matrix);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -3,7 +3,7 @@
 #ifndef _FIXQUAT_H_
 #define _FIXQUAT_H_
 
-#include "../../fixmath.h"
+#include "fixmatrix.h"
 #include "fixvector3d.h"
 
 typedef struct {
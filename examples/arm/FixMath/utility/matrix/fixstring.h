@@ -4,7 +4,7 @@
 #define _FIXSTRING_H_
 
 #include <stdio.h>
-#include "../../fixmath.h"
+#include "fixmatrix.h"
 #include "fixquat.h"
 #include "fixvector3d.h"
 #include "fixvector2d.h"
@@ -5,6 +5,7 @@
 #include "lcd7920_STM.h"
 #include <pins_arduino.h>
 #include <avr/interrupt.h>
+#include <libmaple/dwt.h>
 
 // LCD basic instructions. These all take 72us to execute except LcdDisplayClear, which takes 1.6ms
 const uint8_t LcdDisplayClear = 0x01;
@@ -26,10 +27,14 @@ const unsigned int LcdCommandDelayMicros = 2;
 const unsigned int LcdDataDelayMicros = 2;// 10;         // Delay between sending data bytes
 const unsigned int LcdDisplayClearDelayMillis = 2;  // 1.6ms should be enough
 
+// ST7920 serial timing: SCLK high and low for at least 200ns each, so
+// allow 250ns per half clock in CPU cycles
+const uint32_t LcdHalfClockCycles = (F_CPU / 1000000 * 250 + 999) / 1000;
+
 const unsigned int numRows = 64;
 const unsigned int numCols = 128;
 
-Lcd7920::Lcd7920(uint8_t cPin, uint8_t dPin, bool spi) : clockPin(cPin), dataPin(dPin), useSpi(spi), currentFont(0), textInverted(false)
+Lcd7920::Lcd7920(uint8_t cPin, uint8_t dPin, bool spi) : clockPin(cPin), dataPin(dPin), clockOut(cPin), dataOut(dPin), useSpi(spi), currentFont(0), textInverted(false)
 {
 }
 
@@ -464,13 +469,19 @@ void Lcd7920::sendLcdSlow(uint8_t data)
 
   #else
   */
-  // really slow version, like Arduino shiftOut function
+  // Bit-banged, like Arduino shiftOut function. The pin changes are
+  // single stores, so the ST7920's minimum clock pulse widths are kept
+  // by counting CPU cycles rather than by slow pin changes.
 
+  uint32_t start = dwt_cycles();
   for (uint8_t i = 0; i < 8; ++i) {
-    digitalWrite(dataPin, (data & 0x80) ? HIGH : LOW);
-    //  mosifast((data & 0x80) ? HIGH : LOW); // faster
-    digitalWrite(clockPin, HIGH); // do not change to high speed!
-    digitalWrite(clockPin, LOW); // do not change to high speed pin change!
+    dataOut.write(data & 0x80);
+    while (dwt_cycles() - start < LcdHalfClockCycles) { }
+    clockOut.set();
+    start = dwt_cycles();
+    while (dwt_cycles() - start < LcdHalfClockCycles) { }
+    clockOut.clear();
+    start = dwt_cycles();
 
     data <<= 1;
 
@@ -45,6 +45,8 @@ public:
   // Returns the number of characters written (1 if we wrote it, 0 otherwise)
   virtual size_t write(uint8_t c);                 // write a character
 
+  using Print::write;
+
   // Initialize the display. Call this in setup(). If using graphics mode, also call setFont to select initial text font.
   //  gmode = true to use graphics mode, false to use ST7920 alphanumeric mode.
   void begin(bool gmode);
@@ -111,6 +113,7 @@ private:
   bool useSpi;
   bool textInverted;
   uint8_t clockPin, dataPin;
+  FastPin clockOut, dataOut;                  // the same pins, resolved once for sendLcdSlow()
   uint16_t lastCharColData;                   // data for the last non-space column, used for kerning
   uint8_t row, column;
   uint8_t startRow, startCol, endRow, endCol; // coordinates of the dirty rectangle
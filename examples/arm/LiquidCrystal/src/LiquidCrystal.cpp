@@ -71,6 +71,11 @@ void LiquidCrystal::init(uint8 fourbitmode, uint8 rs, uint8 rw, uint8 enable,
   _data_pins[7] = d7;
     displaymode=fourbitmode;
 
+  _rs.attach(rs);
+  _rw.attach(rw);
+  _enable.attach(enable);
+  _data.attach(_data_pins, fourbitmode ? 4 : 8);
+
   if (fourbitmode)
     _displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
   else
@@ -282,16 +287,32 @@ inline size_t LiquidCrystal::write(uint8 value) {
     return 1;
 }
 
+// Like send(), but RS and RW are set once for the whole string
+size_t LiquidCrystal::write(const void *buf, uint32 len) {
+  const uint8 *data = (const uint8 *)buf;
+
+  _rs.set();
+  _rw.clear();
+  for (uint32 i = 0; i < len; i++) {
+    if (_displayfunction & LCD_8BITMODE) {
+      write8bits(data[i]);
+    } else {
+      write4bits(data[i]>>4);
+      write4bits(data[i]);
+    }
+  }
+  return len;
+}
+
 /************ low level data pushing commands **********/
 
 // write either command or data, with automatic 4/8-bit selection
 void LiquidCrystal::send(uint8 value, uint8 mode) {
-  digitalWrite(_rs_pin, mode);
+  _rs.write(mode);
 
-  // if there is a RW pin indicated, set it low to Write
-  if (_rw_pin != 255) {
-    digitalWrite(_rw_pin, LOW);
-  }
+  // if there is a RW pin indicated, set it low to Write (an unattached
+  // one ignores this)
+  _rw.clear();
 
   if (_displayfunction & LCD_8BITMODE) {
     write8bits(value);
@@ -304,33 +325,30 @@ void LiquidCrystal::send(uint8 value, uint8 mode) {
 void LiquidCrystal::pulseEnable(void) {
   // _enable_pin should already be LOW (unless someone else messed
   // with it), so don't sit around waiting for long.
-  digitalWrite(_enable_pin, LOW);
+  _enable.clear();
   delayMicroseconds(1);
 
   // Enable pulse must be > 450 ns.  Value chosen here according to
   // the following threads:
   // http://forums.leaflabs.com/topic.php?id=640
   // http://forums.leaflabs.com/topic.php?id=512
-  gpio_toggle_bit(PIN_MAP[_enable_pin].gpio_device, PIN_MAP[_enable_pin].gpio_bit);// togglePin(_enable_pin);
+  _enable.set();
   delayMicroseconds(1);
-  gpio_toggle_bit(PIN_MAP[_enable_pin].gpio_device, PIN_MAP[_enable_pin].gpio_bit);// togglePin(_enable_pin);
+  _enable.clear();
 
   // Commands needs > 37us to settle.
   delayMicroseconds(42);
 }
 
+// The data pins change together when they share a port
 void LiquidCrystal::write4bits(uint8 value) {
-  for (int i = 0; i < 4; i++) {
-    digitalWrite(_data_pins[i], (value >> i) & 0x01);
-  }
+  _data.write(value & 0x0F);
 
   pulseEnable();
 }
 
 void LiquidCrystal::write8bits(uint8 value) {
-  for (int i = 0; i < 8; i++) {
-    digitalWrite(_data_pins[i], (value >> i) & 0x01);
-  }
+  _data.write(value);
 
   pulseEnable();
 }
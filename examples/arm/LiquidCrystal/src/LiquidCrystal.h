@@ -80,6 +80,8 @@ public:
   void createChar(uint8, uint8[]);
   void setCursor(uint8, uint8);
   virtual size_t write(uint8);
+  virtual size_t write(const void *buf, uint32 len);
+  using Print::write;
   void command(uint8);
 
 private:
@@ -94,6 +96,12 @@ private:
   uint8 _enable_pin; // activated by a HIGH pulse.
   uint8 _data_pins[8];
 
+  // The same pins, resolved once for the data pushing functions
+  FastPin _rs;
+  FastPin _rw;      // unattached if there is no RW pin
+  FastPin _enable;
+  PinGroup _data;
+
   uint8 _displayfunction;
   uint8 _displaycontrol;
   uint8 _displaymode;
@@ -0,0 +1,65 @@
+/**
+    SPI transaction queue example
+
+    Description:
+    Two devices share SPI_1: a SPI flash on PA4 and a display on PB0.
+    Each loop queues a flash read (command + address, then 16 data bytes,
+    all under one chip select) and a display update at a different
+    clock and mode. The jobs run back to back from the DMA interrupt
+    while loop() is free to do other work; the SPI is only reconfigured
+    when switching between the two devices.
+
+    SCK   <-->  PA5 <-->  BOARD_SPI1_SCK_PIN
+    MISO  <-->  PA6 <-->  BOARD_SPI1_MISO_PIN
+    MOSI  <-->  PA7 <-->  BOARD_SPI1_MOSI_PIN
+*/
+
+#include <SPI.h>
+
+#define FLASH_CS_PIN   PA4
+#define DISPLAY_CS_PIN PB0
+
+uint8 flashCmd[4] = { 0x03, 0x00, 0x00, 0x00 };   // READ from address 0
+uint8 flashData[16];
+uint8 pixels[64];
+
+SPIDescriptor flashBufs[] = {
+  { flashCmd, 0, sizeof(flashCmd) },
+  { 0, flashData, sizeof(flashData) },
+};
+SPIDescriptor displayBufs[] = {
+  { pixels, 0, sizeof(pixels) },
+};
+
+volatile bool flashDone;
+
+void flashRead(SPITransaction *job) {
+  flashDone = true;
+}
+
+SPITransaction flashJob(SPISettings(18000000, MSBFIRST, SPI_MODE0), FLASH_CS_PIN, flashBufs, 2, flashRead);
+SPITransaction displayJob(SPISettings(4000000, MSBFIRST, SPI_MODE3), DISPLAY_CS_PIN, displayBufs, 1);
+
+void setup() {
+  Serial.begin(115200);
+  SPI.begin();
+}
+
+void loop() {
+  flashDone = false;
+  SPI.queue(&flashJob);
+  SPI.queue(&displayJob);
+
+  while (!flashDone)
+    ;   // Could be doing something useful here
+  Serial.print("flash: ");
+  for (unsigned i = 0; i < sizeof(flashData); i++) {
+    Serial.print(flashData[i], HEX);
+    Serial.print(' ');
+  }
+  Serial.println();
+
+  SPI.waitForCompletion();
+  pixels[0]++;
+  delay(500);
+}
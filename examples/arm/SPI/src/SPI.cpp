@@ -148,17 +148,25 @@ SPIClass::SPIClass(uint32 spi_num)
 /*
  * Set up/tear down
  */
+/* The CR1 value spi_master_enable() would load for s */
+uint32 SPIClass::masterConfig(const SPISettings *s)
+{
+	uint32 flags = ((s->bitOrder == MSBFIRST ? SPI_FRAME_MSB : SPI_FRAME_LSB) | SPI_DFF_8_BIT | SPI_SW_SLAVE | SPI_SOFT_SS);
+	return s->clockDivider | flags | SPI_CR1_MSTR | s->dataMode;
+}
+
 void SPIClass::updateSettings(void)
 {
-	uint32 flags = ((_currentSetting->bitOrder == MSBFIRST ? SPI_FRAME_MSB : SPI_FRAME_LSB) | SPI_DFF_8_BIT | SPI_SW_SLAVE | SPI_SOFT_SS);
+	uint32 cr1 = masterConfig(_currentSetting);
 #ifdef SPI_DEBUG
-	Serial.print("spi_master_enable("); Serial.print(_currentSetting->clockDivider); Serial.print(","); Serial.print(_currentSetting->dataMode); Serial.print(","); Serial.print(flags); Serial.println(")");
+	Serial.print("spi_reconfigure("); Serial.print(cr1); Serial.println(")");
 #endif
-	spi_master_enable(_currentSetting->spi_d, (spi_baud_rate)_currentSetting->clockDivider, (spi_mode)_currentSetting->dataMode, flags);
+	spi_reconfigure(_currentSetting->spi_d, cr1);
 }
 
 void SPIClass::begin(void)
 {
+	waitForCompletion();
 	spi_init(_currentSetting->spi_d);
 	configure_gpios(_currentSetting->spi_d, 1);
 	updateSettings();
@@ -185,6 +193,14 @@ void SPIClass::end(void)
 		return;
 	}
 
+	waitForCompletion();
+	if (currentPort()->settings == _currentSetting) {
+		// Give the channels back to whoever else shares them
+		dma_detach_interrupt(_currentSetting->spiDmaDev, _currentSetting->spiRxDmaChannel);
+		dma_detach_interrupt(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
+		currentPort()->settings = NULL;
+	}
+
 	// Follows RM0008's sequence for disabling a SPI in master/slave
 	// full duplex mode.
 	while (spi_is_rx_nonempty(_currentSetting->spi_d)) {
@@ -205,6 +221,7 @@ void SPIClass::setClockDivider(uint32_t clockDivider)
 	Serial.print("Clock divider set to "); Serial.println(clockDivider);
 #endif
 	_currentSetting->clockDivider = clockDivider;
+	_currentSetting->clock = 0; // No longer matches clockDivider
 	updateSettings();
 }
 
@@ -267,25 +284,36 @@ void SPIClass::setDataMode(uint8_t dataMode)
 }
 
 
+/*
+ * Only touches the hardware when settings differ from the current
+ * configuration, so back-to-back transactions with one device are cheap.
+ */
 void SPIClass::beginTransaction(uint8_t pin, SPISettings settings)
 {
-#ifdef SPI_DEBUG
-	Serial.println("SPIClass::beginTransaction");
-#endif
+	SPISettings *s = _currentSetting;
+
 	//_SSPin=pin;
 	//pinMode(_SSPin,OUTPUT);
 	//digitalWrite(_SSPin,LOW);
-	setBitOrder(settings.bitOrder);
-	setDataMode(settings.dataMode);
-	setClockDivider(determine_baud_rate(_currentSetting->spi_d, settings.clock));
-	begin();
+	waitForCompletion();
+	if (settings.clock != s->clock) {
+		s->clock = settings.clock;
+		s->clockDivider = determine_baud_rate(s->spi_d, settings.clock);
+	}
+	s->bitOrder = settings.bitOrder;
+	s->dataMode = settings.dataMode;
+	if (!spi_is_enabled(s->spi_d)) {
+		begin();
+		return;
+	}
+	uint32 cr1 = masterConfig(s);
+	if ((s->spi_d->regs->CR1 & ~SPI_CR1_SPE) != cr1) {
+		spi_reconfigure(s->spi_d, cr1);
+	}
 }
 
 void SPIClass::endTransaction(void)
 {
-#ifdef SPI_DEBUG
-	Serial.println("SPIClass::endTransaction");
-#endif
 	//digitalWrite(_SSPin,HIGH);
 #if false
 	// code from SAM core
@@ -377,132 +405,370 @@ uint8 SPIClass::transfer(uint8 byte) const
 	while (spi_is_busy(_currentSetting->spi_d) != 0); // "... and then wait until BSY=0 before disabling the SPI."
 	return b;
 }
-/*  Roger Clark and Victor Perez, 2015
-*	Performs a DMA SPI transfer with at least a receive buffer.
-*	If a TX buffer is not provided, FF is sent over and over for the lenght of the transfer.
-*	On exit TX buffer is not modified, and RX buffer cotains the received data.
-*	Still in progress.
-*/
-uint8 SPIClass::dmaTransfer(uint8 *transmitBuf, uint8 *receiveBuf, uint16 length)
+/*
+ * DMA
+ *
+ * The tubes are pointed at the data register once per begin(); a
+ * transfer then only sets the memory address, count and a few CCR
+ * bits. Completion is always signalled by the RX tube's
+ * transfer-complete interrupt: the last frame has then been clocked
+ * in, so the bus is idle. A transmit-only transfer reads into a
+ * scratch word rather than ending on the TX tube, which finishes up
+ * to two frames early and would leave the interrupt waiting them out.
+ */
+
+SPIClass::PortState SPIClass::_ports[BOARD_NR_SPI];
+
+template <uint8 port> void SPIClass::dmaIrq(void)
+{
+	PortState *p = &_ports[port];
+	SPISettings *s = p->settings;
+	if (!s || !p->dmaBusy) {
+		return;
+	}
+	uint8 bits = (dma_get_isr_bits(s->spiDmaDev, s->spiRxDmaChannel) |
+	              dma_get_isr_bits(s->spiDmaDev, s->spiTxDmaChannel));
+	dma_clear_isr_bits(s->spiDmaDev, s->spiRxDmaChannel);
+	dma_clear_isr_bits(s->spiDmaDev, s->spiTxDmaChannel);
+	dmaFinish(p, (bits & 0x8) ? 1 : 0); // TEIF
+}
+
+/* A tube is taken while enabled or while someone else handles its
+ * interrupts, like a serial port between transmissions. */
+static bool dma_tube_free(dma_dev *dev, dma_tube tube, void (*handler)(void))
+{
+	void (*owner)(void) = dev->handlers[tube - 1].handler;
+	return !dma_is_enabled(dev, tube) && (!owner || owner == handler);
+}
+
+/* Claim the port's DMA tubes on its first DMA transfer. */
+bool SPIClass::dmaClaim(void)
+{
+	static uint8 dummy;
+	SPISettings *s = _currentSetting;
+	uint8 port = s - _settings;
+	dma_tube_config cfg;
+
+	if (_ports[port].settings == s) {
+		return true;
+	}
+
+	void (*handler)(void) = NULL;
+	switch (port) {
+#if BOARD_NR_SPI >= 1
+	case 0: handler = &SPIClass::dmaIrq<0>; break;
+#endif
+#if BOARD_NR_SPI >= 2
+	case 1: handler = &SPIClass::dmaIrq<1>; break;
+#endif
+#if BOARD_NR_SPI >= 3
+	case 2: handler = &SPIClass::dmaIrq<2>; break;
+#endif
+	}
+
+	dma_init(s->spiDmaDev);
+	if (!dma_tube_free(s->spiDmaDev, s->spiRxDmaChannel, handler) ||
+	    !dma_tube_free(s->spiDmaDev, s->spiTxDmaChannel, handler)) {
+		return false;
+	}
+
+	cfg.tube_src = &s->spi_d->regs->DR;
+	cfg.tube_src_size = DMA_SIZE_8BITS;
+	cfg.tube_dst = &dummy;
+	cfg.tube_dst_size = DMA_SIZE_8BITS;
+	cfg.tube_nr_xfers = 1;
+	cfg.tube_flags = 0;
+	cfg.target_data = NULL;
+	cfg.tube_req_src = (dma_request_src)((s->spiDmaDev->clk_id << 3) | s->spiRxDmaChannel);
+	if (dma_tube_cfg(s->spiDmaDev, s->spiRxDmaChannel, &cfg) != DMA_TUBE_CFG_SUCCESS) {
+		return false;
+	}
+
+	cfg.tube_src = &dummy;
+	cfg.tube_dst = &s->spi_d->regs->DR;
+	cfg.tube_req_src = (dma_request_src)((s->spiDmaDev->clk_id << 3) | s->spiTxDmaChannel);
+	if (dma_tube_cfg(s->spiDmaDev, s->spiTxDmaChannel, &cfg) != DMA_TUBE_CFG_SUCCESS) {
+		return false;
+	}
+
+	_ports[port].settings = s;
+	dma_attach_interrupt(s->spiDmaDev, s->spiRxDmaChannel, handler);
+	dma_attach_interrupt(s->spiDmaDev, s->spiTxDmaChannel, handler);
+	return true;
+}
+
+/* Start a transfer on an idle port. */
+void SPIClass::dmaStart(PortState *port, const void *transmitBuf, void *receiveBuf,
+                        uint16 length, uint32 ccrFlags, bool minc)
 {
-	if (length == 0) return 0;
-	uint8 b = 0;
-	if (spi_is_rx_nonempty(_currentSetting->spi_d) == 1) b = spi_rx_reg(_currentSetting->spi_d); //Clear the RX buffer in case a byte is waiting on it.
-	//	dma1_ch3_Active=true;
-	dma_init(_currentSetting->spiDmaDev);
-	//	dma_attach_interrupt(DMA1, DMA_CH3, &SPIClass::DMA1_CH3_Event);
-
-	// RX
-	spi_rx_dma_enable(_currentSetting->spi_d);
-	dma_setup_transfer(_currentSetting->spiDmaDev, _currentSetting->spiRxDmaChannel, &_currentSetting->spi_d->regs->DR, DMA_SIZE_8BITS,
-	                   receiveBuf, DMA_SIZE_8BITS, (DMA_MINC_MODE | DMA_TRNS_CMPLT));// receive buffer DMA
-	dma_set_num_transfers(_currentSetting->spiDmaDev, _currentSetting->spiRxDmaChannel, length);
-
-	// TX
-	spi_tx_dma_enable(_currentSetting->spi_d);
+	SPISettings *s = port->settings;
+	static const uint8 ff = 0xFF;
+	static uint16 scratch;
+	const uint32 keep = ~(DMA_CCR_MSIZE | DMA_CCR_PSIZE | DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE);
+	dma_tube_reg_map *rx = dma_tube_regs(s->spiDmaDev, s->spiRxDmaChannel);
+	dma_tube_reg_map *tx = dma_tube_regs(s->spiDmaDev, s->spiTxDmaChannel);
+
+	port->dmaStatus = 0;
+	port->dmaBusy = true;
+
+	if (spi_is_rx_nonempty(s->spi_d)) {
+		(void)spi_rx_reg(s->spi_d); // Clear the RX buffer in case a byte is waiting on it.
+	}
+
+	rx->CCR = ((rx->CCR & keep) | ccrFlags | DMA_CCR_TCIE | DMA_CCR_TEIE |
+	           (receiveBuf ? DMA_CCR_MINC : 0));
+	dma_set_mem_addr(s->spiDmaDev, s->spiRxDmaChannel, receiveBuf ? receiveBuf : &scratch);
+	dma_set_num_transfers(s->spiDmaDev, s->spiRxDmaChannel, length);
 	if (!transmitBuf) {
-		static uint8_t ff = 0XFF;
-		transmitBuf = &ff;
-		dma_setup_transfer(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, &_currentSetting->spi_d->regs->DR, DMA_SIZE_8BITS,
-		                   transmitBuf, DMA_SIZE_8BITS, (DMA_FROM_MEM | DMA_TRNS_CMPLT));// Transmit FF repeatedly
-	} else {
-		dma_setup_transfer(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, &_currentSetting->spi_d->regs->DR, DMA_SIZE_8BITS,
-		                   transmitBuf, DMA_SIZE_8BITS, (DMA_MINC_MODE |  DMA_FROM_MEM | DMA_TRNS_CMPLT));// Transmit buffer DMA
+		transmitBuf = &ff; // Transmit FF repeatedly
+		minc = false;
 	}
-	dma_set_num_transfers(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, length);
+	tx->CCR = ((tx->CCR & keep) | ccrFlags | DMA_CCR_TEIE | (minc ? DMA_CCR_MINC : 0));
+	dma_set_mem_addr(s->spiDmaDev, s->spiTxDmaChannel, (void *)transmitBuf);
+	dma_set_num_transfers(s->spiDmaDev, s->spiTxDmaChannel, length);
 
-	dma_enable(_currentSetting->spiDmaDev, _currentSetting->spiRxDmaChannel);// enable receive
-	dma_enable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);// enable transmit
+	dma_enable(s->spiDmaDev, s->spiRxDmaChannel);
+	spi_rx_dma_enable(s->spi_d);
+	dma_enable(s->spiDmaDev, s->spiTxDmaChannel);
+	spi_tx_dma_enable(s->spi_d);
+}
 
-	uint32_t m = millis();
-	while ((dma_get_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel) & 0x2) == 0) { //Avoid interrupts and just loop waiting for the flag to be set.
-		if ((millis() - m) > 100)  {
+uint8 SPIClass::dmaStartAsync(const void *transmitBuf, void *receiveBuf, uint16 length,
+                              uint32 ccrFlags, bool minc, spi_dma_callback callback)
+{
+	PortState *port = currentPort();
 
-			b = 2;
-			break;
-		}
+	waitForCompletion();
+	if (length == 0) {
+		port->dmaStatus = 0;
+		if (callback) callback();
+		return 0;
+	}
+	if (!dmaClaim()) {
+		port->dmaStatus = 1;
+		return 1;
 	}
-	dma_clear_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
+	port->dmaCallback = callback;
+	dmaStart(port, transmitBuf, receiveBuf, length, ccrFlags, minc);
+	return 0;
+}
 
+/* Called with the transfer stopped or finished; status as for waitForCompletion(). */
+void SPIClass::dmaFinish(PortState *port, uint8 status)
+{
+	SPISettings *s = port->settings;
+	spi_dev *spi = s->spi_d;
 
-	while (spi_is_tx_empty(_currentSetting->spi_d) == 0); // "5. Wait until TXE=1 ..."
-	while (spi_is_busy(_currentSetting->spi_d) != 0); // "... and then wait until BSY=0 before disabling the SPI."
-	dma_disable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
-	dma_disable(_currentSetting->spiDmaDev, _currentSetting->spiRxDmaChannel);
-	spi_rx_dma_disable(_currentSetting->spi_d); // And disable generation of DMA request from the SPI port so other peripherals can use the channels
-	spi_tx_dma_disable(_currentSetting->spi_d);
-	if (spi_is_rx_nonempty(_currentSetting->spi_d) != 0) {
-		; // "4. Wait until RXNE=1 ..."
-		uint8 x = spi_rx_reg(_currentSetting->spi_d); // "... and read the last received data."
+	dma_disable(s->spiDmaDev, s->spiTxDmaChannel);
+	dma_disable(s->spiDmaDev, s->spiRxDmaChannel);
+	if (status == 0) {
+		// The last frame is in, so TXE is set and BSY drops within a clock edge
+		while (spi_is_busy(spi) != 0);
 	}
-	return b;
+	spi_rx_dma_disable(spi); // And disable generation of DMA request from the SPI port so other peripherals can use the channels
+	spi_tx_dma_disable(spi);
+	if (spi_is_rx_nonempty(spi) != 0) {
+		(void)spi_rx_reg(spi);
+	}
+	(void)spi->regs->SR; // Reading DR then SR clears any overrun an aborted transfer leaves behind
+
+	port->dmaStatus = status;
+	port->dmaBusy = false;
+	if (port->jobActive) {
+		jobRun(port, status);
+		return;
+	}
+	if (status != 2 && port->dmaCallback) {
+		port->dmaCallback();
+	}
+	jobKick(port);
 }
 
-/*  Roger Clark and Victor Perez, 2015
-*	Performs a DMA SPI send using a TX buffer.
-*	On exit TX buffer is not modified.
-*	Still in progress.
-*/
-uint8 SPIClass::dmaSend(uint8 *transmitBuf, uint16 length, bool minc)
+uint8 SPIClass::dmaTransferAsync(const uint8 *transmitBuf, uint8 *receiveBuf, uint16 length,
+                                 spi_dma_callback callback)
 {
-	if (length == 0) return 0;
-	uint32 flags = ((DMA_MINC_MODE * minc) |  DMA_FROM_MEM | DMA_TRNS_CMPLT);
-	uint8 b = 0;
-	//	dma1_ch3_Active=true;
-	dma_init(_currentSetting->spiDmaDev);
-	//	dma_attach_interrupt(DMA1, DMA_CH3, &SPIClass::DMA1_CH3_Event);
+	return dmaStartAsync(transmitBuf, receiveBuf, length, DMA_CCR_MSIZE_8BITS | DMA_CCR_PSIZE_8BITS, true, callback);
+}
 
-	// TX
-	spi_tx_dma_enable(_currentSetting->spi_d);
-	dma_setup_transfer(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, &_currentSetting->spi_d->regs->DR, DMA_SIZE_8BITS,
-	                   transmitBuf, DMA_SIZE_8BITS, flags);// Transmit buffer DMA
-	dma_set_num_transfers(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, length);
-	dma_enable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);// enable transmit
+uint8 SPIClass::dmaSendAsync(const uint8 *transmitBuf, uint16 length, bool minc,
+                             spi_dma_callback callback)
+{
+	return dmaStartAsync(transmitBuf, NULL, length, DMA_CCR_MSIZE_8BITS | DMA_CCR_PSIZE_8BITS, minc, callback);
+}
 
-	//    while (dma1_ch3_Active);
-	while ((dma_get_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel) & 0x2) == 0); //Avoid interrupts and just loop waiting for the flag to be set.
-	dma_clear_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
+uint8 SPIClass::dmaSendAsync(const uint16 *transmitBuf, uint16 length, bool minc,
+                             spi_dma_callback callback)
+{
+	return dmaStartAsync(transmitBuf, NULL, length, DMA_CCR_MSIZE_16BITS | DMA_CCR_PSIZE_16BITS, minc, callback);
+}
 
-	while (spi_is_tx_empty(_currentSetting->spi_d) == 0); // "5. Wait until TXE=1 ..."
-	while (spi_is_busy(_currentSetting->spi_d) != 0); // "... and then wait until BSY=0 before disabling the SPI."
-	dma_disable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
-	spi_tx_dma_disable(_currentSetting->spi_d);
-	if (spi_is_rx_nonempty(_currentSetting->spi_d) != 0) {
-		; // "4. Wait until RXNE=1 ..."
-		uint8 x = spi_rx_reg(_currentSetting->spi_d); // "... and read the last received data."
+/*
+ * Transaction queue
+ *
+ * Jobs form a singly linked list per port. The head job is "active"
+ * from the moment its chip select goes low; each DMA completion then
+ * starts its next descriptor, or finishes it and starts the next job.
+ */
+
+static inline uint32 irq_save(void)
+{
+	uint32 masked = nvic_globalirq_masked();
+	nvic_globalirq_disable();
+	return masked;
+}
+
+static inline void irq_restore(uint32 masked)
+{
+	if (!masked) {
+		nvic_globalirq_enable();
 	}
-	return b;
 }
 
-uint8 SPIClass::dmaSend(uint16 *transmitBuf, uint16 length, bool minc)
+bool SPIClass::queue(SPITransaction *job)
 {
-	if (length == 0) return 0;
-	uint32 flags = ((DMA_MINC_MODE * minc) |  DMA_FROM_MEM | DMA_TRNS_CMPLT);
-	uint8 b;
-	dma1_ch3_Active = true;
-	dma_init(_currentSetting->spiDmaDev);
-	//	dma_attach_interrupt(DMA1, DMA_CH3, &SPIClass::DMA1_CH3_Event);
+	PortState *port = currentPort();
 
-	// TX
-	spi_tx_dma_enable(_currentSetting->spi_d);
-	dma_setup_transfer(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, &_currentSetting->spi_d->regs->DR, DMA_SIZE_16BITS,
-	                   transmitBuf, DMA_SIZE_16BITS, flags);// Transmit buffer DMA
-	dma_set_num_transfers(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel, length);
-	dma_enable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);// enable transmit
+	if (!job->count || job->status == SPI_JOB_QUEUED || job->status == SPI_JOB_ACTIVE) {
+		return false;
+	}
+	if (!dmaClaim()) {
+		return false;
+	}
+	if (job->csPin != SPI_NO_CS) {
+		digitalWrite(job->csPin, HIGH);
+		pinMode(job->csPin, OUTPUT);
+	}
+	// Work out the CR1 value now, so the interrupt only has to compare
+	job->settings.clockDivider = determine_baud_rate(_currentSetting->spi_d, job->settings.clock);
+	job->cr1 = masterConfig(&job->settings);
+	job->status = SPI_JOB_QUEUED;
+	job->next = NULL;
+
+	uint32 primask = irq_save();
+	if (port->jobTail) {
+		port->jobTail->next = job;
+	} else {
+		port->jobHead = job;
+	}
+	port->jobTail = job;
+	jobKick(port);
+	irq_restore(primask);
+	return true;
+}
 
-	//    while (dma1_ch3_Active);
-	while ((dma_get_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel) & 0x2) == 0); //Avoid interrupts and just loop waiting for the flag to be set.
-	dma_clear_isr_bits(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
+/* Start the head job if the port is idle. */
+void SPIClass::jobKick(PortState *port)
+{
+	SPITransaction *job = port->jobHead;
+	SPISettings *s = port->settings;
 
-	while (spi_is_tx_empty(_currentSetting->spi_d) == 0); // "5. Wait until TXE=1 ..."
-	while (spi_is_busy(_currentSetting->spi_d) != 0); // "... and then wait until BSY=0 before disabling the SPI."
-	dma_disable(_currentSetting->spiDmaDev, _currentSetting->spiTxDmaChannel);
-	spi_tx_dma_disable(_currentSetting->spi_d);
-	if (spi_is_rx_nonempty(_currentSetting->spi_d) != 0) {
-		; // "4. Wait until RXNE=1 ..."
-		b = spi_rx_reg(_currentSetting->spi_d); // "... and read the last received data."
+	if (!job || port->jobActive || port->dmaBusy) {
+		return;
 	}
-	return b;
+	if ((s->spi_d->regs->CR1 & ~SPI_CR1_SPE) != job->cr1) {
+		spi_reconfigure(s->spi_d, job->cr1);
+		s->clock = job->settings.clock;
+		s->clockDivider = job->settings.clockDivider;
+		s->bitOrder = job->settings.bitOrder;
+		s->dataMode = job->settings.dataMode;
+	}
+	if (job->csPin != SPI_NO_CS) {
+		digitalWrite(job->csPin, LOW);
+	}
+	job->status = SPI_JOB_ACTIVE;
+	port->jobActive = true;
+	port->jobSeg = 0;
+	jobRun(port, 0);
+}
+
+/* Advance the active job after its last transfer ended with status. */
+void SPIClass::jobRun(PortState *port, uint8 status)
+{
+	SPITransaction *job = port->jobHead;
+
+	if (status == 0) {
+		while (port->jobSeg < job->count) {
+			const SPIDescriptor *d = &job->descriptors[port->jobSeg++];
+			if (d->length) {
+				dmaStart(port, d->tx, d->rx, d->length, DMA_CCR_MSIZE_8BITS | DMA_CCR_PSIZE_8BITS, true);
+				return;
+			}
+		}
+	}
+
+	if (job->csPin != SPI_NO_CS) {
+		digitalWrite(job->csPin, HIGH);
+	}
+	port->jobActive = false;
+	port->jobHead = job->next;
+	if (!port->jobHead) {
+		port->jobTail = NULL;
+	}
+	job->status = status;
+	if (job->callback) {
+		job->callback(job);
+	}
+	jobKick(port);
+}
+
+uint8 SPIClass::waitForCompletion(uint32 timeout)
+{
+	PortState *port = currentPort();
+	SPISettings *s = port->settings; // Set whenever anything is running
+	uint32 m = millis();
+
+	while (port->dmaBusy || port->jobHead) {
+		if (timeout && (millis() - m) > timeout) {
+			// Stop the tubes first so the interrupt can no longer finish the transfer
+			dma_disable(s->spiDmaDev, s->spiTxDmaChannel);
+			dma_disable(s->spiDmaDev, s->spiRxDmaChannel);
+			uint32 primask = irq_save();
+			SPITransaction *job = port->jobHead;
+			if (job && port->jobActive && job->csPin != SPI_NO_CS) {
+				digitalWrite(job->csPin, HIGH);
+			}
+			port->jobHead = NULL;
+			port->jobTail = NULL;
+			port->jobActive = false;
+			if (port->dmaBusy) {
+				dmaFinish(port, 2);
+			}
+			port->dmaStatus = 2;
+			irq_restore(primask);
+			for (; job; job = job->next) {
+				job->status = SPI_JOB_ABORTED;
+			}
+			break;
+		}
+	}
+	return port->dmaStatus;
+}
+
+/*  Roger Clark and Victor Perez, 2015
+*	Performs a DMA SPI transfer with at least a receive buffer.
+*	If a TX buffer is not provided, FF is sent over and over for the lenght of the transfer.
+*	On exit TX buffer is not modified, and RX buffer cotains the received data.
+*/
+uint8 SPIClass::dmaTransfer(uint8 *transmitBuf, uint8 *receiveBuf, uint16 length)
+{
+	dmaTransferAsync(transmitBuf, receiveBuf, length);
+	return waitForCompletion(100);
+}
+
+/*  Roger Clark and Victor Perez, 2015
+*	Performs a DMA SPI send using a TX buffer.
+*	On exit TX buffer is not modified.
+*/
+uint8 SPIClass::dmaSend(uint8 *transmitBuf, uint16 length, bool minc)
+{
+	dmaSendAsync(transmitBuf, length, minc);
+	return waitForCompletion();
+}
+
+uint8 SPIClass::dmaSend(uint16 *transmitBuf, uint16 length, bool minc)
+{
+	dmaSendAsync(transmitBuf, length, minc);
+	return waitForCompletion();
 }
 
 
@@ -96,6 +96,8 @@
 #define SPI_MODE2 SPI_MODE_2
 #define SPI_MODE3 SPI_MODE_3
 
+class SPITransaction;
+
 class SPISettings
 {
 public:
@@ -132,8 +134,70 @@ private:
     friend class SPIClass;
 };
 
+/**
+ * @brief Function called from the DMA interrupt when an asynchronous
+ *        transfer has finished.
+ */
+typedef void (*spi_dma_callback)(void);
+
+/** Pass as an SPITransaction's csPin when the caller drives chip select. */
+#define SPI_NO_CS 0xFF
+
+/** SPITransaction::status values. The first three match waitForCompletion(). */
+enum {
+    SPI_JOB_DONE    = 0, /**< Finished successfully */
+    SPI_JOB_ERROR   = 1, /**< DMA error; the rest of the job was skipped */
+    SPI_JOB_ABORTED = 2, /**< Dropped by a waitForCompletion() timeout */
+    SPI_JOB_QUEUED  = 3, /**< Waiting for the bus */
+    SPI_JOB_ACTIVE  = 4, /**< On the bus */
+};
+
+/**
+ * @brief One buffer of an SPITransaction.
+ *
+ * Either pointer may be 0: with no tx, FF is sent; with no rx, the
+ * received bytes are discarded.
+ */
+struct SPIDescriptor {
+    const uint8 *tx;
+    uint8 *rx;
+    uint16 length;
+};
+
+/**
+ * @brief A job for SPIClass::queue().
+ *
+ * Chip select is asserted once the bus has been set up for settings,
+ * held across all the descriptors, and released before callback is
+ * called from the DMA interrupt. The job and its descriptors and
+ * buffers must stay valid until then. A callback may queue further
+ * jobs (including this one), but must not wait for the bus.
+ */
+class SPITransaction
+{
+public:
+    SPITransaction() : csPin(SPI_NO_CS), descriptors(0), count(0), callback(0),
+        user(0), status(SPI_JOB_DONE), next(0), cr1(0) {}
+    SPITransaction(const SPISettings &settings, uint8 csPin,
+                   const SPIDescriptor *descriptors, uint8 count,
+                   void (*callback)(SPITransaction *job) = 0)
+        : settings(settings), csPin(csPin), descriptors(descriptors), count(count),
+          callback(callback), user(0), status(SPI_JOB_DONE), next(0), cr1(0) {}
+
+    SPISettings settings;
+    uint8 csPin;
+    const SPIDescriptor *descriptors;
+    uint8 count;
+    void (*callback)(SPITransaction *job);
+    void *user;                 /**< Free for the callback's use */
+    volatile uint8 status;      /**< One of SPI_JOB_... */
+
+private:
+    SPITransaction *next;
+    uint32 cr1;
 
-volatile static bool dma1_ch3_Active;
+    friend class SPIClass;
+};
 
 /**
  * @brief Wirish SPI interface.
@@ -286,6 +350,89 @@ public:
      */
     uint8 dmaSend(uint16 *transmitBuf, uint16 length, bool minc = 1);
 
+    /**
+     * @brief Start a DMA transfer of "length" bytes and return at once.
+     *
+     * The buffers belong to the DMA controller until the transfer has
+     * finished; callback, if given, is then called from the DMA
+     * interrupt. A transfer still in progress is waited for first,
+     * so it is safe to start the next one from the callback.
+     *
+     * @param transmitBuf Bytes to transmit. If 0, FF is sent "length" times.
+     * @param receiveBuf Buffer to save received data.
+     * @param length Number of bytes to transfer.
+     * The port's DMA channels are claimed on its first DMA transfer;
+     * if another driver, such as a serial port using DMA, holds one,
+     * the transfer fails without calling callback.
+     *
+     * @param callback Function to call on completion, or 0.
+     * @return 0, or 1 if the DMA channels are taken.
+     * @see isBusy()
+     * @see waitForCompletion()
+     */
+    uint8 dmaTransferAsync(const uint8 *transmitBuf, uint8 *receiveBuf, uint16 length,
+                           spi_dma_callback callback = 0);
+
+    /**
+     * @brief Start a DMA transmit of bytes and return at once.
+     *
+     * Received data is discarded. Otherwise as dmaTransferAsync().
+     *
+     * @param transmitBuf Bytes to transmit.
+     * @param length Number of bytes to transmit.
+     * @param minc Set to use Memory Increment mode, clear to send
+     *             transmitBuf[0] "length" times.
+     * @param callback Function to call on completion, or 0.
+     */
+    uint8 dmaSendAsync(const uint8 *transmitBuf, uint16 length, bool minc = 1,
+                       spi_dma_callback callback = 0);
+
+    /**
+     * @brief Start a DMA transmit of half words and return at once.
+     * SPI PERFIPHERAL MUST BE SET TO 16 BIT MODE BEFORE
+     * @see dmaSendAsync()
+     */
+    uint8 dmaSendAsync(const uint16 *transmitBuf, uint16 length, bool minc = 1,
+                       spi_dma_callback callback = 0);
+
+    /**
+     * @brief Add a transaction to the end of this port's queue.
+     *
+     * Queued jobs run back to back, each started from the DMA
+     * interrupt that ends the one before; the SPI is reconfigured
+     * only when a job's settings differ from the current ones.
+     * begin() must have been called. Don't use the polled I/O
+     * functions while isBusy().
+     *
+     * @param job Transaction to run.
+     * @return false if job is already queued or has no descriptors,
+     *         or the port's DMA channels are taken (see
+     *         dmaTransferAsync()).
+     */
+    bool queue(SPITransaction *job);
+
+    /**
+     * @brief Return true while an asynchronous DMA transfer is running
+     *        or transactions are queued.
+     */
+    bool isBusy(void) const { return currentPort()->dmaBusy || currentPort()->jobHead; }
+
+    /**
+     * @brief Wait for the current DMA transfer, if any, and all queued
+     *        transactions to finish.
+     *
+     * On timeout, queued transactions are dropped with status
+     * SPI_JOB_ABORTED and their callbacks are not called.
+     *
+     * Must not be called from an interrupt that can preempt the DMA
+     * interrupt.
+     *
+     * @param timeout Milliseconds to wait before aborting the
+     *                transfer, or 0 to wait forever.
+     * @return 0 on success, 1 on a DMA error, 2 on timeout.
+     */
+    uint8 waitForCompletion(uint32 timeout = 0);
+
     /*
      * Pin accessors
      */
@@ -368,19 +515,37 @@ public:
     uint8 recv(void);
 
 private:
-    /*
-        static inline void DMA1_CH3_Event() {
-            dma1_ch3_Active = 0;
-    //      dma_disable(DMA1, DMA_CH3);
-    //      dma_disable(DMA1, DMA_CH2);
-
-            // To Do. Need to wait for
-        }
-    */
     SPISettings _settings[BOARD_NR_SPI];
     SPISettings *_currentSetting;
 
+    /* DMA and queue state of an SPI device, shared by every SPIClass
+     * driving it */
+    struct PortState {
+        SPISettings *settings;  /* Settings holding the DMA tubes, or 0 */
+        volatile bool dmaBusy;
+        volatile uint8 dmaStatus;
+        spi_dma_callback dmaCallback;
+
+        SPITransaction *volatile jobHead;
+        SPITransaction *jobTail;
+        volatile bool jobActive;
+        uint8 jobSeg;
+    };
+    static PortState _ports[BOARD_NR_SPI];
+
+    PortState *currentPort(void) const { return &_ports[_currentSetting - _settings]; }
+
     void updateSettings(void);
+    static uint32 masterConfig(const SPISettings *s);
+    bool dmaClaim(void);
+    uint8 dmaStartAsync(const void *transmitBuf, void *receiveBuf, uint16 length,
+                        uint32 ccrFlags, bool minc, spi_dma_callback callback);
+    static void dmaStart(PortState *port, const void *transmitBuf, void *receiveBuf,
+                         uint16 length, uint32 ccrFlags, bool minc);
+    static void dmaFinish(PortState *port, uint8 status);
+    static void jobKick(PortState *port);
+    static void jobRun(PortState *port, uint8 status);
+    template <uint8 port> static void dmaIrq(void);
     /*
     spi_dev *spi_d;
     uint8_t _SSPin;
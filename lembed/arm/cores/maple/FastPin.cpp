@@ -0,0 +1,95 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @brief Precomputed pin handles for fast digital I/O.
+ */
+
+#include "FastPin.h"
+
+#include "boards.h"
+
+gpio_reg_map fastpin_dummy_regs;
+
+void FastPin::attach(uint8 pin)
+{
+    if (pin >= BOARD_NR_GPIO_PINS) {
+        regs = &fastpin_dummy_regs;
+        mask = 0;
+        return;
+    }
+    regs = PIN_MAP[pin].gpio_device->regs;
+    mask = 1U << PIN_MAP[pin].gpio_bit;
+}
+
+void PinGroup::attach(const uint8 *pins, uint8 npins)
+{
+    count = npins > MAX_PINS ? MAX_PINS : npins;
+    regs = NULL;
+    for (uint8 i = 0; i < MAX_PINS; i++) {
+        this->pins[i] = i < count ? FastPin(pins[i]) : FastPin();
+    }
+
+    for (uint8 i = 0; i < count; i++) {
+        if (this->pins[i].port() != this->pins[0].port()) {
+            return;
+        }
+    }
+    regs = count ? this->pins[0].port() : NULL;
+
+    /* For each nibble of a value: set the pins for its ones, reset
+     * the pins for its zeros. The two nibbles' pins don't overlap, so
+     * their words can be ORed together. */
+    for (uint8 half = 0; half < 2; half++) {
+        for (uint8 nibble = 0; nibble < 16; nibble++) {
+            uint32 word = 0;
+            for (uint8 bit = 0; bit < 4; bit++) {
+                uint32 mask = this->pins[half * 4 + bit].bitmask();
+                word |= (nibble & (1U << bit)) ? mask : mask << 16;
+            }
+            table[half][nibble] = word;
+        }
+    }
+}
+
+void PinGroup::writeEach(uint32 value) const
+{
+    for (uint8 i = 0; i < count; i++) {
+        pins[i].write(value & (1U << i));
+    }
+}
+
+uint32 PinGroup::read() const
+{
+    uint32 idr = regs ? regs->IDR : 0;
+    uint32 value = 0;
+
+    for (uint8 i = 0; i < count; i++) {
+        uint32 level = regs ? (idr & pins[i].bitmask()) != 0 : pins[i].read();
+        value |= level << i;
+    }
+    return value;
+}
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/FastPin.h
+ * @brief Precomputed pin handles for fast digital I/O.
+ *
+ * digitalWrite() and digitalRead() look the pin up in PIN_MAP on every
+ * call. A FastPin does that once, in its constructor, and then sets,
+ * clears or reads the pin with a single register access. A PinGroup
+ * does the same for up to 8 pins, writing all of them at once when
+ * they share a port.
+ *
+ * The pins still need pinMode() first.
+ */
+
+#ifndef _WIRISH_FASTPIN_H_
+#define _WIRISH_FASTPIN_H_
+
+#include <libmaple/gpio.h>
+
+/* Stands in for the registers of invalid pins, so that writes to
+ * them go nowhere without a check on every access. */
+extern gpio_reg_map fastpin_dummy_regs;
+
+/**
+ * @brief One GPIO pin, resolved to its port and bit mask.
+ */
+class FastPin {
+public:
+    /** An unattached pin; accesses do nothing, reads return 0. */
+    FastPin() : regs(&fastpin_dummy_regs), mask(0) {}
+
+    /** @param pin Pin number; out of range pins act as unattached. */
+    explicit FastPin(uint8 pin) { attach(pin); }
+
+    /** Resolve a (new) pin number. */
+    void attach(uint8 pin);
+
+    /** Drive the pin high. */
+    void set() const { regs->BSRR = mask; }
+
+    /** Drive the pin low. */
+    void clear() const { regs->BRR = mask; }
+
+    /** Drive the pin high if value is nonzero, else low. */
+    void write(uint32 value) const {
+        regs->BSRR = value ? mask : mask << 16;
+    }
+
+    /**
+     * Invert the pin. Unlike gpio_toggle_bit(), this leaves other pins
+     * on the port alone even if an interrupt changes them meanwhile.
+     */
+    void toggle() const {
+        uint32 odr = regs->ODR;
+        regs->BSRR = ((odr & mask) << 16) | (~odr & mask);
+    }
+
+    /** Returns HIGH or LOW. */
+    uint32 read() const { return (regs->IDR & mask) != 0; }
+
+    /** Port register map. */
+    gpio_reg_map* port() const { return regs; }
+
+    /** Pin's bit in the port registers. */
+    uint32 bitmask() const { return mask; }
+
+private:
+    gpio_reg_map *regs;
+    uint32 mask;
+};
+
+/**
+ * @brief Up to 8 pins, written and read together as the bits of a value.
+ *
+ * Bit i of a value belongs to the i-th pin given to the constructor.
+ * When the pins are all on one port, write() is a single store to its
+ * BSRR register, so they change together; otherwise each port (and in
+ * fact each pin) is written in turn.
+ */
+class PinGroup {
+public:
+    /** Maximum number of pins in a group. */
+    static const uint8 MAX_PINS = 8;
+
+    /** An empty group. */
+    PinGroup() : regs(0), count(0) {}
+
+    /**
+     * @param pins  Pin numbers, bit 0's first.
+     * @param npins Number of pins, up to MAX_PINS; extra ones are
+     *              ignored.
+     */
+    PinGroup(const uint8 *pins, uint8 npins) { attach(pins, npins); }
+
+    /** Resolve a (new) set of pins. */
+    void attach(const uint8 *pins, uint8 npins);
+
+    /** Set the pins to the low bits of value. */
+    void write(uint32 value) const {
+        if (regs) {
+            regs->BSRR = table[0][value & 0xF] | table[1][(value >> 4) & 0xF];
+        } else {
+            writeEach(value);
+        }
+    }
+
+    /** Read the pins into the low bits of the result. */
+    uint32 read() const;
+
+    /** Whether all the pins are on one port. */
+    bool onePort() const { return regs != 0; }
+
+    /** Number of pins in the group. */
+    uint8 size() const { return count; }
+
+    /** The group's i-th pin. */
+    const FastPin& operator[](uint8 i) const { return pins[i]; }
+
+private:
+    void writeEach(uint32 value) const;
+
+    gpio_reg_map *regs;         /* Common port, or NULL */
+    uint32 table[2][16];        /* BSRR words for each nibble of a value */
+    FastPin pins[MAX_PINS];
+    uint8 count;
+};
+
+#endif
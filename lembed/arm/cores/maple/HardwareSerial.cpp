@@ -91,6 +91,24 @@ void HardwareSerial::end(void)
 	usart_disable(this->usart_device);
 }
 
+bool HardwareSerial::enableDMA(uint8 *rxBuffer, uint16 rxSize)
+{
+	if (usart_dma_rx_enable(this->usart_device, rxBuffer, rxSize) < 0) {
+		return false;
+	}
+	if (usart_dma_tx_enable(this->usart_device) < 0) {
+		usart_dma_rx_disable(this->usart_device);
+		return false;
+	}
+	return true;
+}
+
+void HardwareSerial::disableDMA(void)
+{
+	usart_dma_tx_disable(this->usart_device);
+	usart_dma_rx_disable(this->usart_device);
+}
+
 /*
  * I/O
  */
@@ -101,6 +119,21 @@ int HardwareSerial::read(void)
 	return usart_getc(this->usart_device);
 }
 
+size_t HardwareSerial::read(uint8_t *buffer, size_t size)
+{
+	return usart_rx(this->usart_device, buffer, size);
+}
+
+size_t HardwareSerial::readSpan(const uint8 **span)
+{
+	return usart_rx_span(this->usart_device, (uint8**)span);
+}
+
+bool HardwareSerial::readCommit(size_t len)
+{
+	return usart_rx_commit(this->usart_device, len);
+}
+
 int HardwareSerial::available(void)
 {
 	return usart_data_available(this->usart_device);
@@ -113,7 +146,7 @@ int HardwareSerial::peek(void)
 
 int HardwareSerial::availableForWrite(void)
 {
-	return 1;
+	return usart_tx_room(this->usart_device);
 }
 
 size_t HardwareSerial::write(unsigned char ch)
@@ -122,7 +155,22 @@ size_t HardwareSerial::write(unsigned char ch)
 	return 1;
 }
 
+/* Copies as much as fits straight into the TX buffer, waiting for
+ * room only when it is full. */
+size_t HardwareSerial::write(const void *buf, uint32 len)
+{
+	const uint8 *data = (const uint8*)buf;
+	uint32 txed = 0;
+
+	while (txed < len) {
+		txed += usart_tx(this->usart_device, data + txed, len - txed);
+	}
+	return len;
+}
+
+/* Like Arduino 1.0+, flush() waits for outgoing data to be sent; it
+ * no longer discards incoming data. */
 void HardwareSerial::flush(void)
 {
-	usart_reset_rx(this->usart_device);
+	usart_tx_flush(this->usart_device);
 }
@@ -122,12 +122,28 @@ public:
     void begin(uint32 baud);
     void begin(uint32 baud, uint8_t config);
     void end();
+
+    /* Move RX into a circular DMA buffer and TX into DMA blocks.
+     * Call after begin(); rxSize must be a power of two. With no
+     * buffer, the port's built-in RX buffer is used. */
+    bool enableDMA(uint8 *rxBuffer = NULL, uint16 rxSize = 0);
+    void disableDMA(void);
     virtual int available(void);
     virtual int peek(void);
     virtual int read(void);
+    /* Copy up to size buffered bytes into buffer without waiting;
+     * returns the number copied. */
+    size_t read(uint8_t *buffer, size_t size);
+    /* While readSpan()'s bytes are in use, a full RX buffer drops new
+     * bytes rather than the oldest ones. With RX DMA, nothing holds
+     * the tube back; readCommit() returns false if it got a whole
+     * buffer ahead and overwrote them. */
+    virtual size_t readSpan(const uint8 **span);
+    virtual bool readCommit(size_t len);
     int availableForWrite(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const void *buf, uint32 len);
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
@@ -26,6 +26,9 @@
 
 #include "wirish_math.h"
 #include "limits.h"
+#include "itoa.h"
+#include "dtoa.h"
+#include <string.h>
 
 #ifndef LLONG_MAX
 /*
@@ -48,12 +51,10 @@
 
 size_t Print::write(const char *str)
 {
-    size_t n = 0;
-    while (*str) {
-        write(*str++);
-        n++;
+    if (str == NULL) {
+        return 0;
     }
-    return n;
+    return write(str, strlen(str));
 }
 
 size_t Print::write(const void *buffer, uint32 size)
@@ -61,14 +62,14 @@ size_t Print::write(const void *buffer, uint32 size)
     size_t n = 0;
     uint8 *ch = (uint8*)buffer;
     while (size--) {
-        write(*ch++);
+        n += write(*ch++);
     }
     return n;
 }
 
 size_t Print::print(uint8 b, int base)
 {
-    return print((uint64)b, base);
+    return print((unsigned long)b, base);
 }
 
 size_t Print::print(const String &s)
@@ -76,6 +77,11 @@ size_t Print::print(const String &s)
     return write(s.c_str(), s.length());
 }
 
+size_t Print::print(const Printable &x)
+{
+    return x.printTo(*this);
+}
+
 size_t Print::print(char c)
 {
     return write(c);
@@ -88,22 +94,31 @@ size_t Print::print(const char str[])
 
 size_t Print::print(int n, int base)
 {
-    return print((long long)n, base);
+    return print((long)n, base);
 }
 
 size_t Print::print(unsigned int n, int base)
 {
-    return print((unsigned long long)n, base);
+    return print((unsigned long)n, base);
 }
 
 size_t Print::print(long n, int base)
 {
-    return print((long long)n, base);
+    if (base == BYTE) {
+        return write((uint8)n);
+    }
+    if (n < 0) {
+        return printNumber(-(unsigned long)n, base, true);
+    }
+    return printNumber((unsigned long)n, base, false);
 }
 
 size_t Print::print(unsigned long n, int base)
 {
-    return print((unsigned long long)n, base);
+    if (base == BYTE) {
+        return write((uint8)n);
+    }
+    return printNumber(n, base, false);
 }
 
 size_t Print::print(long long n, int base)
@@ -112,21 +127,17 @@ size_t Print::print(long long n, int base)
         return write((uint8)n);
     }
     if (n < 0) {
-        print('-');
-        n = -n;
+        return printNumber(-(unsigned long long)n, base, true);
     }
-    return printNumber(n, base);
+    return printNumber((unsigned long long)n, base, false);
 }
 
 size_t Print::print(unsigned long long n, int base)
 {
-    size_t c = 0;
     if (base == BYTE) {
-        c = write((uint8)n);
-    } else {
-        c = printNumber(n, base);
+        return write((uint8)n);
     }
-    return c;
+    return printNumber(n, base, false);
 }
 
 size_t Print::print(double n, int digits)
@@ -136,9 +147,7 @@ size_t Print::print(double n, int digits)
 
 size_t Print::println(void)
 {
-    size_t n =  print('\r');
-    n += print('\n');
-    return n;
+    return write("\r\n", 2);
 }
 
 size_t Print::println(const String &s)
@@ -148,6 +157,13 @@ size_t Print::println(const String &s)
     return n;
 }
 
+size_t Print::println(const Printable &x)
+{
+    size_t n = print(x);
+    n += println();
+    return n;
+}
+
 size_t Print::println(char c)
 {
     size_t n = print(c);
@@ -218,113 +234,47 @@ size_t Print::println(double n, int digits)
     return s;
 }
 
-#ifdef SUPPORTS_PRINTF
-#include <stdio.h>
-#include <stdarg.h>
-// Work in progress to support printf.
-// Need to implement stream FILE to write individual chars to chosen serial port
-int Print::printf (__const char *__restrict __format, ...)
-{
-    FILE *__restrict __stream;
-    int ret_status = 0;
-
-
-    va_list args;
-    va_start(args, __format);
-    ret_status = vfprintf(__stream, __format, args);
-    va_end(args);
-    return ret_status;
-}
-#endif
-
 /*
  * Private methods
  */
 
-size_t Print::printNumber(unsigned long long n, uint8 base)
+/* Numbers are formatted into a buffer on the stack and written in
+ * one go, which saves a virtual call per digit. */
+size_t Print::printNumber(unsigned long n, uint8 base, bool negative)
 {
-    unsigned char buf[CHAR_BIT * sizeof(long long)];
-    unsigned long i = 0;
-    size_t s = 0;
-    if (n == 0) {
-        print('0');
-        return 1;
+    char buf[1 + CHAR_BIT * sizeof(long)];
+    char *end = buf + sizeof(buf);
+    char *p = ultoa_back(n, end, base);
+    if (negative) {
+        *--p = '-';
     }
+    return write(p, end - p);
+}
 
-    while (n > 0) {
-        buf[i++] = n % base;
-        n /= base;
+size_t Print::printNumber(unsigned long long n, uint8 base, bool negative)
+{
+    if (n <= ULONG_MAX) {
+        return printNumber((unsigned long)n, base, negative);
     }
-
-    for (; i > 0; i--) {
-        s += print((char)(buf[i - 1] < 10 ?
-                          '0' + buf[i - 1] :
-                          'A' + buf[i - 1] - 10));
+    char buf[1 + CHAR_BIT * sizeof(long long)];
+    char *end = buf + sizeof(buf);
+    char *p = ulltoa_back(n, end, base);
+    if (negative) {
+        *--p = '-';
     }
-    return s;
+    return write(p, end - p);
 }
 
 
-/* According to snprintf(),
- *
- * nextafter((double)numeric_limits<long long>::max(), 0.0) ~= 9.22337e+18
- *
- * This slightly smaller value was picked semi-arbitrarily. */
-#define LARGE_DOUBLE_TRESHOLD (9.1e18)
+static void print_write(void *ctx, const char *str, unsigned len)
+{
+    Print *p = (Print*)ctx;
+    p->write(str, len);
+}
 
-/* THIS FUNCTION SHOULDN'T BE USED IF YOU NEED ACCURATE RESULTS.
- *
- * This implementation is meant to be simple and not occupy too much
- * code size.  However, printing floating point values accurately is a
- * subtle task, best left to a well-tested library function.
- *
- * See Steele and White 2003 for more details:
- *
- * http://kurtstephens.com/files/p372-steele.pdf
- */
+/* Correctly rounded, over the whole double range; see dtoa.h. */
 size_t Print::printFloat(double number, uint8 digits)
 {
-    size_t s = 0;
-    // Hackish fail-fast behavior for large-magnitude doubles
-    if (abs(number) >= LARGE_DOUBLE_TRESHOLD) {
-        if (number < 0.0) {
-            s = print('-');
-        }
-        s += print("<large double>");
-        return s;
-    }
-
-    // Handle negative numbers
-    if (number < 0.0) {
-        s += print('-');
-        number = -number;
-    }
-
-    // Simplistic rounding strategy so that e.g. print(1.999, 2)
-    // prints as "2.00"
-    double rounding = 0.5;
-    for (uint8 i = 0; i < digits; i++) {
-        rounding /= 10.0;
-    }
-    number += rounding;
-
-    // Extract the integer part of the number and print it
-    long long int_part = (long long)number;
-    double remainder = number - int_part;
-    s += print(int_part);
-
-    // Print the decimal point, but only if there are digits beyond
-    if (digits > 0) {
-        s += print(".");
-    }
-
-    // Extract digits from the remainder one at a time
-    while (digits-- > 0) {
-        remainder *= 10.0;
-        int to_print = (int)remainder;
-        s += print(to_print);
-        remainder -= to_print;
-    }
-    return s;
+    return dtoa_fixed(number, digits, print_write, this);
 }
 
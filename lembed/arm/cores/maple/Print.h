@@ -23,8 +23,10 @@
 #ifndef _WIRISH_PRINT_H_
 #define _WIRISH_PRINT_H_
 
+#include <stdarg.h>
 #include <libmaple/libmaple_types.h>
 #include "WString.h"
+#include "Printable.h"
 
 enum {
     BYTE = 0,
@@ -37,6 +39,10 @@ enum {
 class Print
 {
 public:
+    /* Subclasses must provide write(uint8). Overriding the bulk
+     * write(buf, len) too saves a virtual call per byte: print() and
+     * println() hand over whole strings and numbers through it. Both
+     * return the number of bytes written. */
     virtual size_t write(uint8 ch) = 0;
     virtual size_t write(const char *str);
     virtual size_t write(const void *buf, uint32 len);
@@ -52,6 +58,7 @@ public:
     size_t print(long long, int = DEC);
     size_t print(unsigned long long, int = DEC);
     size_t print(double, int = 2);
+    size_t print(const Printable &);
     size_t println(void);
     size_t println(const String &s);
     size_t println(char);
@@ -64,10 +71,17 @@ public:
     size_t println(long long, int = DEC);
     size_t println(unsigned long long, int = DEC);
     size_t println(double, int = 2);
-#ifdef SUPPORTS_PRINTF
-// Roger Clark. Work in progress to add printf support
-    int printf(const char * format, ...);
-#endif
+    size_t println(const Printable &);
+
+    /* Formats into a small buffer on the stack, which goes out in bulk
+     * writes. Supports flags, width and precision, and the d, i, u, o,
+     * x, X, c, s, p and f conversions (f not with PRINTF_NO_FLOAT).
+     * e, g and a are printed as they are, and n stores nothing; both
+     * still take their argument. Returns the number of characters
+     * produced. See Printf.h for
+     * PRINTF(), which checks the arguments at compile time. */
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    int vprintf(const char *format, va_list ap);
     Print() : write_error(0) {}
 
     int getWriteError() { return write_error; }
@@ -78,7 +92,8 @@ protected:
 
 private:
     int write_error;
-    size_t printNumber(unsigned long long, uint8);
+    size_t printNumber(unsigned long, uint8, bool);
+    size_t printNumber(unsigned long long, uint8, bool);
     size_t printFloat(double, uint8);
 };
 
@@ -0,0 +1,425 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/Printf.cpp
+ * @brief Buffered printf() formatting.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "Printf.h"
+#include "itoa.h"
+#ifndef PRINTF_NO_FLOAT
+#include "dtoa.h"
+#endif
+
+void PrintfBuffer::write(const char *str, size_t len)
+{
+    total += len;
+    if (n + len > sizeof(buf)) {
+        flush();
+        if (len >= sizeof(buf)) {
+            out.write(str, len);
+            return;
+        }
+    }
+    memcpy(buf + n, str, len);
+    n += len;
+}
+
+void PrintfBuffer::flush()
+{
+    if (n) {
+        out.write(buf, n);
+        n = 0;
+    }
+}
+
+void PrintfBuffer::padded(const char *prefix, unsigned prefix_len, unsigned zeros,
+                          const char *body, unsigned body_len,
+                          const printf_spec &spec)
+{
+    unsigned len = prefix_len + zeros + body_len;
+    unsigned pad = spec.width > len ? spec.width - len : 0;
+
+    if (!(spec.flags & PRINTF_LEFT)) {
+        while (pad) {
+            put(' ');
+            pad--;
+        }
+    }
+    write(prefix, prefix_len);
+    while (zeros--) {
+        put('0');
+    }
+    write(body, body_len);
+    while (pad--) {
+        put(' ');
+    }
+}
+
+void PrintfBuffer::integer(unsigned long long mag, bool negative,
+                           const printf_spec &spec)
+{
+    char digits[64];
+    char *end = digits + sizeof(digits);
+    char prefix[2];
+    unsigned prefix_len = 0;
+    unsigned zeros = 0;
+
+    if (spec.conv == 'c') {
+        char c = (char)mag;
+        padded("", 0, 0, &c, 1, spec);
+        return;
+    }
+
+    int base = spec.conv == 'o' ? 8 : (spec.conv == 'x' || spec.conv == 'X') ? 16 : 10;
+    char *p = end;
+    if (mag != 0 || spec.prec != 0) {
+        p = ulltoa_back(mag, end, base);
+    }
+    if (spec.conv == 'x') {
+        for (char *q = p; q < end; q++) {
+            if (*q >= 'A') {
+                *q += 'a' - 'A';
+            }
+        }
+    }
+    unsigned len = end - p;
+    if (spec.prec > 0 && (unsigned)spec.prec > len) {
+        zeros = spec.prec - len;
+    }
+
+    if (base == 10) {
+        if (negative) {
+            prefix[prefix_len++] = '-';
+        } else if ((spec.conv == 'd' || spec.conv == 'i') && (spec.flags & PRINTF_PLUS)) {
+            prefix[prefix_len++] = '+';
+        } else if ((spec.conv == 'd' || spec.conv == 'i') && (spec.flags & PRINTF_SPACE)) {
+            prefix[prefix_len++] = ' ';
+        }
+    } else if (spec.flags & PRINTF_ALT) {
+        if (base == 8) {
+            if (zeros == 0 && (len == 0 || *p != '0')) {
+                zeros = 1;
+            }
+        } else if (mag != 0) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = spec.conv;
+        }
+    }
+
+    // '0' pads out to the width, unless there is a precision or '-'
+    if ((spec.flags & (PRINTF_ZERO | PRINTF_LEFT)) == PRINTF_ZERO && spec.prec < 0 &&
+        spec.width > prefix_len + zeros + len) {
+        zeros = spec.width - prefix_len - len;
+    }
+    padded(prefix, prefix_len, zeros, p, len, spec);
+}
+
+void PrintfBuffer::string(const char *str, const printf_spec &spec)
+{
+    if (str == NULL) {
+        str = "(null)";
+    }
+    size_t len = 0;
+    while (str[len] && (spec.prec < 0 || len < (size_t)spec.prec)) {
+        len++;
+    }
+    padded("", 0, 0, str, len, spec);
+}
+
+void PrintfBuffer::pointer(const void *ptr, const printf_spec &spec)
+{
+    printf_spec hex = spec;
+    hex.conv = 'x';
+    hex.flags |= PRINTF_ALT;
+    hex.prec = -1;
+    if (ptr == NULL) {
+        // "0x0" rather than the plain "0" that %#x gives
+        padded("0x", 2, 0, "0", 1, spec);
+        return;
+    }
+    integer((uintptr_t)ptr, false, hex);
+}
+
+#ifndef PRINTF_NO_FLOAT
+static void printf_sink(void *ctx, const char *str, unsigned len)
+{
+    ((PrintfBuffer *)ctx)->write(str, len);
+}
+
+void PrintfBuffer::floating(double val, const printf_spec &spec)
+{
+    unsigned prec = spec.prec < 0 ? 6 : spec.prec;
+    char tmp[32];
+    unsigned len = dtoa_fixed_buf(val, prec, tmp, sizeof(tmp));
+    char sign = 0;
+
+    if (spec.flags & PRINTF_PLUS) {
+        sign = '+';
+    } else if (spec.flags & PRINTF_SPACE) {
+        sign = ' ';
+    }
+
+    if (len >= sizeof(tmp) - 1) {
+        // Too long to hold (1e30 and up); goes out as it is made
+        if (val < 0) {
+            sign = 0;
+        }
+        unsigned len_signed = len + (sign != 0);
+        unsigned pad = spec.width > len_signed ? spec.width - len_signed : 0;
+        if (!(spec.flags & PRINTF_LEFT)) {
+            while (pad) {
+                put(' ');
+                pad--;
+            }
+        }
+        if (sign) {
+            put(sign);
+        }
+        dtoa_fixed(val, prec, printf_sink, this);
+        while (pad--) {
+            put(' ');
+        }
+        return;
+    }
+
+    char *body = tmp;
+    if (*body == '-') {
+        sign = '-';
+        body++;
+        len--;
+    }
+    bool finite = *body >= '0' && *body <= '9';
+    if (prec == 0 && (spec.flags & PRINTF_ALT) && finite) {
+        body[len++] = '.';
+    }
+    if (spec.conv == 'F') {
+        for (unsigned i = 0; i < len; i++) {
+            if (body[i] >= 'a' && body[i] <= 'z') {
+                body[i] += 'A' - 'a';
+            }
+        }
+    }
+    unsigned zeros = 0;
+    unsigned sign_len = sign != 0;
+    if ((spec.flags & (PRINTF_ZERO | PRINTF_LEFT)) == PRINTF_ZERO && finite &&
+        spec.width > sign_len + len) {
+        zeros = spec.width - sign_len - len;
+    }
+    padded(&sign, sign_len, zeros, body, len, spec);
+}
+#endif
+
+int Print::printf(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    int ret = vprintf(format, ap);
+    va_end(ap);
+    return ret;
+}
+
+enum {
+    PRINTF_LEN_INT,
+    PRINTF_LEN_CHAR,
+    PRINTF_LEN_SHORT,
+    PRINTF_LEN_LONG,
+    PRINTF_LEN_LONG_LONG,
+    PRINTF_LEN_SIZE,
+    PRINTF_LEN_LONG_DOUBLE,
+};
+
+static unsigned printf_number(const char *&p)
+{
+    unsigned v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+    }
+    return v;
+}
+
+int Print::vprintf(const char *format, va_list ap)
+{
+    PrintfBuffer o(*this);
+    const char *p = format;
+
+    for (;;) {
+        const char *start = p;
+        while (*p && *p != '%') {
+            p++;
+        }
+        o.write(start, p - start);
+        if (!*p) {
+            break;
+        }
+
+        start = p++;
+        printf_spec spec;
+        spec.flags = 0;
+        spec.prec = -1;
+
+        for (;; p++) {
+            unsigned f = *p == '-' ? PRINTF_LEFT : *p == '+' ? PRINTF_PLUS :
+                *p == ' ' ? PRINTF_SPACE : *p == '0' ? PRINTF_ZERO :
+                *p == '#' ? PRINTF_ALT : 0;
+            if (!f) {
+                break;
+            }
+            spec.flags |= f;
+        }
+
+        unsigned width;
+        if (*p == '*') {
+            p++;
+            int w = va_arg(ap, int);
+            if (w < 0) {
+                spec.flags |= PRINTF_LEFT;
+                w = -w;
+            }
+            width = w;
+        } else {
+            width = printf_number(p);
+        }
+        spec.width = width > 255 ? 255 : width;
+
+        if (*p == '.') {
+            p++;
+            int prec;
+            if (*p == '*') {
+                p++;
+                prec = va_arg(ap, int);
+            } else {
+                prec = printf_number(p);
+            }
+            spec.prec = prec < 0 ? -1 : prec > 255 ? 255 : prec;
+        }
+
+        int len = PRINTF_LEN_INT;
+        if (*p == 'h') {
+            len = *++p == 'h' ? (p++, PRINTF_LEN_CHAR) : PRINTF_LEN_SHORT;
+        } else if (*p == 'l') {
+            len = *++p == 'l' ? (p++, PRINTF_LEN_LONG_LONG) : PRINTF_LEN_LONG;
+        } else if (*p == 'j') {
+            p++;
+            len = PRINTF_LEN_LONG_LONG;
+        } else if (*p == 'z' || *p == 't') {
+            p++;
+            len = PRINTF_LEN_SIZE;
+        } else if (*p == 'L') {
+            p++;
+            len = PRINTF_LEN_LONG_DOUBLE;
+        }
+
+        spec.conv = *p;
+        switch (spec.conv) {
+        case 'd':
+        case 'i': {
+            long long v;
+            switch (len) {
+            case PRINTF_LEN_CHAR: v = (signed char)va_arg(ap, int); break;
+            case PRINTF_LEN_SHORT: v = (short)va_arg(ap, int); break;
+            case PRINTF_LEN_LONG: v = va_arg(ap, long); break;
+            case PRINTF_LEN_LONG_LONG: v = va_arg(ap, long long); break;
+            case PRINTF_LEN_SIZE: v = (long long)va_arg(ap, ptrdiff_t); break;
+            default: v = va_arg(ap, int); break;
+            }
+            o.integer(v < 0 ? -(unsigned long long)v : v, v < 0, spec);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            unsigned long long v;
+            switch (len) {
+            case PRINTF_LEN_CHAR: v = (unsigned char)va_arg(ap, unsigned); break;
+            case PRINTF_LEN_SHORT: v = (unsigned short)va_arg(ap, unsigned); break;
+            case PRINTF_LEN_LONG: v = va_arg(ap, unsigned long); break;
+            case PRINTF_LEN_LONG_LONG: v = va_arg(ap, unsigned long long); break;
+            case PRINTF_LEN_SIZE: v = va_arg(ap, size_t); break;
+            default: v = va_arg(ap, unsigned); break;
+            }
+            o.integer(v, false, spec);
+            break;
+        }
+        case 'c':
+            o.integer((unsigned char)va_arg(ap, int), false, spec);
+            break;
+        case 's':
+            o.string(va_arg(ap, const char *), spec);
+            break;
+        case 'p':
+            o.pointer(va_arg(ap, void *), spec);
+            break;
+        case 'f':
+        case 'F': {
+            double v = (len == PRINTF_LEN_LONG_DOUBLE ?
+                        (double)va_arg(ap, long double) : va_arg(ap, double));
+#ifndef PRINTF_NO_FLOAT
+            o.floating(v, spec);
+#else
+            (void)v;
+            o.put('?');
+#endif
+            break;
+        }
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            // Not supported, but the argument still has to be skipped
+            if (len == PRINTF_LEN_LONG_DOUBLE) {
+                (void)va_arg(ap, long double);
+            } else {
+                (void)va_arg(ap, double);
+            }
+            o.write(start, p + 1 - start);
+            break;
+        case 'n':
+            (void)va_arg(ap, void *);
+            break;
+        case '%':
+            o.put('%');
+            break;
+        default:
+            // Not one we know; print it as it is
+            if (!*p) {
+                p--;
+            }
+            o.write(start, p + 1 - start);
+            break;
+        }
+        p++;
+    }
+
+    o.flush();
+    return o.length();
+}
@@ -0,0 +1,425 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/Printf.h
+ * @brief Buffered printf() formatting, and PRINTF(), its checked form.
+ *
+ * Print::printf() parses the format as it goes. PRINTF() does the
+ * parsing at compile time instead:
+ *
+ *     PRINTF(Serial, "t=%lu ms, %s: %6.2f\n", millis(), name, volts);
+ *
+ * The format must be a string literal. A conversion that doesn't
+ * match its argument, or a wrong number of arguments, is a compile
+ * error. The literal text between conversions and where each one
+ * starts, ends and what its flags, width and precision are, are all
+ * constants; at run time only the arguments get converted. The
+ * argument types choose the conversion, so length modifiers (l, ll,
+ * h, z) are accepted but not needed. Width and precision have to be
+ * numbers ('*' is only for printf()), and there can be at most
+ * PRINTF_MAX_CONVERSIONS conversions, %% included.
+ *
+ * Both write PRINTF_BUFFER_SIZE bytes at a time. With PRINTF_NO_FLOAT
+ * defined, %f is left out, and so is the float converter.
+ *
+ * PRINTF() needs a C++11 compiler; without one, only printf() is
+ * available.
+ */
+
+#ifndef _WIRISH_PRINTF_H_
+#define _WIRISH_PRINTF_H_
+
+#include "Print.h"
+
+#ifndef PRINTF_BUFFER_SIZE
+#define PRINTF_BUFFER_SIZE 32
+#endif
+
+#define PRINTF_MAX_CONVERSIONS 10
+
+/* Conversion flags */
+#define PRINTF_LEFT     0x01    /* '-' */
+#define PRINTF_PLUS     0x02    /* '+' */
+#define PRINTF_SPACE    0x04    /* ' ' */
+#define PRINTF_ZERO     0x08    /* '0' */
+#define PRINTF_ALT      0x10    /* '#' */
+
+/** One conversion: flags, width, precision (-1 if none) and letter. */
+struct printf_spec {
+    uint8 flags;
+    uint8 width;
+    int16 prec;
+    char conv;
+};
+
+/**
+ * @brief Collects formatted output and writes it to a Print in bulk.
+ */
+class PrintfBuffer {
+public:
+    explicit PrintfBuffer(Print &out) : out(out), n(0), total(0) {}
+
+    void write(const char *str, size_t len);
+    void put(char c) {
+        if (n == sizeof(buf)) {
+            flush();
+        }
+        buf[n++] = c;
+        total++;
+    }
+    void flush();
+
+    /** Characters produced so far. */
+    size_t length() const { return total; }
+
+    /** An integer conversion (d, i, u, o, x, X or c) of -mag if
+     * negative, else of mag. */
+    void integer(unsigned long long mag, bool negative, const printf_spec &spec);
+    void string(const char *str, const printf_spec &spec);
+    void pointer(const void *ptr, const printf_spec &spec);
+#ifndef PRINTF_NO_FLOAT
+    void floating(double val, const printf_spec &spec);
+#endif
+
+private:
+    void padded(const char *prefix, unsigned prefix_len, unsigned zeros,
+                const char *body, unsigned body_len, const printf_spec &spec);
+
+    Print &out;
+    size_t n;
+    size_t total;
+    char buf[PRINTF_BUFFER_SIZE];
+};
+
+/* PRINTF() needs C++11; printf() doesn't. */
+#if __cplusplus >= 201103L
+
+namespace wirish {
+namespace priv {
+
+/*
+ * Compile-time format parsing. A conversion is packed into 64 bits:
+ *
+ *   0-9   offset of the '%'         10-19 offset past the letter
+ *   20-27 letter                    28-32 flags
+ *   33-40 width                     41-48 precision + 1, 0 if none
+ *   49    set for every conversion, so that 0 means "no more"
+ *
+ * All of this is C++11 constexpr, hence the single-expression style.
+ */
+typedef unsigned long long printf_packed;
+
+constexpr bool printf_is_digit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr unsigned printf_flag(char c) {
+    return c == '-' ? PRINTF_LEFT : c == '+' ? PRINTF_PLUS :
+        c == ' ' ? PRINTF_SPACE : c == '0' ? PRINTF_ZERO :
+        c == '#' ? PRINTF_ALT : 0;
+}
+
+constexpr unsigned printf_find(const char *f, unsigned i) {
+    return !f[i] || f[i] == '%' ? i : printf_find(f, i + 1);
+}
+
+constexpr unsigned printf_skip_flags(const char *f, unsigned i) {
+    return printf_flag(f[i]) ? printf_skip_flags(f, i + 1) : i;
+}
+
+constexpr unsigned printf_flags(const char *f, unsigned i) {
+    return printf_flag(f[i]) ? printf_flag(f[i]) | printf_flags(f, i + 1) : 0;
+}
+
+constexpr unsigned printf_skip_digits(const char *f, unsigned i) {
+    return printf_is_digit(f[i]) ? printf_skip_digits(f, i + 1) : i;
+}
+
+constexpr unsigned printf_number(const char *f, unsigned i, unsigned acc) {
+    return printf_is_digit(f[i]) ? printf_number(f, i + 1, acc * 10 + (f[i] - '0')) : acc;
+}
+
+constexpr unsigned printf_skip_length(const char *f, unsigned i) {
+    return f[i] == 'h' || f[i] == 'l' || f[i] == 'z' || f[i] == 'j' ||
+        f[i] == 't' ? printf_skip_length(f, i + 1) : i;
+}
+
+/* Offset of the width, of the precision's '.', and of the letter */
+constexpr unsigned printf_width_at(const char *f, unsigned p) {
+    return printf_skip_flags(f, p + 1);
+}
+
+constexpr unsigned printf_dot_at(const char *f, unsigned p) {
+    return printf_skip_digits(f, printf_width_at(f, p));
+}
+
+constexpr unsigned printf_conv_at(const char *f, unsigned p) {
+    return printf_skip_length(f, f[printf_dot_at(f, p)] == '.' ?
+                              printf_skip_digits(f, printf_dot_at(f, p) + 1) :
+                              printf_dot_at(f, p));
+}
+
+constexpr unsigned printf_end(const char *f, unsigned p) {
+    return f[printf_conv_at(f, p)] ? printf_conv_at(f, p) + 1 : printf_conv_at(f, p);
+}
+
+constexpr printf_packed printf_pack(const char *f, unsigned p) {
+    return (printf_packed)p |
+        (printf_packed)printf_end(f, p) << 10 |
+        (printf_packed)(unsigned char)f[printf_conv_at(f, p)] << 20 |
+        (printf_packed)printf_flags(f, p + 1) << 28 |
+        (printf_packed)(printf_number(f, printf_width_at(f, p), 0) & 0xFF) << 33 |
+        (printf_packed)(f[printf_dot_at(f, p)] == '.' ?
+                        (printf_number(f, printf_dot_at(f, p) + 1, 0) & 0xFF) + 1 : 0) << 41 |
+        (printf_packed)1 << 49;
+}
+
+/* The k-th conversion at or after offset p, or 0 */
+constexpr printf_packed printf_conversion_from(const char *f, unsigned p, unsigned k) {
+    return !f[p] ? 0 : k == 0 ? printf_pack(f, p) :
+        printf_conversion_from(f, printf_find(f, printf_end(f, p)), k - 1);
+}
+
+constexpr printf_packed printf_conversion(const char *f, unsigned k) {
+    return printf_conversion_from(f, printf_find(f, 0), k);
+}
+
+constexpr unsigned printf_start_of(printf_packed c) { return c & 0x3FF; }
+constexpr unsigned printf_end_of(printf_packed c) { return (c >> 10) & 0x3FF; }
+constexpr char printf_letter_of(printf_packed c) { return (char)((c >> 20) & 0xFF); }
+
+inline printf_spec printf_unpack(printf_packed c) {
+    printf_spec s;
+    s.flags = (c >> 28) & 0x1F;
+    s.width = (c >> 33) & 0xFF;
+    s.prec = (int16)((c >> 41) & 0xFF) - 1;
+    s.conv = printf_letter_of(c);
+    return s;
+}
+
+/* The format's length and conversions, as a type */
+template <unsigned Len, printf_packed... C>
+struct printf_layout {};
+
+/* What the conversions take */
+enum {
+    PRINTF_ARG_NONE,
+    PRINTF_ARG_SIGNED,
+    PRINTF_ARG_UNSIGNED,
+    PRINTF_ARG_FLOAT,
+    PRINTF_ARG_STRING,
+    PRINTF_ARG_POINTER,
+};
+
+template <class T> struct printf_kind { static const int value = PRINTF_ARG_NONE; };
+template <class T> struct printf_kind<T*> { static const int value = PRINTF_ARG_POINTER; };
+#define PRINTF_KIND(type, kind) \
+    template <> struct printf_kind<type> { static const int value = kind; }
+PRINTF_KIND(bool, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(char, PRINTF_ARG_SIGNED);
+PRINTF_KIND(signed char, PRINTF_ARG_SIGNED);
+PRINTF_KIND(unsigned char, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(short, PRINTF_ARG_SIGNED);
+PRINTF_KIND(unsigned short, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(int, PRINTF_ARG_SIGNED);
+PRINTF_KIND(unsigned int, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(long, PRINTF_ARG_SIGNED);
+PRINTF_KIND(unsigned long, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(long long, PRINTF_ARG_SIGNED);
+PRINTF_KIND(unsigned long long, PRINTF_ARG_UNSIGNED);
+PRINTF_KIND(float, PRINTF_ARG_FLOAT);
+PRINTF_KIND(double, PRINTF_ARG_FLOAT);
+PRINTF_KIND(char*, PRINTF_ARG_STRING);
+PRINTF_KIND(const char*, PRINTF_ARG_STRING);
+PRINTF_KIND(String, PRINTF_ARG_STRING);
+#undef PRINTF_KIND
+template <size_t N> struct printf_kind<char[N]> { static const int value = PRINTF_ARG_STRING; };
+template <size_t N> struct printf_kind<const char[N]> { static const int value = PRINTF_ARG_STRING; };
+
+constexpr bool printf_accepts(char letter, int kind) {
+    return (letter == 'd' || letter == 'i' || letter == 'u' || letter == 'o' ||
+            letter == 'x' || letter == 'X' || letter == 'c') ?
+        kind == PRINTF_ARG_SIGNED || kind == PRINTF_ARG_UNSIGNED :
+#ifndef PRINTF_NO_FLOAT
+        (letter == 'f' || letter == 'F') ? kind == PRINTF_ARG_FLOAT :
+#endif
+        letter == 's' ? kind == PRINTF_ARG_STRING :
+        letter == 'p' ? kind == PRINTF_ARG_POINTER || kind == PRINTF_ARG_STRING :
+        false;
+}
+
+/* Do the conversions C match the argument types A? */
+template <class C, class... A> struct printf_match;
+
+template <unsigned Len>
+struct printf_match<printf_layout<Len> > {
+    static const bool value = true;
+};
+
+template <unsigned Len, class T, class... A>
+struct printf_match<printf_layout<Len>, T, A...> {
+    static const bool value = false;
+};
+
+template <unsigned Len, printf_packed C, printf_packed... Rest>
+struct printf_match<printf_layout<Len, C, Rest...> > {
+    static const bool value = (C == 0 || printf_letter_of(C) == '%') &&
+        printf_match<printf_layout<Len, Rest...> >::value;
+};
+
+template <unsigned Len, printf_packed C, printf_packed... Rest, class T, class... A>
+struct printf_match<printf_layout<Len, C, Rest...>, T, A...> {
+    static const bool value = printf_letter_of(C) == '%' ?
+        printf_match<printf_layout<Len, Rest...>, T, A...>::value :
+        C != 0 && printf_accepts(printf_letter_of(C), printf_kind<T>::value) &&
+        printf_match<printf_layout<Len, Rest...>, A...>::value;
+};
+
+/* The K-th of C */
+template <unsigned K, printf_packed... C> struct printf_nth;
+
+template <printf_packed C, printf_packed... Rest>
+struct printf_nth<0, C, Rest...> {
+    static const printf_packed value = C;
+};
+
+template <unsigned K, printf_packed C, printf_packed... Rest>
+struct printf_nth<K, C, Rest...> : printf_nth<K - 1, Rest...> {};
+
+/* Converting one argument */
+template <int Kind> struct printf_tag {};
+
+template <class T>
+inline void printf_put(PrintfBuffer &o, const printf_spec &s, const T &v,
+                       printf_tag<PRINTF_ARG_SIGNED>) {
+    if (s.conv == 'd' || s.conv == 'i') {
+        long long x = v;
+        o.integer(x < 0 ? -(unsigned long long)x : x, x < 0, s);
+    } else {
+        // Unsigned conversions see the bits of the argument's own size
+        unsigned long long mask = sizeof(T) < sizeof(mask) ?
+            (1ULL << (8 * sizeof(T) % 64)) - 1 : ~0ULL;
+        o.integer((unsigned long long)v & mask, false, s);
+    }
+}
+
+template <class T>
+inline void printf_put(PrintfBuffer &o, const printf_spec &s, const T &v,
+                       printf_tag<PRINTF_ARG_UNSIGNED>) {
+    o.integer(v, false, s);
+}
+
+#ifndef PRINTF_NO_FLOAT
+template <class T>
+inline void printf_put(PrintfBuffer &o, const printf_spec &s, const T &v,
+                       printf_tag<PRINTF_ARG_FLOAT>) {
+    o.floating(v, s);
+}
+#endif
+
+inline const char *printf_c_str(const char *s) { return s; }
+inline const char *printf_c_str(const String &s) { return s.c_str(); }
+
+template <class T>
+inline void printf_put(PrintfBuffer &o, const printf_spec &s, const T &v,
+                       printf_tag<PRINTF_ARG_STRING>) {
+    if (s.conv == 'p') {
+        o.pointer(printf_c_str(v), s);
+    } else {
+        o.string(printf_c_str(v), s);
+    }
+}
+
+template <class T>
+inline void printf_put(PrintfBuffer &o, const printf_spec &s, const T &v,
+                       printf_tag<PRINTF_ARG_POINTER>) {
+    o.pointer(v, s);
+}
+
+/* Literal text, and any %% before the next conversion */
+inline unsigned printf_literal(PrintfBuffer &o, const char *fmt,
+                               const printf_packed *&c, unsigned pos) {
+    while (*c && printf_letter_of(*c) == '%') {
+        o.write(fmt + pos, printf_start_of(*c) - pos + 1);
+        pos = printf_end_of(*c++);
+    }
+    return pos;
+}
+
+inline void printf_emit(PrintfBuffer &o, const char *fmt, unsigned len,
+                        const printf_packed *c, unsigned pos) {
+    pos = printf_literal(o, fmt, c, pos);
+    o.write(fmt + pos, len - pos);
+}
+
+template <class T, class... A>
+inline void printf_emit(PrintfBuffer &o, const char *fmt, unsigned len,
+                        const printf_packed *c, unsigned pos,
+                        const T &v, const A &... rest) {
+    pos = printf_literal(o, fmt, c, pos);
+    o.write(fmt + pos, printf_start_of(*c) - pos);
+    printf_put(o, printf_unpack(*c), v, printf_tag<printf_kind<T>::value>());
+    printf_emit(o, fmt, len, c + 1, printf_end_of(*c), rest...);
+}
+
+template <unsigned Len, printf_packed... C, class... A>
+size_t printf_checked(Print &out, printf_layout<Len, C...>, const char *fmt,
+                      const A &... args) {
+    static const printf_packed conversions[] = { C... };
+    static_assert(Len < 1024, "PRINTF: format too long");
+    static_assert(printf_nth<PRINTF_MAX_CONVERSIONS, C...>::value == 0,
+                  "PRINTF: too many conversions");
+    static_assert(printf_match<printf_layout<Len, C...>, A...>::value,
+                  "PRINTF: the conversions don't match the arguments");
+    PrintfBuffer o(out);
+    printf_emit(o, fmt, Len, conversions, 0, args...);
+    o.flush();
+    return o.length();
+}
+
+}
+}
+
+#define PRINTF_CONVERSIONS_(f)                                          \
+    wirish::priv::printf_conversion(f, 0), wirish::priv::printf_conversion(f, 1), \
+    wirish::priv::printf_conversion(f, 2), wirish::priv::printf_conversion(f, 3), \
+    wirish::priv::printf_conversion(f, 4), wirish::priv::printf_conversion(f, 5), \
+    wirish::priv::printf_conversion(f, 6), wirish::priv::printf_conversion(f, 7), \
+    wirish::priv::printf_conversion(f, 8), wirish::priv::printf_conversion(f, 9), \
+    wirish::priv::printf_conversion(f, 10)
+
+/**
+ * @brief printf() to out with a literal format, checked at compile time.
+ * @return Number of characters produced.
+ */
+#define PRINTF(out, fmt, ...)                                           \
+    wirish::priv::printf_checked(                                       \
+        (out),                                                          \
+        wirish::priv::printf_layout<sizeof(fmt) - 1, PRINTF_CONVERSIONS_(fmt)>(), \
+        fmt, ##__VA_ARGS__)
+
+#endif /* __cplusplus >= 201103L */
+
+#endif
@@ -91,36 +91,96 @@ bool  Stream::findUntil(char *target, char *terminator)
   return findUntil(target, strlen(target), terminator, strlen(terminator));
 }
 
+// Knuth-Morris-Pratt matching of one string against stream bytes:
+// on a mismatch, the part of the string already matched is known,
+// so the search falls back to its longest border (proper prefix
+// that is also a suffix) instead of starting over, and never needs
+// to see a byte twice. The borders of the first STREAM_MATCH_TABLE
+// prefixes are kept in a table; longer ones are worked out when
+// needed.
+#define STREAM_MATCH_TABLE 32
+
+class StreamMatch
+{
+  public:
+    StreamMatch(const char *str, size_t len) : str(str), len(len), index(0)
+    {
+      size_t n = len < STREAM_MATCH_TABLE ? len : STREAM_MATCH_TABLE;
+      if (n) fail[0] = 0;
+      for (size_t k = 1; k < n; k++) {
+        uint8 b = fail[k - 1];
+        while (b > 0 && str[k] != str[b])
+          b = fail[b - 1];
+        if (str[k] == str[b])
+          b++;
+        fail[k] = b;
+      }
+    }
+
+    // feed the next byte; true once the whole string has been seen
+    bool step(char c)
+    {
+      while (index > 0 && c != str[index])
+        index = border(index);
+      if (c == str[index])
+        index++;
+      return index >= len;
+    }
+
+  private:
+    // length of the longest border of the first n characters
+    size_t border(size_t n)
+    {
+      if (n <= STREAM_MATCH_TABLE)
+        return fail[n - 1];
+      size_t b = n - 1;
+      while (b > 0 && memcmp(str, str + n - b, b) != 0)
+        b--;
+      return b;
+    }
+
+    const char *str;
+    size_t len;
+    size_t index;
+    uint8 fail[STREAM_MATCH_TABLE];
+};
+
 // reads data from the stream until the target string of the given length is found
 // search terminated if the terminator string is found
 // returns true if target string is found, false if terminated or timed out
+// bytes already received are scanned in place (see readSpan())
 bool Stream::findUntil(char *target, size_t targetLen, char *terminator, size_t termLen)
 {
-  size_t index = 0;  // maximum target string length is 64k bytes!
-  size_t termIndex = 0;
-  int c;
-
-  if ( *target == 0)
+  if (targetLen == 0)
     return true;   // return true if target is a null string
-  while ( (c = timedRead()) > 0) {
-
-    if (c != target[index])
-      index = 0; // reset index if any char does not match
+  StreamMatch t(target, targetLen);
+  StreamMatch term(terminator, termLen);
 
-    if ( c == target[index]) {
-      //////Serial.print("found "); Serial.write(c); Serial.print("index now"); Serial.println(index+1);
-      if (++index >= targetLen) { // return true if all chars in the target match
+  while (1) {
+    const uint8 *span;
+    size_t n = readSpan(&span);
+    if (n == 0) {
+      int c = timedRead();
+      if (c < 0)
+        return false;  // timed out
+      if (t.step(c))
+        return true;
+      if (termLen > 0 && term.step(c))
+        return false;  // return false if terminate string found before target string
+      continue;
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (t.step(span[i])) {
+        readCommit(i + 1);
         return true;
       }
+      if (termLen > 0 && term.step(span[i])) {
+        readCommit(i + 1);
+        return false;
+      }
     }
-
-    if (termLen > 0 && c == terminator[termIndex]) {
-      if (++termIndex >= termLen)
-        return false;       // return false if terminate string found before target string
-    } else
-      termIndex = 0;
+    readCommit(n);
   }
-  return false;
 }
 
 
@@ -176,7 +236,7 @@ float Stream::parseFloat(char skipChar)
   boolean isFraction = false;
   long value = 0;
   int c;
-  float fraction = 1.0;
+  int decimals = 0;
 
   c = peekNextDigit();
   // ignore non numeric leading characters
@@ -193,7 +253,7 @@ float Stream::parseFloat(char skipChar)
     else if (c >= '0' && c <= '9')  {     // is c a digit?
       value = value * 10 + c - '0';
       if (isFraction)
-        fraction *= 0.1;
+        decimals++;
     }
     read();  // consume the character we got with peek
     c = timedPeek();
@@ -201,10 +261,13 @@ float Stream::parseFloat(char skipChar)
 
   if (isNegative)
     value = -value;
-  if (isFraction)
-    return value * fraction;
-  else
-    return value;
+  if (isFraction) {
+    float scale = 1;  // exact up to 1e10
+    while (decimals-- > 0)
+      scale *= 10;
+    return value / scale;  // one rounding, not one per digit
+  }
+  return value;
 }
 
 // read characters from stream into buffer
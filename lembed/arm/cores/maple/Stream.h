@@ -50,6 +50,16 @@ class Stream : public Print
     virtual int peek() = 0;
     virtual void flush() = 0;
 
+    // Zero-copy input, for streams with a receive buffer:
+    // readSpan() points span at the longest run of bytes already
+    // received that lie together in memory, and returns how many;
+    // they stay where they are until readCommit() drops len of them.
+    // readCommit() returns false if the receiver had to overwrite
+    // some of them meanwhile. The defaults have no buffer to show,
+    // and readers then fall back to read().
+    virtual size_t readSpan(const uint8 **span) { return 0; }
+    virtual bool readCommit(size_t len) { return true; }
+
     Stream() {_timeout=1000;}
 
 // parsing methods
@@ -0,0 +1,293 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/StreamReader.cpp
+ * @brief Line reader and tokenizer over a Stream's receive buffer.
+ */
+
+#include "StreamReader.h"
+
+/*
+ * Span
+ */
+
+int Span::indexOf(char c, size_t from) const
+{
+    if (from >= len) {
+        return -1;
+    }
+    const char *p = (const char *)memchr(ptr + from, c, len - from);
+    return p ? p - ptr : -1;
+}
+
+Span Span::trim() const
+{
+    size_t start = 0;
+    size_t end = len;
+    while (start < end && (ptr[start] == ' ' || ptr[start] == '\t')) {
+        start++;
+    }
+    while (end > start && (ptr[end - 1] == ' ' || ptr[end - 1] == '\t')) {
+        end--;
+    }
+    return Span(ptr + start, end - start);
+}
+
+bool Span::equals(const char *s) const
+{
+    return s && strlen(s) == len && memcmp(ptr, s, len) == 0;
+}
+
+bool Span::startsWith(const char *s) const
+{
+    size_t n = strlen(s);
+    return n <= len && memcmp(ptr, s, n) == 0;
+}
+
+/* Sign, digits and decimals of a number, without overflow checks */
+struct SpanNumber {
+    bool negative;
+    unsigned long whole;    // up to 9 significant digits
+    unsigned long frac;     // first decimals digits after the point
+    unsigned decimals;      // how many of them there were
+    int round;              // the digit after those, or -1
+    bool overflow;
+};
+
+static bool parseNumber(const char *p, size_t len, bool point, unsigned max_decimals,
+                        SpanNumber &num)
+{
+    const char *end = p + len;
+    bool digits = false;
+
+    num.negative = false;
+    num.whole = 0;
+    num.frac = 0;
+    num.decimals = 0;
+    num.round = -1;
+    num.overflow = false;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        num.negative = *p++ == '-';
+    }
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (num.whole > (0xFFFFFFFFUL - 9) / 10) {
+            num.overflow = true;
+        }
+        num.whole = num.whole * 10 + (*p - '0');
+        digits = true;
+    }
+    if (point && p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (num.decimals < max_decimals) {
+                num.frac = num.frac * 10 + (*p - '0');
+                num.decimals++;
+            } else if (num.round < 0) {
+                num.round = *p - '0';
+            }
+            digits = true;
+        }
+    }
+    return digits && p == end;
+}
+
+static bool fitsLong(unsigned long mag, bool negative, long &value)
+{
+    if (mag > (negative ? 0x80000000UL : 0x7FFFFFFFUL)) {
+        return false;
+    }
+    value = negative ? -(long)(mag - 1) - 1 : (long)mag;
+    return true;
+}
+
+bool Span::toLong(long &value) const
+{
+    SpanNumber num;
+    if (!parseNumber(ptr, len, false, 0, num) || num.overflow) {
+        return false;
+    }
+    return fitsLong(num.whole, num.negative, value);
+}
+
+bool Span::toFixed(long &value, unsigned decimals) const
+{
+    SpanNumber num;
+    if (decimals > 9 || !parseNumber(ptr, len, true, decimals, num) || num.overflow) {
+        return false;
+    }
+    unsigned long long mag = num.whole;
+    unsigned long frac = num.frac;
+    for (unsigned i = 0; i < decimals; i++) {
+        mag *= 10;
+        if (i >= num.decimals) {
+            frac *= 10;
+        }
+    }
+    mag += frac + (num.round >= 5);
+    if (mag > 0xFFFFFFFFULL) {
+        return false;
+    }
+    return fitsLong((unsigned long)mag, num.negative, value);
+}
+
+bool Span::toFloat(float &value) const
+{
+    // Nine decimals are more than a float holds
+    SpanNumber num;
+    if (!parseNumber(ptr, len, true, 9, num) || num.overflow) {
+        return false;
+    }
+    unsigned long scale = 1;
+    for (unsigned i = 0; i < num.decimals; i++) {
+        scale *= 10;
+    }
+    // All the digits as one integer, divided once
+    double v = (double)((unsigned long long)num.whole * scale + num.frac) / scale;
+    value = num.negative ? -v : v;
+    return true;
+}
+
+/*
+ * StreamReader
+ */
+
+StreamReader::StreamReader(Stream &in, char *buf, size_t size)
+    : in(in), buf(buf), size(size), len(0), held(0), dropped(0), last(0),
+      partial(false), cut(false)
+{
+}
+
+bool StreamReader::release()
+{
+    bool intact = true;
+
+    if (held) {
+        intact = in.readCommit(held);
+        held = 0;
+    }
+    remaining = Span();
+    return intact;
+}
+
+/* Add n bytes to the line in buf; if they end it, make it the
+ * current line */
+bool StreamReader::append(const char *data, size_t n, bool end, Span &line)
+{
+    size_t room = size - len;
+    if (n > room) {
+        dropped += n - room;
+        last = data[n - 1];
+        n = room;
+    }
+    memcpy(buf + len, data, n);
+    len += n;
+    partial = true;
+    if (!end) {
+        return false;
+    }
+    // A '\r' before the '\n' doesn't count, even if it didn't fit
+    if (dropped == 0 && len && buf[len - 1] == '\r') {
+        len--;
+    }
+    cut = dropped > (last == '\r' ? 1U : 0U);
+    line = remaining = Span(buf, len);
+    len = 0;
+    dropped = 0;
+    partial = false;
+    return true;
+}
+
+bool StreamReader::readLine(Span &line)
+{
+    release();
+    cut = false;
+
+    for (;;) {
+        const uint8 *span;
+        size_t n = in.readSpan(&span);
+
+        if (n == 0) {
+            // Nothing in place; a byte at a time, if at all
+            if (in.available() <= 0) {
+                return false;
+            }
+            char c = in.read();
+            if (append(&c, c != '\n', c == '\n', line)) {
+                return true;
+            }
+            continue;
+        }
+
+        const char *data = (const char *)span;
+        const char *nl = (const char *)memchr(data, '\n', n);
+        if (!nl) {
+            append(data, n, false, line);
+            in.readCommit(n);
+            continue;
+        }
+
+        size_t used = nl - data;
+        if (!partial) {
+            // The whole line is in place: leave it there
+            if (used && data[used - 1] == '\r') {
+                used--;
+            }
+            if (used > size) {
+                // Same cut as for a line that has to be copied
+                used = size;
+                cut = true;
+            }
+            line = remaining = Span(data, used);
+            held = nl - data + 1;
+            return true;
+        }
+        append(data, used, true, line);
+        in.readCommit(used + 1);
+        return true;
+    }
+}
+
+bool StreamReader::nextToken(Span &token, const char *delims)
+{
+    const char *p = remaining.data();
+    const char *end = p + remaining.length();
+
+    while (p < end && *p && strchr(delims, *p)) {
+        p++;
+    }
+    if (p == end) {
+        remaining = Span(end, 0);
+        return false;
+    }
+    const char *start = p;
+    while (p < end && !(*p && strchr(delims, *p))) {
+        p++;
+    }
+    token = Span(start, p - start);
+    remaining = Span(p, end - p);
+    return true;
+}
@@ -0,0 +1,185 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/StreamReader.h
+ * @brief Line reader and tokenizer that works on a Stream's own
+ *        receive buffer.
+ *
+ * Stream's parsing methods take one byte at a time through read()
+ * and peek(), each waiting on millis(). A StreamReader instead takes
+ * whole runs of received bytes from the serial port's buffer (see
+ * Stream::readSpan()), and hands out lines and tokens as Spans that
+ * point into it. Only a line that wraps around the end of that
+ * buffer is copied, into one supplied by the caller:
+ *
+ *     char lineBuf[96];
+ *     StreamReader reader(Serial, lineBuf, sizeof(lineBuf));
+ *
+ *     void loop() {
+ *         Span line, word;
+ *         long x;
+ *         while (reader.readLine(line)) {
+ *             while (reader.nextToken(word)) {
+ *                 if (word[0] == 'X' && word.sub(1).toFixed(x, 3)) {
+ *                     // x is in thousandths
+ *                 }
+ *             }
+ *         }
+ *     }
+ *
+ * readLine() never waits: it returns false until a whole line is in.
+ *
+ * While a line is used in place, the Stream has to leave its bytes
+ * alone. HardwareSerial's RX interrupt does: with the buffer full, it
+ * drops new bytes instead. Circular RX DMA (enableDMA()) can't be
+ * held back, and overwrites the line if it gets a whole buffer ahead;
+ * release() then returns false, and whatever was made of the line
+ * should be thrown away.
+ */
+
+#ifndef _WIRISH_STREAMREADER_H_
+#define _WIRISH_STREAMREADER_H_
+
+#include <string.h>
+#include "Stream.h"
+
+/**
+ * @brief Characters that are stored elsewhere; not NUL-terminated.
+ */
+class Span {
+public:
+    Span() : ptr(""), len(0) {}
+    Span(const char *ptr, size_t len) : ptr(ptr), len(len) {}
+
+    const char *data() const { return ptr; }
+    size_t length() const { return len; }
+    bool isEmpty() const { return len == 0; }
+    char operator[](size_t index) const { return index < len ? ptr[index] : 0; }
+
+    /** The len characters from start on, or as many as there are. */
+    Span sub(size_t start, size_t n = (size_t)-1) const {
+        if (start > len) {
+            start = len;
+        }
+        return Span(ptr + start, n < len - start ? n : len - start);
+    }
+    /** Index of the first c at or after from, or -1. */
+    int indexOf(char c, size_t from = 0) const;
+    /** Without leading and trailing spaces and tabs. */
+    Span trim() const;
+
+    bool equals(const char *s) const;
+    bool startsWith(const char *s) const;
+    bool operator==(const char *s) const { return equals(s); }
+    bool operator!=(const char *s) const { return !equals(s); }
+
+    /*
+     * Number parsing. The whole span must be the number, with an
+     * optional sign; on anything else, or overflow, these return
+     * false and leave value alone.
+     */
+
+    /** A decimal integer. */
+    bool toLong(long &value) const;
+    /**
+     * A decimal number with up to one point, in units of
+     * 10^-decimals: "-1.5" with 3 decimals is -1500. Further digits
+     * are rounded, half away from zero.
+     */
+    bool toFixed(long &value, unsigned decimals) const;
+    /** A decimal number with up to one point. */
+    bool toFloat(float &value) const;
+
+private:
+    const char *ptr;
+    size_t len;
+};
+
+/**
+ * @brief Splits a Stream into lines, and lines into tokens.
+ */
+class StreamReader {
+public:
+    /**
+     * @param in   Stream to read from.
+     * @param buf  Storage for lines that can't be used in place.
+     * @param size Size of buf: the longest line kept whole. Longer
+     *             lines are cut short, see truncated().
+     */
+    StreamReader(Stream &in, char *buf, size_t size);
+
+    /**
+     * @brief Take the next line, if a whole one has arrived.
+     *
+     * The line is what came before the next '\n', without a '\r'
+     * before it. It stays valid, and its bytes stay in the Stream's
+     * buffer, until the next readLine() or release().
+     *
+     * @return true if line was set; false if no whole line is in yet.
+     */
+    bool readLine(Span &line);
+
+    /**
+     * @brief Take the next token of the current line.
+     * @param token Set to the next run of characters not in delims.
+     * @param delims Characters that separate tokens.
+     * @return false if the line has no more tokens.
+     */
+    bool nextToken(Span &token, const char *delims = " \t");
+
+    /** What nextToken() hasn't taken yet of the current line. */
+    Span rest() const { return remaining; }
+
+    /** True if the current line was longer than the buffer. */
+    bool truncated() const { return cut; }
+
+    /**
+     * @brief Let the Stream reuse the current line's space.
+     * @return false if the Stream overwrote the line while it was in
+     *         use; see above.
+     */
+    bool release();
+
+private:
+    StreamReader(const StreamReader &);
+    StreamReader &operator=(const StreamReader &);
+
+    bool append(const char *data, size_t n, bool end, Span &line);
+
+    Stream &in;
+    char *buf;
+    size_t size;
+    size_t len;       // bytes of an unfinished line in buf
+    size_t held;      // bytes of the current line left in the Stream
+    size_t dropped;   // bytes of the unfinished line that didn't fit
+    char last;        // the last of them
+    bool partial;     // an unfinished line has been started
+    bool cut;
+    Span remaining;
+};
+
+#endif
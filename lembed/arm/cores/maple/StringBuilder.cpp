@@ -0,0 +1,56 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/StringBuilder.cpp
+ * @brief Fixed-capacity strings that are written through Print.
+ */
+
+#include "StringBuilder.h"
+
+size_t StringBuilder::write(uint8 ch)
+{
+    if (len + 1 >= size) {
+        setWriteError();
+        return 0;
+    }
+    buf[len++] = ch;
+    buf[len] = 0;
+    return 1;
+}
+
+size_t StringBuilder::write(const void *data, uint32 n)
+{
+    size_t room = size - 1 - len;
+    if (n > room) {
+        n = room;
+        setWriteError();
+    }
+    memcpy(buf + len, data, n);
+    len += n;
+    buf[len] = 0;
+    return n;
+}
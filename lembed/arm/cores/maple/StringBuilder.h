@@ -0,0 +1,149 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/StringBuilder.h
+ * @brief Fixed-capacity strings that are written through Print.
+ *
+ * A StringBuilder formats into a buffer it is given, and a
+ * StaticString<N> into one of N characters inside itself; neither
+ * ever allocates. Both are Print, so every print() and println()
+ * works on them, and Printable, so a whole record goes out in one
+ * bulk write:
+ *
+ *     StaticString<64> line;
+ *     line.print("t=");
+ *     line.print(millis());
+ *     line.print(" v=");
+ *     line.println(analogRead(A0));
+ *     Serial.print(line);
+ *
+ * Output that doesn't fit is dropped, and sets the write error.
+ */
+
+#ifndef _WIRISH_STRINGBUILDER_H_
+#define _WIRISH_STRINGBUILDER_H_
+
+#include <string.h>
+#include "Print.h"
+#include "Printable.h"
+#include "WString.h"
+
+/**
+ * @brief Writes through Print into a caller-supplied buffer.
+ */
+class StringBuilder : public Print, public Printable {
+public:
+    /**
+     * @param buf Storage; always kept NUL-terminated.
+     * @param size Size of buf in bytes, including the NUL. At least 1.
+     */
+    StringBuilder(char *buf, size_t size) : buf(buf), size(size), len(0) {
+        buf[0] = 0;
+    }
+
+    size_t write(uint8 ch);
+    size_t write(const void *data, uint32 n);
+    using Print::write;
+
+    /** Empty the string and clear the write error. */
+    void clear() {
+        len = 0;
+        buf[0] = 0;
+        clearWriteError();
+    }
+
+    const char *c_str() const { return buf; }
+    size_t length() const { return len; }
+    size_t capacity() const { return size - 1; }
+
+    /** True if something didn't fit since the last clear(). */
+    bool overflowed() { return getWriteError() != 0; }
+
+    char operator[](size_t index) const { return index < len ? buf[index] : 0; }
+
+    /** A String copy; this one allocates. */
+    operator String() const { return String(buf); }
+
+    bool equals(const char *s) const { return s && strcmp(buf, s) == 0; }
+    bool equals(const String &s) const {
+        return s.length() == len && equals(s.c_str());
+    }
+    bool operator==(const char *s) const { return equals(s); }
+    bool operator==(const String &s) const { return equals(s); }
+    bool operator==(const StringBuilder &s) const { return equals(s.buf); }
+    bool operator!=(const char *s) const { return !equals(s); }
+    bool operator!=(const String &s) const { return !equals(s); }
+    bool operator!=(const StringBuilder &s) const { return !equals(s.buf); }
+
+    /** Write the whole string to p at once. */
+    size_t printTo(Print &p) const { return p.write(buf, len); }
+
+private:
+    StringBuilder(const StringBuilder &);
+    StringBuilder &operator=(const StringBuilder &);
+
+    char *buf;
+    size_t size;
+    size_t len;
+};
+
+inline bool operator==(const String &a, const StringBuilder &b) { return b.equals(a); }
+inline bool operator!=(const String &a, const StringBuilder &b) { return !b.equals(a); }
+
+/**
+ * @brief A StringBuilder with room for N characters inside itself.
+ */
+template <size_t N>
+class StaticString : public StringBuilder {
+public:
+    StaticString() : StringBuilder(storage, N + 1) {}
+
+    StaticString(const char *s) : StringBuilder(storage, N + 1) { write(s); }
+
+    StaticString(const StaticString &s) : StringBuilder(storage, N + 1) {
+        write(s.c_str(), s.length());
+    }
+
+    StaticString &operator=(const StaticString &s) {
+        if (this != &s) {
+            clear();
+            write(s.c_str(), s.length());
+        }
+        return *this;
+    }
+
+    StaticString &operator=(const char *s) {
+        clear();
+        write(s);
+        return *this;
+    }
+
+private:
+    char storage[N + 1];
+};
+
+#endif
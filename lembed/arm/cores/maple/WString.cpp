@@ -21,7 +21,7 @@
 
 #include "WString.h"
 #include "itoa.h"
-#include "avr/dtostrf.h"
+#include "dtoa.h"
 
 /*********************************************/
 /*  Constructors                             */
@@ -31,6 +31,7 @@ String::String(const char *cstr)
 {
 	init();
 	if (cstr) copy(cstr, strlen(cstr));
+	else invalidate();
 }
 
 String::String(const String &value)
@@ -110,20 +111,18 @@ String::String(unsigned long value, unsigned char base)
 String::String(float value, unsigned char decimalPlaces)
 {
 	init();
-	char buf[33];
-	*this = dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf);
+	if (!concat((double)value, decimalPlaces)) invalidate();
 }
 
 String::String(double value, unsigned char decimalPlaces)
 {
 	init();
-	char buf[33];
-	*this = dtostrf(value, (decimalPlaces + 2), decimalPlaces, buf);
+	if (!concat(value, decimalPlaces)) invalidate();
 }
 
 String::~String()
 {
-	free(buffer);
+	if (buffer != sso) free(buffer);
 }
 
 /*********************************************/
@@ -132,14 +131,15 @@ String::~String()
 
 inline void String::init(void)
 {
-	buffer = NULL;
-	capacity = 0;
+	buffer = sso;
+	capacity = sizeof(sso) - 1;
 	len = 0;
+	sso[0] = 0;
 }
 
 void String::invalidate(void)
 {
-	if (buffer) free(buffer);
+	if (buffer != sso) free(buffer);
 	buffer = NULL;
 	capacity = len = 0;
 }
@@ -147,6 +147,24 @@ void String::invalidate(void)
 unsigned char String::reserve(unsigned int size)
 {
 	if (buffer && capacity >= size) return 1;
+
+	// Grow by half at least, rounded up to the heap's 8 byte chunks, so
+	// that appending a character at a time takes O(log n) reallocs.
+	unsigned int grown = capacity + (capacity >> 1);
+	if (grown < size) grown = size;
+	grown = ((grown + 1 + 7) & ~7U) - 1;
+
+	if (changeBuffer(grown) || changeBuffer(size)) {
+		if (len == 0) buffer[0] = 0;
+		return 1;
+	}
+	return 0;
+}
+
+unsigned char String::reserveExact(unsigned int size)
+{
+	if (size < len) size = len;
+	if (buffer && (capacity == size || (buffer == sso && size < sizeof(sso)))) return 1;
 	if (changeBuffer(size)) {
 		if (len == 0) buffer[0] = 0;
 		return 1;
@@ -154,10 +172,25 @@ unsigned char String::reserve(unsigned int size)
 	return 0;
 }
 
+// Sets the capacity to maxStrLen, or to that of sso if it fits there.
+// maxStrLen must not be less than len.
 unsigned char String::changeBuffer(unsigned int maxStrLen)
 {
-	char *newbuffer = (char *)realloc(buffer, maxStrLen + 1);
+	if (maxStrLen < sizeof(sso)) {
+		if (buffer != sso) {
+			if (buffer) {
+				memcpy(sso, buffer, len + 1);
+				free(buffer);
+			}
+			buffer = sso;
+		}
+		capacity = sizeof(sso) - 1;
+		return 1;
+	}
+
+	char *newbuffer = (char *)realloc(buffer == sso ? NULL : buffer, maxStrLen + 1);
 	if (newbuffer) {
+		if (buffer == sso) memcpy(newbuffer, sso, len + 1);
 		buffer = newbuffer;
 		capacity = maxStrLen;
 		return 1;
@@ -171,7 +204,7 @@ unsigned char String::changeBuffer(unsigned int maxStrLen)
 
 String & String::copy(const char *cstr, unsigned int length)
 {
-	if (!reserve(length)) {
+	if ((!buffer || capacity < length) && !changeBuffer(length)) {
 		invalidate();
 		return *this;
 	}
@@ -182,7 +215,7 @@ String & String::copy(const char *cstr, unsigned int length)
 
 String & String::copy(const __FlashStringHelper *pstr, unsigned int length)
 {
-	if (!reserve(length)) {
+	if ((!buffer || capacity < length) && !changeBuffer(length)) {
 		invalidate();
 		return *this;
 	}
@@ -194,22 +227,28 @@ String & String::copy(const __FlashStringHelper *pstr, unsigned int length)
 #if __cplusplus >= 201103L || defined(__GXX_EXPERIMENTAL_CXX0X__)
 void String::move(String &rhs)
 {
-	if (buffer) {
-		if (capacity >= rhs.len) {
-			strcpy(buffer, rhs.buffer);
-			len = rhs.len;
-			rhs.len = 0;
-			return;
-		} else {
-			free(buffer);
+	if (!rhs.buffer) {
+		invalidate();
+		return;
+	}
+	if (rhs.buffer == rhs.sso || (buffer && capacity >= rhs.len)) {
+		// Short strings, or ones that fit what we have, are copied
+		if (!buffer) {
+			buffer = sso;
+			capacity = sizeof(sso) - 1;
 		}
+		memcpy(buffer, rhs.buffer, rhs.len + 1);
+		len = rhs.len;
+	} else {
+		if (buffer != sso) free(buffer);
+		buffer = rhs.buffer;
+		capacity = rhs.capacity;
+		len = rhs.len;
+		rhs.buffer = rhs.sso;
+		rhs.capacity = sizeof(rhs.sso) - 1;
 	}
-	buffer = rhs.buffer;
-	capacity = rhs.capacity;
-	len = rhs.len;
-	rhs.buffer = NULL;
-	rhs.capacity = 0;
 	rhs.len = 0;
+	rhs.buffer[0] = 0;
 }
 #endif
 
@@ -267,9 +306,17 @@ unsigned char String::concat(const char *cstr, unsigned int length)
 	unsigned int newlen = len + length;
 	if (!cstr) return 0;
 	if (length == 0) return 1;
-	if (!reserve(newlen)) return 0;
-	strcpy(buffer + len, cstr);
+	if (cstr >= buffer && cstr < buffer + len) {
+		// Appending (part of) ourselves; the buffer may move
+		unsigned int offset = cstr - buffer;
+		if (!reserve(newlen)) return 0;
+		cstr = buffer + offset;
+	} else if (!reserve(newlen)) {
+		return 0;
+	}
+	memmove(buffer + len, cstr, length);
 	len = newlen;
+	buffer[len] = 0;
 	return 1;
 }
 
@@ -324,16 +371,25 @@ unsigned char String::concat(unsigned long num)
 
 unsigned char String::concat(float num)
 {
-	char buf[20];
-	char* string = dtostrf(num, 4, 2, buf);
-	return concat(string, strlen(string));
+	return concat((double)num, 2);
 }
 
 unsigned char String::concat(double num)
 {
-	char buf[20];
-	char* string = dtostrf(num, 4, 2, buf);
-	return concat(string, strlen(string));
+	return concat(num, 2);
+}
+
+unsigned char String::concat(double num, unsigned char decimalPlaces)
+{
+	char buf[24];
+	unsigned int length = dtoa_fixed_buf(num, decimalPlaces, buf, sizeof(buf));
+	if (length < sizeof(buf)) return concat(buf, length);
+
+	// Too long for buf: format straight into our own buffer
+	if (!buffer || !reserve(len + length)) return 0;
+	dtoa_fixed_buf(num, decimalPlaces, buffer + len, length + 1);
+	len += length;
+	return 1;
 }
 
 unsigned char String::concat(const __FlashStringHelper * str)
@@ -34,6 +34,12 @@
 //     -felide-constructors
 //     -std=c++0x
 
+// Strings up to STRING_SSO_SIZE - 1 characters are kept inside the
+// String object itself, and don't touch the heap.
+#ifndef STRING_SSO_SIZE
+#define STRING_SSO_SIZE 12
+#endif
+
 class __FlashStringHelper;
 #define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string_literal)))
 
@@ -77,7 +83,11 @@ public:
 	// return true on success, false on failure (in which case, the string
 	// is left unchanged).  reserve(0), if successful, will validate an
 	// invalid string (i.e., "if (s)" will be true afterwards)
+	// reserve() may round the capacity up, so that appending grows the
+	// buffer geometrically; reserveExact() sets it to max(size, length()),
+	// shrinking the buffer if need be.
 	unsigned char reserve(unsigned int size);
+	unsigned char reserveExact(unsigned int size);
 	inline unsigned int length(void) const {return len;}
 
 	// creates a copy of the assigned value.  if the value is null or
@@ -191,11 +201,13 @@ protected:
 	char *buffer;	        // the actual char array
 	unsigned int capacity;  // the array length minus one (for the '\0')
 	unsigned int len;       // the String length (not counting the '\0')
+	char sso[STRING_SSO_SIZE]; // buffer for short strings
 protected:
 	void init(void);
 	void invalidate(void);
 	unsigned char changeBuffer(unsigned int maxStrLen);
 	unsigned char concat(const char *cstr, unsigned int length);
+	unsigned char concat(double num, unsigned char decimalPlaces);
 
 	// copy and move
 	String & copy(const char *cstr, unsigned int length);
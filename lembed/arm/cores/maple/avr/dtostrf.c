@@ -18,12 +18,23 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
-#include <stdio.h>
+#include <string.h>
+#include "../dtoa.h"
 
 char *dtostrf (double val, signed char width, unsigned char prec, char *sout) {
-  char fmt[20];
-  sprintf(fmt, "%%%d.%df", width, prec);
-  sprintf(sout, fmt, val);
+  /* Like sprintf("%*.*f"): right-justified in width, or left-justified
+   * if width is negative. */
+  unsigned len = dtoa_fixed_buf(val, prec, sout, ~0U);
+  unsigned w = width < 0 ? -width : width;
+
+  if (len < w) {
+    if (width > 0) {
+      memmove(sout + w - len, sout, len + 1);
+      memset(sout, ' ', w - len);
+    } else {
+      memset(sout + len, ' ', w - len);
+      sout[w] = 0;
+    }
+  }
   return sout;
 }
-
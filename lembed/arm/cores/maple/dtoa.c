@@ -0,0 +1,283 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/dtoa.c
+ * @brief Fixed-precision double to decimal conversion.
+ *
+ * The value is m * 2^e exactly. The integer part is printed from a
+ * 64-bit integer, or for values of 2^64 and up, from a multi-word one.
+ * The fraction is kept as a multi-word binary fraction; multiplying it
+ * by ten carries out the next digit. One pass over the digits finds how
+ * the last one rounds, and a second one prints them, so that a carry
+ * into the integer part is known before that is printed.
+ */
+
+#include "dtoa.h"
+#include "itoa.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* 32-bit words for 2^1024, and for 2^-1074 as a fraction over
+ * 2^(32 * words). */
+#define DTOA_WORDS 36
+
+struct dtoa_out {
+    dtoa_write_fn write;
+    void *ctx;
+    unsigned len;
+    unsigned n;
+    char buf[16];
+};
+
+static void out_flush(struct dtoa_out *o) {
+    if (o->n) {
+        o->write(o->ctx, o->buf, o->n);
+        o->n = 0;
+    }
+}
+
+static void out_char(struct dtoa_out *o, char c) {
+    if (o->n == sizeof(o->buf)) {
+        out_flush(o);
+    }
+    o->buf[o->n++] = c;
+    o->len++;
+}
+
+static void out_mem(struct dtoa_out *o, const char *str, unsigned len) {
+    while (len--) {
+        out_char(o, *str++);
+    }
+}
+
+/* Place the bits of m << shift in words, from word on. */
+static void put_shifted(uint32_t *words, unsigned word, uint64_t m,
+                        unsigned shift) {
+    words[word] = (uint32_t)(m << shift);
+    words[word + 1] = (uint32_t)((m << shift) >> 32);
+    words[word + 2] = shift ? (uint32_t)(m >> (64 - shift)) : 0;
+}
+
+/* The fraction part of m * 2^-s, over 2^(32 * the return value). */
+static unsigned frac_init(uint32_t *f, uint64_t m, unsigned s) {
+    unsigned words = (s + 31) / 32;
+
+    if (s < 64) {
+        m &= ((uint64_t)1 << s) - 1;
+    }
+    if (words > 3) {
+        memset(f + 3, 0, (words - 3) * sizeof(*f));
+    }
+    put_shifted(f, 0, m, words * 32 - s);
+    return words;
+}
+
+/* Multiply the fraction by ten, and return the digit carried out. */
+static unsigned frac_mul10(uint32_t *f, unsigned words) {
+    uint32_t carry = 0;
+    unsigned i;
+
+    for (i = 0; i < words; i++) {
+        uint64_t t = (uint64_t)f[i] * 10 + carry;
+        f[i] = (uint32_t)t;
+        carry = (uint32_t)(t >> 32);
+    }
+    return carry;
+}
+
+/* Compare the fraction with one half: 1 above, 0 equal, -1 below. */
+static int frac_cmp_half(const uint32_t *f, unsigned words) {
+    unsigned i;
+
+    if (words == 0 || !(f[words - 1] & 0x80000000)) {
+        return -1;
+    }
+    if (f[words - 1] & 0x7FFFFFFF) {
+        return 1;
+    }
+    for (i = 0; i + 1 < words; i++) {
+        if (f[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* m * 2^e, for e > 11, nine digits at a time. */
+static void out_big_int(struct dtoa_out *o, uint64_t m, unsigned e) {
+    uint32_t big[DTOA_WORDS];
+    uint32_t chunks[DTOA_WORDS];
+    char digits[9];
+    unsigned words = e / 32 + 3;
+    unsigned n = 0, i;
+
+    memset(big, 0, sizeof(big));
+    put_shifted(big, e / 32, m, e % 32);
+
+    /* The remainders of dividing by 10^9 are the chunks, lowest first */
+    while (words && !big[words - 1]) {
+        words--;
+    }
+    while (words) {
+        uint64_t rem = 0;
+        for (i = words; i-- > 0;) {
+            uint64_t cur = (rem << 32) | big[i];
+            big[i] = (uint32_t)(cur / 1000000000);
+            rem = cur - (uint64_t)big[i] * 1000000000;
+        }
+        chunks[n++] = (uint32_t)rem;
+        while (words && !big[words - 1]) {
+            words--;
+        }
+    }
+
+    for (i = n; i-- > 0;) {
+        char *end = digits + sizeof(digits);
+        char *p = ultoa_back(chunks[i], end, 10);
+        if (i != n - 1) {
+            while (p > digits) {
+                *--p = '0';
+            }
+        }
+        out_mem(o, p, end - p);
+    }
+}
+
+unsigned dtoa_fixed(double val, unsigned prec, dtoa_write_fn write, void *ctx) {
+    struct dtoa_out o;
+    uint32_t f[DTOA_WORDS];
+    uint64_t bits, m;
+    unsigned s = 0, words = 0, digit = 0, i;
+    int e, last_non9 = -1, round_up = 0;
+
+    o.write = write;
+    o.ctx = ctx;
+    o.len = 0;
+    o.n = 0;
+
+    memcpy(&bits, &val, sizeof(bits));
+    m = bits & 0xFFFFFFFFFFFFFULL;
+    e = (int)(bits >> 52) & 0x7FF;
+    if (bits >> 63) {
+        out_char(&o, '-');
+    }
+    if (e == 0x7FF) {
+        out_mem(&o, m ? "nan" : "inf", 3);
+        out_flush(&o);
+        return o.len;
+    }
+    if (e) {
+        m |= (uint64_t)1 << 52;
+    } else {
+        e = 1;
+    }
+    e -= 1075;
+
+    /* First pass: does the fraction round up, and where does the carry
+     * stop (the last digit that isn't a 9)? Ties go to the even digit. */
+    if (e < 0) {
+        int cmp, odd;
+
+        s = -e;
+        words = frac_init(f, m, s);
+        for (i = 0; i < prec; i++) {
+            digit = frac_mul10(f, words);
+            if (digit != 9) {
+                last_non9 = i;
+            }
+        }
+        cmp = frac_cmp_half(f, words);
+        if (prec) {
+            odd = digit & 1;
+        } else {
+            odd = s < 64 ? (int)(m >> s) & 1 : 0;
+        }
+        round_up = cmp > 0 || (cmp == 0 && odd);
+    }
+
+    if (e > 11) {
+        out_big_int(&o, m, e);
+    } else {
+        char ibuf[20];
+        char *end = ibuf + sizeof(ibuf);
+        char *p;
+        uint64_t ip = e >= 0 ? m << e : (s < 64 ? m >> s : 0);
+
+        if (round_up && last_non9 < 0) {
+            ip++;
+        }
+        p = ulltoa_back(ip, end, 10);
+        out_mem(&o, p, end - p);
+    }
+
+    if (prec) {
+        out_char(&o, '.');
+        if (s) {
+            words = frac_init(f, m, s);
+        }
+        for (i = 0; i < prec; i++) {
+            digit = s ? frac_mul10(f, words) : 0;
+            if (round_up && (int)i >= last_non9) {
+                digit = (int)i == last_non9 ? digit + 1 : 0;
+            }
+            out_char(&o, '0' + digit);
+        }
+    }
+
+    out_flush(&o);
+    return o.len;
+}
+
+struct dtoa_buf {
+    char *p;
+    unsigned room;
+};
+
+static void buf_write(void *ctx, const char *str, unsigned len) {
+    struct dtoa_buf *b = (struct dtoa_buf*)ctx;
+
+    if (len > b->room) {
+        len = b->room;
+    }
+    memcpy(b->p, str, len);
+    b->p += len;
+    b->room -= len;
+}
+
+unsigned dtoa_fixed_buf(double val, unsigned prec, char *buf, unsigned size) {
+    struct dtoa_buf b;
+    unsigned len;
+
+    b.p = buf;
+    b.room = size ? size - 1 : 0;
+    len = dtoa_fixed(val, prec, buf_write, &b);
+    if (size) {
+        *b.p = 0;
+    }
+    return len;
+}
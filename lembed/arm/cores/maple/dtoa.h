@@ -0,0 +1,65 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file wirish/dtoa.h
+ * @brief Fixed-precision double to decimal conversion.
+ *
+ * Prints what printf("%.*f") would, exactly: the digits come from
+ * the binary value itself, and the last one is rounded to nearest,
+ * ties to even. It needs no heap and no float printf, and covers the
+ * whole double range, including "inf" and "nan".
+ */
+
+#ifndef _WIRISH_DTOA_H_
+#define _WIRISH_DTOA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Receives the text in pieces; len bytes, not NUL-terminated. */
+typedef void (*dtoa_write_fn)(void *ctx, const char *str, unsigned len);
+
+/**
+ * @brief Format val with prec digits after the point.
+ * @return Number of characters produced.
+ */
+unsigned dtoa_fixed(double val, unsigned prec, dtoa_write_fn write, void *ctx);
+
+/**
+ * @brief Format val with prec digits after the point into buf.
+ *
+ * Like snprintf(), writes at most size - 1 characters and a NUL, and
+ * returns the length the whole text needs.
+ */
+unsigned dtoa_fixed_buf(double val, unsigned prec, char *buf, unsigned size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
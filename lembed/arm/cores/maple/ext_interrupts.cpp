@@ -78,6 +78,33 @@ void detachInterrupt(uint8 pin)
   exti_detach_interrupt((exti_num)(PIN_MAP[pin].gpio_bit));
 }
 
+void deferInterrupt(uint8 pin, bool deferred)
+{
+  if (pin >= BOARD_NR_GPIO_PINS) {
+    return;
+  }
+
+  exti_set_deferred((exti_num)(PIN_MAP[pin].gpio_bit), deferred);
+}
+
+uint32 interruptCount(uint8 pin)
+{
+  if (pin >= BOARD_NR_GPIO_PINS) {
+    return 0;
+  }
+
+  return exti_event_count((exti_num)(PIN_MAP[pin].gpio_bit));
+}
+
+uint32 interruptsLost(uint8 pin)
+{
+  if (pin >= BOARD_NR_GPIO_PINS) {
+    return 0;
+  }
+
+  return exti_lost_count((exti_num)(PIN_MAP[pin].gpio_bit));
+}
+
 
 static inline exti_trigger_mode exti_out_mode(ExtIntTriggerMode mode)
 {
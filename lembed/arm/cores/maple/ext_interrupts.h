@@ -34,6 +34,7 @@
 
 #include <libmaple/libmaple_types.h>
 #include <libmaple/nvic.h>
+#include <libmaple/exti.h>
 
 /**
  * The kind of transition on an external pin which should trigger an
@@ -98,6 +99,53 @@ void attachInterrupt(uint8 pin, voidArgumentFuncPtr handler, void *arg,
  */
 void detachInterrupt(uint8 pin);
 
+/**
+ * @brief Queue a pin's interrupts, to handle them outside interrupt
+ *        context.
+ *
+ * Once deferred, an interrupt on the pin only records the time it
+ * happened; its handler runs later, from runDeferredInterrupts(). This
+ * keeps the interrupt short, for fast edges, and lets the handler take
+ * its time. Call it after attachInterrupt().
+ *
+ * Pins share interrupt lines by pin number within their port (PA3 and
+ * PB3 are both on line 3), so this applies to whichever pin is
+ * attached to the line.
+ *
+ * @param pin      Pin number
+ * @param deferred Whether to queue (true) or handle at once (false)
+ * @see runDeferredInterrupts()
+ * @see exti_set_deferred()
+ */
+void deferInterrupt(uint8 pin, bool deferred = true);
+
+/**
+ * @brief Run the handlers of deferred interrupts.
+ *
+ * Call this regularly, e.g. from loop().
+ *
+ * @return Number of interrupts handled
+ * @see deferInterrupt()
+ */
+static inline uint32 runDeferredInterrupts(void) {
+    return exti_run_deferred();
+}
+
+/**
+ * @brief Number of interrupts on a pin's line since it was attached,
+ *        whether handled, deferred or lost. It wraps around.
+ * @param pin Pin number
+ */
+uint32 interruptCount(uint8 pin);
+
+/**
+ * @brief Number of deferred interrupts on a pin's line that were lost
+ *        because the queue was full.
+ * @param pin Pin number
+ * @see deferInterrupt()
+ */
+uint32 interruptsLost(uint8 pin);
+
 /**
  * Re-enable interrupts.
  *
@@ -137,6 +137,11 @@ uint32 digitalRead(uint8 pin);
  * conversion, and has 12 bits of resolution.  The pin must have its
  * mode set to INPUT_ANALOG.
  *
+ * While the pin's ADC is scanning (adc_scan_start()), a channel in the
+ * scan returns its latest value at once, and any other channel is
+ * converted without stopping the scan, except during a dual-mode
+ * scan, when it reads as 0.
+ *
  * @param pin Pin to read from.
  * @return Converted voltage, in the range 0--4095, (i.e. a 12-bit ADC
  *         conversion).
@@ -160,4 +165,81 @@ uint16 analogRead(uint8 pin);
  */
 void shiftOut(uint8 dataPin, uint8 clockPin, uint8 bitOrder, uint8 value);
 
+/**
+ * Shift in a byte of data, one bit at a time.
+ *
+ * The clock pin is pulsed high before each bit is read, and the bit is
+ * read while it is high, so devices clocking data out on the rising
+ * edge work.
+ *
+ * @param dataPin  Pin to shift data in on
+ * @param clockPin Pin to pulse before each bit is read
+ * @param bitOrder Either MSBFIRST (big-endian) or LSBFIRST (little-endian).
+ * @return Byte read
+ */
+uint8 shiftIn(uint8 dataPin, uint8 clockPin, uint8 bitOrder);
+
+/**
+ * Shift out a buffer of bytes, like shiftOut() on each in turn, in the
+ * background.
+ *
+ * If the pins are the SCK and MOSI pins of an SPI port that isn't
+ * enabled, that port shifts the bytes out, at up to 4.5 MHz. Otherwise,
+ * if the pins are on one port and a timer is free (no channel or
+ * interrupt in use), the timer paces DMA writes to the pins, at
+ * 1 Mbit/s. Failing both, the bytes are bit-banged before this
+ * returns.
+ *
+ * Only one buffer shifts at a time; this waits for the previous one.
+ *
+ * @param dataPin  Pin to shift data out on
+ * @param clockPin Pin to pulse after each bit is shifted out
+ * @param bitOrder Either MSBFIRST (big-endian) or LSBFIRST (little-endian).
+ * @param buf      Bytes to shift out. Unless wait is true, it must stay
+ *                 valid until shiftBufferBusy() returns false.
+ * @param len      Number of bytes
+ * @param wait     Whether to return only once all bytes are out
+ * @return As shiftBufferWait() if wait is true, else true.
+ * @see shiftBufferWait()
+ */
+bool shiftOutBuffer(uint8 dataPin, uint8 clockPin, uint8 bitOrder,
+                    const uint8 *buf, uint32 len, bool wait = true);
+
+/**
+ * Shift in a buffer of bytes, like shiftIn() for each in turn, in the
+ * background.
+ *
+ * The hardware is chosen as by shiftOutBuffer(), with the data pin
+ * being an SPI port's MISO pin rather than MOSI. The data pin must be
+ * an input.
+ *
+ * @param dataPin  Pin to shift data in on
+ * @param clockPin Pin to pulse before each bit is read
+ * @param bitOrder Either MSBFIRST (big-endian) or LSBFIRST (little-endian).
+ * @param buf      Where to store the bytes. Unless wait is true, it is
+ *                 only complete once shiftBufferBusy() returns false.
+ * @param len      Number of bytes
+ * @param wait     Whether to return only once all bytes are in
+ * @return As shiftBufferWait() if wait is true, else true.
+ * @see shiftBufferWait()
+ */
+bool shiftInBuffer(uint8 dataPin, uint8 clockPin, uint8 bitOrder,
+                   uint8 *buf, uint32 len, bool wait = true);
+
+/**
+ * Whether a buffer started by shiftOutBuffer() or shiftInBuffer() is
+ * still shifting.
+ */
+bool shiftBufferBusy(void);
+
+/**
+ * Wait for shiftOutBuffer() or shiftInBuffer() to finish.
+ *
+ * @return false if the buffer was cut short. That only happens with
+ *         the timer: its DMA interrupt must run within 64 us of
+ *         asking, or stale bits would go out (or samples be lost), so
+ *         the shift stops there instead.
+ */
+bool shiftBufferWait(void);
+
 #endif
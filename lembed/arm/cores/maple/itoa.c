@@ -165,6 +165,119 @@ extern char* ultoa( unsigned long value, char *string, int radix )
 }
 #endif /* 0 */
 
+static const char digit_chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+extern char* ultoa_back( unsigned long value, char *end, int radix )
+{
+  char *p = end;
+
+  if (radix < 2 || radix > 36)
+    radix = 10;
+
+  if (radix == 10)
+  {
+    /* Two digits per step; value / 100 compiles to a multiply by the
+     * reciprocal, not a division. */
+    while (value >= 100)
+    {
+      unsigned long q = value / 100;
+      unsigned long r = value - q * 100;
+      p -= 2;
+      p[0] = digit_pairs[2 * r];
+      p[1] = digit_pairs[2 * r + 1];
+      value = q;
+    }
+    if (value >= 10)
+    {
+      p -= 2;
+      p[0] = digit_pairs[2 * value];
+      p[1] = digit_pairs[2 * value + 1];
+    }
+    else
+    {
+      *--p = '0' + value;
+    }
+    return p;
+  }
+
+  if ((radix & (radix - 1)) == 0)
+  {
+    unsigned shift = __builtin_ctz(radix);
+    unsigned long mask = radix - 1;
+    do
+    {
+      *--p = digit_chars[value & mask];
+      value >>= shift;
+    } while (value);
+    return p;
+  }
+
+  do
+  {
+    unsigned long q = value / radix;
+    *--p = digit_chars[value - q * radix];
+    value = q;
+  } while (value);
+  return p;
+}
+
+extern char* ulltoa_back( unsigned long long value, char *end, int radix )
+{
+  char *p = end;
+
+  if (radix < 2 || radix > 36)
+    radix = 10;
+
+  if (radix == 10)
+  {
+    /* Split off nine digits at a time, so that a 64-bit division is
+     * only needed while the value is wider than 32 bits (at most
+     * twice). */
+    while (value >> 32)
+    {
+      unsigned long long q = value / 1000000000;
+      char *start = ultoa_back((unsigned long)(value - q * 1000000000), p, 10);
+      while (start > p - 9)
+        *--start = '0';
+      p = start;
+      value = q;
+    }
+    return ultoa_back((unsigned long)value, p, 10);
+  }
+
+  if ((radix & (radix - 1)) == 0)
+  {
+    unsigned shift = __builtin_ctz(radix);
+    unsigned mask = radix - 1;
+    do
+    {
+      *--p = digit_chars[(unsigned)value & mask];
+      value >>= shift;
+    } while (value);
+    return p;
+  }
+
+  while (value >> 32)
+  {
+    unsigned long long q = value / radix;
+    *--p = digit_chars[(unsigned)(value - q * radix)];
+    value = q;
+  }
+  return ultoa_back((unsigned long)value, p, radix);
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
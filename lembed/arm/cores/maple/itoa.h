@@ -35,6 +35,19 @@ extern char* utoa( unsigned long value, char *string, int radix ) ;
 extern char* ultoa( unsigned long value, char *string, int radix ) ;
 #endif /* 0 */
 
+/*
+ * Write the digits of value backwards into the buffer that ends just
+ * before end, and return a pointer to the first digit. Nothing is
+ * written at end itself, and there is no terminator. Digits above 9
+ * are upper case; a radix outside 2..36 is taken as 10.
+ *
+ * Base 10 needs no division instruction (the compiler turns the
+ * divisions by 100 into multiplications) and powers of two use
+ * shifts. The buffer needs room for 32 digits (64 for ulltoa_back).
+ */
+extern char* ultoa_back( unsigned long value, char *end, int radix ) ;
+extern char* ulltoa_back( unsigned long long value, char *end, int radix ) ;
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
@@ -36,6 +36,7 @@
 #include <libmaple/libmaple.h>
 #include <libmaple/rcc.h>
 #include <libmaple/gpio.h>
+#include <libmaple/dma.h>
 
 /*
  * Devices
@@ -140,10 +141,309 @@ uint16 adc_read(const adc_dev *dev, uint8 channel)
     return (uint16)(regs->DR & ADC_DR_DATA);
 }
 
+/**
+ * @brief Perform a single synchronous software triggered conversion on a
+ *        channel, as an injected conversion.
+ *
+ * Unlike adc_read(), this leaves the regular sequence alone, so it can
+ * be used on an ADC that is scanning: the regular conversion it
+ * interrupts starts over once it is done. Not in dual mode, where that
+ * would put ADC1 out of step with ADC2. The injected sequence and
+ * trigger are overwritten.
+ *
+ * @param dev ADC device to use for reading.
+ * @param channel channel to convert
+ * @return conversion result
+ */
+uint16 adc_read_injected(const adc_dev *dev, uint8 channel)
+{
+    adc_reg_map *regs = dev->regs;
+
+    /* A sequence of one converts JSQ4 */
+    regs->JSQR = ADC_JSQR_JL_1CONV | ((uint32)(channel & 0x1F) << 15);
+    regs->CR2 = ((regs->CR2 & ~ADC_CR2_JEXTSEL) |
+                 ADC_CR2_JEXTSEL_JSWSTART | ADC_CR2_JEXTTRIG);
+    regs->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+    regs->CR2 |= ADC_CR2_JSWSTART;
+    while (!(regs->SR & ADC_SR_JEOC))
+        ;
+    regs->SR = ~(ADC_SR_JEOC | ADC_SR_JSTRT);
+
+    return (uint16)(regs->JDR1 & ADC_JDR_JDATA);
+}
+
+/**
+ * @brief Set the regular channel sequence.
+ *
+ * Also sets the sequence length.
+ *
+ * @param dev ADC device
+ * @param channels Channels to convert, in order.
+ * @param length Number of channels, from 1 to 16.
+ */
+void adc_set_reg_seq(const adc_dev *dev, const uint8 *channels, uint8 length)
+{
+    uint32 sqr[3] = {0, 0, 0};  /* SQR3, SQR2, SQR1 */
+    uint8 i;
+
+    for (i = 0; i < length; i++) {
+        sqr[i / 6] |= (uint32)(channels[i] & 0x1F) << ((i % 6) * 5);
+    }
+    dev->regs->SQR3 = sqr[0];
+    dev->regs->SQR2 = sqr[1];
+    dev->regs->SQR1 = sqr[2] | ((uint32)(length - 1) << 20);
+}
+
 /*
  * STM32F1 routines
  */
 
+/*
+ * Scan mode
+ */
+
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+#define NR_SCANS 2
+#else
+#define NR_SCANS 1
+#endif
+
+static adc_scan *active_scans[NR_SCANS];
+
+static int scan_index(const adc_dev *dev)
+{
+    if (dev == ADC1) {
+        return 0;
+    }
+#if NR_SCANS > 1
+    if (dev == ADC3) {
+        return 1;
+    }
+#endif
+    return -1;
+}
+
+static void scan_irq(adc_scan *scan)
+{
+    uint16 half = scan->size / 2;
+
+    switch (dma_get_irq_cause(scan->dma, scan->tube)) {
+    case DMA_TRANSFER_HALF_COMPLETE:
+        scan->handler(scan, (const uint16*)scan->buf, half);
+        break;
+    case DMA_TRANSFER_COMPLETE:
+        scan->handler(scan, (const uint16*)scan->buf + half, half);
+        break;
+    default:
+        break;
+    }
+}
+
+static void adc1_scan_irq(void)
+{
+    scan_irq(active_scans[0]);
+}
+
+#if NR_SCANS > 1
+static void adc3_scan_irq(void)
+{
+    scan_irq(active_scans[1]);
+}
+#endif
+
+/* Switch dev between scan and single conversion mode. CR2 is
+ * written with ADON already set and other bits changing, which does
+ * not start a conversion. */
+static void scan_mode(const adc_dev *dev, const uint8 *channels,
+                      uint8 length, uint32 cr1, uint32 cr2)
+{
+    adc_reg_map *regs = dev->regs;
+
+    regs->CR1 = (regs->CR1 & ~(ADC_CR1_SCAN | ADC_CR1_DUALMOD)) | cr1;
+    regs->CR2 = ((regs->CR2 & ~(ADC_CR2_EXTSEL | ADC_CR2_CONT | ADC_CR2_DMA)) |
+                 ADC_CR2_EXTTRIG | cr2);
+    adc_set_reg_seq(dev, channels, length);
+}
+
+/**
+ * @brief Start a scan.
+ *
+ * The ADCs must have been enabled and calibrated, as
+ * adc_enable_single_swstart() does. Don't call adc_read() on an ADC
+ * that is scanning; use adc_scan_read() or adc_scan_latest().
+ *
+ * @param scan Scan to start; see adc_scan for the fields to fill in.
+ * @return 0 on success, nonzero if the configuration is invalid.
+ */
+int adc_scan_start(adc_scan *scan)
+{
+    int idx = scan_index(scan->dev);
+    uint8 dual = scan->channels2 != NULL;
+    dma_tube_config cfg;
+    uint32 cr2;
+    int ret;
+
+    if (idx < 0 || (dual && idx != 0) ||
+        scan->nr_channels < 1 || scan->nr_channels > 16) {
+        return -1;
+    }
+    scan->frame = scan->nr_channels << dual;
+    if (scan->size == 0 || scan->size % (2 * scan->frame) != 0) {
+        return -1;
+    }
+    if (active_scans[idx]) {
+        adc_scan_stop(active_scans[idx]);
+    }
+
+    scan->dma = DMA1;
+    scan->tube = DMA_CH1;
+    cfg.tube_req_src = DMA_REQ_SRC_ADC1;
+#if NR_SCANS > 1
+    if (idx == 1) {
+        scan->dma = DMA2;
+        scan->tube = DMA_CH5;
+        cfg.tube_req_src = DMA_REQ_SRC_ADC3;
+    }
+#endif
+    dma_init(scan->dma);
+
+    /* In dual mode ADC1's DR carries ADC2's result in its upper half,
+     * so each transfer is a word holding one sample from each. */
+    cfg.tube_src = &scan->dev->regs->DR;
+    cfg.tube_src_size = dual ? DMA_SIZE_32BITS : DMA_SIZE_16BITS;
+    cfg.tube_dst = scan->buf;
+    cfg.tube_dst_size = cfg.tube_src_size;
+    cfg.tube_nr_xfers = scan->size >> dual;
+    cfg.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CIRC;
+    if (scan->handler) {
+        cfg.tube_flags |= DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE;
+    }
+    cfg.target_data = NULL;
+    ret = dma_tube_cfg(scan->dma, scan->tube, &cfg);
+    if (ret != DMA_TUBE_CFG_SUCCESS) {
+        return ret;
+    }
+
+    active_scans[idx] = scan;
+    if (scan->handler) {
+#if NR_SCANS > 1
+        dma_attach_interrupt(scan->dma, scan->tube,
+                             idx == 0 ? adc1_scan_irq : adc3_scan_irq);
+#else
+        dma_attach_interrupt(scan->dma, scan->tube, adc1_scan_irq);
+#endif
+    }
+    dma_enable(scan->dma, scan->tube);
+
+    cr2 = scan->trigger | ADC_CR2_DMA;
+    if (scan->trigger == ADC_EXT_EV_SWSTART) {
+        cr2 |= ADC_CR2_CONT;
+    }
+    if (dual) {
+        /* ADC2 follows ADC1's trigger; its own must be software. */
+        scan_mode(ADC2, scan->channels2, scan->nr_channels, ADC_CR1_SCAN,
+                  ADC_EXT_EV_SWSTART | ADC_CR2_DMA |
+                  (cr2 & ADC_CR2_CONT));
+    }
+    scan_mode(scan->dev, scan->channels, scan->nr_channels,
+              ADC_CR1_SCAN | (dual ? ADC_CR1_DUALMOD_REG_SIMULT : 0), cr2);
+    if (scan->trigger == ADC_EXT_EV_SWSTART) {
+        scan->dev->regs->CR2 |= ADC_CR2_SWSTART;
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop a scan and return its ADCs to single conversion mode.
+ * @param scan Scan to stop.
+ */
+void adc_scan_stop(adc_scan *scan)
+{
+    int idx = scan_index(scan->dev);
+
+    if (idx < 0 || active_scans[idx] != scan) {
+        return;
+    }
+    scan_mode(scan->dev, scan->channels, 1, 0, ADC_EXT_EV_SWSTART);
+    if (scan->channels2) {
+        scan_mode(ADC2, scan->channels2, 1, 0, ADC_EXT_EV_SWSTART);
+    }
+    dma_disable(scan->dma, scan->tube);
+    if (scan->handler) {
+        dma_detach_interrupt(scan->dma, scan->tube);
+    }
+    active_scans[idx] = NULL;
+}
+
+/**
+ * @brief Return the most recently completed frame of a scan.
+ *
+ * The frame stays intact until DMA comes round to it again, a whole
+ * buffer later. Before the first frame completes, this is the last
+ * frame of the buffer, and holds whatever the buffer was
+ * initialised with.
+ *
+ * @param scan A running scan.
+ */
+const volatile uint16* adc_scan_latest(adc_scan *scan)
+{
+    uint8 dual = scan->channels2 != NULL;
+    uint32 xfers = scan->size >> dual;
+    uint32 done = (xfers - dma_tube_regs(scan->dma, scan->tube)->CNDTR) << dual;
+    uint32 start = done - done % scan->frame;
+
+    return scan->buf + (start ? start : scan->size) - scan->frame;
+}
+
+/**
+ * @brief Return the scan running on an ADC, if any.
+ *
+ * In dual mode, the scan is returned for ADC2 as well as ADC1.
+ *
+ * @param dev ADC device
+ * @return The scan, or NULL.
+ */
+adc_scan* adc_scan_active(const adc_dev *dev)
+{
+    int idx;
+
+    if (dev == ADC2) {
+        return (active_scans[0] && active_scans[0]->channels2) ?
+            active_scans[0] : NULL;
+    }
+    idx = scan_index(dev);
+    return idx < 0 ? NULL : active_scans[idx];
+}
+
+/**
+ * @brief Read a channel's latest value from a running scan.
+ *
+ * No conversion is started or waited for.
+ *
+ * @param dev ADC device
+ * @param channel Channel to read
+ * @return The value, or -1 if no scan on dev converts channel.
+ */
+int adc_scan_read(const adc_dev *dev, uint8 channel)
+{
+    adc_scan *scan = adc_scan_active(dev);
+    const uint8 *channels;
+    uint8 i, dual, second;
+
+    if (!scan) {
+        return -1;
+    }
+    dual = scan->channels2 != NULL;
+    second = dev == ADC2;
+    channels = second ? scan->channels2 : scan->channels;
+    for (i = 0; i < scan->nr_channels; i++) {
+        if (channels[i] == channel) {
+            return adc_scan_latest(scan)[(i << dual) + second];
+        }
+    }
+    return -1;
+}
+
 /**
  * @brief Calibrate an ADC peripheral
  *
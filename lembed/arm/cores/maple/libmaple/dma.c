@@ -444,6 +444,7 @@ void __irq_dma2_channel4_5(void)
         dma_irq_handler(DMA2, DMA_CH5);
     }
 }
+#endif
 
 /**
  * @brief Initialize a DMA device.
@@ -487,6 +488,3 @@ enum dma_atype _dma_addr_type(__io void *addr)
             return DMA_ATYPE_OTHER;
         }
     }
-
-
-#endif
@@ -34,6 +34,8 @@
 #include <libmaple/libmaple.h>
 #include <libmaple/nvic.h>
 #include <libmaple/bitband.h>
+#include <libmaple/dwt.h>
+#include <libmaple/ring_buffer.h>
 
 #include <libmaple/gpio.h>
 #include "exti_private.h"
@@ -49,26 +51,24 @@ static inline void dispatch_extis(uint32 start, uint32 stop);
 typedef struct exti_channel {
     void (*handler)(void *);
     void *arg;
+    volatile uint32 events;     /* Interrupts dispatched */
+    volatile uint32 lost;       /* ... of which dropped, queue full */
 } exti_channel;
 
-static exti_channel exti_channels[] = {
-    { .handler = NULL, .arg = NULL },  // EXTI0
-    { .handler = NULL, .arg = NULL },  // EXTI1
-    { .handler = NULL, .arg = NULL },  // EXTI2
-    { .handler = NULL, .arg = NULL },  // EXTI3
-    { .handler = NULL, .arg = NULL },  // EXTI4
-    { .handler = NULL, .arg = NULL },  // EXTI5
-    { .handler = NULL, .arg = NULL },  // EXTI6
-    { .handler = NULL, .arg = NULL },  // EXTI7
-    { .handler = NULL, .arg = NULL },  // EXTI8
-    { .handler = NULL, .arg = NULL },  // EXTI9
-    { .handler = NULL, .arg = NULL },  // EXTI10
-    { .handler = NULL, .arg = NULL },  // EXTI11
-    { .handler = NULL, .arg = NULL },  // EXTI12
-    { .handler = NULL, .arg = NULL },  // EXTI13
-    { .handler = NULL, .arg = NULL },  // EXTI14
-    { .handler = NULL, .arg = NULL },  // EXTI15
-};
+/* Zeroed like any other static data */
+static exti_channel exti_channels[16];
+
+/* Lines whose events are queued rather than handled in the IRQ */
+static volatile uint32 exti_deferred;
+
+/* Deferred events. The EXTI IRQs all have the same priority (see
+ * nvic_init()), so they never preempt one another: there is one
+ * producer, the IRQs, and one consumer, the main program. The entries
+ * aren't volatile, so rb_barrier() keeps their accesses on the right
+ * side of the head and tail updates, as in ring_buffer.h. */
+static exti_event exti_queue[EXTI_QUEUE_SIZE];
+static volatile uint32 exti_queue_head;     /* Written by the IRQs */
+static volatile uint32 exti_queue_tail;     /* Written by the consumer */
 
 void exti_select(exti_num num, exti_cfg port)
 {
@@ -113,6 +113,7 @@ void exti_attach_interrupt(exti_num num,
  * @param num     External interrupt line number.
  * @param port    Port to use as source input for external interrupt.
  * @param handler Function handler to execute when interrupt is triggered.
+ *                May be NULL for a line in deferred mode.
  * @param arg     Argument to pass to the interrupt handler.
  * @param mode    Type of transition to trigger on, one of:
  *                EXTI_RISING, EXTI_FALLING, EXTI_RISING_FALLING.
@@ -127,11 +128,11 @@ void exti_attach_callback(exti_num num,
                           void *arg,
                           exti_trigger_mode mode)
 {
-    ASSERT(handler);
-
-    /* Register the handler */
+    /* Register the handler, and start counting afresh */
     exti_channels[num].handler = handler;
     exti_channels[num].arg = arg;
+    exti_channels[num].events = 0;
+    exti_channels[num].lost = 0;
 
     /* Set trigger mode */
     switch (mode) {
@@ -205,6 +206,126 @@ void exti_detach_interrupt(exti_num num)
     /* Finally, unregister the user's handler */
     exti_channels[num].handler = NULL;
     exti_channels[num].arg = NULL;
+    exti_set_deferred(num, 0);
+}
+
+/**
+ * @brief Queue an EXTI line's interrupts instead of handling them.
+ *
+ * In deferred mode, the IRQ only records the line and the DWT cycle
+ * count (see dwt_cycles()) in a queue, and the handler registered for
+ * the line runs later, from exti_run_deferred(). Alternatively, the
+ * events can be read with exti_get_event(). The queue holds
+ * EXTI_QUEUE_SIZE events; once it is full, new events are only
+ * counted as lost.
+ *
+ * The line need not have a handler, e.g. if only the counts or the
+ * raw events are wanted; exti_attach_callback() still configures it.
+ *
+ * @param num      External interrupt line number.
+ * @param deferred Nonzero to queue, zero to handle in the IRQ again.
+ * @see exti_event_count()
+ */
+void exti_set_deferred(exti_num num, int deferred)
+{
+    uint32 masked = nvic_globalirq_masked();
+
+    nvic_globalirq_disable();
+    if (deferred) {
+        exti_deferred |= 1U << num;
+    } else {
+        exti_deferred &= ~(1U << num);
+    }
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
+}
+
+/**
+ * @brief Take the oldest event from the deferred queue.
+ * @param event Where to store the event.
+ * @return 1 if there was an event, 0 if the queue was empty.
+ * @see exti_set_deferred()
+ */
+int exti_get_event(exti_event *event)
+{
+    uint32 tail = exti_queue_tail;
+
+    if (tail == exti_queue_head) {
+        return 0;
+    }
+    rb_barrier();
+    *event = exti_queue[tail & (EXTI_QUEUE_SIZE - 1)];
+    rb_barrier();
+    exti_queue_tail = tail + 1;
+    return 1;
+}
+
+/**
+ * @brief Run the handlers for the events in the deferred queue.
+ *
+ * Call this regularly, e.g. from loop(). Each handler runs once per
+ * event, in the order the events happened.
+ *
+ * @return Number of events taken from the queue.
+ * @see exti_set_deferred()
+ */
+uint32 exti_run_deferred(void)
+{
+    exti_event event;
+    uint32 n = 0;
+
+    while (exti_get_event(&event)) {
+        exti_channel *channel = &exti_channels[event.num];
+        voidArgumentFuncPtr handler = channel->handler;
+
+        if (handler) {
+            handler(channel->arg);
+        }
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Number of interrupts on an EXTI line.
+ *
+ * This counts every interrupt dispatched, whether handled, queued or
+ * lost, since the line was attached or exti_reset_counts() was last
+ * called. It wraps around.
+ *
+ * @param num External interrupt line number.
+ */
+uint32 exti_event_count(exti_num num)
+{
+    return exti_channels[num].events;
+}
+
+/**
+ * @brief Number of deferred interrupts on an EXTI line that were lost
+ *        because the queue was full.
+ * @param num External interrupt line number.
+ * @see exti_set_deferred()
+ */
+uint32 exti_lost_count(exti_num num)
+{
+    return exti_channels[num].lost;
+}
+
+/**
+ * @brief Zero an EXTI line's event and lost counts.
+ * @param num External interrupt line number.
+ */
+void exti_reset_counts(exti_num num)
+{
+    uint32 masked = nvic_globalirq_masked();
+
+    nvic_globalirq_disable();
+    exti_channels[num].events = 0;
+    exti_channels[num].lost = 0;
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
 }
 
 /*
@@ -276,39 +397,54 @@ static inline __always_inline void clear_pending_msk(uint32 exti_msk)
     asm volatile("nop");
 }
 
+static inline __always_inline void dispatch_exti(uint32 exti, uint32 now)
+{
+    exti_channel *channel = &exti_channels[exti];
+
+    channel->events++;
+    if (exti_deferred & (1U << exti)) {
+        uint32 head = exti_queue_head;
+
+        if (head - exti_queue_tail >= EXTI_QUEUE_SIZE) {
+            channel->lost++;
+            return;
+        }
+        exti_queue[head & (EXTI_QUEUE_SIZE - 1)].cycles = now;
+        exti_queue[head & (EXTI_QUEUE_SIZE - 1)].num = (exti_num)exti;
+        rb_barrier();
+        exti_queue_head = head + 1;
+    } else if (channel->handler) {
+        channel->handler(channel->arg);
+    }
+}
+
+/* Both dispatch routines clear the pending bits before running any
+ * handler, so an edge that comes while the handler runs raises the
+ * IRQ again instead of being lost. */
+
 /* This dispatch routine is for non-multiplexed EXTI lines only; i.e.,
  * it doesn't check EXTI_PR. */
 static inline __always_inline void dispatch_single_exti(uint32 exti)
 {
-    voidArgumentFuncPtr handler = exti_channels[exti].handler;
-
-    if (!handler) {
-        return;
-    }
+    uint32 now = dwt_cycles();
 
-    handler(exti_channels[exti].arg);
     clear_pending_msk(1U << exti);
+    dispatch_exti(exti, now);
 }
 
-/* Dispatch routine for EXTIs which share an IRQ. */
+/* Dispatch routine for EXTIs which share an IRQ. Rather than testing
+ * each line of the range, it finds the pending ones with CLZ, so they
+ * are dispatched highest line first. */
 static inline __always_inline void dispatch_extis(uint32 start, uint32 stop)
 {
-    uint32 pr = EXTI_BASE->PR;
-    uint32 handled_msk = 0;
-    uint32 exti;
-
-    /* Dispatch user handlers for pending EXTIs. */
-    for (exti = start; exti <= stop; exti++) {
-        uint32 eb = (1U << exti);
-        if (pr & eb) {
-            voidArgumentFuncPtr handler = exti_channels[exti].handler;
-            if (handler) {
-                handler(exti_channels[exti].arg);
-                handled_msk |= eb;
-            }
-        }
-    }
+    uint32 now = dwt_cycles();
+    uint32 pr = EXTI_BASE->PR & ((2U << stop) - (1U << start));
 
-    /* Clear the pending bits for handled EXTIs. */
-    clear_pending_msk(handled_msk);
+    clear_pending_msk(pr);
+    while (pr) {
+        uint32 exti = 31 - __builtin_clz(pr);
+
+        pr &= ~(1U << exti);
+        dispatch_exti(exti, now);
+    }
 }
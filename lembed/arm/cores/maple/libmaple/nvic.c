@@ -97,7 +97,9 @@ void nvic_set_vector_table(uint32 address, uint32 offset) {
 void nvic_sys_reset() {
     uint32 prigroup = SCB_BASE->AIRCR & SCB_AIRCR_PRIGROUP;
     SCB_BASE->AIRCR = SCB_AIRCR_VECTKEY | SCB_AIRCR_SYSRESETREQ | prigroup;
+#ifndef LIBMAPLE_HOST
     asm volatile("dsb");
+#endif
     while (1)
         ;
 }
@@ -38,8 +38,6 @@
 #include <libmaple/gpio.h>
 #include "spi_private.h"
 
-static void spi_reconfigure(spi_dev *dev, uint32 cr1_config);
-
 /*
  * Devices
  */
@@ -215,11 +213,16 @@ void spi_rx_dma_disable(spi_dev *dev)
   bb_peri_set_bit(&dev->regs->CR2, SPI_CR2_RXDMAEN_BIT, 0);
 }
 
-/*
- * SPI auxiliary routines
+/**
+ * @brief Load a complete CR1 configuration into a SPI device.
+ *
+ * The peripheral is disabled while CR1 is written and re-enabled
+ * afterwards; SPI interrupts are disabled.
+ *
+ * @param dev Device to reconfigure
+ * @param cr1_config New CR1 value, less SPI_CR1_SPE
  */
-
-static void spi_reconfigure(spi_dev *dev, uint32 cr1_config)
+void spi_reconfigure(spi_dev *dev, uint32 cr1_config)
 {
   spi_irq_disable(dev, SPI_INTERRUPTS_ALL);
   spi_peripheral_disable(dev);
@@ -31,10 +31,60 @@
  */
 
 #include <libmaple/systick.h>
+#include <libmaple/nvic.h>
 
 volatile uint32 systick_uptime_millis;
 static void (*systick_user_callback)(void);
 
+volatile systick_timebase systick_timebase_anchor[2];
+volatile uint32 systick_timebase_gen;
+uint32 systick_cycles_per_ms = 1;
+uint32 systick_cycles_per_us = 1;
+volatile uint32 systick_tickless_mode;
+
+/* Tickless mode: when to run the callback next, or 0 for never */
+static uint64 systick_deadline;
+
+/* Shortest tickless wait, so a deadline in the past doesn't leave us
+ * taking back-to-back exceptions. */
+#define SYSTICK_MIN_WAIT                64
+
+/*
+ * Move the anchor up to the last millisecond boundary. Only called
+ * from the SysTick handler, or with interrupts disabled.
+ */
+static void systick_timebase_update(void) {
+    uint32 gen = systick_timebase_gen;
+    const volatile systick_timebase *cur = &systick_timebase_anchor[gen & 1];
+    volatile systick_timebase *next = &systick_timebase_anchor[~gen & 1];
+    uint64 cycles = cur->cycles;
+    uint32 ms = (dwt_cycles() - (uint32)cycles) / systick_cycles_per_ms;
+
+    next->cycles = cycles + (uint64)ms * systick_cycles_per_ms;
+    next->millis = cur->millis + ms;
+    systick_timebase_gen = gen + 1;
+    systick_uptime_millis = (uint32)next->millis;
+}
+
+/*
+ * Tickless mode: have SysTick fire at the deadline, or after as long
+ * as it can count if that's sooner or there isn't one.
+ */
+static void systick_program(void) {
+    uint32 wait = SYSTICK_MAX_RELOAD + 1;
+
+    if (systick_deadline) {
+        uint64 now = systick_cycles();
+        if (systick_deadline <= now + SYSTICK_MIN_WAIT) {
+            wait = SYSTICK_MIN_WAIT;
+        } else if (systick_deadline - now < wait) {
+            wait = (uint32)(systick_deadline - now);
+        }
+    }
+    SYSTICK_BASE->RVR = wait - 1;
+    SYSTICK_BASE->CNT = 0;      /* Reloads from RVR */
+}
+
 /**
  * @brief Initialize and enable SysTick.
  *
@@ -44,6 +94,14 @@ static void (*systick_user_callback)(void);
  * @param reload_val Appropriate reload counter to tick every 1 ms.
  */
 void systick_init(uint32 reload_val) {
+    systick_cycles_per_ms = reload_val + 1;
+    systick_cycles_per_us = systick_cycles_per_ms / 1000;
+
+    /* Anchor the timebase just before the first period starts, so
+     * every tick finds a whole millisecond has passed. */
+    dwt_cycle_counter_enable();
+    systick_timebase_anchor[systick_timebase_gen & 1].cycles = dwt_cycles();
+
     SYSTICK_BASE->RVR = reload_val;
     systick_enable();
 }
@@ -67,9 +125,66 @@ void systick_enable() {
                          SYSTICK_CSR_TICKINT_PEND);
 }
 
+/**
+ * @brief Turn tickless mode on or off.
+ *
+ * In tickless mode SysTick no longer interrupts every millisecond;
+ * it only fires for a deadline set with systick_schedule(), and every
+ * 2^24 cycles (about 233 ms at 72 MHz) to keep the timebase going.
+ * systick_uptime() and millis() are then computed from the cycle
+ * counter. Anything relying on a regular tick, such as FreeRTOS,
+ * needs tickless mode off.
+ *
+ * @param enable Nonzero to stop the periodic tick, zero to restart it.
+ */
+void systick_set_tickless(uint32 enable) {
+    uint32 masked = nvic_globalirq_masked();
+
+    nvic_globalirq_disable();
+    systick_timebase_update();
+    systick_tickless_mode = enable;
+    if (enable) {
+        systick_program();
+    } else {
+        systick_deadline = 0;
+        SYSTICK_BASE->RVR = systick_cycles_per_ms - 1;
+        SYSTICK_BASE->CNT = 0;
+    }
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
+}
+
+/**
+ * @brief Schedule the next callback in tickless mode.
+ *
+ * The callback attached with systick_attach_callback() runs from the
+ * SysTick handler once systick_cycles() reaches the deadline. There
+ * is one deadline; setting another replaces it.
+ *
+ * @param deadline Value of systick_cycles() to wake up at, or 0 to
+ *                 cancel the pending one.
+ * @see systick_set_tickless()
+ */
+void systick_schedule(uint64 deadline) {
+    uint32 masked = nvic_globalirq_masked();
+
+    nvic_globalirq_disable();
+    systick_deadline = deadline;
+    if (systick_tickless_mode) {
+        systick_program();
+    }
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
+}
+
 /**
  * @brief Attach a callback to be called from the SysTick exception handler.
  *
+ * The callback runs every millisecond, or in tickless mode, at the
+ * deadline set with systick_schedule().
+ *
  * To detach a callback, call this function again with a null argument.
  */
 void systick_attach_callback(void (*callback)(void)) {
@@ -81,7 +196,21 @@ void systick_attach_callback(void (*callback)(void)) {
  */
 
 void __exc_systick(void) {
-    systick_uptime_millis++;
+    systick_timebase_update();
+    if (systick_tickless_mode) {
+        uint64 deadline = systick_deadline;
+        if (deadline && systick_cycles() >= deadline) {
+            systick_deadline = 0;
+            if (systick_user_callback) {
+                systick_user_callback();
+            }
+        }
+        /* The callback may have scheduled the next deadline */
+        if (systick_tickless_mode) {
+            systick_program();
+        }
+        return;
+    }
     if (systick_user_callback) {
         systick_user_callback();
     }
@@ -38,6 +38,8 @@
 static void disable_channel(timer_dev *dev, uint8 channel);
 static void pwm_mode(timer_dev *dev, uint8 channel);
 static void output_compare_mode(timer_dev *dev, uint8 channel);
+static void input_capture_mode(timer_dev *dev, uint8 channel);
+static void ic_config(timer_dev *dev, uint8 channel, uint8 filter);
 
 static inline void enable_irq(timer_dev *dev, timer_interrupt_id iid);
 
@@ -230,6 +232,9 @@ void timer_set_mode(timer_dev *dev, uint8 channel, timer_mode mode) {
     case TIMER_OUTPUT_COMPARE:
         output_compare_mode(dev, channel);
         break;
+    case TIMER_INPUT_CAPTURE:
+        input_capture_mode(dev, channel);
+        break;
     }
 }
 
@@ -293,6 +298,431 @@ void timer_detach_interrupt(timer_dev *dev, uint8 interrupt) {
     dev->handlers[interrupt] = NULL;
 }
 
+/*
+ * Input capture
+ */
+
+/* DMA request for each capture channel */
+static const struct capture_dma {
+    rcc_clk_id clk_id;
+    uint8 channel;
+    dma_request_src src;
+} capture_dma[] = {
+#if STM32_HAVE_TIMER(1)
+    {RCC_TIMER1, 1, DMA_REQ_SRC_TIM1_CH1},
+    {RCC_TIMER1, 2, DMA_REQ_SRC_TIM1_CH2},
+    {RCC_TIMER1, 3, DMA_REQ_SRC_TIM1_CH3},
+    {RCC_TIMER1, 4, DMA_REQ_SRC_TIM1_CH4},
+#endif
+#if STM32_HAVE_TIMER(2)
+    {RCC_TIMER2, 1, DMA_REQ_SRC_TIM2_CH1},
+    {RCC_TIMER2, 2, DMA_REQ_SRC_TIM2_CH2},
+    {RCC_TIMER2, 3, DMA_REQ_SRC_TIM2_CH3},
+    {RCC_TIMER2, 4, DMA_REQ_SRC_TIM2_CH4},
+#endif
+#if STM32_HAVE_TIMER(3)
+    {RCC_TIMER3, 1, DMA_REQ_SRC_TIM3_CH1},
+    {RCC_TIMER3, 3, DMA_REQ_SRC_TIM3_CH3},
+    {RCC_TIMER3, 4, DMA_REQ_SRC_TIM3_CH4},
+#endif
+#if STM32_HAVE_TIMER(4)
+    {RCC_TIMER4, 1, DMA_REQ_SRC_TIM4_CH1},
+    {RCC_TIMER4, 2, DMA_REQ_SRC_TIM4_CH2},
+    {RCC_TIMER4, 3, DMA_REQ_SRC_TIM4_CH3},
+#endif
+#if STM32_HAVE_TIMER(5) && (defined(STM32_HIGH_DENSITY) || \
+                            defined(STM32_XL_DENSITY))
+    {RCC_TIMER5, 1, DMA_REQ_SRC_TIM5_CH1},
+    {RCC_TIMER5, 2, DMA_REQ_SRC_TIM5_CH2},
+    {RCC_TIMER5, 3, DMA_REQ_SRC_TIM5_CH3},
+    {RCC_TIMER5, 4, DMA_REQ_SRC_TIM5_CH4},
+#endif
+};
+
+static int capture_dma_start(timer_capture *cap) {
+    const struct capture_dma *entry = NULL;
+    dma_tube_config cfg;
+    unsigned i;
+    int ret;
+
+    for (i = 0; i < sizeof(capture_dma) / sizeof(capture_dma[0]); i++) {
+        if (capture_dma[i].clk_id == cap->dev->clk_id &&
+            capture_dma[i].channel == cap->channel) {
+            entry = &capture_dma[i];
+            break;
+        }
+    }
+    if (!entry || cap->buf_size == 0) {
+        return -1;
+    }
+
+    cap->dma = DMA1;
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+    if ((rcc_clk_id)(entry->src >> 3) == RCC_DMA2) {
+        cap->dma = DMA2;
+    }
+#endif
+    cap->tube = (dma_tube)(entry->src & 0x7);
+    dma_init(cap->dma);
+
+    cfg.tube_src = &(cap->dev->regs).gen->CCR1 + (cap->channel - 1);
+    cfg.tube_src_size = DMA_SIZE_16BITS;
+    cfg.tube_dst = cap->buf;
+    cfg.tube_dst_size = DMA_SIZE_16BITS;
+    cfg.tube_nr_xfers = cap->buf_size;
+    cfg.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CIRC;
+    cfg.tube_req_src = entry->src;
+    cfg.target_data = NULL;
+    ret = dma_tube_cfg(cap->dma, cap->tube, &cfg);
+    if (ret != DMA_TUBE_CFG_SUCCESS) {
+        return ret;
+    }
+    dma_enable(cap->dma, cap->tube);
+
+    timer_cc_set_pol(cap->dev, cap->channel, cap->level ? 1 : 0);
+    timer_dma_enable_req(cap->dev, cap->channel);
+    timer_cc_enable(cap->dev, cap->channel);
+    return 0;
+}
+
+/**
+ * @brief Start measuring pulses on a timer channel.
+ *
+ * Any capture already running on the channel is stopped. The channel
+ * stops whatever it was doing before, e.g. PWM output.
+ *
+ * @param cap Capture to start; see timer_capture for the fields to
+ *            fill in.
+ * @return 0 on success, nonzero if the timer, channel or DMA
+ *         configuration isn't usable.
+ */
+int timer_capture_start(timer_capture *cap) {
+    timer_dev *dev = cap->dev;
+    uint8 channel = cap->channel;
+    timer_gen_reg_map *regs = (dev->regs).gen;
+    timer_capture *old;
+    uint32 masked;
+
+    if (dev->type == TIMER_BASIC || channel < 1 || channel > 4 ||
+        !timer_has_cc_channel(dev, channel)) {
+        return -1;
+    }
+    old = timer_capture_find(dev, channel);
+    if (old) {
+        timer_capture_stop(old);
+    }
+
+    timer_cc_disable(dev, channel);
+    timer_disable_irq(dev, channel);
+    timer_dma_disable_req(dev, channel);
+    ic_config(dev, channel, cap->filter);
+
+    cap->high = cap->low = cap->period = 0;
+    cap->nr_high = cap->nr_low = 0;
+    cap->base = 0;
+    cap->state = cap->level ? TIMER_CAPTURE_HIGH : 0;
+    if (cap->buf) {
+        return capture_dma_start(cap);
+    }
+
+    masked = nvic_globalirq_masked();
+    nvic_globalirq_disable();
+    cap->next = dev->capture;
+    dev->capture = cap;
+    /* Wait for whichever edge comes next */
+    timer_cc_set_pol(dev, channel, cap->state & TIMER_CAPTURE_HIGH);
+    regs->SR = ~((TIMER_SR_CC1IF | TIMER_SR_CC1OF) << (channel - 1));
+    timer_cc_enable(dev, channel);
+    timer_enable_irq(dev, channel);
+    enable_irq(dev, (timer_interrupt_id)channel);
+    timer_enable_irq(dev, TIMER_UPDATE_INTERRUPT);
+    enable_irq(dev, TIMER_UPDATE_INTERRUPT);
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
+    return 0;
+}
+
+/**
+ * @brief Stop a capture started with timer_capture_start().
+ *
+ * The last results stay in cap.
+ *
+ * @param cap Capture to stop.
+ */
+void timer_capture_stop(timer_capture *cap) {
+    timer_dev *dev = cap->dev;
+    timer_capture **link;
+    uint32 masked;
+
+    timer_cc_disable(dev, cap->channel);
+    if (cap->buf) {
+        timer_dma_disable_req(dev, cap->channel);
+        dma_disable(cap->dma, cap->tube);
+        return;
+    }
+
+    masked = nvic_globalirq_masked();
+    nvic_globalirq_disable();
+    timer_disable_irq(dev, cap->channel);
+    for (link = &dev->capture; *link; link = &(*link)->next) {
+        if (*link == cap) {
+            *link = cap->next;
+            break;
+        }
+    }
+    if (!dev->capture && !dev->handlers[TIMER_UPDATE_INTERRUPT]) {
+        timer_disable_irq(dev, TIMER_UPDATE_INTERRUPT);
+    }
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
+}
+
+/**
+ * @brief Find the interrupt-mode capture running on a channel.
+ * @param dev     Timer device.
+ * @param channel Channel, 1 to 4.
+ * @return The capture, or NULL if there is none.
+ */
+timer_capture* timer_capture_find(timer_dev *dev, uint8 channel) {
+    timer_capture *cap;
+
+    for (cap = dev->capture; cap; cap = cap->next) {
+        if (cap->channel == channel) {
+            return cap;
+        }
+    }
+    return NULL;
+}
+
+/* Account for an edge captured at extended count t. */
+static void capture_edge(timer_capture *cap, uint32 t) {
+    uint8 state = cap->state;
+
+    if (state & TIMER_CAPTURE_HIGH) {
+        if (state & TIMER_CAPTURE_HAVE_RISE) {
+            cap->high = t - cap->rise;
+            cap->nr_high++;
+        }
+        cap->fall = t;
+        state = (state & ~TIMER_CAPTURE_HIGH) | TIMER_CAPTURE_HAVE_FALL;
+    } else {
+        if (state & TIMER_CAPTURE_HAVE_RISE) {
+            cap->period = t - cap->rise;
+        }
+        if (state & TIMER_CAPTURE_HAVE_FALL) {
+            cap->low = t - cap->fall;
+            cap->nr_low++;
+        }
+        cap->rise = t;
+        state |= TIMER_CAPTURE_HIGH | TIMER_CAPTURE_HAVE_RISE;
+    }
+    cap->state = state;
+    /* Falling edge next after a rising one, and vice versa */
+    timer_cc_set_pol(cap->dev, cap->channel, state & TIMER_CAPTURE_HIGH);
+}
+
+/* Called from the timer's interrupt handlers while captures are
+ * running, before any user handlers. Only the vector that owns the
+ * update event (update nonzero) extends the count and clears UIF;
+ * advanced timers' CC vector leaves both to the UP vector. */
+void _timer_capture_irq(timer_dev *dev, int update) {
+    timer_gen_reg_map *regs = (dev->regs).gen;
+    uint32 sr = regs->SR;
+    uint32 updated = sr & TIMER_SR_UIF;
+    uint32 reload = (regs->ARR & 0xFFFF) + 1;
+    timer_capture *cap;
+
+    for (cap = dev->capture; cap; cap = cap->next) {
+        uint8 shift = cap->channel - 1;
+
+        if (sr & (TIMER_SR_CC1IF << shift)) {
+            /* Reading CCR clears CCxIF. */
+            uint32 ccr = *(&regs->CCR1 + shift);
+            uint32 t = cap->base + ccr;
+            /* If the counter has wrapped since, but the update isn't
+             * accounted for yet, a low capture came after the wrap. */
+            if (updated && ccr < reload / 2) {
+                t += reload;
+            }
+            if (sr & (TIMER_SR_CC1OF << shift)) {
+                /* Missed an edge: what we have doesn't pair up. */
+                regs->SR = ~(TIMER_SR_CC1OF << shift);
+                cap->state &= ~(TIMER_CAPTURE_HAVE_RISE |
+                                TIMER_CAPTURE_HAVE_FALL);
+            }
+            capture_edge(cap, t);
+        }
+        if (updated && update) {
+            cap->base += reload;
+        }
+    }
+    /* Leave the flag to the dispatch routine if there's a handler */
+    if (updated && update && !dev->handlers[TIMER_UPDATE_INTERRUPT]) {
+        regs->SR = ~TIMER_SR_UIF;
+    }
+}
+
+/*
+ * Compare value streaming
+ */
+
+/* DMA request for each timer's update event */
+static const struct {
+    rcc_clk_id clk_id;
+    dma_request_src src;
+} update_dma[] = {
+#if STM32_HAVE_TIMER(1)
+    {RCC_TIMER1, DMA_REQ_SRC_TIM1_UP},
+#endif
+#if STM32_HAVE_TIMER(2)
+    {RCC_TIMER2, DMA_REQ_SRC_TIM2_UP},
+#endif
+#if STM32_HAVE_TIMER(3)
+    {RCC_TIMER3, DMA_REQ_SRC_TIM3_UP},
+#endif
+#if STM32_HAVE_TIMER(4)
+    {RCC_TIMER4, DMA_REQ_SRC_TIM4_UP},
+#endif
+#if STM32_HAVE_TIMER(5) && (defined(STM32_HIGH_DENSITY) || \
+                            defined(STM32_XL_DENSITY))
+    {RCC_TIMER5, DMA_REQ_SRC_TIM5_UP},
+#endif
+};
+
+/* Find the DMA tube serving dev's update event. */
+static int update_dma_find(timer_dev *dev, dma_dev **dma, dma_tube *tube) {
+    unsigned i;
+
+    for (i = 0; i < sizeof(update_dma) / sizeof(update_dma[0]); i++) {
+        if (update_dma[i].clk_id == dev->clk_id) {
+            dma_request_src src = update_dma[i].src;
+            *dma = DMA1;
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+            if ((rcc_clk_id)(src >> 3) == RCC_DMA2) {
+                *dma = DMA2;
+            }
+#endif
+            *tube = (dma_tube)(src & 0x7);
+            return (int)src;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Stream a table of compare values into a timer's channels.
+ *
+ * Each update event (once per counter period) DMA writes the next
+ * nr_channels entries of buf into CCRx onwards, through the timer's
+ * DMA burst register, so a PWM duty cycle follows the table with no
+ * CPU involvement. With several channels, buf holds one entry per
+ * channel per period, interleaved. The channels' compare preload
+ * (the default in PWM mode) makes each value take effect on the
+ * following update.
+ *
+ * The timer's prescaler and reload value set the rate, and the
+ * channels should already be in PWM mode. The timer's update DMA
+ * request must not be in use, by an earlier stream (stop it first)
+ * or anything else, and its DMA channel must be free; the channel
+ * is shared with other peripherals (e.g. TIM1_UP with USART1_RX).
+ *
+ * Availability: TIM1 to TIM5.
+ *
+ * @param dev         Timer device.
+ * @param channel     First channel to write, 1 to 4.
+ * @param nr_channels Channels to write each period, from channel on.
+ * @param buf         Compare values; must stay valid while streaming.
+ * @param len         Entries in buf, a multiple of nr_channels.
+ * @param circular    Nonzero to restart at the beginning of buf after
+ *                    the last entry; otherwise the channels keep the
+ *                    last values written.
+ * @return 0 on success, nonzero if the timer has no update DMA
+ *         request, it or its DMA channel is busy or the arguments
+ *         are bad.
+ * @see timer_dma_stream_stop()
+ */
+int timer_dma_stream_start(timer_dev *dev, uint8 channel, uint8 nr_channels,
+                           const uint16 *buf, uint16 len, int circular) {
+    dma_tube_config cfg;
+    dma_dev *dma;
+    dma_tube tube;
+    int src;
+
+    if (dev->type == TIMER_BASIC || channel < 1 || nr_channels < 1 ||
+        channel + nr_channels > 5 || len == 0 || len % nr_channels) {
+        return -1;
+    }
+    src = update_dma_find(dev, &dma, &tube);
+    if (src < 0 || (dev->regs.bas->DIER & TIMER_DIER_UDE)) {
+        return -1;
+    }
+    dma_init(dma);
+    if (dma_is_enabled(dma, tube)) {
+        return -1;
+    }
+
+    cfg.tube_src = (void*)buf;
+    cfg.tube_src_size = DMA_SIZE_16BITS;
+    cfg.tube_dst = &(dev->regs).gen->DMAR;
+    cfg.tube_dst_size = DMA_SIZE_16BITS;
+    cfg.tube_nr_xfers = len;
+    cfg.tube_flags = DMA_CFG_SRC_INC | (circular ? DMA_CFG_CIRC : 0);
+    cfg.tube_req_src = (dma_request_src)src;
+    cfg.target_data = NULL;
+    if (dma_tube_cfg(dma, tube, &cfg) != DMA_TUBE_CFG_SUCCESS) {
+        return -1;
+    }
+
+    timer_dma_set_base_addr(dev, (timer_dma_base_addr)
+                            (TIMER_DMA_BASE_CCR1 + channel - 1));
+    timer_dma_set_burst_len(dev, nr_channels);
+    dma_enable(dma, tube);
+    timer_dma_enable_req(dev, 0);
+    return 0;
+}
+
+/**
+ * @brief Stop streaming compare values into a timer.
+ *
+ * The channels keep the last values written.
+ *
+ * @param dev Timer device.
+ * @see timer_dma_stream_start()
+ */
+void timer_dma_stream_stop(timer_dev *dev) {
+    dma_dev *dma;
+    dma_tube tube;
+
+    if (!(dev->regs.bas->DIER & TIMER_DIER_UDE) ||
+        update_dma_find(dev, &dma, &tube) < 0) {
+        return;
+    }
+    timer_dma_disable_req(dev, 0);
+    dma_disable(dma, tube);
+}
+
+/**
+ * @brief Entries of a stream's table still to be written.
+ *
+ * For a circular stream, this counts down to the end of the table
+ * and starts again.
+ *
+ * @param dev Timer device.
+ * @return Entries left, or 0 if no stream is running.
+ */
+uint16 timer_dma_stream_left(timer_dev *dev) {
+    dma_dev *dma;
+    dma_tube tube;
+
+    if (!(dev->regs.bas->DIER & TIMER_DIER_UDE) ||
+        update_dma_find(dev, &dma, &tube) < 0) {
+        return 0;
+    }
+    return dma_tube_regs(dma, tube)->CNDTR;
+}
+
 /*
  * Utilities
  */
@@ -313,6 +743,26 @@ static void output_compare_mode(timer_dev *dev, uint8 channel) {
     timer_cc_enable(dev, channel);
 }
 
+static void input_capture_mode(timer_dev *dev, uint8 channel) {
+    timer_cc_disable(dev, channel);
+    ic_config(dev, channel, 0);
+    timer_cc_set_pol(dev, channel, 0);
+    timer_cc_enable(dev, channel);
+}
+
+/* Make a channel capture its own input (TIx), with the given input
+ * filter. CCxS is only writable while the channel is disabled. */
+static void ic_config(timer_dev *dev, uint8 channel, uint8 filter) {
+    /* Same layout as in timer_oc_set_mode() */
+    __io uint32 *ccmr = &(dev->regs).gen->CCMR1 + (((channel - 1) >> 1) & 1);
+    uint8 shift = 8 * (1 - (channel & 1));
+    uint32 tmp = *ccmr;
+
+    tmp &= ~(0xFF << shift);
+    tmp |= (((filter & 0xF) << 4) | TIMER_CCMR_CCS_INPUT_TI1) << shift;
+    *ccmr = tmp;
+}
+
 static void enable_adv_irq(timer_dev *dev, timer_interrupt_id id);
 static void enable_bas_gen_irq(timer_dev *dev);
 
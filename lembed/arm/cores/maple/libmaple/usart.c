@@ -37,56 +37,173 @@
 #include "usart_private.h"
 #include <libmaple/rcc.h>
 #include <libmaple/stm32.h>
+#include <libmaple/dma.h>
 
-static ring_buffer usart1_rb;
+/*
+ * DMA tubes and request sources. The DMA interrupt handlers take no
+ * arguments, so each USART gets a pair of small trampolines, defined
+ * with the interrupt handlers below.
+ */
+
+static void usart1_dma_rx_isr(void);
+static void usart1_dma_tx_isr(void);
+static void usart2_dma_rx_isr(void);
+static void usart2_dma_tx_isr(void);
+static void usart3_dma_rx_isr(void);
+static void usart3_dma_tx_isr(void);
+
+/* A ring buffer over a statically allocated array. */
+#define USART_RB(array) { .buf = array, .mask = sizeof(array) - 1 }
+
+/* Whether n bytes suit a port's ring buffer */
+#define USART_BUF_SIZE_OK(n) (IS_POWER_OF_TWO(n) && (n) <= 32768)
+
+#define USART_DMA_CONFIG(rx_ch, rx_src, rx_fn, tx_ch, tx_src, tx_fn) \
+    {                                                                \
+        .rx_tube = rx_ch,                                            \
+        .rx_req  = rx_src,                                           \
+        .tx_tube = tx_ch,                                            \
+        .tx_req  = tx_src,                                           \
+        .rx_isr  = rx_fn,                                            \
+        .tx_isr  = tx_fn,                                            \
+    }
+
+static usart_dma usart1_dma =
+    USART_DMA_CONFIG(DMA_CH5, DMA_REQ_SRC_USART1_RX, usart1_dma_rx_isr,
+                     DMA_CH4, DMA_REQ_SRC_USART1_TX, usart1_dma_tx_isr);
+static usart_dma usart2_dma =
+    USART_DMA_CONFIG(DMA_CH6, DMA_REQ_SRC_USART2_RX, usart2_dma_rx_isr,
+                     DMA_CH7, DMA_REQ_SRC_USART2_TX, usart2_dma_tx_isr);
+static usart_dma usart3_dma =
+    USART_DMA_CONFIG(DMA_CH3, DMA_REQ_SRC_USART3_RX, usart3_dma_rx_isr,
+                     DMA_CH2, DMA_REQ_SRC_USART3_TX, usart3_dma_tx_isr);
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+static void uart4_dma_rx_isr(void);
+static void uart4_dma_tx_isr(void);
+static usart_dma uart4_dma =
+    USART_DMA_CONFIG(DMA_CH3, DMA_REQ_SRC_UART4_RX, uart4_dma_rx_isr,
+                     DMA_CH5, DMA_REQ_SRC_UART4_TX, uart4_dma_tx_isr);
+/* UART5 has no DMA requests. */
+#endif
+
+#ifndef USART1_RX_BUF_SIZE
+#define USART1_RX_BUF_SIZE USART_RX_BUF_SIZE
+#endif
+#ifndef USART1_TX_BUF_SIZE
+#define USART1_TX_BUF_SIZE USART_TX_BUF_SIZE
+#endif
+#if !USART_BUF_SIZE_OK(USART1_RX_BUF_SIZE) || !USART_BUF_SIZE_OK(USART1_TX_BUF_SIZE)
+#error "USART1_RX_BUF_SIZE and USART1_TX_BUF_SIZE must be powers of two, at most 32768"
+#endif
+static uint8 usart1_rx_buf[USART1_RX_BUF_SIZE];
+static uint8 usart1_tx_buf[USART1_TX_BUF_SIZE];
+static ring_buffer usart1_rb = USART_RB(usart1_rx_buf);
+static ring_buffer usart1_wb = USART_RB(usart1_tx_buf);
 static usart_dev usart1 = {
     .regs     = USART1_BASE,
     .rb       = &usart1_rb,
+    .wb       = &usart1_wb,
     .max_baud = 4500000UL,
     .clk_id   = RCC_USART1,
     .irq_num  = NVIC_USART1,
+    .dma      = &usart1_dma,
 };
 /** USART1 device */
 usart_dev *USART1 = &usart1;
 
-static ring_buffer usart2_rb;
+#ifndef USART2_RX_BUF_SIZE
+#define USART2_RX_BUF_SIZE USART_RX_BUF_SIZE
+#endif
+#ifndef USART2_TX_BUF_SIZE
+#define USART2_TX_BUF_SIZE USART_TX_BUF_SIZE
+#endif
+#if !USART_BUF_SIZE_OK(USART2_RX_BUF_SIZE) || !USART_BUF_SIZE_OK(USART2_TX_BUF_SIZE)
+#error "USART2_RX_BUF_SIZE and USART2_TX_BUF_SIZE must be powers of two, at most 32768"
+#endif
+static uint8 usart2_rx_buf[USART2_RX_BUF_SIZE];
+static uint8 usart2_tx_buf[USART2_TX_BUF_SIZE];
+static ring_buffer usart2_rb = USART_RB(usart2_rx_buf);
+static ring_buffer usart2_wb = USART_RB(usart2_tx_buf);
 static usart_dev usart2 = {
     .regs     = USART2_BASE,
     .rb       = &usart2_rb,
+    .wb       = &usart2_wb,
     .max_baud = 2250000UL,
     .clk_id   = RCC_USART2,
     .irq_num  = NVIC_USART2,
+    .dma      = &usart2_dma,
 };
 /** USART2 device */
 usart_dev *USART2 = &usart2;
 
-static ring_buffer usart3_rb;
+#ifndef USART3_RX_BUF_SIZE
+#define USART3_RX_BUF_SIZE USART_RX_BUF_SIZE
+#endif
+#ifndef USART3_TX_BUF_SIZE
+#define USART3_TX_BUF_SIZE USART_TX_BUF_SIZE
+#endif
+#if !USART_BUF_SIZE_OK(USART3_RX_BUF_SIZE) || !USART_BUF_SIZE_OK(USART3_TX_BUF_SIZE)
+#error "USART3_RX_BUF_SIZE and USART3_TX_BUF_SIZE must be powers of two, at most 32768"
+#endif
+static uint8 usart3_rx_buf[USART3_RX_BUF_SIZE];
+static uint8 usart3_tx_buf[USART3_TX_BUF_SIZE];
+static ring_buffer usart3_rb = USART_RB(usart3_rx_buf);
+static ring_buffer usart3_wb = USART_RB(usart3_tx_buf);
 static usart_dev usart3 = {
     .regs     = USART3_BASE,
     .rb       = &usart3_rb,
+    .wb       = &usart3_wb,
     .max_baud = 2250000UL,
     .clk_id   = RCC_USART3,
     .irq_num  = NVIC_USART3,
+    .dma      = &usart3_dma,
 };
 /** USART3 device */
 usart_dev *USART3 = &usart3;
 
 #if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
-static ring_buffer uart4_rb;
+#ifndef UART4_RX_BUF_SIZE
+#define UART4_RX_BUF_SIZE USART_RX_BUF_SIZE
+#endif
+#ifndef UART4_TX_BUF_SIZE
+#define UART4_TX_BUF_SIZE USART_TX_BUF_SIZE
+#endif
+#if !USART_BUF_SIZE_OK(UART4_RX_BUF_SIZE) || !USART_BUF_SIZE_OK(UART4_TX_BUF_SIZE)
+#error "UART4_RX_BUF_SIZE and UART4_TX_BUF_SIZE must be powers of two, at most 32768"
+#endif
+static uint8 uart4_rx_buf[UART4_RX_BUF_SIZE];
+static uint8 uart4_tx_buf[UART4_TX_BUF_SIZE];
+static ring_buffer uart4_rb = USART_RB(uart4_rx_buf);
+static ring_buffer uart4_wb = USART_RB(uart4_tx_buf);
 static usart_dev uart4 = {
     .regs     = UART4_BASE,
     .rb       = &uart4_rb,
+    .wb       = &uart4_wb,
     .max_baud = 2250000UL,
     .clk_id   = RCC_UART4,
     .irq_num  = NVIC_UART4,
+    .dma      = &uart4_dma,
 };
 /** UART4 device */
 usart_dev *UART4 = &uart4;
 
-static ring_buffer uart5_rb;
+#ifndef UART5_RX_BUF_SIZE
+#define UART5_RX_BUF_SIZE USART_RX_BUF_SIZE
+#endif
+#ifndef UART5_TX_BUF_SIZE
+#define UART5_TX_BUF_SIZE USART_TX_BUF_SIZE
+#endif
+#if !USART_BUF_SIZE_OK(UART5_RX_BUF_SIZE) || !USART_BUF_SIZE_OK(UART5_TX_BUF_SIZE)
+#error "UART5_RX_BUF_SIZE and UART5_TX_BUF_SIZE must be powers of two, at most 32768"
+#endif
+static uint8 uart5_rx_buf[UART5_RX_BUF_SIZE];
+static uint8 uart5_tx_buf[UART5_TX_BUF_SIZE];
+static ring_buffer uart5_rb = USART_RB(uart5_rx_buf);
+static ring_buffer uart5_wb = USART_RB(uart5_tx_buf);
 static usart_dev uart5 = {
     .regs     = UART5_BASE,
     .rb       = &uart5_rb,
+    .wb       = &uart5_wb,
     .max_baud = 2250000UL,
     .clk_id   = RCC_UART5,
     .irq_num  = NVIC_UART5,
@@ -187,34 +304,150 @@ void usart_foreach(void (*fn)(usart_dev*))
 #endif
 }
 
+/*
+ * DMA helpers
+ */
+
+/* Retire the TX block that just finished: it was at the front of wb. */
+static void usart_dma_tx_advance(usart_dev *dev)
+{
+    rb_read_commit(dev->wb, dev->dma->tx_len);
+    dev->dma->tx_len = 0;
+}
+
+/* Start a DMA transfer of the longest contiguous run of bytes at the
+ * front of wb, unless one is in flight already. The transfer-complete
+ * interrupt calls this again, so wb drains block by block. */
+static void usart_dma_tx_kick(usart_dev *dev)
+{
+    usart_dma *dma = dev->dma;
+    uint8 *span;
+    uint16 len;
+
+    if (dma->tx_len || !(len = rb_read_span(dev->wb, &span))) {
+        return;
+    }
+    dma->tx_len = len;
+
+    dma_disable(dma->dma_dev, dma->tx_tube);
+    dma_set_mem_addr(dma->dma_dev, dma->tx_tube, span);
+    dma_set_num_transfers(dma->dma_dev, dma->tx_tube, len);
+    dma_enable(dma->dma_dev, dma->tx_tube);
+}
+
+static void usart_dma_rx_irq(usart_dma *dma)
+{
+    dma_irq_cause cause = dma_get_irq_cause(dma->dma_dev, dma->rx_tube);
+
+    dma_ring_update(&dma->rx, dma->rx_cndtr);
+    if (!dma->handler) {
+        return;
+    }
+    if (cause == DMA_TRANSFER_HALF_COMPLETE) {
+        dma->handler(USART_DMA_RX_HALF);
+    } else if (cause == DMA_TRANSFER_COMPLETE) {
+        dma->handler(USART_DMA_RX_FULL);
+    }
+}
+
+static void usart_dma_tx_irq(usart_dev *dev)
+{
+    usart_dma *dma = dev->dma;
+
+    dma_clear_isr_bits(dma->dma_dev, dma->tx_tube);
+    if (!dma->tx_len) {
+        /* Already retired by usart_tx_drain_polled() */
+        return;
+    }
+    usart_dma_tx_advance(dev);
+    usart_dma_tx_kick(dev);
+    if (dma->handler) {
+        dma->handler(USART_DMA_TX_DONE);
+    }
+}
+
+/* Called by usart_irq() on IDLE. */
+void _usart_dma_rx_idle(usart_dma *dma)
+{
+    if (!dma || !dma->rx_on) {
+        return;
+    }
+    dma_ring_update(&dma->rx, dma->rx_cndtr);
+    if (dma->handler) {
+        dma->handler(USART_DMA_RX_IDLE);
+    }
+}
+
 /*
  * Interrupt handlers.
  */
 
+static void usart1_dma_rx_isr(void)
+{
+    usart_dma_rx_irq(&usart1_dma);
+}
+
+static void usart1_dma_tx_isr(void)
+{
+    usart_dma_tx_irq(&usart1);
+}
+
+static void usart2_dma_rx_isr(void)
+{
+    usart_dma_rx_irq(&usart2_dma);
+}
+
+static void usart2_dma_tx_isr(void)
+{
+    usart_dma_tx_irq(&usart2);
+}
+
+static void usart3_dma_rx_isr(void)
+{
+    usart_dma_rx_irq(&usart3_dma);
+}
+
+static void usart3_dma_tx_isr(void)
+{
+    usart_dma_tx_irq(&usart3);
+}
+
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+static void uart4_dma_rx_isr(void)
+{
+    usart_dma_rx_irq(&uart4_dma);
+}
+
+static void uart4_dma_tx_isr(void)
+{
+    usart_dma_tx_irq(&uart4);
+}
+#endif
+
 void __irq_usart1(void)
 {
-    usart_irq(&usart1_rb, USART1_BASE);
+    usart_irq(&usart1, &usart1_rb, &usart1_wb, &usart1_dma, USART1_BASE);
 }
 
 void __irq_usart2(void)
 {
-    usart_irq(&usart2_rb, USART2_BASE);
+    usart_irq(&usart2, &usart2_rb, &usart2_wb, &usart2_dma, USART2_BASE);
 }
 
 void __irq_usart3(void)
 {
-    usart_irq(&usart3_rb, USART3_BASE);
+    usart_irq(&usart3, &usart3_rb, &usart3_wb, &usart3_dma, USART3_BASE);
 }
 
 #ifdef STM32_HIGH_DENSITY
 void __irq_uart4(void)
 {
-    usart_irq(&uart4_rb, UART4_BASE);
+    usart_irq(&uart4, &uart4_rb, &uart4_wb, &uart4_dma, UART4_BASE);
 }
 
 void __irq_uart5(void)
 {
-    usart_irq(&uart5_rb, UART5_BASE);
+    usart_irq(&uart5, &uart5_rb, &uart5_wb, NULL, UART5_BASE);
 }
 #endif
 
@@ -224,7 +457,8 @@ void __irq_uart5(void)
  */
 void usart_init(usart_dev *dev)
 {
-    rb_init(dev->rb, USART_RX_BUF_SIZE, dev->rx_buf);
+    rb_reset(dev->rb);
+    rb_reset(dev->wb);
     rcc_clk_enable(dev->clk_id);
     nvic_irq_enable(dev->irq_num);
 }
@@ -256,34 +490,128 @@ void usart_disable(usart_dev *dev)
     /* FIXME this misbehaves (on F1) if you try to use PWM on TX afterwards */
     usart_reg_map *regs = dev->regs;
 
-    /* TC bit must be high before disabling the USART */
-    while ((regs->CR1 & USART_CR1_UE) && !(regs->SR & USART_SR_TC))
-        ;
+    /* Let queued bytes go out, and TC go high, before disabling */
+    if (regs->CR1 & USART_CR1_UE) {
+        usart_tx_flush(dev);
+    }
+    if (dev->dma && dev->dma->tx_on) {
+        usart_dma_tx_disable(dev);
+    }
+    if (dev->dma && dev->dma->rx_on) {
+        usart_dma_rx_disable(dev);
+    }
 
-    /* Disable UE */
-    regs->CR1 &= ~USART_CR1_UE;
+    /* Disable UE and the TX interrupt */
+    regs->CR1 &= ~(USART_CR1_UE | USART_CR1_TXEIE);
 
-    /* Clean up buffer */
+    /* Clean up buffers */
     usart_reset_rx(dev);
+    rb_reset(dev->wb);
+}
+
+/*
+ * Returns nonzero if dev's interrupt can't run right now, because it
+ * is disabled in the NVIC (e.g. by __lm_error()), interrupts are
+ * masked, or we're inside an exception handler. Waiting on the TXE
+ * interrupt from here would hang, so usart_tx() and usart_tx_flush()
+ * fall back to polling instead.
+ */
+static inline int usart_tx_irq_blocked(usart_dev *dev)
+{
+    return (nvic_globalirq_masked() || nvic_active_exception() ||
+            !(NVIC_BASE->ISER[dev->irq_num / 32] & BIT(dev->irq_num % 32)));
+}
+
+/*
+ * Empty dev's TX buffer by polling TXE. Interrupts are masked while
+ * we do it, since we're stepping in for the consumer side of wb. A
+ * DMA block in flight is waited out first.
+ */
+static void usart_tx_drain_polled(usart_dev *dev)
+{
+    usart_reg_map *regs = dev->regs;
+    usart_dma *dma = dev->dma;
+    uint32 masked = nvic_globalirq_masked();
+
+    nvic_globalirq_disable();
+    if (dma && dma->tx_len) {
+        while (!(dma_get_isr_bits(dma->dma_dev, dma->tx_tube) &
+                 (1U << DMA_ISR_TCIF_BIT)))
+            ;
+        dma_clear_isr_bits(dma->dma_dev, dma->tx_tube);
+        usart_dma_tx_advance(dev);
+    }
+    while (!rb_is_empty(dev->wb)) {
+        while (!(regs->SR & USART_SR_TXE))
+            ;
+        regs->DR = rb_remove(dev->wb);
+    }
+    if (!masked) {
+        nvic_globalirq_enable();
+    }
 }
 
 /**
  * @brief Nonblocking USART transmit
+ *
+ * Bytes are copied into the TX ring buffer, which the USART interrupt
+ * drains whenever DR is empty (or, with usart_dma_tx_enable(), which
+ * the DMA drains a contiguous block at a time). If the interrupt
+ * can't run (interrupts are masked, or we're in an exception
+ * handler), the buffer is emptied by polling and buf is written
+ * straight to DR instead.
+ *
  * @param dev Serial port to transmit over
  * @param buf Buffer to transmit
  * @param len Maximum number of bytes to transmit
- * @return Number of bytes transmitted
+ * @return Number of bytes queued or transmitted
  */
 uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len)
 {
     usart_reg_map *regs = dev->regs;
     uint32 txed = 0;
-    while ((regs->SR & USART_SR_TXE) && (txed < len)) {
-        regs->DR = buf[txed++];
+
+    if (usart_tx_irq_blocked(dev)) {
+        usart_tx_drain_polled(dev);
+        while ((regs->SR & USART_SR_TXE) && (txed < len)) {
+            regs->DR = buf[txed++];
+        }
+        return txed;
+    }
+
+    txed = rb_write(dev->wb, buf, len > 0xFFFF ? 0xFFFF : len);
+    if (txed) {
+        if (dev->dma && dev->dma->tx_on) {
+            usart_dma_tx_kick(dev);
+        } else {
+            bb_peri_set_bit(&regs->CR1, USART_CR1_TXEIE_BIT, 1);
+        }
     }
     return txed;
 }
 
+/**
+ * @brief Wait until everything queued on a serial port has been sent.
+ *
+ * Blocks until the TX buffer is empty and the last frame has left
+ * the shift register (TC is set). The RX buffer is left alone.
+ *
+ * @param dev Serial port to flush
+ */
+void usart_tx_flush(usart_dev *dev)
+{
+    usart_reg_map *regs = dev->regs;
+
+    if (usart_tx_irq_blocked(dev)) {
+        usart_tx_drain_polled(dev);
+    } else {
+        while (usart_tx_pending(dev))
+            ;
+    }
+    while (!(regs->SR & USART_SR_TC))
+        ;
+}
+
 /**
  * @brief Nonblocking USART receive.
  * @param dev Serial port to receive bytes from
@@ -294,6 +622,11 @@ uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len)
 uint32 usart_rx(usart_dev *dev, uint8 *buf, uint32 len)
 {
     uint32 rxed = 0;
+
+    if (!usart_dma_rx_on(dev)) {
+        dev->rx_held = 0;
+        return rb_read(dev->rb, buf, len > 0xFFFF ? 0xFFFF : len);
+    }
     while (usart_data_available(dev) && rxed < len) {
         *buf++ = usart_getc(dev);
         rxed++;
@@ -326,6 +659,202 @@ void usart_putudec(usart_dev *dev, uint32 val)
     }
 }
 
+/*
+ * DMA mode
+ */
+
+/* Find (and clock) the DMA controller serving dma's requests. */
+static dma_dev* usart_dma_dev(usart_dma *dma)
+{
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+    dma->dma_dev = ((rcc_clk_id)(dma->rx_req >> 3) == RCC_DMA2 ?
+                    DMA2 : DMA1);
+#else
+    dma->dma_dev = DMA1;
+#endif
+    dma_init(dma->dma_dev);
+    return dma->dma_dev;
+}
+
+/**
+ * @brief Receive through a circular DMA buffer instead of RXNE.
+ *
+ * The DMA tube fills buf in circular mode; the half-transfer,
+ * transfer-complete and IDLE line interrupts keep track of how far
+ * it got, so there is no interrupt per byte. usart_getc(),
+ * usart_peek(), usart_data_available() and usart_rx() read from buf
+ * from then on. Bytes still in the RXNE ring buffer are dropped.
+ *
+ * Call this after usart_init(). If the reader falls more than a
+ * buffer behind, the oldest data is lost.
+ *
+ * @param dev  Serial port to switch over
+ * @param buf  Buffer for the DMA to fill, or NULL to reuse the RX
+ *             ring buffer's storage
+ * @param size Size of buf; must be a power of two. Ignored if buf is
+ *             NULL.
+ * @return 0 on success, or the (negative) dma_tube_cfg() error code.
+ * @see usart_dma_attach_handler()
+ */
+int usart_dma_rx_enable(usart_dev *dev, uint8 *buf, uint16 size)
+{
+    usart_reg_map *regs = dev->regs;
+    usart_dma *dma = dev->dma;
+    dma_tube_config cfg;
+    int ret;
+
+    if (!dma) {
+        return -DMA_TUBE_CFG_EREQ;
+    }
+    if (!buf) {
+        buf = (uint8*)dev->rb->buf;
+        size = rb_capacity(dev->rb);
+    }
+    if (size < 2 || (size & (size - 1))) {
+        return -DMA_TUBE_CFG_ENDATA;
+    }
+
+    cfg.tube_src = &regs->DR;
+    cfg.tube_src_size = DMA_SIZE_8BITS;
+    cfg.tube_dst = buf;
+    cfg.tube_dst_size = DMA_SIZE_8BITS;
+    cfg.tube_nr_xfers = size;
+    cfg.tube_flags = (DMA_CFG_DST_INC | DMA_CFG_CIRC |
+                      DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE);
+    cfg.target_data = NULL;
+    cfg.tube_req_src = dma->rx_req;
+
+    bb_peri_set_bit(&regs->CR1, USART_CR1_RXNEIE_BIT, 0);
+    ret = dma_tube_cfg(usart_dma_dev(dma), dma->rx_tube, &cfg);
+    if (ret < 0) {
+        bb_peri_set_bit(&regs->CR1, USART_CR1_RXNEIE_BIT, 1);
+        return ret;
+    }
+    dma_ring_init(&dma->rx, buf, size);
+    dma->rx_cndtr = &dma_tube_regs(dma->dma_dev, dma->rx_tube)->CNDTR;
+    dma_attach_interrupt(dma->dma_dev, dma->rx_tube, dma->rx_isr);
+    dma->rx_on = 1;
+
+    dma_enable(dma->dma_dev, dma->rx_tube);
+    bb_peri_set_bit(&regs->CR3, USART_CR3_DMAR_BIT, 1);
+    bb_peri_set_bit(&regs->CR1, USART_CR1_IDLEIE_BIT, 1);
+    return DMA_TUBE_CFG_SUCCESS;
+}
+
+/**
+ * @brief Go back to receiving through the RXNE interrupt.
+ *
+ * Unread bytes in the DMA buffer are dropped.
+ *
+ * @param dev Serial port to switch back
+ */
+void usart_dma_rx_disable(usart_dev *dev)
+{
+    usart_reg_map *regs = dev->regs;
+    usart_dma *dma = dev->dma;
+
+    if (!dma || !dma->rx_on) {
+        return;
+    }
+    bb_peri_set_bit(&regs->CR1, USART_CR1_IDLEIE_BIT, 0);
+    bb_peri_set_bit(&regs->CR3, USART_CR3_DMAR_BIT, 0);
+    dma_disable(dma->dma_dev, dma->rx_tube);
+    dma_detach_interrupt(dma->dma_dev, dma->rx_tube);
+    dma->rx_on = 0;
+
+    rb_reset(dev->rb);
+    bb_peri_set_bit(&regs->CR1, USART_CR1_RXNEIE_BIT, 1);
+}
+
+/**
+ * @brief Transmit through DMA instead of TXE.
+ *
+ * usart_tx() keeps queueing into the TX ring buffer, but the buffer
+ * is handed to the DMA a contiguous block at a time, so there is one
+ * interrupt per block rather than one per byte.
+ *
+ * Call this after usart_init().
+ *
+ * @param dev Serial port to switch over
+ * @return 0 on success, or the (negative) dma_tube_cfg() error code.
+ */
+int usart_dma_tx_enable(usart_dev *dev)
+{
+    usart_reg_map *regs = dev->regs;
+    usart_dma *dma = dev->dma;
+    dma_tube_config cfg;
+    int ret;
+
+    if (!dma) {
+        return -DMA_TUBE_CFG_EREQ;
+    }
+    /* Let the TXE interrupt finish what it started. */
+    if (regs->CR1 & USART_CR1_UE) {
+        usart_tx_flush(dev);
+    }
+
+    cfg.tube_src = dev->wb->buf;
+    cfg.tube_src_size = DMA_SIZE_8BITS;
+    cfg.tube_dst = &regs->DR;
+    cfg.tube_dst_size = DMA_SIZE_8BITS;
+    cfg.tube_nr_xfers = 0;      /* set per block by usart_dma_tx_kick() */
+    cfg.tube_flags = DMA_CFG_SRC_INC | DMA_CFG_CMPLT_IE;
+    cfg.target_data = NULL;
+    cfg.tube_req_src = dma->tx_req;
+
+    ret = dma_tube_cfg(usart_dma_dev(dma), dma->tx_tube, &cfg);
+    if (ret < 0) {
+        return ret;
+    }
+    dma_attach_interrupt(dma->dma_dev, dma->tx_tube, dma->tx_isr);
+    dma->tx_len = 0;
+    dma->tx_on = 1;
+    bb_peri_set_bit(&regs->CR3, USART_CR3_DMAT_BIT, 1);
+    return DMA_TUBE_CFG_SUCCESS;
+}
+
+/**
+ * @brief Go back to transmitting through the TXE interrupt.
+ *
+ * Anything already queued is sent first.
+ *
+ * @param dev Serial port to switch back
+ */
+void usart_dma_tx_disable(usart_dev *dev)
+{
+    usart_reg_map *regs = dev->regs;
+    usart_dma *dma = dev->dma;
+
+    if (!dma || !dma->tx_on) {
+        return;
+    }
+    if (regs->CR1 & USART_CR1_UE) {
+        usart_tx_flush(dev);
+    }
+    bb_peri_set_bit(&regs->CR3, USART_CR3_DMAT_BIT, 0);
+    dma_disable(dma->dma_dev, dma->tx_tube);
+    dma_detach_interrupt(dma->dma_dev, dma->tx_tube);
+    dma->tx_len = 0;
+    dma->tx_on = 0;
+}
+
+/**
+ * @brief Get told about DMA progress on a serial port.
+ *
+ * handler runs in interrupt context on RX half/full/IDLE events (see
+ * usart_dma_rx_enable()) and whenever a TX block finishes.
+ *
+ * @param dev     Serial port
+ * @param handler Function to call, or NULL for none
+ */
+void usart_dma_attach_handler(usart_dev *dev,
+                              void (*handler)(usart_dma_event))
+{
+    if (dev->dma) {
+        dev->dma->handler = handler;
+    }
+}
+
 uint32 _usart_clock_freq(usart_dev *dev)
 {
     rcc_clk_domain domain = rcc_dev_clk(dev->clk_id);
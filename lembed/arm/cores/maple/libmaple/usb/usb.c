@@ -232,6 +232,9 @@ void __irq_usb_lp_can_rx0(void) {
 #if (USB_ISR_MSK & USB_ISTR_SOF)
     if (istr & USB_ISTR_SOF & USBLIB->irq_mask) {
         USB_BASE->ISTR = ~USB_ISTR_SOF;
+        if (USBLIB->sof_hook) {
+            USBLIB->sof_hook();
+        }
     }
 #endif
 
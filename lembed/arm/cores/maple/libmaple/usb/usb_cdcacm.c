@@ -38,6 +38,7 @@
 #include <libmaple/usb.h>
 #include <libmaple/nvic.h>
 #include <libmaple/delay.h>
+#include <libmaple/ring_buffer.h>
 
 /* Private headers */
 #include "usb_lib_globals.h"
@@ -63,6 +64,7 @@
 
 static void vcomDataTxCb(void);
 static void vcomDataRxCb(void);
+static void vcomSofCb(void);
 static uint8* vcomGetSetLineCoding(uint16);
 
 static void usbInit(void);
@@ -263,13 +265,35 @@ static ONE_DESCRIPTOR String_Descriptor[N_STRING_DESCRIPTORS] = {
 static volatile uint8 vcomBufferRx[CDC_SERIAL_BUFFER_SIZE];
 /* Read index into vcomBufferRx */
 static volatile uint32 rx_offset = 0;
-/* Number of bytes left to transmit */
-static volatile uint32 n_unsent_bytes = 0;
-/* Are we currently sending an IN packet? */
-static volatile uint8 transmitting = 0;
 /* Number of unread bytes */
 static volatile uint32 n_unread_bytes = 0;
 
+/* Data waiting to be packetized. usb_cdcacm_tx() fills it; the TX
+ * endpoint callback empties it. */
+static uint8 vcomBufferTx[USB_CDCACM_TX_BUF_SIZE];
+static ring_buffer tx_rb = {
+    .buf  = vcomBufferTx,
+    .mask = USB_CDCACM_TX_BUF_SIZE - 1,
+};
+
+#ifdef USB_CDCACM_TX_DBL_BUF
+#define TX_PMA_PACKETS 2
+#else
+#define TX_PMA_PACKETS 1
+#endif
+
+/* Number of IN packets in the PMA that the host hasn't taken yet */
+static volatile uint8 tx_packets = 0;
+/* Their lengths, by PMA buffer, and the buffer that goes out first */
+static volatile uint16 tx_packet_len[2];
+static volatile uint8 tx_first_buf = 0;
+/* Number of bytes in those packets */
+static volatile uint32 n_unsent_bytes = 0;
+/* Did the last packet fill the endpoint? If so, the host won't
+ * consider the transfer done until it gets a short or zero-length
+ * packet. */
+static volatile uint8 tx_need_zlp = 0;
+
 /* Other state (line coding, DTR/RTS) */
 
 static volatile usb_cdcacm_line_coding line_coding = {
@@ -371,6 +395,9 @@ void usb_cdcacm_set_hooks(unsigned hook_flags, void (*hook)(unsigned, void*))
 
 void usb_cdcacm_enable(gpio_dev *disc_dev, uint8 disc_bit)
 {
+    /* Finish up transfers on start of frame. */
+    USBLIB->sof_hook = vcomSofCb;
+
     /* Present ourselves to the host. Writing 0 to "disc" pin must
      * pull USB_DP pin up while leaving USB_DM pulled down by the
      * transceiver. See USB 2.0 spec, section 7.1.7.3. */
@@ -395,38 +422,100 @@ void usb_cdcacm_putc(char ch)
         ;
 }
 
-/* This function is non-blocking.
- *
- * It copies data from a usercode buffer into the USB peripheral TX
- * buffer, and returns the number of bytes copied. */
-uint32 usb_cdcacm_tx(const uint8* buf, uint32 len)
+/* Load the next len bytes of tx_rb (possibly none, for a ZLP) into a
+ * free PMA buffer and hand it to the IN endpoint. Must not race with
+ * the USB interrupt. */
+static void vcomTxPacket(uint16 len)
 {
-    /* Last transmission hasn't finished, so abort. */
-    if (usb_cdcacm_is_transmitting()) {
-        return 0;
-    }
+    uint8 packet[USB_CDCACM_TX_EPSIZE];
+    uint8 *src;
+    uint8 buf = 0;
+    int in_place;
 
-    /* We can only put USB_CDCACM_TX_EPSIZE bytes in the buffer. */
-    if (len > USB_CDCACM_TX_EPSIZE) {
-        len = USB_CDCACM_TX_EPSIZE;
+    /* Copy straight out of tx_rb, unless the packet wraps around. */
+    in_place = rb_read_span(&tx_rb, &src) >= len;
+    if (!in_place) {
+        rb_read(&tx_rb, packet, len);
+        src = packet;
     }
 
-    /* Queue bytes for sending. */
-    if (len) {
-        usb_copy_to_pma(buf, len, USB_CDCACM_TX_ADDR);
+#ifdef USB_CDCACM_TX_DBL_BUF
+    /* SW_BUF names the buffer the hardware isn't using. Toggling it
+     * passes that buffer on. */
+    if (usb_get_ep_tx_sw_buf(USB_CDCACM_TX_ENDP)) {
+        usb_copy_to_pma(src, len, USB_CDCACM_TX_ADDR1);
+        usb_set_ep_tx_buf1_count(USB_CDCACM_TX_ENDP, len);
+        buf = 1;
+    } else {
+        usb_copy_to_pma(src, len, USB_CDCACM_TX_ADDR);
+        usb_set_ep_tx_buf0_count(USB_CDCACM_TX_ENDP, len);
     }
-    // We still need to wait for the interrupt, even if we're sending
-    // zero bytes. (Sending zero-size packets is useful for flushing
-    // host-side buffers.)
+    usb_toggle_ep_tx_sw_buf(USB_CDCACM_TX_ENDP);
+#else
+    usb_copy_to_pma(src, len, USB_CDCACM_TX_ADDR);
     usb_set_ep_tx_count(USB_CDCACM_TX_ENDP, len);
-    n_unsent_bytes = len;
-    transmitting = 1;
+#endif
+
+    if (in_place) {
+        rb_read_commit(&tx_rb, len);
+    }
+    tx_packet_len[buf] = len;
+    n_unsent_bytes += len;
+    tx_packets++;
+    tx_need_zlp = (len == USB_CDCACM_TX_EPSIZE);
     usb_set_ep_tx_stat(USB_CDCACM_TX_ENDP, USB_EP_STAT_TX_VALID);
+}
 
-    return len;
+/* Send whatever tx_rb holds, as far as there's room in the PMA. Full
+ * packets go out as soon as they can; a partial one only once
+ * nothing else is in flight, so that small writes made while a
+ * packet is on the wire get batched into the next one. */
+static void vcomTxKick(void)
+{
+    uint16 len;
+
+    while (tx_packets < TX_PMA_PACKETS) {
+        len = rb_full_count(&tx_rb);
+        if (len >= USB_CDCACM_TX_EPSIZE) {
+            len = USB_CDCACM_TX_EPSIZE;
+        } else if (!len || tx_packets) {
+            break;
+        }
+        vcomTxPacket(len);
+    }
 }
 
+/* This function is non-blocking.
+ *
+ * It copies data from a usercode buffer into the TX buffer, starts
+ * sending it if the endpoint is idle, and returns the number of bytes
+ * copied. The endpoint callback sends the rest as the host takes
+ * each packet. Queueing zero bytes asks for a zero-length packet once
+ * the endpoint goes idle, which flushes host-side buffers. */
+uint32 usb_cdcacm_tx(const uint8* buf, uint32 len)
+{
+    uint32 masked;
 
+    if (len > USB_CDCACM_TX_BUF_SIZE) {
+        len = USB_CDCACM_TX_BUF_SIZE;
+    }
+    if (len) {
+        len = rb_write(&tx_rb, buf, len);
+    } else {
+        tx_need_zlp = 1;
+    }
+
+    if (usb_is_configured(USBLIB) && tx_packets < TX_PMA_PACKETS) {
+        /* Keep the endpoint callback from sending at the same time. */
+        masked = nvic_globalirq_masked();
+        nvic_globalirq_disable();
+        vcomTxKick();
+        if (!masked) {
+            nvic_globalirq_enable();
+        }
+    }
+    return len;
+}
 
 uint32 usb_cdcacm_data_available(void)
 {
@@ -435,12 +524,17 @@ uint32 usb_cdcacm_data_available(void)
 
 uint8 usb_cdcacm_is_transmitting(void)
 {
-    return transmitting;
+    return tx_packets || !rb_is_empty(&tx_rb);
 }
 
 uint16 usb_cdcacm_get_pending(void)
 {
-    return n_unsent_bytes;
+    return rb_full_count(&tx_rb) + n_unsent_bytes;
+}
+
+uint32 usb_cdcacm_tx_room(void)
+{
+    return rb_room(&tx_rb);
 }
 
 /* Nonblocking byte receive.
@@ -452,9 +546,29 @@ uint32 usb_cdcacm_rx(uint8* buf, uint32 len)
     /* Copy bytes to buffer. */
     uint32 n_copied = usb_cdcacm_peek(buf, len);
 
+    usb_cdcacm_rx_commit(n_copied);
+    return n_copied;
+}
+
+/* Zero-copy receive.
+ *
+ * Points *span at the unread bytes up to the end of our buffer, and
+ * returns how many there are. They stay put until released with
+ * usb_cdcacm_rx_commit(). */
+uint32 usb_cdcacm_rx_span(uint8** span)
+{
+    uint32 n = n_unread_bytes;
+    uint32 head = rx_offset;
+
+    *span = (uint8*)&vcomBufferRx[head];
+    return n < CDC_SERIAL_BUFFER_SIZE - head ? n : CDC_SERIAL_BUFFER_SIZE - head;
+}
+
+void usb_cdcacm_rx_commit(uint32 len)
+{
     /* Mark bytes as read. */
-    n_unread_bytes -= n_copied;
-    rx_offset = (rx_offset + n_copied) % CDC_SERIAL_BUFFER_SIZE;
+    n_unread_bytes -= len;
+    rx_offset = (rx_offset + len) % CDC_SERIAL_BUFFER_SIZE;
 
     /* If all bytes have been read, re-enable the RX endpoint, which
      * was set to NAK when the current batch of bytes was received. */
@@ -462,8 +576,6 @@ uint32 usb_cdcacm_rx(uint8* buf, uint32 len)
         usb_set_ep_rx_count(USB_CDCACM_RX_ENDP, USB_CDCACM_RX_EPSIZE);
         usb_set_ep_rx_stat(USB_CDCACM_RX_ENDP, USB_EP_STAT_RX_VALID);
     }
-
-    return n_copied;
 }
 
 /* Nonblocking byte lookahead.
@@ -558,28 +670,60 @@ int usb_cdcacm_get_n_data_bits(void)
 
 static void vcomDataTxCb(void)
 {
-    n_unsent_bytes = 0;
-    transmitting = 0;
+    uint8 done = 1;
+
+#ifdef USB_CDCACM_TX_DBL_BUF
+    /* If both buffers went out before we got here, their CTR_TX
+     * events merged into one. In that case DTOG_TX has caught up
+     * with SW_BUF again; had only one gone out, they'd differ. */
+    if (tx_packets == 2 &&
+        !usb_get_ep_dtog_tx(USB_CDCACM_TX_ENDP) ==
+        !usb_get_ep_tx_sw_buf(USB_CDCACM_TX_ENDP)) {
+        done = 2;
+    }
+#endif
+    while (done-- && tx_packets) {
+        n_unsent_bytes -= tx_packet_len[tx_first_buf];
+        tx_first_buf ^= TX_PMA_PACKETS - 1;
+        tx_packets--;
+    }
+    vcomTxKick();
+}
+
+/* Called every millisecond. Once the endpoint is idle, end a transfer
+ * that finished on a packet boundary with a zero-length packet, and
+ * send anything queued before the host configured us. */
+static void vcomSofCb(void)
+{
+    if (tx_packets || !usb_is_configured(USBLIB)) {
+        return;
+    }
+    if (!rb_is_empty(&tx_rb)) {
+        vcomTxKick();
+    } else if (tx_need_zlp) {
+        vcomTxPacket(0);
+    }
 }
 
 static void vcomDataRxCb(void)
 {
     uint32 ep_rx_size;
     uint32 tail = (rx_offset + n_unread_bytes) % CDC_SERIAL_BUFFER_SIZE;
-    uint8 ep_rx_data[USB_CDCACM_RX_EPSIZE];
-    uint32 i;
+    uint32 span = CDC_SERIAL_BUFFER_SIZE - tail;
 
     usb_set_ep_rx_stat(USB_CDCACM_RX_ENDP, USB_EP_STAT_RX_NAK);
     ep_rx_size = usb_get_ep_rx_count(USB_CDCACM_RX_ENDP);
-    /* This copy won't overwrite unread bytes, since we've set the RX
-     * endpoint to NAK, and will only set it to VALID when all bytes
-     * have been read. */
-    usb_copy_from_pma((uint8*)ep_rx_data, ep_rx_size,
-                      USB_CDCACM_RX_ADDR);
-
-    for (i = 0; i < ep_rx_size; i++) {
-        vcomBufferRx[tail] = ep_rx_data[i];
-        tail = (tail + 1) % CDC_SERIAL_BUFFER_SIZE;
+    /* Copy straight into vcomBufferRx, in two pieces if the packet
+     * wraps around its end. This won't overwrite unread bytes, since
+     * we've set the RX endpoint to NAK, and will only set it to VALID
+     * when there's room for another packet. */
+    if (span > ep_rx_size) {
+        span = ep_rx_size;
+    }
+    usb_copy_from_pma((uint8*)&vcomBufferRx[tail], span, USB_CDCACM_RX_ADDR);
+    if (span < ep_rx_size) {
+        usb_copy_from_pma((uint8*)vcomBufferRx, ep_rx_size - span,
+                          USB_CDCACM_RX_ADDR + span);
     }
 
     n_unread_bytes += ep_rx_size;
@@ -660,7 +804,15 @@ static void usbReset(void)
 
     /* set up data endpoint IN (TX)  */
     usb_set_ep_type(USB_CDCACM_TX_ENDP, USB_EP_EP_TYPE_BULK);
+#ifdef USB_CDCACM_TX_DBL_BUF
+    usb_set_ep_kind(USB_CDCACM_TX_ENDP, USB_EP_EP_KIND_DBL_BUF);
+    usb_set_ep_tx_buf0_addr(USB_CDCACM_TX_ENDP, USB_CDCACM_TX_ADDR);
+    usb_set_ep_tx_buf1_addr(USB_CDCACM_TX_ENDP, USB_CDCACM_TX_ADDR1);
+    usb_clear_ep_dtog_tx(USB_CDCACM_TX_ENDP);
+    usb_clear_ep_tx_sw_buf(USB_CDCACM_TX_ENDP);
+#else
     usb_set_ep_tx_addr(USB_CDCACM_TX_ENDP, USB_CDCACM_TX_ADDR);
+#endif
     usb_set_ep_tx_stat(USB_CDCACM_TX_ENDP, USB_EP_STAT_TX_NAK);
     usb_set_ep_rx_stat(USB_CDCACM_TX_ENDP, USB_EP_STAT_RX_DISABLED);
 
@@ -669,9 +821,12 @@ static void usbReset(void)
 
     /* Reset the RX/TX state */
     n_unread_bytes = 0;
-    n_unsent_bytes = 0;
     rx_offset = 0;
-    transmitting = 0;
+    rb_reset(&tx_rb);
+    n_unsent_bytes = 0;
+    tx_packets = 0;
+    tx_first_buf = 0;
+    tx_need_zlp = 0;
 }
 
 static RESULT usbDataSetup(uint8 request)
@@ -26,35 +26,90 @@
 
 #include "usb_reg_map.h"
 
-/* TODO these could use some improvement; they're fairly
- * straightforward ports of the analogous ST code.  The PMA blit
- * routines in particular are obvious targets for performance
- * measurement and tuning. */
+/* The PMA is 16 bits wide, but each halfword takes up a 32-bit slot
+ * in the CPU's address space, so packets can't just be memcpy()ed.
+ * These routines move a halfword per PMA access, unrolled by four.
+ * Loads from the user buffer stay halfword-aligned even when buf
+ * isn't: a byte is then carried over from one halfword to the next. */
 
 void usb_copy_to_pma(const uint8 *buf, uint16 len, uint16 pma_offset) {
-    uint16 *dst = (uint16*)usb_pma_ptr(pma_offset);
+    __io uint32 *dst = (__io uint32*)usb_pma_ptr(pma_offset);
     uint16 n = len >> 1;
-    uint16 i;
-    for (i = 0; i < n; i++) {
-        *dst = (uint16)(*buf) | *(buf + 1) << 8;
-        buf += 2;
-        dst += 2;
-    }
-    if (len & 1) {
-        *dst = *buf;
+
+    if (!((uint32)buf & 1)) {
+        const uint16 *src = (const uint16*)buf;
+        for (; n >= 4; n -= 4) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = src[3];
+            dst += 4;
+            src += 4;
+        }
+        while (n--) {
+            *dst++ = *src++;
+        }
+        if (len & 1) {
+            *dst = *(const uint8*)src;
+        }
+    } else if (n) {
+        /* Output halfword i is buf[2i] | buf[2i + 1] << 8; src[i]
+         * holds buf[2i + 1] and buf[2i + 2]. */
+        const uint16 *src = (const uint16*)(buf + 1);
+        uint32 lo = buf[0];
+        uint32 h;
+        while (--n) {
+            h = *src++;
+            *dst++ = lo | (h & 0xFF) << 8;
+            lo = h >> 8;
+        }
+        /* Don't read past the end of buf for the last byte. */
+        *dst++ = lo | (uint32)*(const uint8*)src << 8;
+        if (len & 1) {
+            *dst = ((const uint8*)src)[1];
+        }
+    } else if (len) {
+        *dst = buf[0];
     }
 }
 
+/* pma_offset may be odd here, e.g. to pick up the rest of a packet
+ * after copying an odd number of bytes out of it. */
 void usb_copy_from_pma(uint8 *buf, uint16 len, uint16 pma_offset) {
-    uint32 *src = (uint32*)usb_pma_ptr(pma_offset);
-    uint16 *dst = (uint16*)buf;
-    uint16 n = len >> 1;
-    uint16 i;
-    for (i = 0; i < n; i++) {
-        *dst++ = *src++;
+    __io uint32 *src = (__io uint32*)usb_pma_ptr(pma_offset & ~1);
+    uint16 n;
+
+    if ((pma_offset & 1) && len) {
+        *buf++ = (uint8)(*src++ >> 8);
+        len--;
+    }
+    n = len >> 1;
+
+    if (!((uint32)buf & 1)) {
+        uint16 *dst = (uint16*)buf;
+        for (; n >= 4; n -= 4) {
+            dst[0] = (uint16)src[0];
+            dst[1] = (uint16)src[1];
+            dst[2] = (uint16)src[2];
+            dst[3] = (uint16)src[3];
+            dst += 4;
+            src += 4;
+        }
+        while (n--) {
+            *dst++ = (uint16)*src++;
+        }
+        buf = (uint8*)dst;
+    } else {
+        uint32 h;
+        while (n--) {
+            h = *src++;
+            buf[0] = (uint8)h;
+            buf[1] = (uint8)(h >> 8);
+            buf += 2;
+        }
     }
     if (len & 1) {
-        *dst = *src & 0xFF;
+        *buf = (uint8)*src;
     }
 }
 
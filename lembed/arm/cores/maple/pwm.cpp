@@ -28,7 +28,7 @@
 
 /**
  * @file wirish/pwm.cpp
- * @brief Wiring-style pwmWrite().
+ * @brief Wiring-style pwmWrite() and analogWrite().
  */
 
 #include "pwm.h"
@@ -39,6 +39,93 @@
 #include "boards.h"
 #include "io.h"
 
+/* analogWrite() state for each timer. scale turns a value into a
+ * compare value, in 16.16 fixed point; it is recomputed whenever the
+ * reload value it was made for changes, whoever changed it. */
+struct pwm_timer {
+	timer_dev *dev;
+	uint8 bits;
+	uint32 reload;
+	uint32 scale;
+};
+
+#define PWM_TIMER(n) {&timer##n, 8, 0xFFFFFFFF, 0}
+
+static pwm_timer pwm_timers[] = {
+#if STM32_HAVE_TIMER(1)
+	PWM_TIMER(1),
+#endif
+#if STM32_HAVE_TIMER(2)
+	PWM_TIMER(2),
+#endif
+#if STM32_HAVE_TIMER(3)
+	PWM_TIMER(3),
+#endif
+#if STM32_HAVE_TIMER(4)
+	PWM_TIMER(4),
+#endif
+#if STM32_HAVE_TIMER(5)
+	PWM_TIMER(5),
+#endif
+#if STM32_HAVE_TIMER(8)
+	PWM_TIMER(8),
+#endif
+#if STM32_HAVE_TIMER(9)
+	PWM_TIMER(9),
+#endif
+#if STM32_HAVE_TIMER(10)
+	PWM_TIMER(10),
+#endif
+#if STM32_HAVE_TIMER(11)
+	PWM_TIMER(11),
+#endif
+#if STM32_HAVE_TIMER(12)
+	PWM_TIMER(12),
+#endif
+#if STM32_HAVE_TIMER(13)
+	PWM_TIMER(13),
+#endif
+#if STM32_HAVE_TIMER(14)
+	PWM_TIMER(14),
+#endif
+};
+
+#define PWM_NR_TIMERS (sizeof(pwm_timers) / sizeof(pwm_timers[0]))
+
+/* For each pin in PWM mode, its timer's index in pwm_timers plus one */
+static uint8 pwm_pins[BOARD_NR_GPIO_PINS];
+
+/* Resolution for pins without a timer */
+static uint8 pwm_bits = 8;
+
+static pwm_timer* pwm_find(timer_dev *dev)
+{
+	for (unsigned i = 0; i < PWM_NR_TIMERS; i++) {
+		if (pwm_timers[i].dev == dev) {
+			return &pwm_timers[i];
+		}
+	}
+	return NULL;
+}
+
+static void pwm_rescale(pwm_timer *t)
+{
+	uint32 reload = timer_get_reload(t->dev);
+	/* CCR is 16 bits, so with the largest reload value full scale
+	 * is one tick short of always high. */
+	uint32 top = reload < 0xFFFF ? reload + 1 : 0xFFFF;
+	uint32 max = (1U << t->bits) - 1;
+
+	t->scale = ((top << 16) + max - 1) / max;
+	t->reload = reload;
+}
+
+void wirish::priv::pwm_pin_mode(uint8 pin, bool pwm)
+{
+	pwm_timer *t = pwm ? pwm_find(PIN_MAP[pin].timer_device) : NULL;
+	pwm_pins[pin] = t ? (t - pwm_timers) + 1 : 0;
+}
+
 void pwmWrite(uint8 pin, uint16 duty_cycle)
 {
 	if (pin >= BOARD_NR_GPIO_PINS) {
@@ -50,9 +137,122 @@ void pwmWrite(uint8 pin, uint16 duty_cycle)
 	timer_set_compare(dev, cc_channel, duty_cycle);
 }
 
+void analogWrite(uint8 pin, int value)
+{
+	if (pin >= BOARD_NR_GPIO_PINS) {
+		return;
+	}
+	uint8 slot = pwm_pins[pin];
+	if (!slot) {
+		if (!PIN_MAP[pin].timer_device || !PIN_MAP[pin].timer_channel) {
+			pinMode(pin, OUTPUT);
+			digitalWrite(pin, value >= (1 << (pwm_bits - 1)) ? HIGH : LOW);
+			return;
+		}
+		pinMode(pin, PWM);
+		slot = pwm_pins[pin];
+	}
 
-void analogWrite(uint8 pin, int duty_cycle8)
+	pwm_timer *t = &pwm_timers[slot - 1];
+	timer_dev *dev = t->dev;
+	if (timer_get_reload(dev) != t->reload) {
+		pwm_rescale(t);
+	}
+	uint32 max = (1U << t->bits) - 1;
+	if ((uint32)value > max) {
+		value = value < 0 ? 0 : max;
+	}
+	timer_set_compare(dev, PIN_MAP[pin].timer_channel,
+	                  (uint16)(((uint64)(uint32)value * t->scale) >> 16));
+}
+
+uint32 analogWriteFrequency(timer_dev *dev, uint32 hz)
 {
-	pinMode(pin, PWM);
-	pwmWrite(pin, duty_cycle8 * 257); // 257 maps 255 to 65535 (i.e 255*257 = 65535)
+	const uint32 clock = CYCLES_PER_MICROSECOND * 1000000UL;
+
+	if (!hz) {
+		return 0;
+	}
+	uint32 ticks = clock / hz;
+	if (ticks < 2) {
+		ticks = 2;
+	}
+	uint32 psc = (ticks - 1) >> 16;
+	if (psc > 0xFFFF) {
+		psc = 0xFFFF;
+	}
+	uint32 period = ticks / (psc + 1);
+	if (period > 0x10000) {
+		period = 0x10000;
+	}
+
+	/* Keep the duty cycles */
+	uint32 old = timer_get_reload(dev) + 1;
+	for (uint8 ch = 1; ch <= 4; ch++) {
+		if (!timer_has_cc_channel(dev, ch)) {
+			continue;
+		}
+		uint32 ccr = (uint32)((uint64)timer_get_compare(dev, ch) * period / old);
+		timer_set_compare(dev, ch, ccr > 0xFFFF ? 0xFFFF : ccr);
+	}
+	timer_set_prescaler(dev, psc);
+	timer_set_reload(dev, period - 1);
+	timer_generate_update(dev);
+	return clock / ((psc + 1) * period);
+}
+
+uint32 analogWriteFrequency(uint8 pin, uint32 hz)
+{
+	if (pin >= BOARD_NR_GPIO_PINS || !PIN_MAP[pin].timer_device) {
+		return 0;
+	}
+	return analogWriteFrequency(PIN_MAP[pin].timer_device, hz);
+}
+
+void analogWriteResolution(timer_dev *dev, uint8 bits)
+{
+	pwm_timer *t = pwm_find(dev);
+
+	if (!t) {
+		return;
+	}
+	t->bits = bits < 1 ? 1 : bits > 16 ? 16 : bits;
+	pwm_rescale(t);
+}
+
+void analogWriteResolution(uint8 bits)
+{
+	pwm_bits = bits < 1 ? 1 : bits > 16 ? 16 : bits;
+	for (unsigned i = 0; i < PWM_NR_TIMERS; i++) {
+		analogWriteResolution(pwm_timers[i].dev, pwm_bits);
+	}
+}
+
+bool analogWriteStream(uint8 pin, const uint16 *table, uint16 len,
+                       bool repeat)
+{
+	if (pin >= BOARD_NR_GPIO_PINS || !PIN_MAP[pin].timer_device ||
+	    !PIN_MAP[pin].timer_channel) {
+		return false;
+	}
+	if (!pwm_pins[pin]) {
+		pinMode(pin, PWM);
+	}
+	return timer_dma_stream_start(PIN_MAP[pin].timer_device,
+	                              PIN_MAP[pin].timer_channel, 1,
+	                              table, len, repeat) == 0;
+}
+
+void analogWriteStreamStop(uint8 pin)
+{
+	if (pin >= BOARD_NR_GPIO_PINS || !PIN_MAP[pin].timer_device ||
+	    !PIN_MAP[pin].timer_channel) {
+		return;
+	}
+	timer_dev *dev = PIN_MAP[pin].timer_device;
+	/* Leave other channels' streams alone */
+	if (timer_dma_get_base_addr(dev) ==
+	    TIMER_DMA_BASE_CCR1 + PIN_MAP[pin].timer_channel - 1) {
+		timer_dma_stream_stop(dev);
+	}
 }
@@ -33,6 +33,7 @@
 #define _WIRISH_PWM_H_
 
 #include <libmaple/libmaple_types.h>
+#include <libmaple/timer.h>
 
 /**
  * Set the PWM duty on the given pin.
@@ -46,14 +47,92 @@
 void pwmWrite(uint8 pin, uint16 duty_cycle16);
 
 /**
- * Roger Clark. 20140103
- * Added function to replicate the Arduino PWM functionality or range 0 to 255
- * User code is expected to determine and honor the maximum value
- * (based on the configured period).
+ * Arduino-style PWM output.
+ *
+ * The first call on a pin, or pinMode(pin, PWM), sets it up; later
+ * calls only scale the value and write the timer's compare register.
+ * value runs from 0 to 2^bits - 1, where bits is the resolution set
+ * with analogWriteResolution() (8 by default). Pins without a timer
+ * channel are driven HIGH from half scale up, LOW below.
  *
  * @param pin PWM output pin
- * @param duty_cycle Duty cycle to set. (Range is 0 to 255)
+ * @param value Duty cycle to set.
  */
-void analogWrite(uint8 pin, int duty_cycle8);
-#endif
+void analogWrite(uint8 pin, int value);
+
+/**
+ * Set the PWM frequency of a timer, and so of all its channels.
+ *
+ * The timer's prescaler and reload value are recomputed, and the
+ * duty cycles of its channels are kept. The counter restarts.
+ *
+ * @param dev Timer device
+ * @param hz Frequency, in Hz.
+ * @return The frequency actually set, or 0 if hz is 0.
+ */
+uint32 analogWriteFrequency(timer_dev *dev, uint32 hz);
+
+/**
+ * Set the PWM frequency of the timer behind a pin.
+ * @see analogWriteFrequency(timer_dev*, uint32)
+ */
+uint32 analogWriteFrequency(uint8 pin, uint32 hz);
+
+/**
+ * Set the range of analogWrite() values for a timer's pins.
+ *
+ * The resolution only scales analogWrite() values; the number of
+ * distinct duty cycles depends on the timer's reload value, which
+ * analogWriteFrequency() sets.
+ *
+ * @param dev Timer device
+ * @param bits Bits per value, from 1 to 16.
+ */
+void analogWriteResolution(timer_dev *dev, uint8 bits);
+
+/**
+ * Set the range of analogWrite() values for all pins.
+ * @see analogWriteResolution(timer_dev*, uint8)
+ */
+void analogWriteResolution(uint8 bits);
+
+/**
+ * Stream a table of duty cycles to a PWM pin.
+ *
+ * DMA writes the next entry of table into the pin's compare register
+ * at the start of every PWM period, e.g. for LED dimming curves or
+ * audio-rate waveforms. Entries are compare values, from 0 (always
+ * low) to the timer's reload value plus one (always high), not
+ * analogWrite() values; analogWriteFrequency() sets the period and so
+ * the rate. Only one pin per timer can stream at a time, so stop a
+ * stream before starting another on the same timer; see
+ * timer_dma_stream_start() to stream to several channels.
+ *
+ * @param pin PWM output pin; TIM1 to TIM5 only.
+ * @param table Compare values; must stay valid while streaming.
+ * @param len Entries in table.
+ * @param repeat Whether to start over after the last entry.
+ * @return Whether streaming started; false if the timer is already
+ *         streaming or its update DMA request is otherwise in use.
+ */
+bool analogWriteStream(uint8 pin, const uint16 *table, uint16 len,
+                       bool repeat = true);
+
+/**
+ * Stop streaming to a pin. It keeps the last duty cycle written.
+ * @see analogWriteStream()
+ */
+void analogWriteStreamStop(uint8 pin);
 
+namespace wirish
+{
+namespace priv
+{
+
+/* pinMode() tells us which pins are in PWM mode. */
+void pwm_pin_mode(uint8 pin, bool pwm);
+
+}
+}
+
+#endif
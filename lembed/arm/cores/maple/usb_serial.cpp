@@ -97,53 +97,34 @@ void USBSerial::end(void)
 
 size_t USBSerial::write(uint8 ch)
 {
-    size_t n = 0;
-    this->write(&ch, 1);
-    return n;
+    return this->write(&ch, 1);
 }
 
 size_t USBSerial::write(const char *str)
 {
-    size_t n = 0;
-    this->write(str, strlen(str));
-    return n;
+    return this->write(str, strlen(str));
 }
 
 size_t USBSerial::write(const void *buf, uint32 len)
 {
-    size_t n = 0;
     if (!this->isConnected() || !buf) {
         return 0;
     }
 
     uint32 txed = 0;
-    uint32 old_txed = 0;
     uint32 start = millis();
 
-    uint32 sent = 0;
-
+    /* usb_cdcacm_tx() only queues, so this returns as soon as
+     * everything fits in the TX buffer. If it's full, wait as long as
+     * the host keeps taking packets. */
     while (txed < len && (millis() - start < USB_TIMEOUT)) {
-        sent = usb_cdcacm_tx((const uint8*)buf + txed, len - txed);
-        txed += sent;
-        if (old_txed != txed) {
+        uint32 sent = usb_cdcacm_tx((const uint8*)buf + txed, len - txed);
+        if (sent) {
+            txed += sent;
             start = millis();
         }
-        old_txed = txed;
-    }
-
-
-#if 0
-// this code leads to a serious performance drop and appears to be
-// unnecessary - everything seems to work fine without, -jcw, 2015-11-05
-// see http://stm32duino.com/posting.php?mode=quote&f=3&p=7746
-    if (sent == USB_CDCACM_TX_EPSIZE) {
-        while (usb_cdcacm_is_transmitting() != 0) {
-        }
-        /* flush out to avoid having the pc wait for more data */
-        usb_cdcacm_tx(NULL, 0);
     }
-#endif
-    return n;
+    return txed;
 }
 
 int USBSerial::available(void)
@@ -161,14 +142,37 @@ int USBSerial::peek(void)
     }
 }
 
+size_t USBSerial::readSpan(const uint8 **span)
+{
+    return usb_cdcacm_rx_span((uint8**)span);
+}
+
+bool USBSerial::readCommit(size_t len)
+{
+    // The host is held off (NAK) while the buffer is full
+    usb_cdcacm_rx_commit(len);
+    return true;
+}
+
+int USBSerial::availableForWrite(void)
+{
+    return usb_cdcacm_tx_room();
+}
+
+/* Like HardwareSerial::flush(), wait for queued data to go out. Give
+ * up if the host stops taking it. */
 void USBSerial::flush(void)
 {
-    /*Roger Clark. Rather slow method. Need to improve this */
-    uint8 b;
-    while (usb_cdcacm_data_available()) {
-        this->read(&b, 1);
+    uint16 pending = usb_cdcacm_get_pending();
+    uint32 start = millis();
+
+    while (usb_cdcacm_is_transmitting() && this->isConnected() &&
+           (millis() - start < USB_TIMEOUT)) {
+        if (usb_cdcacm_get_pending() != pending) {
+            pending = usb_cdcacm_get_pending();
+            start = millis();
+        }
     }
-    return;
 }
 
 uint32 USBSerial::read(void *buf, uint32 len)
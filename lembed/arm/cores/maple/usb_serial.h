@@ -59,6 +59,8 @@ public:
 	// Roger Clark. added functions to support Arduino 1.0 API
     virtual int peek(void);
     virtual int read(void);
+    virtual size_t readSpan(const uint8 **span);
+    virtual bool readCommit(size_t len);
     int availableForWrite(void);
     virtual void flush(void);
 	
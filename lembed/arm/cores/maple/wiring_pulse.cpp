@@ -1,59 +1,209 @@
 #include <wiring_pulse.h>
 #include "boards.h"
+#include "io.h"
+#include "wirish_time.h"
 
+#include <string.h>
+#include <libmaple/nvic.h>
 
+/* Input capture is usable if the pin has a general purpose or
+ * advanced timer channel, and the timer is counting. */
+static bool capture_usable(uint8 pin)
+{
+  timer_dev *dev = PIN_MAP[pin].timer_device;
+  return (dev && PIN_MAP[pin].timer_channel && dev->type != TIMER_BASIC &&
+          (dev->regs.bas->CR1 & TIMER_CR1_CEN));
+}
+
+/* A channel feeding DMA (a PulseCapture in DMA mode) has no capture
+ * pulseIn() could read, and starting one would take it over. */
+static bool capture_dma_busy(uint8 pin)
+{
+  timer_dev *dev = PIN_MAP[pin].timer_device;
+  uint8 channel = PIN_MAP[pin].timer_channel;
+  return (dev->regs.gen->DIER & (TIMER_DIER_CC1DE << (channel - 1))) != 0;
+}
 
+static uint32 ticks_to_us(timer_dev *dev, uint32 ticks)
+{
+  uint64 cycles = (uint64)ticks * (timer_get_prescaler(dev) + 1);
+  return (uint32)(cycles / CYCLES_PER_MICROSECOND);
+}
 
+static uint32 pulse_in_capture(uint8 pin, uint32 state, uint32 timeout)
+{
+  timer_dev *dev = PIN_MAP[pin].timer_device;
+  uint8 channel = PIN_MAP[pin].timer_channel;
+  timer_capture local;
+  timer_capture *cap = timer_capture_find(dev, channel);
+  uint32 high = state != LOW;
+  uint32 target = 1;
+  uint32 width = 0;
 
-/* Measures the length (in microseconds) of a pulse on the pin; state is HIGH
- * or LOW, the type of pulse to measure.  Works on pulses from 2-3 microseconds
- * to 3 minutes in length, but must be called at least a few dozen microseconds
- * before the start of the pulse. */
+  if (cap) {
+    // Skip a pulse in progress, as the running capture will count it
+    // when it ends.
+    uint32 masked = nvic_globalirq_masked();
+    nvic_globalirq_disable();
+    target = (high ? cap->nr_high : cap->nr_low) + 1 +
+             (timer_capture_level(cap) == high);
+    if (!masked) {
+      nvic_globalirq_enable();
+    }
+  } else {
+    // A new capture only counts pulses it saw start.
+    memset(&local, 0, sizeof(local));
+    local.dev = dev;
+    local.channel = channel;
+    local.level = digitalRead(pin) != LOW;
+    if (timer_capture_start(&local) != 0) {
+      return 0;
+    }
+    cap = &local;
+  }
 
+  volatile uint32 *count = high ? &cap->nr_high : &cap->nr_low;
+  uint32 start = micros();
+  while ((int32)(*count - target) < 0) {
+    if (micros() - start >= timeout) {
+      goto out;
+    }
+  }
+  width = ticks_to_us(dev, high ? cap->high : cap->low);
 
-uint32_t pulseIn( uint32_t pin, uint32_t state, uint32_t timeout )
+ out:
+  if (cap == &local) {
+    timer_capture_stop(&local);
+  }
+  return width;
+}
+
+static uint32 pulse_in_polled(uint8 pin, uint32 state, uint32 timeout)
 {
   // cache the port and bit of the pin in order to speed up the
   // pulse width measuring loop and achieve finer resolution.  calling
   // digitalRead() instead yields much coarser resolution.
-
-  gpio_dev *dev = PIN_MAP[pin].gpio_device;
-  uint32_t bit = (1U << PIN_MAP[pin].gpio_bit);
-
-
-  uint32_t width = 0; // keep initialization out of time critical area
-
-  // convert the timeout from microseconds to a number of times through
-  // the initial loop; it takes 16 clock cycles per iteration.
-  uint32_t numloops = 0;
-  uint32_t maxloops =  timeout * ( F_CPU / 16000000);
-  volatile uint32_t dummyWidth = 0;
+  gpio_reg_map *regs = PIN_MAP[pin].gpio_device->regs;
+  uint32 bit = (1U << PIN_MAP[pin].gpio_bit);
+  uint32 want = state != LOW ? bit : 0;
+  uint64 deadline = cycles() + (uint64)timeout * CYCLES_PER_MICROSECOND;
+  uint64 begin;
 
   // wait for any previous pulse to end
-  while ( (dev->regs->IDR & bit)  == bit)   {
-    if (numloops++ == maxloops)  {
+  while ((regs->IDR & bit) == want) {
+    if (cycles() >= deadline) {
       return 0;
     }
-    dummyWidth++;
   }
 
   // wait for the pulse to start
-  while ((dev->regs->IDR & bit) != bit)   {
-    if (numloops++ == maxloops) {
+  while ((regs->IDR & bit) != want) {
+    if (cycles() >= deadline) {
       return 0;
     }
-    dummyWidth++;
   }
+  begin = cycles();
 
   // wait for the pulse to stop
-  while ((dev->regs->IDR & bit) == bit) {
-    if (numloops++ == maxloops)  {
+  while ((regs->IDR & bit) == want) {
+    if (cycles() >= deadline) {
       return 0;
     }
-    width++;
   }
 
-  // Excluding time taking up by the interrupts, it needs 16 clock cycles to look through the last while loop
-  // 5 is added as a fiddle factor to correct for interrupts etc. But ultimately this would only be accurate if it was done one hardware timer
-  return (uint32_t)( ( (unsigned long long)(width + 5) *  (unsigned long long) 16000000.0) / (unsigned long long)F_CPU );
+  // The cycle counter keeps time through interrupts, but one landing
+  // right on an edge can still add its length to the result.
+  return (uint32)((cycles() - begin) / CYCLES_PER_MICROSECOND);
+}
+
+uint32_t pulseIn( uint32_t pin, uint32_t state, uint32_t timeout )
+{
+  if (pin >= BOARD_NR_GPIO_PINS) {
+    return 0;
+  }
+  if (capture_usable(pin) && !capture_dma_busy(pin)) {
+    return pulse_in_capture(pin, state, timeout);
+  }
+  return pulse_in_polled(pin, state, timeout);
+}
+
+/*
+ * PulseCapture
+ */
+
+PulseCapture::PulseCapture() : seen(0), running(false)
+{
+  memset(&cap, 0, sizeof(cap));
+}
+
+PulseCapture::~PulseCapture()
+{
+  end();
+}
+
+bool PulseCapture::start(uint8 pin)
+{
+  if (pin >= BOARD_NR_GPIO_PINS || !capture_usable(pin)) {
+    return false;
+  }
+  end();
+  pinMode(pin, INPUT);
+  cap.dev = PIN_MAP[pin].timer_device;
+  cap.channel = PIN_MAP[pin].timer_channel;
+  seen = 0;
+  running = timer_capture_start(&cap) == 0;
+  return running;
+}
+
+bool PulseCapture::begin(uint8 pin, uint8 filter)
+{
+  cap.buf = NULL;
+  cap.buf_size = 0;
+  cap.filter = filter;
+  cap.level = pin < BOARD_NR_GPIO_PINS && digitalRead(pin) != LOW;
+  return start(pin);
+}
+
+bool PulseCapture::begin(uint8 pin, uint16 *buf, uint16 size,
+                         ExtIntTriggerMode edge)
+{
+  cap.buf = buf;
+  cap.buf_size = size;
+  cap.filter = 0;
+  cap.level = edge == FALLING;
+  return start(pin);
+}
+
+void PulseCapture::end()
+{
+  if (running) {
+    timer_capture_stop(&cap);
+    running = false;
+  }
+}
+
+bool PulseCapture::available()
+{
+  return cap.nr_high != seen;
+}
+
+uint32 PulseCapture::highMicros()
+{
+  seen = cap.nr_high;
+  return ticksToMicros(cap.high);
+}
+
+uint32 PulseCapture::lowMicros()
+{
+  return ticksToMicros(cap.low);
+}
+
+uint32 PulseCapture::periodMicros()
+{
+  return ticksToMicros(cap.period);
+}
+
+uint32 PulseCapture::ticksToMicros(uint32 ticks)
+{
+  return cap.dev ? ticks_to_us(cap.dev, ticks) : 0;
 }
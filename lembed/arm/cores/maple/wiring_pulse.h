@@ -30,8 +30,95 @@
 #define _WIRISH_PULSE_H_
 
 #include <libmaple/gpio.h>
+#include <libmaple/timer.h>
+#include <ext_interrupts.h>
 
+/**
+ * Measures the length (in microseconds) of the next pulse on the pin;
+ * state is HIGH or LOW, the type of pulse to measure. A pulse already
+ * in progress is skipped.
+ *
+ * Pins with a timer channel are timed by input capture, so interrupts
+ * don't skew the result; if a PulseCapture is running on the pin, its
+ * measurements are used. A PulseCapture storing edges by DMA is left
+ * running, and the pin is polled instead, as other pins are.
+ *
+ * @param ulPin     Pin to measure on; it should be an input.
+ * @param ulState   HIGH or LOW.
+ * @param ulTimeout Microseconds to wait for the pulse to start and end.
+ * @return Pulse length, or 0 on timeout.
+ */
 uint32_t pulseIn( uint32_t ulPin, uint32_t ulState, uint32_t ulTimeout = 1000000L ) ;
 
+/**
+ * Measures pulses on a pin in the background, using the input capture
+ * unit of the pin's timer channel (see timer_capture_start()).
+ * Several pins can be measured at once, on the same timer or not; the
+ * timer's other channels can go on with PWM.
+ *
+ *     PulseCapture throttle;
+ *     throttle.begin(PA0);
+ *     ...
+ *     if (throttle.available()) {
+ *         uint32 us = throttle.highMicros();
+ *     }
+ *
+ * Pulses up to 2^32 timer ticks long (about two minutes with the
+ * default timer setup) are measured correctly.
+ */
+class PulseCapture {
+public:
+    PulseCapture();
+    ~PulseCapture();
+
+    /**
+     * Start measuring high and low pulses on a pin.
+     * @param pin    Pin with a timer channel; made an INPUT.
+     * @param filter Timer input filter, 0 (off) to 15.
+     * @return false if the pin has no usable timer channel.
+     */
+    bool begin(uint8 pin, uint8 filter = 0);
+
+    /**
+     * Start capturing the timer count at every rising (or falling)
+     * edge into buf by DMA, wrapping around at the end. Differences
+     * between consecutive entries, modulo the timer's overflow, are
+     * periods in timer ticks; see position() and ticksToMicros().
+     * @return false if the channel has no DMA request.
+     */
+    bool begin(uint8 pin, uint16 *buf, uint16 size,
+               ExtIntTriggerMode edge = RISING);
+
+    /** Stop measuring. The last results remain available. */
+    void end();
+
+    /** Whether a high pulse ended since highMicros() was last called. */
+    bool available();
+
+    /** Length of the last high pulse, in microseconds. */
+    uint32 highMicros();
+
+    /** Length of the last low pulse, in microseconds. */
+    uint32 lowMicros();
+
+    /** Time between the last two rising edges, in microseconds. */
+    uint32 periodMicros();
+
+    /** Number of high pulses measured so far. */
+    uint32 count() { return cap.nr_high; }
+
+    /** Index in the DMA buffer of the next capture. */
+    uint16 position() { return timer_capture_dma_pos(&cap); }
+
+    /** Convert timer ticks into microseconds. */
+    uint32 ticksToMicros(uint32 ticks);
+
+private:
+    bool start(uint8 pin);
+
+    timer_capture cap;
+    uint32 seen;
+    bool running;
+};
 
 #endif
@@ -61,6 +61,7 @@
 #include <wirish_time.h>
 #include <wirish_constants.h>
 #include <wiring_pulse.h>
+#include <FastPin.h>
 
 
 //#include <HardwareSPI.h>
@@ -69,6 +70,9 @@
 #include <HardwareSerial.h>
 #include <HardwareTimer.h>
 #include <usb_serial.h>
+#include <StringBuilder.h>
+#include <Printf.h>
+#include <StreamReader.h>
 #include <wirish_types.h>
 
 #include <libmaple/libmaple.h>
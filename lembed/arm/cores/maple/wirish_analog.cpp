@@ -36,7 +36,14 @@
 
 /* Unlike Wiring and Arduino, this assumes that the pin's mode is set
  * to INPUT_ANALOG. That's faster, but it does require some extra work
- * on the user's part. Not too much, we think ;). */
+ * on the user's part. Not too much, we think ;).
+ *
+ * If a scan (see adc_scan_start()) is converting the pin's channel,
+ * its latest value is returned without waiting for a conversion.
+ * Other channels of a scanning ADC are converted on ADC2 if it's free,
+ * or else as an injected conversion, which the scan waits out. A
+ * dual-mode scan can't wait without losing step, so channels it
+ * doesn't cover read as 0. */
 uint16 analogRead(uint8 pin)
 {
 	const adc_dev *dev = PIN_MAP[pin].adc_device;
@@ -44,11 +51,22 @@ uint16 analogRead(uint8 pin)
 		return 0;
 	}
 
-	return adc_read(dev, PIN_MAP[pin].adc_channel);
-}
-
-
-void analogWrite(uint8_t pin, int val)
-{
-
+	uint8 channel = PIN_MAP[pin].adc_channel;
+	adc_scan *scan = adc_scan_active(dev);
+	if (scan) {
+		int scanned = adc_scan_read(dev, channel);
+		if (scanned >= 0) {
+			return scanned;
+		}
+		if (scan->channels2) {
+			return 0;
+		}
+		/* ADC2 shares ADC1's channels and may be free, which spares
+		 * the scan a pause. */
+		if (dev != ADC1 || adc_scan_active(ADC2)) {
+			return adc_read_injected(dev, channel);
+		}
+		dev = ADC2;
+	}
+	return adc_read(dev, channel);
 }
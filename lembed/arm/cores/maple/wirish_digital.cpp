@@ -36,6 +36,7 @@
 
 #include "wirish_time.h"
 #include "boards.h"
+#include "pwm.h"
 
 
 void pinMode(uint8 pin, WiringPinMode mode)
@@ -89,6 +90,7 @@ void pinMode(uint8 pin, WiringPinMode mode)
                        PIN_MAP[pin].timer_channel,
                        pwm ? TIMER_PWM : TIMER_DISABLED);
     }
+    wirish::priv::pwm_pin_mode(pin, pwm);
 }
 
 
@@ -26,13 +26,630 @@
 
 #include "wirish.h"
 
+#include <libmaple/dma.h>
+#include <libmaple/spi.h>
+#include <libmaple/timer.h>
+
+/*
+ * The pins are resolved once, then each bit costs a few stores. Reading
+ * a port's IDR back goes over the bus after the preceding store has
+ * reached the pin, so it holds off the next edge: that gives data setup
+ * time before the rising edge and a clock high time of a couple of bus
+ * cycles, instead of edges only one or two CPU cycles apart.
+ */
+
 void shiftOut(uint8 dataPin, uint8 clockPin, uint8 bitOrder, uint8 value)
 {
-	digitalWrite(clockPin, LOW);
+	FastPin data(dataPin);
+	FastPin clock(clockPin);
+
+	clock.clear();
+	for (int i = 0; i < 8; i++) {
+		int bit = bitOrder == LSBFIRST ? i : (7 - i);
+		data.write((value >> bit) & 0x1);
+		(void)data.read();
+		clock.set();
+		(void)clock.read();
+		clock.clear();
+	}
+}
+
+uint8 shiftIn(uint8 dataPin, uint8 clockPin, uint8 bitOrder)
+{
+	FastPin data(dataPin);
+	FastPin clock(clockPin);
+	uint8 value = 0;
+
 	for (int i = 0; i < 8; i++) {
 		int bit = bitOrder == LSBFIRST ? i : (7 - i);
-		digitalWrite(dataPin, (value >> bit) & 0x1);
-		gpio_toggle_bit(PIN_MAP[clockPin].gpio_device, PIN_MAP[clockPin].gpio_bit);// togglePin(clockPin);
-		gpio_toggle_bit(PIN_MAP[clockPin].gpio_device, PIN_MAP[clockPin].gpio_bit);// togglePin(clockPin);
+		clock.set();
+		(void)clock.read();
+		value |= data.read() << bit;
+		clock.clear();
+	}
+	return value;
+}
+
+/*
+ * Bulk shifting
+ *
+ * shiftOutBuffer() and shiftInBuffer() hand the bits to the hardware.
+ * If the pins are a free SPI port's SCK and MOSI (or MISO), the port
+ * shifts them, fed by DMA. Otherwise, a free timer's update DMA
+ * request copies a waveform into the pins' port BSRR, two words per
+ * bit: one changes the data pin and drops the clock, the next raises
+ * the clock. The waveform is built in the two halves of a ring, each
+ * refilled from the DMA interrupt once it has gone out, a byte's
+ * sixteen words at a time. For input, the timer's channel 1 DMA
+ * request also copies the data pin's IDR, late in each half bit, and
+ * the interrupt keeps the samples taken while the clock was high.
+ *
+ * The interrupt has half a ring's time (64 us) to refill each half.
+ * If it runs later than that, the DMA has already replayed stale
+ * words, so the transfer is abandoned and shiftBufferWait() reports
+ * it.
+ *
+ * With neither free, or for an output on two ports, the bits are
+ * bit-banged as by shiftOut().
+ */
+
+/* SPI clock at most 4.5 MHz: PCLK2 / 16, or PCLK1 / 8 */
+#define SHIFT_SPI_BAUD(dev)	(rcc_dev_clk((dev)->clk_id) == RCC_APB2 ? \
+				 SPI_BAUD_PCLK_DIV_16 : SPI_BAUD_PCLK_DIV_8)
+
+/* Timer waveform bit rate; the timers all count at the CPU clock */
+#define SHIFT_TIMER_BIT_RATE	1000000
+#define SHIFT_TIMER_TICKS	(CYCLES_PER_MICROSECOND * 1000000 / \
+				 SHIFT_TIMER_BIT_RATE / 2)
+
+/* Words (half bits) in each half of the waveform ring; whole bytes */
+#define SHIFT_RING_HALF		128
+#if SHIFT_RING_HALF % 16
+#error "SHIFT_RING_HALF must hold whole bytes"
+#endif
+
+#define SHIFT_DMA_MAX		65535
+
+/* The host simulation has no DMA, so it always bit-bangs */
+#ifdef LIBMAPLE_HOST
+#define SHIFT_HAVE_DMA		0
+#else
+#define SHIFT_HAVE_DMA		1
+#endif
+
+struct shift_spi {
+	spi_dev *dev;
+	uint8 sck, miso, mosi;
+	dma_request_src rx, tx;
+};
+
+/* A timer's update and channel 1 requests are on the same DMA
+ * controller. */
+struct shift_timer {
+	timer_dev *dev;
+	dma_request_src up;
+	dma_request_src cc1;	/* Only used if has_cc1 */
+	bool has_cc1;
+};
+
+/* Basic timers first: they can't be doing PWM. */
+static const shift_timer shift_timers[] = {
+#if STM32_HAVE_TIMER(6) && (defined(STM32_HIGH_DENSITY) || \
+			    defined(STM32_XL_DENSITY))
+	{&timer6, DMA_REQ_SRC_TIM6_UP, DMA_REQ_SRC_TIM6_UP, false},
+#endif
+#if STM32_HAVE_TIMER(5) && (defined(STM32_HIGH_DENSITY) || \
+			    defined(STM32_XL_DENSITY))
+	{&timer5, DMA_REQ_SRC_TIM5_UP, DMA_REQ_SRC_TIM5_CH1, true},
+#endif
+#if STM32_HAVE_TIMER(4)
+	{&timer4, DMA_REQ_SRC_TIM4_UP, DMA_REQ_SRC_TIM4_CH1, true},
+#endif
+#if STM32_HAVE_TIMER(3)
+	{&timer3, DMA_REQ_SRC_TIM3_UP, DMA_REQ_SRC_TIM3_CH1, true},
+#endif
+#if STM32_HAVE_TIMER(2)
+	{&timer2, DMA_REQ_SRC_TIM2_UP, DMA_REQ_SRC_TIM2_CH1, true},
+#endif
+#if STM32_HAVE_TIMER(1)
+	{&timer1, DMA_REQ_SRC_TIM1_UP, DMA_REQ_SRC_TIM1_CH1, true},
+#endif
+};
+
+enum {
+	SHIFT_IDLE,
+	SHIFT_SPI,
+	SHIFT_TIMER,
+};
+
+static struct {
+	volatile uint8 engine;
+	bool input;
+	uint8 bitOrder;
+	const uint8 *out;
+	uint8 *in;
+	uint32 len;
+	dma_dev *dma;
+	dma_tube tx, rx;	/* Timer: waveform and samples */
+
+	/* SPI */
+	spi_dev *spi;
+	uint32 pos;		/* Bytes handed to DMA */
+	uint32 chunk;		/* ... of which in the current transfer */
+	gpio_dev *pin_dev[2];
+	uint8 pin_bit[2];
+	gpio_pin_mode pin_mode[2];
+
+	/* Timer */
+	const shift_timer *timer;
+	__io uint32 *bsrr;
+	uint32 data_mask, clock_mask;
+	uint32 fill_word;	/* Next half bit to go in the ring */
+	uint32 done_word;	/* Half bits gone out */
+	uint32 end_word;	/* Half bits in all, with the final clock drop */
+	uint32 saved_cr1, saved_psc, saved_arr, saved_ccmr1, saved_ccr1;
+	volatile bool failed;	/* Abandoned after a late interrupt */
+} shift;
+
+static uint32 shift_wave[2 * SHIFT_RING_HALF];
+static uint16 shift_samples[2 * SHIFT_RING_HALF];
+static const uint8 shift_dummy = 0xFF;
+
+static dma_dev* shift_dma_dev(dma_request_src src)
+{
+#if defined(STM32_HIGH_DENSITY) || defined(STM32_XL_DENSITY)
+	if ((rcc_clk_id)(src >> 3) == RCC_DMA2) {
+		return DMA2;
+	}
+#endif
+	return DMA1;
+}
+
+static dma_tube shift_dma_tube(dma_request_src src)
+{
+	return (dma_tube)(src & 0x7);
+}
+
+/* A tube is taken while enabled or while someone handles its
+ * interrupts, like a serial port between transmissions. */
+static bool shift_tube_free(dma_request_src src)
+{
+	dma_dev *dev = shift_dma_dev(src);
+	dma_tube tube = shift_dma_tube(src);
+
+	dma_init(dev);
+	return !dma_is_enabled(dev, tube) && !dev->handlers[tube - 1].handler;
+}
+
+static void shift_pin_mode(uint8 i, uint8 pin, gpio_pin_mode mode)
+{
+	shift.pin_dev[i] = PIN_MAP[pin].gpio_device;
+	shift.pin_bit[i] = PIN_MAP[pin].gpio_bit;
+	shift.pin_mode[i] = gpio_get_mode(shift.pin_dev[i], shift.pin_bit[i]);
+	gpio_set_mode(shift.pin_dev[i], shift.pin_bit[i], mode);
+}
+
+/*
+ * SPI
+ */
+
+static void shift_spi_next(void)
+{
+	uint32 left = shift.len - shift.pos;
+
+	shift.chunk = left > SHIFT_DMA_MAX ? SHIFT_DMA_MAX : left;
+	dma_disable(shift.dma, shift.tx);
+	dma_set_num_transfers(shift.dma, shift.tx, shift.chunk);
+	if (shift.input) {
+		dma_disable(shift.dma, shift.rx);
+		dma_set_mem_addr(shift.dma, shift.rx, shift.in + shift.pos);
+		dma_set_num_transfers(shift.dma, shift.rx, shift.chunk);
+		dma_enable(shift.dma, shift.rx);
+	} else {
+		dma_set_mem_addr(shift.dma, shift.tx, (void*)(shift.out + shift.pos));
+	}
+	dma_enable(shift.dma, shift.tx);
+}
+
+static void shift_spi_irq(void)
+{
+	spi_reg_map *regs = shift.spi->regs;
+
+	dma_get_irq_cause(shift.dma, shift.input ? shift.rx : shift.tx);
+	shift.pos += shift.chunk;
+	if (shift.pos < shift.len) {
+		shift_spi_next();
+		return;
+	}
+
+	/* The last byte is still being shifted */
+	while (!(regs->SR & SPI_SR_TXE) || (regs->SR & SPI_SR_BSY)) {
+		;
+	}
+	dma_detach_interrupt(shift.dma, shift.tx);
+	dma_disable(shift.dma, shift.tx);
+	if (shift.input) {
+		dma_detach_interrupt(shift.dma, shift.rx);
+		dma_disable(shift.dma, shift.rx);
+	}
+	regs->CR2 = 0;
+	spi_peripheral_disable(shift.spi);
+	(void)regs->DR;		/* Clear any overrun */
+	(void)regs->SR;
+	gpio_set_mode(shift.pin_dev[0], shift.pin_bit[0], shift.pin_mode[0]);
+	gpio_set_mode(shift.pin_dev[1], shift.pin_bit[1], shift.pin_mode[1]);
+	shift.engine = SHIFT_IDLE;
+}
+
+static bool shift_spi_start(uint8 dataPin, uint8 clockPin)
+{
+	const shift_spi ports[] = {
+#if BOARD_NR_SPI >= 1
+		{SPI1, BOARD_SPI1_SCK_PIN, BOARD_SPI1_MISO_PIN,
+		 BOARD_SPI1_MOSI_PIN, DMA_REQ_SRC_SPI1_RX, DMA_REQ_SRC_SPI1_TX},
+#endif
+#if BOARD_NR_SPI >= 2
+		{SPI2, BOARD_SPI2_SCK_PIN, BOARD_SPI2_MISO_PIN,
+		 BOARD_SPI2_MOSI_PIN, DMA_REQ_SRC_SPI2_RX, DMA_REQ_SRC_SPI2_TX},
+#endif
+#if BOARD_NR_SPI >= 3 && (defined(STM32_HIGH_DENSITY) || \
+                          defined(STM32_XL_DENSITY))
+		{SPI3, BOARD_SPI3_SCK_PIN, BOARD_SPI3_MISO_PIN,
+		 BOARD_SPI3_MOSI_PIN, DMA_REQ_SRC_SPI3_RX, DMA_REQ_SRC_SPI3_TX},
+#endif
+		{NULL, 0, 0, 0, DMA_REQ_SRC_SPI1_RX, DMA_REQ_SRC_SPI1_TX},
+	};
+	const shift_spi *port;
+	dma_tube_config cfg;
+
+	for (port = ports; port->dev; port++) {
+		if (port->sck == clockPin &&
+		    (shift.input ? port->miso : port->mosi) == dataPin) {
+			break;
+		}
+	}
+	if (!port->dev) {
+		return false;
+	}
+	rcc_clk_enable(port->dev->clk_id);
+	if ((port->dev->regs->CR1 & SPI_CR1_SPE) || !shift_tube_free(port->tx) ||
+	    (shift.input && !shift_tube_free(port->rx))) {
+		return false;
+	}
+
+	shift.spi = port->dev;
+	shift.dma = shift_dma_dev(port->tx);
+	shift.tx = shift_dma_tube(port->tx);
+	shift.rx = shift_dma_tube(port->rx);
+
+	/* Mode 0 sets the data up before the clock rises, like shiftOut().
+	 * Mode 1 samples as the clock falls, late in the high phase, like
+	 * shiftIn(). */
+	spi_master_enable(shift.spi, SHIFT_SPI_BAUD(shift.spi),
+			  shift.input ? SPI_MODE_1 : SPI_MODE_0,
+			  SPI_SW_SLAVE | SPI_SOFT_SS |
+			  (shift.bitOrder == LSBFIRST ? SPI_FRAME_LSB :
+			   SPI_FRAME_MSB));
+
+	cfg.tube_src = shift.input ? (void*)&shift_dummy : (void*)shift.out;
+	cfg.tube_src_size = DMA_SIZE_8BITS;
+	cfg.tube_dst = &shift.spi->regs->DR;
+	cfg.tube_dst_size = DMA_SIZE_8BITS;
+	cfg.tube_nr_xfers = 1;
+	cfg.tube_flags = (shift.input ? 0 : DMA_CFG_SRC_INC | DMA_CFG_CMPLT_IE);
+	cfg.target_data = NULL;
+	cfg.tube_req_src = port->tx;
+	dma_tube_cfg(shift.dma, shift.tx, &cfg);
+	if (shift.input) {
+		cfg.tube_src = &shift.spi->regs->DR;
+		cfg.tube_dst = shift.in;
+		cfg.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CMPLT_IE;
+		cfg.tube_req_src = port->rx;
+		dma_tube_cfg(shift.dma, shift.rx, &cfg);
+		dma_attach_interrupt(shift.dma, shift.rx, shift_spi_irq);
+		spi_rx_dma_enable(shift.spi);
+	} else {
+		dma_attach_interrupt(shift.dma, shift.tx, shift_spi_irq);
+	}
+
+	shift_pin_mode(0, clockPin, GPIO_AF_OUTPUT_PP);
+	shift_pin_mode(1, dataPin, shift.input ? GPIO_INPUT_FLOATING :
+		       GPIO_AF_OUTPUT_PP);
+	shift.pos = 0;
+	shift.engine = SHIFT_SPI;
+	shift_spi_next();
+	spi_tx_dma_enable(shift.spi);
+	return true;
+}
+
+/*
+ * Timer
+ */
+
+/* Fill half the ring with BSRR words, a byte at a time, and the
+ * clock held low once the bytes run out. */
+static void shift_timer_fill(uint32 *half)
+{
+	uint32 *end = half + SHIFT_RING_HALF;
+	uint32 high = shift.clock_mask;
+	uint32 low = shift.clock_mask << 16;
+	uint32 one = shift.data_mask | low;
+	uint32 zero = shift.data_mask << 16 | low;
+	uint32 byte = shift.fill_word / 16;
+
+	shift.fill_word += SHIFT_RING_HALF;
+	for (; half < end && byte < shift.len; byte++) {
+		if (shift.input) {
+			/* Clock high, then low; sampled late in each */
+			for (int i = 0; i < 8; i++) {
+				*half++ = high;
+				*half++ = low;
+			}
+		} else if (shift.bitOrder == LSBFIRST) {
+			for (uint32 v = shift.out[byte] | 0x100; v != 1; v >>= 1) {
+				*half++ = v & 1 ? one : zero;
+				*half++ = high;
+			}
+		} else {
+			for (uint32 v = shift.out[byte] << 1 | 1; v & 0xFF; v <<= 1) {
+				*half++ = v & 0x100 ? one : zero;
+				*half++ = high;
+			}
+		}
+	}
+	while (half < end) {
+		*half++ = low;
+	}
+}
+
+/* Keep the samples taken while the clock was high */
+static void shift_timer_pack(const uint16 *half)
+{
+	uint32 w = shift.done_word;
+
+	for (uint32 i = 0; i < SHIFT_RING_HALF; i += 2, w += 2) {
+		uint32 bit = w >> 1;
+		uint8 mask;
+
+		if (w >= shift.end_word) {
+			break;
+		}
+		mask = 1 << (shift.bitOrder == LSBFIRST ? (bit & 7) :
+			     7 - (bit & 7));
+		if (half[i] & shift.data_mask) {
+			shift.in[bit >> 3] |= mask;
+		} else {
+			shift.in[bit >> 3] &= ~mask;
+		}
+	}
+}
+
+static void shift_timer_stop(void)
+{
+	timer_dev *dev = shift.timer->dev;
+
+	timer_pause(dev);
+	timer_dma_disable_req(dev, 0);
+	dma_detach_interrupt(shift.dma, shift.tx);
+	dma_disable(shift.dma, shift.tx);
+	if (shift.input) {
+		timer_dma_disable_req(dev, 1);
+		dma_detach_interrupt(shift.dma, shift.rx);
+		dma_disable(shift.dma, shift.rx);
+		dev->regs.gen->CCMR1 = shift.saved_ccmr1;
+		timer_set_compare(dev, 1, shift.saved_ccr1);
+	}
+	timer_set_prescaler(dev, shift.saved_psc);
+	timer_set_reload(dev, shift.saved_arr);
+	timer_generate_update(dev);
+	dev->regs.bas->SR = 0;
+	dev->regs.bas->CR1 = shift.saved_cr1;
+	shift.engine = SHIFT_IDLE;
+}
+
+static void shift_timer_half(uint32 offset, uint32 cndtr)
+{
+	uint32 ahead;
+
+	if (shift.engine != SHIFT_TIMER) {
+		return;
+	}
+	if (shift.input) {
+		shift_timer_pack(shift_samples + offset);
+	}
+	shift.done_word += SHIFT_RING_HALF;
+	/* The DMA should still be in the other half; done_word is where
+	 * that starts. Past its end, it's taking words from this one,
+	 * which are a lap old. */
+	ahead = (2 * SHIFT_RING_HALF - cndtr - shift.done_word) &
+		(2 * SHIFT_RING_HALF - 1);
+	if (ahead > SHIFT_RING_HALF) {
+		*shift.bsrr = shift.clock_mask << 16;
+		shift.failed = true;
+		shift_timer_stop();
+		return;
+	}
+	if (shift.done_word >= shift.end_word) {
+		shift_timer_stop();
+		return;
+	}
+	shift_timer_fill(shift_wave + offset);
+}
+
+static void shift_timer_irq(void)
+{
+	dma_tube tube = shift.input ? shift.rx : shift.tx;
+	uint8 bits = dma_get_isr_bits(shift.dma, tube);
+	uint32 cndtr = dma_tube_regs(shift.dma, tube)->CNDTR;
+
+	/* If this is late, both halves may be done; the first one first */
+	dma_clear_isr_bits(shift.dma, tube);
+	if (bits & 0x4) {
+		shift_timer_half(0, cndtr);
+	}
+	if (bits & 0x2) {
+		shift_timer_half(SHIFT_RING_HALF, cndtr);
+	}
+}
+
+static bool shift_timer_free(const shift_timer *t)
+{
+	timer_dev *dev = t->dev;
+
+	if (shift.input && !t->has_cc1) {
+		return false;
+	}
+	rcc_clk_enable(dev->clk_id);
+	if (dev->regs.bas->DIER || dev->capture) {
+		return false;
+	}
+	if (dev->type != TIMER_BASIC && dev->regs.gen->CCER) {
+		return false;
+	}
+	return shift_tube_free(t->up) && (!shift.input || shift_tube_free(t->cc1));
+}
+
+static bool shift_timer_start(uint8 dataPin, uint8 clockPin)
+{
+	gpio_dev *port = PIN_MAP[clockPin].gpio_device;
+	const shift_timer *t = NULL;
+	dma_tube_config cfg;
+	timer_dev *dev;
+
+	if (!shift.input && PIN_MAP[dataPin].gpio_device != port) {
+		return false;
+	}
+	for (uint32 i = 0; i < sizeof(shift_timers) / sizeof(shift_timers[0]); i++) {
+		if (shift_timer_free(&shift_timers[i])) {
+			t = &shift_timers[i];
+			break;
+		}
+	}
+	if (!t) {
+		return false;
+	}
+
+	dev = t->dev;
+	shift.timer = t;
+	shift.dma = shift_dma_dev(t->up);
+	shift.tx = shift_dma_tube(t->up);
+	shift.rx = shift_dma_tube(t->cc1);
+	shift.bsrr = &port->regs->BSRR;
+	shift.data_mask = 1U << PIN_MAP[dataPin].gpio_bit;
+	shift.clock_mask = 1U << PIN_MAP[clockPin].gpio_bit;
+	shift.fill_word = 0;
+	shift.done_word = 0;
+	/* Output also drops the clock after the last bit */
+	shift.end_word = shift.len * 16 + !shift.input;
+	shift_timer_fill(shift_wave);
+	shift_timer_fill(shift_wave + SHIFT_RING_HALF);
+
+	cfg.tube_src = shift_wave;
+	cfg.tube_src_size = DMA_SIZE_32BITS;
+	cfg.tube_dst = shift.bsrr;
+	cfg.tube_dst_size = DMA_SIZE_32BITS;
+	cfg.tube_nr_xfers = 2 * SHIFT_RING_HALF;
+	cfg.tube_flags = DMA_CFG_SRC_INC | DMA_CFG_CIRC;
+	if (!shift.input) {
+		cfg.tube_flags |= DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE;
+	}
+	cfg.target_data = NULL;
+	cfg.tube_req_src = t->up;
+	dma_tube_cfg(shift.dma, shift.tx, &cfg);
+	if (shift.input) {
+		/* GPIO registers only take word accesses; keep the low half */
+		cfg.tube_src = &PIN_MAP[dataPin].gpio_device->regs->IDR;
+		cfg.tube_dst = shift_samples;
+		cfg.tube_dst_size = DMA_SIZE_16BITS;
+		cfg.tube_flags = DMA_CFG_DST_INC | DMA_CFG_CIRC |
+				 DMA_CFG_HALF_CMPLT_IE | DMA_CFG_CMPLT_IE;
+		cfg.tube_req_src = t->cc1;
+		dma_tube_cfg(shift.dma, shift.rx, &cfg);
+		dma_attach_interrupt(shift.dma, shift.rx, shift_timer_irq);
+		dma_enable(shift.dma, shift.rx);
+	} else {
+		dma_attach_interrupt(shift.dma, shift.tx, shift_timer_irq);
+	}
+	dma_enable(shift.dma, shift.tx);
+
+	shift.saved_cr1 = dev->regs.bas->CR1;
+	shift.saved_psc = timer_get_prescaler(dev);
+	shift.saved_arr = timer_get_reload(dev);
+	timer_pause(dev);
+	timer_set_prescaler(dev, 0);
+	timer_set_reload(dev, SHIFT_TIMER_TICKS - 1);
+	timer_generate_update(dev);
+	if (shift.input) {
+		/* Frozen output compare, pin not driven (CCER is clear) */
+		shift.saved_ccmr1 = dev->regs.gen->CCMR1;
+		shift.saved_ccr1 = timer_get_compare(dev, 1);
+		dev->regs.gen->CCMR1 = 0;
+		timer_set_compare(dev, 1, SHIFT_TIMER_TICKS * 3 / 4);
+		timer_dma_enable_req(dev, 1);
+	}
+	shift.engine = SHIFT_TIMER;
+
+	/* Overflow on the first tick, so the first word goes out at once
+	 * and each sample follows its word. */
+	timer_set_count(dev, SHIFT_TIMER_TICKS - 1);
+	timer_dma_enable_req(dev, 0);
+	timer_resume(dev);
+	return true;
+}
+
+static void shift_start(uint8 dataPin, uint8 clockPin, uint8 bitOrder,
+			const uint8 *out, uint8 *in, uint32 len)
+{
+	shiftBufferWait();
+	shift.failed = false;
+	if (len == 0) {
+		return;
+	}
+	shift.input = in != NULL;
+	shift.bitOrder = bitOrder;
+	shift.out = out;
+	shift.in = in;
+	shift.len = len;
+
+	if (SHIFT_HAVE_DMA &&
+	    dataPin < BOARD_NR_GPIO_PINS && clockPin < BOARD_NR_GPIO_PINS &&
+	    (shift_spi_start(dataPin, clockPin) ||
+	     shift_timer_start(dataPin, clockPin))) {
+		return;
+	}
+
+	for (uint32 i = 0; i < len; i++) {
+		if (in) {
+			in[i] = shiftIn(dataPin, clockPin, bitOrder);
+		} else {
+			shiftOut(dataPin, clockPin, bitOrder, out[i]);
+		}
+	}
+}
+
+bool shiftOutBuffer(uint8 dataPin, uint8 clockPin, uint8 bitOrder,
+		    const uint8 *buf, uint32 len, bool wait)
+{
+	shift_start(dataPin, clockPin, bitOrder, buf, NULL, len);
+	return !wait || shiftBufferWait();
+}
+
+bool shiftInBuffer(uint8 dataPin, uint8 clockPin, uint8 bitOrder,
+		   uint8 *buf, uint32 len, bool wait)
+{
+	shift_start(dataPin, clockPin, bitOrder, NULL, buf, len);
+	return !wait || shiftBufferWait();
+}
+
+bool shiftBufferBusy(void)
+{
+	return shift.engine != SHIFT_IDLE;
+}
+
+bool shiftBufferWait(void)
+{
+	while (shiftBufferBusy()) {
+		;
 	}
+	return !shift.failed;
 }
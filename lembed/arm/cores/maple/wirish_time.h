@@ -51,25 +51,40 @@ static inline uint32 millis(void)
  * Returns time (in microseconds) since the beginning of program
  * execution.  On overflow, restarts at 0.
  * @see millis()
+ * @see micros64()
  */
 static inline uint32 micros(void)
 {
-    uint32 ms;
-    uint32 cycle_cnt;
+    return (uint32)systick_uptime_micros();
+}
 
-    do {
-        ms = millis();
-        cycle_cnt = systick_get_count();
-        asm volatile("nop"); //allow interrupt to fire
-        asm volatile("nop");
-    } while (ms != millis());
+/**
+ * Returns time (in microseconds) since the beginning of program
+ * execution, as a 64-bit count that doesn't overflow.
+ * @see micros()
+ */
+static inline uint64 micros64(void)
+{
+    return systick_uptime_micros();
+}
 
-#define US_PER_MS               1000
-    /* SYSTICK_RELOAD_VAL is 1 less than the number of cycles it
-     * actually takes to complete a SysTick reload */
-    return ((ms * US_PER_MS) +
-            (SYSTICK_RELOAD_VAL + 1 - cycle_cnt) / CYCLES_PER_MICROSECOND);
-#undef US_PER_MS
+/**
+ * Returns time (in nanoseconds) since the beginning of program
+ * execution, to the nearest CPU clock cycle.
+ * @see micros64()
+ */
+static inline uint64 nanos(void)
+{
+    return systick_uptime_nanos();
+}
+
+/**
+ * Returns the number of CPU clock cycles since the beginning of
+ * program execution, as a 64-bit count.
+ */
+static inline uint64 cycles(void)
+{
+    return systick_cycles();
 }
 
 /**
@@ -0,0 +1,786 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file libmaple/host/host_periph.c
+ * @brief Peripheral models for host builds
+ *
+ * Just enough of each peripheral for the core to run: registers
+ * nobody models behave as plain memory. Serial ports transmit
+ * instantly, so TXE and TC are always set.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include <libmaple/host_sim.h>
+#include <libmaple/nvic.h>
+#include <libmaple/systick.h>
+#include <libmaple/dwt.h>
+#include <libmaple/usart.h>
+#include <libmaple/gpio.h>
+#include <libmaple/adc.h>
+#include <libmaple/timer.h>
+#include <libmaple/exti.h>
+#include <libmaple/rcc.h>
+#include <libmaple/scb.h>
+#include "host_private.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define OFFSET(type, field)     offsetof(type, field)
+
+/*
+ * RCC: clocks are ready as soon as they're turned on.
+ */
+
+static void rcc_after(host_periph *p, uint32 offset, int write) {
+    __io uint32 *cr = host_periph_reg(p, OFFSET(rcc_reg_map, CR));
+    __io uint32 *cfgr = host_periph_reg(p, OFFSET(rcc_reg_map, CFGR));
+    __io uint32 *bdcr = host_periph_reg(p, OFFSET(rcc_reg_map, BDCR));
+    __io uint32 *csr = host_periph_reg(p, OFFSET(rcc_reg_map, CSR));
+
+    (void)offset;
+    if (!write) {
+        return;
+    }
+    /* Each RDY bit sits just above its ON bit. */
+    *cr = (*cr & ~(RCC_CR_HSIRDY | RCC_CR_HSERDY | RCC_CR_PLLRDY)) |
+        ((*cr & (RCC_CR_HSION | RCC_CR_HSEON | RCC_CR_PLLON)) << 1);
+    *cfgr = (*cfgr & ~RCC_CFGR_SWS) | ((*cfgr & RCC_CFGR_SW) << 2);
+    *bdcr = (*bdcr & ~RCC_BDCR_LSERDY) | ((*bdcr & RCC_BDCR_LSEON) << 1);
+    *csr = (*csr & ~RCC_CSR_LSIRDY) | ((*csr & RCC_CSR_LSION) << 1);
+}
+
+/*
+ * GPIO: IDR follows ODR unless a pin is driven with host_gpio_input().
+ */
+
+typedef struct gpio_state {
+    char name;
+    uint16 odr;                 /* ODR as of the last trace */
+    uint16 force_mask;
+    uint16 force_val;
+} gpio_state;
+
+static gpio_state gpio_states[] = {
+    {.name = 'A'}, {.name = 'B'}, {.name = 'C'}, {.name = 'D'},
+    {.name = 'E'}, {.name = 'F'}, {.name = 'G'},
+};
+
+static void gpio_update(host_periph *p) {
+    gpio_state *g = (gpio_state*)p->state;
+    __io uint32 *odr = host_periph_reg(p, OFFSET(gpio_reg_map, ODR));
+    uint16 changed = (*odr & 0xFFFF) ^ g->odr;
+    int bit;
+
+    *odr &= 0xFFFF;
+    *host_periph_reg(p, OFFSET(gpio_reg_map, IDR)) =
+        (*odr & ~g->force_mask) | (g->force_val & g->force_mask);
+    if (host_trace_gpio) {
+        for (bit = 0; changed; bit++, changed >>= 1) {
+            if (changed & 1) {
+                host_log("P%c%d = %u", g->name, bit,
+                         (unsigned)(*odr >> bit) & 1);
+            }
+        }
+    }
+    g->odr = *odr;
+}
+
+static void gpio_after(host_periph *p, uint32 offset, int write) {
+    __io uint32 *odr = host_periph_reg(p, OFFSET(gpio_reg_map, ODR));
+    __io uint32 *reg = host_periph_reg(p, offset);
+
+    if (!write) {
+        return;
+    }
+    switch (offset & ~3U) {
+    case OFFSET(gpio_reg_map, BSRR):
+        *odr = (*odr & ~(*reg >> 16)) | (*reg & 0xFFFF);
+        *reg = 0;
+        break;
+    case OFFSET(gpio_reg_map, BRR):
+        *odr &= ~*reg;
+        *reg = 0;
+        break;
+    }
+    gpio_update(p);
+}
+
+void host_gpio_input(void *port, uint8 bit, int level) {
+    host_periph *p;
+    gpio_state *g;
+
+    for (p = host_periphs; p < host_periphs + host_nr_periphs; p++) {
+        if (p->base == (uint32)(uintptr_t)port && p->after == gpio_after) {
+            g = (gpio_state*)p->state;
+            g->force_mask &= ~BIT(bit);
+            g->force_val &= ~BIT(bit);
+            if (level >= 0) {
+                g->force_mask |= BIT(bit);
+                g->force_val |= (level ? 1 : 0) << bit;
+            }
+            gpio_update(p);
+            return;
+        }
+    }
+}
+
+/*
+ * USART: the data register is connected to a host file descriptor,
+ * or looped back.
+ */
+
+#define USART_QUEUE_SIZE        256
+
+typedef struct usart_state {
+    const char *name;
+    int irq;
+    int fd_in;
+    int fd_out;
+    int loop;
+    uint8 rdr;                  /* Received byte; DR reads return it */
+    uint8 rx[USART_QUEUE_SIZE]; /* Received, not yet in DR */
+    uint16 rx_head;
+    uint16 rx_tail;
+    uint8 tx[USART_QUEUE_SIZE]; /* Sent, not yet written to fd_out */
+    uint16 tx_len;
+} usart_state;
+
+static usart_state usart_states[] = {
+    {.name = "USART1", .irq = NVIC_USART1, .fd_in = -1, .fd_out = -1},
+    {.name = "USART2", .irq = NVIC_USART2, .fd_in = -1, .fd_out = -1},
+    {.name = "USART3", .irq = NVIC_USART3, .fd_in = -1, .fd_out = -1},
+    {.name = "UART4",  .irq = NVIC_UART4,  .fd_in = -1, .fd_out = -1},
+    {.name = "UART5",  .irq = NVIC_UART5,  .fd_in = -1, .fd_out = -1},
+};
+#define NR_USARTS (sizeof(usart_states) / sizeof(usart_states[0]))
+
+static void usart_flush(usart_state *u) {
+    uint32 done = 0;
+
+    while (done < u->tx_len) {
+        ssize_t n = write(u->fd_out, u->tx + done, u->tx_len - done);
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    u->tx_len = 0;
+}
+
+static void usart_update(host_periph *p) {
+    usart_state *u = (usart_state*)p->state;
+    __io uint32 *sr = host_periph_reg(p, OFFSET(usart_reg_map, SR));
+    __io uint32 *dr = host_periph_reg(p, OFFSET(usart_reg_map, DR));
+    uint32 cr1 = *host_periph_reg(p, OFFSET(usart_reg_map, CR1));
+
+    *sr |= USART_SR_TXE | USART_SR_TC;
+    if (!(*sr & USART_SR_RXNE) && u->rx_head != u->rx_tail) {
+        u->rdr = u->rx[u->rx_tail++ % USART_QUEUE_SIZE];
+        *dr = u->rdr;
+        *sr |= USART_SR_RXNE;
+    }
+    host_irq_level(u->irq,
+                   ((cr1 & USART_CR1_TXEIE) && (*sr & USART_SR_TXE)) ||
+                   ((cr1 & USART_CR1_TCIE) && (*sr & USART_SR_TC)) ||
+                   ((cr1 & USART_CR1_RXNEIE) && (*sr & USART_SR_RXNE)));
+}
+
+static void usart_before(host_periph *p, uint32 offset, int write) {
+    usart_state *u = (usart_state*)p->state;
+
+    usart_update(p);
+    if (!write && (offset & ~3U) == OFFSET(usart_reg_map, DR)) {
+        *host_periph_reg(p, offset) = u->rdr;
+    }
+}
+
+static void usart_after(host_periph *p, uint32 offset, int write) {
+    usart_state *u = (usart_state*)p->state;
+    __io uint32 *sr = host_periph_reg(p, OFFSET(usart_reg_map, SR));
+    __io uint32 *dr = host_periph_reg(p, OFFSET(usart_reg_map, DR));
+
+    if ((offset & ~3U) == OFFSET(usart_reg_map, DR)) {
+        if (write) {
+            uint8 c = *dr & 0xFF;
+            *dr = u->rdr;       /* Transmit and receive are separate */
+            if (u->loop) {
+                if ((uint16)(u->rx_head - u->rx_tail) < USART_QUEUE_SIZE) {
+                    u->rx[u->rx_head++ % USART_QUEUE_SIZE] = c;
+                } else {
+                    *sr |= USART_SR_ORE;
+                }
+            } else if (u->fd_out >= 0) {
+                u->tx[u->tx_len++] = c;
+                if (u->tx_len == USART_QUEUE_SIZE) {
+                    usart_flush(u);
+                }
+            }
+        } else {
+            *sr &= ~(USART_SR_RXNE | USART_SR_ORE);
+        }
+    }
+    usart_update(p);
+}
+
+/* Pull in whatever the host side has sent. */
+static void usart_poll(host_periph *p) {
+    usart_state *u = (usart_state*)p->state;
+    uint16 room = USART_QUEUE_SIZE - (uint16)(u->rx_head - u->rx_tail);
+    struct pollfd pfd = {u->fd_in, POLLIN, 0};
+
+    if (u->tx_len) {
+        usart_flush(u);
+    }
+    while (u->fd_in >= 0 && room && poll(&pfd, 1, 0) > 0) {
+        uint8 buf[USART_QUEUE_SIZE];
+        ssize_t i, n = read(u->fd_in, buf, room);
+        if (n <= 0) {
+            u->fd_in = -1;      /* EOF; stop polling */
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            u->rx[u->rx_head++ % USART_QUEUE_SIZE] = buf[i];
+        }
+        room -= n;
+    }
+    usart_update(p);
+}
+
+static void usart_open(usart_state *u, const char *how) {
+    if (!strcmp(how, "stdio")) {
+        u->fd_in = STDIN_FILENO;
+        u->fd_out = STDOUT_FILENO;
+    } else if (!strcmp(how, "loop")) {
+        u->loop = 1;
+    } else if (!strcmp(how, "pty")) {
+        int fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+            perror("host_sim: pty");
+            exit(1);
+        }
+        fprintf(stderr, "host_sim: %s is on %s\n", u->name, ptsname(fd));
+        u->fd_in = u->fd_out = fd;
+    } else if (strcmp(how, "null")) {
+        int fd = open(how, O_RDWR | O_NOCTTY);
+        if (fd < 0) {
+            perror(how);
+            exit(1);
+        }
+        u->fd_in = u->fd_out = fd;
+    }
+}
+
+/*
+ * ADC: conversions finish as soon as they're started.
+ */
+
+typedef struct adc_state {
+    uint16 value[18];
+    uint32 sr;                  /* SR before a write */
+} adc_state;
+
+static adc_state adc_states[3];
+
+static void adc_before(host_periph *p, uint32 offset, int write) {
+    if (write && (offset & ~3U) == OFFSET(adc_reg_map, SR)) {
+        ((adc_state*)p->state)->sr = *host_periph_reg(p, offset & ~3U);
+    }
+}
+
+static void adc_after(host_periph *p, uint32 offset, int write) {
+    adc_state *a = (adc_state*)p->state;
+    __io uint32 *sr = host_periph_reg(p, OFFSET(adc_reg_map, SR));
+    __io uint32 *cr2 = host_periph_reg(p, OFFSET(adc_reg_map, CR2));
+    uint32 channel;
+
+    switch (offset & ~3U) {
+    case OFFSET(adc_reg_map, CR2):
+        if (!write) {
+            break;
+        }
+        *cr2 &= ~(ADC_CR2_CAL | ADC_CR2_RSTCAL);
+        if (*cr2 & ADC_CR2_SWSTART) {
+            *cr2 &= ~ADC_CR2_SWSTART;
+            channel = *host_periph_reg(p, OFFSET(adc_reg_map, SQR3)) & 0x1F;
+            *host_periph_reg(p, OFFSET(adc_reg_map, DR)) =
+                channel < 18 ? a->value[channel] : 0;
+            *sr |= ADC_SR_EOC | ADC_SR_STRT;
+        }
+        if (*cr2 & ADC_CR2_JSWSTART) {
+            /* With one injected conversion, JSQ4 is the one converted */
+            *cr2 &= ~ADC_CR2_JSWSTART;
+            channel = (*host_periph_reg(p, OFFSET(adc_reg_map, JSQR)) >> 15) & 0x1F;
+            *host_periph_reg(p, OFFSET(adc_reg_map, JDR1)) =
+                channel < 18 ? a->value[channel] : 0;
+            *sr |= ADC_SR_JEOC | ADC_SR_JSTRT;
+        }
+        break;
+    case OFFSET(adc_reg_map, SR):
+        if (write) {
+            *sr &= a->sr;       /* Bits are cleared by writing 0 */
+        }
+        break;
+    case OFFSET(adc_reg_map, DR):
+        if (!write) {
+            *sr &= ~ADC_SR_EOC;
+        }
+        break;
+    }
+}
+
+void host_adc_input(void *adc, uint8 channel, uint16 value) {
+    host_periph *p;
+
+    for (p = host_periphs; p < host_periphs + host_nr_periphs; p++) {
+        if (p->base == (uint32)(uintptr_t)adc && p->after == adc_after) {
+            if (channel < 18) {
+                ((adc_state*)p->state)->value[channel] = value & 0xFFF;
+            }
+            return;
+        }
+    }
+}
+
+/*
+ * Timers: the counter doesn't run; host_timer_capture() and
+ * host_timer_update() raise the events by hand. SR flags clear when
+ * written with 0, CCxIF also when CCRx is read.
+ */
+
+typedef struct timer_state {
+    int irq_up;                 /* Update interrupt line */
+    int irq_cc;                 /* Capture/compare line; the same as
+                                   irq_up except on advanced timers */
+    uint32 sr;                  /* SR before the current write */
+} timer_state;
+
+static timer_state timer_states[] = {
+    {.irq_up = NVIC_TIMER1_UP_TIMER10, .irq_cc = NVIC_TIMER1_CC},
+    {.irq_up = NVIC_TIMER2, .irq_cc = NVIC_TIMER2},
+    {.irq_up = NVIC_TIMER3, .irq_cc = NVIC_TIMER3},
+    {.irq_up = NVIC_TIMER4, .irq_cc = NVIC_TIMER4},
+    {.irq_up = NVIC_TIMER5, .irq_cc = NVIC_TIMER5},
+    {.irq_up = NVIC_TIMER8_UP_TIMER13, .irq_cc = NVIC_TIMER8_CC},
+};
+
+#define TIMER_SR_CCIF   (TIMER_SR_CC1IF | TIMER_SR_CC2IF | \
+                         TIMER_SR_CC3IF | TIMER_SR_CC4IF)
+
+static void timer_update(host_periph *p) {
+    timer_state *t = (timer_state*)p->state;
+    uint32 dsr = *host_periph_reg(p, OFFSET(timer_gen_reg_map, DIER)) &
+        *host_periph_reg(p, OFFSET(timer_gen_reg_map, SR));
+
+    if (t->irq_up == t->irq_cc) {
+        host_irq_level(t->irq_up, dsr & (TIMER_SR_UIF | TIMER_SR_CCIF |
+                                         TIMER_SR_TIF));
+    } else {
+        host_irq_level(t->irq_up, dsr & TIMER_SR_UIF);
+        host_irq_level(t->irq_cc, dsr & TIMER_SR_CCIF);
+    }
+}
+
+static void timer_before(host_periph *p, uint32 offset, int write) {
+    timer_state *t = (timer_state*)p->state;
+
+    if (write && (offset & ~3U) == OFFSET(timer_gen_reg_map, SR)) {
+        t->sr = *host_periph_reg(p, offset);
+    }
+}
+
+static void timer_after(host_periph *p, uint32 offset, int write) {
+    timer_state *t = (timer_state*)p->state;
+    __io uint32 *sr = host_periph_reg(p, OFFSET(timer_gen_reg_map, SR));
+
+    offset &= ~3U;
+    if (offset == OFFSET(timer_gen_reg_map, SR)) {
+        if (write) {
+            *sr &= t->sr;
+        }
+    } else if (offset >= OFFSET(timer_gen_reg_map, CCR1) &&
+               offset <= OFFSET(timer_gen_reg_map, CCR4) && !write) {
+        *sr &= ~(TIMER_SR_CC1IF <<
+                 ((offset - OFFSET(timer_gen_reg_map, CCR1)) / 4));
+    }
+    timer_update(p);
+}
+
+static host_periph* timer_find(void *timer) {
+    host_periph *p;
+
+    for (p = host_periphs; p < host_periphs + host_nr_periphs; p++) {
+        if (p->base == (uint32)(uintptr_t)timer && p->after == timer_after) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+void host_timer_capture(void *timer, uint8 channel, uint16 value) {
+    host_periph *p = timer_find(timer);
+    __io uint32 *sr;
+    uint32 ccif;
+
+    if (!p || channel < 1 || channel > 4) {
+        return;
+    }
+    sr = host_periph_reg(p, OFFSET(timer_gen_reg_map, SR));
+    ccif = TIMER_SR_CC1IF << (channel - 1);
+    if (*sr & ccif) {
+        *sr |= TIMER_SR_CC1OF << (channel - 1);
+    }
+    *host_periph_reg(p, OFFSET(timer_gen_reg_map, CCR1) + 4 * (channel - 1)) =
+        value;
+    *sr |= ccif;
+    timer_update(p);
+}
+
+void host_timer_update(void *timer) {
+    host_periph *p = timer_find(timer);
+
+    if (p) {
+        *host_periph_reg(p, OFFSET(timer_gen_reg_map, SR)) |= TIMER_SR_UIF;
+        timer_update(p);
+    }
+}
+
+/*
+ * EXTI: edges come from software, through SWIER. PR bits are cleared
+ * by writing ones, which also clears the matching SWIER bits.
+ */
+
+static const int exti_irqs[16] = {
+    NVIC_EXTI0, NVIC_EXTI1, NVIC_EXTI2, NVIC_EXTI3, NVIC_EXTI4,
+    NVIC_EXTI_9_5, NVIC_EXTI_9_5, NVIC_EXTI_9_5, NVIC_EXTI_9_5, NVIC_EXTI_9_5,
+    NVIC_EXTI_15_10, NVIC_EXTI_15_10, NVIC_EXTI_15_10, NVIC_EXTI_15_10,
+    NVIC_EXTI_15_10, NVIC_EXTI_15_10,
+};
+
+static uint32 exti_before_write;        /* Register before a write */
+
+static void exti_update(host_periph *p) {
+    uint32 pending = *host_periph_reg(p, OFFSET(exti_reg_map, PR)) &
+        *host_periph_reg(p, OFFSET(exti_reg_map, IMR));
+    uint64 levels = 0;
+    int line;
+
+    for (line = 0; line < 16; line++) {
+        if (pending & (1U << line)) {
+            levels |= 1ULL << exti_irqs[line];
+        }
+    }
+    for (line = 0; line < 16; line++) {
+        host_irq_level(exti_irqs[line], (levels >> exti_irqs[line]) & 1);
+    }
+}
+
+static void exti_before(host_periph *p, uint32 offset, int write) {
+    if (write) {
+        exti_before_write = *host_periph_reg(p, offset);
+    }
+}
+
+static void exti_after(host_periph *p, uint32 offset, int write) {
+    __io uint32 *reg = host_periph_reg(p, offset);
+    __io uint32 *pr = host_periph_reg(p, OFFSET(exti_reg_map, PR));
+    __io uint32 *swier = host_periph_reg(p, OFFSET(exti_reg_map, SWIER));
+
+    offset &= ~3U;
+    if (write && offset == OFFSET(exti_reg_map, SWIER)) {
+        /* Setting a bit raises the line, if it isn't masked */
+        uint32 set = *reg & ~exti_before_write &
+            *host_periph_reg(p, OFFSET(exti_reg_map, IMR));
+        *pr |= set;
+        *reg = exti_before_write | set;
+    } else if (write && offset == OFFSET(exti_reg_map, PR)) {
+        *reg = exti_before_write & ~*reg;
+        *swier &= *reg;
+    }
+    exti_update(p);
+}
+
+/*
+ * System control space: SysTick, NVIC and SCB.
+ */
+
+#define SCS_BASE                0xE000E000U
+#define SYSTICK_OFFSET          ((uint32)(uintptr_t)SYSTICK_BASE - SCS_BASE)
+#define NVIC_OFFSET             ((uint32)(uintptr_t)NVIC_BASE - SCS_BASE)
+#define SCB_OFFSET              ((uint32)(uintptr_t)SCB_BASE - SCS_BASE)
+
+static struct {
+    uint64 next;                /* Cycle count at the next reload */
+    uint32 period;
+    uint8 countflag;
+} systick;
+
+static uint32 nvic_enabled[2];
+
+uint64 host_nvic_enabled(void) {
+    return nvic_enabled[0] | ((uint64)nvic_enabled[1] << 32);
+}
+
+static void systick_update(host_periph *p, uint64 cycles) {
+    __io uint32 *csr = host_periph_reg(p, SYSTICK_OFFSET +
+                                       OFFSET(systick_reg_map, CSR));
+    uint32 n = 0;
+
+    if (!(*csr & SYSTICK_CSR_ENABLE) || cycles < systick.next) {
+        return;
+    }
+    n = (cycles - systick.next) / systick.period + 1;
+    systick.next += (uint64)n * systick.period;
+    systick.countflag = 1;
+    if (*csr & SYSTICK_CSR_TICKINT) {
+        /* Catch up on missed ticks, within reason */
+        n = n > 1000 ? 1000 : n;
+        while (n--) {
+            host_irq_pend(NVIC_SYSTICK);
+        }
+    }
+}
+
+static void scs_before(host_periph *p, uint32 offset, int write) {
+    uint64 cycles = host_sim_cycles();
+
+    if (write || offset < SYSTICK_OFFSET ||
+        offset >= SYSTICK_OFFSET + sizeof(systick_reg_map)) {
+        return;
+    }
+    systick_update(p, cycles);
+    switch (offset - SYSTICK_OFFSET) {
+    case OFFSET(systick_reg_map, CSR):
+        if (systick.countflag) {
+            *host_periph_reg(p, offset) |= SYSTICK_CSR_COUNTFLAG;
+        }
+        break;
+    case OFFSET(systick_reg_map, CNT):
+        if (*host_periph_reg(p, SYSTICK_OFFSET) & SYSTICK_CSR_ENABLE) {
+            *host_periph_reg(p, offset) = systick.next - cycles - 1;
+        }
+        break;
+    }
+}
+
+/* We're in a signal handler: no stdio, and no atexit() */
+static void system_reset(void) {
+    static const char msg[] = "host_sim: system reset requested\n";
+
+    if (write(STDERR_FILENO, msg, sizeof(msg) - 1) < 0) {
+        /* Nothing sensible to do */
+    }
+    host_periph_exit();
+    _exit(0);
+}
+
+static void scs_after(host_periph *p, uint32 offset, int write) {
+    __io uint32 *reg = host_periph_reg(p, offset);
+    uint32 n;
+
+    if (offset >= SYSTICK_OFFSET &&
+        offset < SYSTICK_OFFSET + sizeof(systick_reg_map)) {
+        if (offset == SYSTICK_OFFSET + OFFSET(systick_reg_map, CSR)) {
+            *reg &= ~SYSTICK_CSR_COUNTFLAG;
+            systick.countflag = 0;
+        }
+        if (write) {
+            systick.period = (*host_periph_reg(p, SYSTICK_OFFSET +
+                              OFFSET(systick_reg_map, RVR)) & 0xFFFFFF) + 1;
+            systick.next = host_sim_cycles() + systick.period;
+        }
+        return;
+    }
+    if (!write) {
+        return;
+    }
+
+    /* NVIC set/clear registers write ones to change things, and read
+     * back the current state. */
+    n = (offset - NVIC_OFFSET) / 4 % 8;
+    if (offset >= NVIC_OFFSET + OFFSET(nvic_reg_map, ISER) &&
+        offset < NVIC_OFFSET + OFFSET(nvic_reg_map, ISER) + 8 && n < 2) {
+        nvic_enabled[n] |= *reg;
+    } else if (offset >= NVIC_OFFSET + OFFSET(nvic_reg_map, ICER) &&
+               offset < NVIC_OFFSET + OFFSET(nvic_reg_map, ICER) + 8 && n < 2) {
+        nvic_enabled[n] &= ~*reg;
+    } else if (offset >= NVIC_OFFSET + OFFSET(nvic_reg_map, ISPR) &&
+               offset < NVIC_OFFSET + OFFSET(nvic_reg_map, ISPR) + 8) {
+        uint32 bits = *reg;
+        while (bits) {
+            host_irq_pend(n * 32 + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+        *reg = 0;
+    } else if (offset == NVIC_OFFSET + OFFSET(nvic_reg_map, STIR)) {
+        host_irq_pend(*reg & 0x1FF);
+    } else if (offset == SCB_OFFSET + OFFSET(scb_reg_map, ICSR)) {
+        if (*reg & SCB_ICSR_PENDSVSET) {
+            host_irq_pend(NVIC_PEND_SVC);
+        }
+        *reg &= ~SCB_ICSR_PENDSVSET;
+    } else if (offset == SCB_OFFSET + OFFSET(scb_reg_map, AIRCR)) {
+        if (*reg & SCB_AIRCR_SYSRESETREQ) {
+            system_reset();
+        }
+    }
+    for (n = 0; n < 2; n++) {
+        *host_periph_reg(p, NVIC_OFFSET + OFFSET(nvic_reg_map, ISER) + 4 * n) =
+            nvic_enabled[n];
+        *host_periph_reg(p, NVIC_OFFSET + OFFSET(nvic_reg_map, ICER) + 4 * n) =
+            nvic_enabled[n];
+    }
+}
+
+/*
+ * DWT: the cycle counter follows the clock while enabled.
+ */
+
+#define DWT_CTRL                OFFSET(dwt_reg_map, CTRL)
+#define DWT_CYCCNT              OFFSET(dwt_reg_map, CYCCNT)
+
+static uint64 dwt_origin;       /* Cycle count when CYCCNT was 0 */
+
+static void dwt_before(host_periph *p, uint32 offset, int write) {
+    __io uint32 *ctrl = host_periph_reg(p, DWT_CTRL);
+
+    if (!write && offset == DWT_CYCCNT && (*ctrl & DWT_CTRL_CYCCNTENA)) {
+        *host_periph_reg(p, DWT_CYCCNT) = host_sim_cycles() - dwt_origin;
+    }
+}
+
+static void dwt_after(host_periph *p, uint32 offset, int write) {
+    __io uint32 *cyccnt = host_periph_reg(p, DWT_CYCCNT);
+    uint64 cycles = host_sim_cycles();
+
+    if (!write) {
+        return;
+    }
+    if (offset == DWT_CYCCNT || offset == DWT_CTRL) {
+        /* Restart from whatever CYCCNT holds now; a disabled counter
+         * just stays where it was left. */
+        dwt_origin = cycles - *cyccnt;
+    }
+}
+
+/*
+ * Table of models
+ */
+
+#define GPIO_PERIPH(port, i) \
+    {(uint32)(uintptr_t)port##_BASE, sizeof(gpio_reg_map), \
+     NULL, gpio_after, &gpio_states[i]}
+#define USART_PERIPH(base, i) \
+    {(uint32)(uintptr_t)base, sizeof(usart_reg_map), \
+     usart_before, usart_after, &usart_states[i]}
+#define ADC_PERIPH(base, i) \
+    {(uint32)(uintptr_t)base, sizeof(adc_reg_map), \
+     adc_before, adc_after, &adc_states[i]}
+#define TIMER_PERIPH(base, i) \
+    {(uint32)(uintptr_t)base, sizeof(timer_gen_reg_map), \
+     timer_before, timer_after, &timer_states[i]}
+
+host_periph host_periphs[] = {
+    {(uint32)(uintptr_t)RCC_BASE, sizeof(rcc_reg_map),
+     NULL, rcc_after, NULL},
+    GPIO_PERIPH(GPIOA, 0),
+    GPIO_PERIPH(GPIOB, 1),
+    GPIO_PERIPH(GPIOC, 2),
+    GPIO_PERIPH(GPIOD, 3),
+    GPIO_PERIPH(GPIOE, 4),
+    GPIO_PERIPH(GPIOF, 5),
+    GPIO_PERIPH(GPIOG, 6),
+    USART_PERIPH(USART1_BASE, 0),
+    USART_PERIPH(USART2_BASE, 1),
+    USART_PERIPH(USART3_BASE, 2),
+#ifdef STM32_HIGH_DENSITY
+    USART_PERIPH(UART4_BASE, 3),
+    USART_PERIPH(UART5_BASE, 4),
+#endif
+    ADC_PERIPH(ADC1_BASE, 0),
+    ADC_PERIPH(ADC2_BASE, 1),
+    ADC_PERIPH(ADC3_BASE, 2),
+    TIMER_PERIPH(TIMER1_BASE, 0),
+    TIMER_PERIPH(TIMER2_BASE, 1),
+    TIMER_PERIPH(TIMER3_BASE, 2),
+    TIMER_PERIPH(TIMER4_BASE, 3),
+    TIMER_PERIPH(TIMER5_BASE, 4),
+    TIMER_PERIPH(TIMER8_BASE, 5),
+    {(uint32)(uintptr_t)EXTI_BASE, sizeof(exti_reg_map),
+     exti_before, exti_after, NULL},
+    {(uint32)(uintptr_t)DWT_BASE, 0x1000, dwt_before, dwt_after, NULL},
+    {SCS_BASE, 0x1000, scs_before, scs_after, NULL},
+};
+const uint32 host_nr_periphs = sizeof(host_periphs) / sizeof(host_periphs[0]);
+
+#define SCS_PERIPH              (&host_periphs[host_nr_periphs - 1])
+
+void host_periph_init(void) {
+    host_periph *p;
+    char var[16];
+
+    for (p = host_periphs; p < host_periphs + host_nr_periphs; p++) {
+        if (p->after == usart_after) {
+            usart_state *u = (usart_state*)p->state;
+            const char *how;
+
+            snprintf(var, sizeof(var), "HOST_%s", u->name);
+            how = getenv(var);
+            usart_open(u, how ? how : u == usart_states ? "stdio" : "null");
+            usart_update(p);
+        }
+    }
+}
+
+void host_periph_tick(uint64 cycles) {
+    systick_update(SCS_PERIPH, cycles);
+}
+
+void host_periph_io(void) {
+    host_periph *p;
+
+    for (p = host_periphs; p < host_periphs + host_nr_periphs; p++) {
+        if (p->after == usart_after) {
+            usart_poll(p);
+        }
+    }
+}
+
+void host_periph_exit(void) {
+    uint32 i;
+
+    for (i = 0; i < NR_USARTS; i++) {
+        if (usart_states[i].tx_len) {
+            usart_flush(&usart_states[i]);
+        }
+    }
+}
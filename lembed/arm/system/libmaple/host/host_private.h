@@ -0,0 +1,78 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/*
+ * Interface between the trap machinery in host_sim.c and the
+ * peripheral models in host_periph.c.
+ */
+
+#ifndef _LIBMAPLE_HOST_PRIVATE_H_
+#define _LIBMAPLE_HOST_PRIVATE_H_
+
+#include <libmaple/host_sim.h>
+
+/* A simulated register block. */
+typedef struct host_periph {
+    uint32 base;                /* Address of the first register */
+    uint32 size;                /* Size of the block, in bytes */
+    /* Called before each access, e.g. to bring a counter up to date. */
+    void (*before)(struct host_periph *p, uint32 offset, int write);
+    /* Called after each access; write is nonzero for stores. */
+    void (*after)(struct host_periph *p, uint32 offset, int write);
+    void *state;                /* Model's own data */
+} host_periph;
+
+/* Pointer to a register, which the models can use without trapping. */
+__io uint32* host_reg(uint32 addr);
+
+static inline __io uint32* host_periph_reg(host_periph *p, uint32 offset) {
+    return host_reg(p->base + (offset & ~3U));
+}
+
+/* Peripheral models */
+extern host_periph host_periphs[];
+extern const uint32 host_nr_periphs;
+void host_periph_init(void);
+void host_periph_tick(uint64 cycles);   /* Clock-driven state */
+void host_periph_io(void);              /* Host file descriptors */
+void host_periph_exit(void);
+
+/* Interrupts. host_irq_pend() also takes NVIC_SYSTICK and
+ * NVIC_PEND_SVC. host_nvic_enabled() is the NVIC model's enable
+ * mask. */
+void host_irq_level(int irq, int level);
+void host_irq_pend(int irq);
+uint64 host_nvic_enabled(void);
+
+#define HOST_NR_IRQS            64
+
+/* Tracing */
+extern int host_trace_gpio;
+extern int host_trace_irq;
+/* Safe in signal handlers; understands %c, %d, %u and %s only */
+void host_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#endif
@@ -0,0 +1,552 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file libmaple/host/host_sim.c
+ * @brief Register traps, clock and interrupts for host builds
+ *
+ * Each simulated address range is a memfd mapped twice: once at the
+ * chip's address with no access rights, which is what firmware code
+ * sees, and once read-write elsewhere, which is what the models in
+ * host_periph.c use. A firmware access faults (SIGSEGV); we let the
+ * model prepare, open the page, and single-step the instruction with
+ * the x86 trap flag. The SIGTRAP that follows closes the page again,
+ * lets the model react to what was done, and runs any interrupts the
+ * access raised.
+ */
+
+#define _GNU_SOURCE
+
+#include <libmaple/host_sim.h>
+#include <libmaple/nvic.h>
+#include "host_private.h"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#if !defined(__x86_64__)
+#error "The host simulation single-steps with the x86-64 trap flag"
+#endif
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+#ifndef F_CPU
+#define F_CPU                   72000000UL
+#endif
+
+#define PAGE_SIZE               4096U
+#define EFLAGS_TF               0x100
+#define PF_WRITE                0x2
+
+volatile uint32 host_primask;
+volatile uint32 host_ipsr;
+volatile uint64 host_sim_traps;
+
+/*
+ * Address ranges
+ */
+
+typedef struct host_region {
+    uint32 base;
+    uint32 size;
+    uint8 *shadow;              /* Read-write view, or NULL (bit-band) */
+} host_region;
+
+#define PERIPH_BASE             0x40000000U
+#define PERIPH_SIZE             0x30000U
+#define PERIPH_BB_BASE          0x42000000U
+#define PPB_BASE                0xE0000000U
+#define PPB_SIZE                0x100000U
+
+static host_region regions[] = {
+    {PERIPH_BASE,    PERIPH_SIZE,      NULL},
+    {PPB_BASE,       PPB_SIZE,         NULL},
+    {PERIPH_BB_BASE, PERIPH_SIZE * 32, NULL},
+};
+#define NR_REGIONS              (sizeof(regions) / sizeof(regions[0]))
+#define BB_REGION               (&regions[2])
+
+static host_region* find_region(uintptr_t addr) {
+    uint32 i;
+    for (i = 0; i < NR_REGIONS; i++) {
+        if (addr >= regions[i].base &&
+            addr < (uintptr_t)regions[i].base + regions[i].size) {
+            return &regions[i];
+        }
+    }
+    return NULL;
+}
+
+__io uint32* host_reg(uint32 addr) {
+    host_region *r = find_region(addr);
+    return (__io uint32*)(r->shadow + (addr - r->base));
+}
+
+static host_periph* find_periph(uint32 addr) {
+    uint32 i;
+    for (i = 0; i < host_nr_periphs; i++) {
+        host_periph *p = &host_periphs[i];
+        if (addr >= p->base && addr < p->base + p->size) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static void map_region(host_region *r) {
+    void *at = (void*)(uintptr_t)r->base;
+    void *got;
+
+    if (r == BB_REGION) {
+        got = mmap(at, r->size, PROT_NONE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    } else {
+        int fd = syscall(SYS_memfd_create, "host_sim", 0);
+        if (fd < 0 || ftruncate(fd, r->size) < 0) {
+            perror("host_sim: memfd");
+            exit(1);
+        }
+        got = mmap(at, r->size, PROT_NONE,
+                   MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+        r->shadow = mmap(NULL, r->size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (got != at || r->shadow == MAP_FAILED) {
+        fprintf(stderr, "host_sim: can't map 0x%08x\n", (unsigned)r->base);
+        exit(1);
+    }
+}
+
+/*
+ * Clock
+ */
+
+static struct timespec clock_start;
+
+uint64 host_sim_cycles(void) {
+    struct timespec now;
+    uint64 ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = (uint64)(now.tv_sec - clock_start.tv_sec) * 1000000000ULL +
+        now.tv_nsec - clock_start.tv_nsec;
+    return ns * (F_CPU / 1000000) / 1000;
+}
+
+void host_delay_us(uint32 us) {
+    uint64 end = host_sim_cycles() + (uint64)us * (F_CPU / 1000000);
+    uint64 now;
+
+    while ((now = host_sim_cycles()) < end) {
+        /* Sleep through long waits; the tick signal still runs
+         * interrupts. */
+        if (end - now > 2 * (F_CPU / 1000)) {
+            struct timespec ms = {0, 1000000};
+            nanosleep(&ms, NULL);
+        }
+    }
+}
+
+/*
+ * Interrupts
+ */
+
+extern void __exc_systick(void) __weak;
+extern void __exc_pendsv(void) __weak;
+extern void __irq_exti0(void) __weak;
+extern void __irq_exti1(void) __weak;
+extern void __irq_exti2(void) __weak;
+extern void __irq_exti3(void) __weak;
+extern void __irq_exti4(void) __weak;
+extern void __irq_exti9_5(void) __weak;
+extern void __irq_exti15_10(void) __weak;
+extern void __irq_usart1(void) __weak;
+extern void __irq_usart2(void) __weak;
+extern void __irq_usart3(void) __weak;
+extern void __irq_uart4(void) __weak;
+extern void __irq_uart5(void) __weak;
+extern void __irq_tim1_up(void) __weak;
+extern void __irq_tim1_cc(void) __weak;
+extern void __irq_tim2(void) __weak;
+extern void __irq_tim3(void) __weak;
+extern void __irq_tim4(void) __weak;
+extern void __irq_tim5(void) __weak;
+extern void __irq_tim8_up(void) __weak;
+extern void __irq_tim8_cc(void) __weak;
+
+static voidFuncPtr irq_handlers[HOST_NR_IRQS];
+static uint64 irq_handled;              /* Lines with a handler */
+static volatile uint64 irq_levels;      /* Level-triggered sources */
+static volatile uint64 irq_pending;     /* Pended once, e.g. by ISPR */
+static volatile uint32 systick_pending;
+static volatile uint32 pendsv_pending;
+static sigset_t tick_sigset;
+
+static void irq_init(void) {
+    int i;
+
+    irq_handlers[NVIC_EXTI0] = __irq_exti0;
+    irq_handlers[NVIC_EXTI1] = __irq_exti1;
+    irq_handlers[NVIC_EXTI2] = __irq_exti2;
+    irq_handlers[NVIC_EXTI3] = __irq_exti3;
+    irq_handlers[NVIC_EXTI4] = __irq_exti4;
+    irq_handlers[NVIC_EXTI_9_5] = __irq_exti9_5;
+    irq_handlers[NVIC_EXTI_15_10] = __irq_exti15_10;
+    irq_handlers[NVIC_USART1] = __irq_usart1;
+    irq_handlers[NVIC_USART2] = __irq_usart2;
+    irq_handlers[NVIC_USART3] = __irq_usart3;
+    irq_handlers[NVIC_UART4] = __irq_uart4;
+    irq_handlers[NVIC_UART5] = __irq_uart5;
+    irq_handlers[NVIC_TIMER1_UP_TIMER10] = __irq_tim1_up;
+    irq_handlers[NVIC_TIMER1_CC] = __irq_tim1_cc;
+    irq_handlers[NVIC_TIMER2] = __irq_tim2;
+    irq_handlers[NVIC_TIMER3] = __irq_tim3;
+    irq_handlers[NVIC_TIMER4] = __irq_tim4;
+    irq_handlers[NVIC_TIMER5] = __irq_tim5;
+    irq_handlers[NVIC_TIMER8_UP_TIMER13] = __irq_tim8_up;
+    irq_handlers[NVIC_TIMER8_CC] = __irq_tim8_cc;
+    for (i = 0; i < HOST_NR_IRQS; i++) {
+        if (irq_handlers[i]) {
+            irq_handled |= 1ULL << i;
+        }
+    }
+}
+
+void host_irq_level(int irq, int level) {
+    if (level) {
+        irq_levels |= 1ULL << irq;
+    } else {
+        irq_levels &= ~(1ULL << irq);
+    }
+}
+
+void host_irq_pend(int irq) {
+    if (irq == NVIC_SYSTICK) {
+        systick_pending++;
+    } else if (irq == NVIC_PEND_SVC) {
+        pendsv_pending = 1;
+    } else if (irq >= 0 && irq < HOST_NR_IRQS) {
+        irq_pending |= 1ULL << irq;
+    }
+}
+
+static uint64 irq_runnable(void) {
+    return (irq_levels | irq_pending) & irq_handled & host_nvic_enabled();
+}
+
+static void irq_run(voidFuncPtr fn, uint32 exc) {
+    if (host_trace_irq) {
+        host_log("exception %u", (unsigned)exc);
+    }
+    host_ipsr = exc;
+    fn();
+    host_ipsr = 0;
+}
+
+/* Run whatever is pending, lowest number first, until nothing is.
+ * Must be called with the tick signal blocked. */
+static void irq_dispatch(void) {
+    uint64 runnable;
+
+    while (!host_primask && !host_ipsr) {
+        if (systick_pending) {
+            systick_pending--;
+            if (__exc_systick) {
+                irq_run(__exc_systick, 16 + NVIC_SYSTICK);
+            }
+        } else if ((runnable = irq_runnable()) != 0) {
+            int irq = __builtin_ctzll(runnable);
+            irq_pending &= ~(1ULL << irq);
+            irq_run(irq_handlers[irq], 16 + irq);
+        } else if (pendsv_pending) {
+            pendsv_pending = 0;
+            if (__exc_pendsv) {
+                irq_run(__exc_pendsv, 16 + NVIC_PEND_SVC);
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+void host_irq_enable(void) {
+    sigset_t old;
+
+    host_primask = 0;
+    if (!host_ipsr && (systick_pending || pendsv_pending || irq_runnable())) {
+        sigprocmask(SIG_BLOCK, &tick_sigset, &old);
+        irq_dispatch();
+        sigprocmask(SIG_SETMASK, &old, NULL);
+    }
+}
+
+/*
+ * Traps
+ */
+
+static struct {
+    int active;
+    uintptr_t page;
+    host_periph *periph;        /* Model of the register accessed */
+    uint32 addr;                /* Register address (not bit-band) */
+    uint32 bb_addr;             /* Bit-band alias accessed, or 0 */
+    int write;
+} step;
+
+static void crash(int sig) {
+    signal(sig, SIG_DFL);       /* Let the access fault for real */
+}
+
+static void bb_before(uint32 alias) {
+    uint32 byte = (alias - PERIPH_BB_BASE) >> 5;
+    uint32 bit = (byte & 3) * 8 + ((alias >> 2) & 7);
+
+    step.addr = PERIPH_BASE + (byte & ~3U);
+    *(__io uint32*)(uintptr_t)alias = (*host_reg(step.addr) >> bit) & 1;
+}
+
+static void bb_after(uint32 alias) {
+    uint32 byte = (alias - PERIPH_BB_BASE) >> 5;
+    uint32 bit = (byte & 3) * 8 + ((alias >> 2) & 7);
+    __io uint32 *reg = host_reg(step.addr);
+
+    if (*(__io uint32*)(uintptr_t)alias & 1) {
+        *reg |= 1U << bit;
+    } else {
+        *reg &= ~(1U << bit);
+    }
+}
+
+static void on_segv(int sig, siginfo_t *si, void *context) {
+    ucontext_t *uc = (ucontext_t*)context;
+    uintptr_t addr = (uintptr_t)si->si_addr;
+    host_region *r = find_region(addr);
+
+    if (!r || step.active) {
+        crash(sig);
+        return;
+    }
+    step.active = 1;
+    step.page = addr & ~(uintptr_t)(PAGE_SIZE - 1);
+    step.write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+    mprotect((void*)step.page, PAGE_SIZE, PROT_READ | PROT_WRITE);
+    if (r == BB_REGION) {
+        step.bb_addr = addr & ~3U;
+        bb_before(step.bb_addr);
+    } else {
+        step.bb_addr = 0;
+        step.addr = addr & ~3U;
+    }
+    step.periph = find_periph(step.addr);
+    if (step.periph && step.periph->before) {
+        step.periph->before(step.periph, step.addr - step.periph->base,
+                            step.write && !step.bb_addr);
+        if (step.bb_addr) {
+            bb_before(step.bb_addr);
+        }
+    }
+    uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+static void on_trap(int sig, siginfo_t *si, void *context) {
+    ucontext_t *uc = (ucontext_t*)context;
+    host_periph *p = step.periph;
+
+    (void)si;
+    if (!step.active) {
+        crash(sig);
+        return;
+    }
+    uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+    if (step.bb_addr && step.write) {
+        bb_after(step.bb_addr);
+    }
+    mprotect((void*)step.page, PAGE_SIZE, PROT_NONE);
+    step.active = 0;
+    host_sim_traps++;
+    if (p && p->after) {
+        p->after(p, step.addr - p->base, step.write);
+    }
+    host_periph_tick(host_sim_cycles());
+    irq_dispatch();
+}
+
+static void on_tick(int sig) {
+    (void)sig;
+    host_periph_io();
+    host_periph_tick(host_sim_cycles());
+    if (!step.active) {
+        irq_dispatch();
+    }
+}
+
+/*
+ * Tracing
+ */
+
+int host_trace_gpio;
+int host_trace_irq;
+
+/* host_log() runs in signal handlers, where stdio isn't safe, so it
+ * formats by hand. */
+
+static char* log_str(char *p, char *end, const char *s) {
+    while (*s && p < end) {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+static char* log_uint(char *p, char *end, uint32 v, int width, char pad) {
+    char digits[10];
+    int n = 0;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (width-- > n && p < end) {
+        *p++ = pad;
+    }
+    while (n && p < end) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+void host_log(const char *fmt, ...) {
+    char line[160];
+    char *p = line, *end = line + sizeof(line) - 1;
+    uint64 us = host_sim_cycles() / (F_CPU / 1000000);
+    va_list ap;
+
+    p = log_str(p, end, "[");
+    p = log_uint(p, end, us / 1000000, 6, ' ');
+    p = log_str(p, end, ".");
+    p = log_uint(p, end, us % 1000000, 6, '0');
+    p = log_str(p, end, "] ");
+    va_start(ap, fmt);
+    for (; *fmt && p < end; fmt++) {
+        int d;
+
+        if (*fmt != '%' || !fmt[1]) {
+            *p++ = *fmt;
+            continue;
+        }
+        switch (*++fmt) {
+        case 'c':
+            *p++ = (char)va_arg(ap, int);
+            break;
+        case 'd':
+            d = va_arg(ap, int);
+            if (d < 0) {
+                *p++ = '-';
+            }
+            p = log_uint(p, end, d < 0 ? -(uint32)d : (uint32)d, 0, ' ');
+            break;
+        case 'u':
+            p = log_uint(p, end, va_arg(ap, unsigned), 0, ' ');
+            break;
+        case 's':
+            p = log_str(p, end, va_arg(ap, const char*));
+            break;
+        default:
+            *p++ = *fmt;
+            break;
+        }
+    }
+    va_end(ap);
+    *p++ = '\n';
+    if (write(STDERR_FILENO, line, p - line) < 0) {
+        /* Nothing sensible to do */
+    }
+}
+
+static void trace_init(void) {
+    const char *trace = getenv("HOST_TRACE");
+
+    if (trace) {
+        host_trace_gpio = strstr(trace, "gpio") != NULL;
+        host_trace_irq = strstr(trace, "irq") != NULL;
+    }
+}
+
+/*
+ * Setup
+ */
+
+void host_sim_init(void) {
+    static int done;
+    struct sigaction sa;
+    struct itimerval tick = {{0, 1000}, {0, 1000}};
+    uint32 i;
+
+    if (done) {
+        return;
+    }
+    done = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &clock_start);
+    for (i = 0; i < NR_REGIONS; i++) {
+        map_region(&regions[i]);
+    }
+    trace_init();
+    irq_init();
+
+    sigemptyset(&tick_sigset);
+    sigaddset(&tick_sigset, SIGALRM);
+
+    /* The trap handlers run interrupt handlers, whose register
+     * accesses trap in turn, so they have to be reentrant. */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = on_segv;
+    sa.sa_flags = SA_SIGINFO | SA_NODEFER | SA_RESTART;
+    sa.sa_mask = tick_sigset;
+    sigaction(SIGSEGV, &sa, NULL);
+    sa.sa_sigaction = on_trap;
+    sigaction(SIGTRAP, &sa, NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_tick;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGALRM, &sa, NULL);
+
+    host_periph_init();
+    atexit(host_periph_exit);
+    setitimer(ITIMER_REAL, &tick, NULL);
+}
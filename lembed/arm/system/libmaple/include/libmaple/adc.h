@@ -42,6 +42,7 @@ extern "C" {
 #include <libmaple/libmaple.h>
 #include <libmaple/bitband.h>
 #include <libmaple/rcc.h>
+#include <libmaple/dma.h>
 /* We include the series header below, after defining the register map
  * and device structs. */
 
@@ -248,6 +249,69 @@ void adc_init(const adc_dev *dev);
 void adc_set_extsel(const adc_dev *dev, adc_extsel_event event);
 void adc_set_sample_rate(const adc_dev *dev, adc_smp_rate smp_rate);
 uint16 adc_read(const adc_dev *dev, uint8 channel);
+uint16 adc_read_injected(const adc_dev *dev, uint8 channel);
+void adc_set_reg_seq(const adc_dev *dev, const uint8 *channels, uint8 length);
+
+/*
+ * Scan mode
+ */
+
+struct adc_scan;
+
+/**
+ * @brief Handler for newly converted samples.
+ * @param scan    The scan the samples belong to.
+ * @param samples First sample of the buffer half just filled.
+ * @param count   Number of samples in that half.
+ */
+typedef void (*adc_scan_handler)(struct adc_scan *scan,
+                                 const uint16 *samples, uint16 count);
+
+/**
+ * @brief Continuous conversion of a channel sequence into a DMA buffer.
+ *
+ * Each trigger converts the whole sequence (a "frame"); DMA stores
+ * the frames one after another in buf, wrapping around at the end.
+ * The handler, if any, is called from the DMA interrupt as each half
+ * of buf fills, so it can work on one half while the other is being
+ * written.
+ *
+ * In dual mode, ADC2 converts channels2 in step with ADC1's
+ * channels, and each frame holds the two results of every step side
+ * by side: ADC1's first channel, ADC2's first channel, ADC1's second,
+ * and so on.
+ *
+ * Fill in the fields up to handler and call adc_scan_start(). The
+ * structure must stay valid until adc_scan_stop().
+ *
+ * Availability: STM32F1, on ADC1 and (high- and XL-density) ADC3.
+ * Dual mode needs ADC1.
+ */
+typedef struct adc_scan {
+    const adc_dev *dev;         /**< ADC1 or ADC3 */
+    const uint8 *channels;      /**< Conversion sequence, 1 to 16 channels */
+    uint8 nr_channels;          /**< Length of channels */
+    const uint8 *channels2;     /**< ADC2's sequence for dual mode,
+                                   nr_channels long, or NULL */
+    adc_extsel_event trigger;   /**< Frame trigger, or ADC_EXT_EV_SWSTART
+                                   to convert back to back */
+    volatile uint16 *buf;       /**< Sample buffer */
+    uint16 size;                /**< Samples in buf; a multiple of twice
+                                   the frame length */
+    adc_scan_handler handler;   /**< Buffer half handler, or NULL */
+    void *arg;                  /**< Free for the handler's use */
+
+    /* Private */
+    dma_dev *dma;
+    dma_tube tube;
+    uint8 frame;                /* Samples per frame */
+} adc_scan;
+
+int adc_scan_start(adc_scan *scan);
+void adc_scan_stop(adc_scan *scan);
+const volatile uint16* adc_scan_latest(adc_scan *scan);
+adc_scan* adc_scan_active(const adc_dev *dev);
+int adc_scan_read(const adc_dev *dev, uint8 channel);
 
 /**
  * @brief Set the ADC prescaler.
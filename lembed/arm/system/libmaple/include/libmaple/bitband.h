@@ -124,7 +124,7 @@ static inline volatile uint32* __bb_addr(volatile void *address,
     uint32 bb_base,
     uint32 bb_ref)
 {
-  return (volatile uint32*)(bb_base + ((uint32)address - bb_ref) * 32 +
+  return (volatile uint32*)(uintptr_t)(bb_base + ((uint32)(uintptr_t)address - bb_ref) * 32 +
                             bit * 4);
 }
 
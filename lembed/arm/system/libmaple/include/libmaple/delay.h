@@ -39,6 +39,9 @@ extern "C" {
 
 #include <libmaple/libmaple_types.h>
 #include <libmaple/stm32.h>
+#ifdef LIBMAPLE_HOST
+#include <libmaple/host_sim.h>
+#endif
 
 /**
  * @brief Delay the given number of microseconds.
@@ -47,6 +50,9 @@ extern "C" {
  */
 static inline void delay_us(uint32 us)
 {
+#ifdef LIBMAPLE_HOST
+	host_delay_us(us);
+#else
 	us *= STM32_DELAY_US_MULT;
 
 	/* fudge for function call overhead  */
@@ -57,6 +63,7 @@ static inline void delay_us(uint32 us)
 	             :
 	             : [us] "r" (us)
 	             : "r0");
+#endif
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file libmaple/include/libmaple/dma_ring.h
+ * @brief Bookkeeping for a circular-mode DMA receive buffer
+ *
+ * A DMA tube in circular mode writes into a buffer on its own; the
+ * only trace of where it is lies in the tube's CNDTR register. A
+ * dma_ring turns that into a byte stream: the interrupt side calls
+ * dma_ring_update() on every half-transfer, transfer-complete (and
+ * e.g. USART IDLE) event, and a single reader consumes bytes with
+ * dma_ring_count() and dma_ring_remove().
+ *
+ * Both sides keep free-running 32-bit byte counts, so the difference
+ * between them is the number of unread bytes, even across buffer
+ * wraps. For that to hold, dma_ring_update() must run at least once
+ * per buffer's worth of data; the half-transfer and transfer-complete
+ * interrupts guarantee this.
+ *
+ * The buffer size must be a power of two.
+ */
+
+#ifndef _LIBMAPLE_DMA_RING_H_
+#define _LIBMAPLE_DMA_RING_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <libmaple/libmaple_types.h>
+
+/** Circular DMA receive buffer state. */
+typedef struct dma_ring {
+    volatile uint8 *buf;    /**< Buffer the DMA tube writes into */
+    uint16 mask;            /**< Buffer size minus one */
+    volatile uint32 head;   /**< Bytes written, as of the last update */
+    uint32 tail;            /**< Bytes consumed by the reader */
+    uint32 overruns;        /**< Times the reader lost data */
+    uint32 span;            /**< tail as of the last dma_ring_span() */
+} dma_ring;
+
+/**
+ * @brief Initialise a DMA ring.
+ * @param dr   Instance to initialise
+ * @param buf  Buffer the DMA tube writes into
+ * @param size Number of bytes in buf; must be a power of two. This
+ *             is also the number of transfers to program the tube
+ *             with.
+ */
+static inline void dma_ring_init(dma_ring *dr, uint8 *buf, uint16 size) {
+    dr->buf = buf;
+    dr->mask = size - 1;
+    dr->head = 0;
+    dr->tail = 0;
+    dr->overruns = 0;
+    dr->span = 0;
+}
+
+/**
+ * @brief Buffer index the DMA tube will write to next.
+ * @param dr    Ring to check.
+ * @param cndtr Current value of the tube's CNDTR register.
+ */
+static inline uint16 dma_ring_pos(dma_ring *dr, uint32 cndtr) {
+    return (uint16)(dr->mask + 1 - cndtr) & dr->mask;
+}
+
+/**
+ * @brief Total number of bytes the DMA tube has written so far.
+ *
+ * CNDTR is read after head, so a concurrent dma_ring_update() can
+ * only make the result more recent, never wrong.
+ *
+ * @param dr    Ring to check.
+ * @param cndtr The tube's CNDTR register.
+ */
+static inline uint32 dma_ring_written(dma_ring *dr, __io uint32 *cndtr) {
+    uint32 head = dr->head;
+    uint16 pos = dma_ring_pos(dr, *cndtr);
+    return head + ((pos - head) & dr->mask);
+}
+
+/**
+ * @brief Record the DMA tube's progress. Interrupt side only.
+ * @param dr    Ring to update.
+ * @param cndtr The tube's CNDTR register.
+ */
+static inline void dma_ring_update(dma_ring *dr, __io uint32 *cndtr) {
+    dr->head = dma_ring_written(dr, cndtr);
+}
+
+/**
+ * @brief Return the number of unread bytes. Reader side only.
+ *
+ * If the reader has fallen more than a buffer behind, the oldest
+ * data is gone; the read position skips ahead to the newest half
+ * buffer and dr->overruns is incremented.
+ *
+ * @param dr    Ring to check.
+ * @param cndtr The tube's CNDTR register.
+ */
+static inline uint32 dma_ring_count(dma_ring *dr, __io uint32 *cndtr) {
+    uint32 written = dma_ring_written(dr, cndtr);
+    uint32 count = written - dr->tail;
+
+    if (count > (uint32)dr->mask + 1) {
+        count = ((uint32)dr->mask + 1) >> 1;
+        dr->tail = written - count;
+        dr->overruns++;
+    }
+    return count;
+}
+
+/**
+ * @brief Remove and return the oldest unread byte. Reader side only.
+ * @param dr Ring to remove from; dma_ring_count() must be nonzero.
+ */
+static inline uint8 dma_ring_remove(dma_ring *dr) {
+    return dr->buf[dr->tail++ & dr->mask];
+}
+
+/**
+ * @brief Return the oldest unread byte without removing it.
+ * @param dr    Ring to peek into.
+ * @param cndtr The tube's CNDTR register.
+ * @return The byte, or -1 if there is none.
+ */
+static inline int dma_ring_peek(dma_ring *dr, __io uint32 *cndtr) {
+    if (!dma_ring_count(dr, cndtr)) {
+        return -1;
+    }
+    return dr->buf[dr->tail & dr->mask];
+}
+
+/**
+ * @brief Find the longest contiguous run of unread bytes. Reader side
+ *        only.
+ *
+ * The bytes may be used in place, then released with
+ * dma_ring_commit(). Nothing stops the DMA tube, though: once it is
+ * a whole buffer past them, it overwrites them, and dma_ring_commit()
+ * reports that.
+ *
+ * @param dr    Ring to look into.
+ * @param cndtr The tube's CNDTR register.
+ * @param span  Set to the address of the first unread byte.
+ * @return Number of bytes at *span.
+ */
+static inline uint32 dma_ring_span(dma_ring *dr, __io uint32 *cndtr, uint8 **span) {
+    uint32 count = dma_ring_count(dr, cndtr);
+    uint32 end = (uint32)dr->mask + 1 - (dr->tail & dr->mask);
+
+    dr->span = dr->tail;
+    *span = (uint8*)&dr->buf[dr->tail & dr->mask];
+    return count < end ? count : end;
+}
+
+/**
+ * @brief Release bytes found with dma_ring_span(). Reader side only.
+ *
+ * If dma_ring_count() skipped ahead while the bytes were in use, the
+ * read position doesn't move further.
+ *
+ * @param dr    Ring to remove from.
+ * @param cndtr The tube's CNDTR register.
+ * @param len   Number of bytes to drop, from the start of the span.
+ * @return 1 if the bytes were still intact, 0 if the DMA tube had
+ *         overwritten some of them.
+ */
+static inline int dma_ring_commit(dma_ring *dr, __io uint32 *cndtr,
+                                  uint32 len) {
+    uint32 end = dr->span + len;
+    int intact = dma_ring_written(dr, cndtr) - dr->span <= (uint32)dr->mask + 1;
+
+    if ((int32)(end - dr->tail) > 0) {
+        dr->tail = end;
+    }
+    dr->span = dr->tail;
+    return intact;
+}
+
+/**
+ * @brief Discard all unread bytes. Reader side only.
+ * @param dr    Ring to empty.
+ * @param cndtr The tube's CNDTR register.
+ */
+static inline void dma_ring_reset(dma_ring *dr, __io uint32 *cndtr) {
+    dr->tail = dma_ring_written(dr, cndtr);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
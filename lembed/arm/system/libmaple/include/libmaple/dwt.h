@@ -0,0 +1,98 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file libmaple/include/libmaple/dwt.h
+ * @brief Data watchpoint and trace unit (DWT) cycle counter
+ *
+ * The DWT's CYCCNT register counts core clock cycles and wraps every
+ * 2^32 cycles (about 60 seconds at 72 MHz). systick_init() starts it
+ * and SysTick extends it to 64 bits (see systick_cycles()), so code
+ * sharing the counter should only take differences, never write it.
+ */
+
+#ifndef _LIBMAPLE_DWT_H_
+#define _LIBMAPLE_DWT_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <libmaple/libmaple_types.h>
+#include <libmaple/util.h>
+
+/** DWT register map type (up to the first comparator) */
+typedef struct dwt_reg_map {
+    __io uint32 CTRL;           /**< Control register */
+    __io uint32 CYCCNT;         /**< Cycle count register */
+    __io uint32 CPICNT;         /**< CPI count register */
+    __io uint32 EXCCNT;         /**< Exception overhead count register */
+    __io uint32 SLEEPCNT;       /**< Sleep count register */
+    __io uint32 LSUCNT;         /**< LSU count register */
+    __io uint32 FOLDCNT;        /**< Folded-instruction count register */
+    __io uint32 PCSR;           /**< Program counter sample register */
+} dwt_reg_map;
+
+/** DWT register map base pointer */
+#define DWT_BASE                        ((struct dwt_reg_map*)0xE0001000)
+
+/** Debug exception and monitor control register (DEMCR) */
+#define DWT_DEMCR                       (*(__io uint32*)0xE000EDFC)
+
+/*
+ * Register bit definitions.
+ */
+
+/* Control register */
+
+#define DWT_CTRL_CYCCNTENA              BIT(0)
+
+/* Debug exception and monitor control register */
+
+#define DWT_DEMCR_TRCENA                BIT(24)
+
+/**
+ * @brief Start the cycle counter, if it isn't running already.
+ *
+ * The counter keeps its current value.
+ */
+static inline void dwt_cycle_counter_enable(void) {
+    DWT_DEMCR |= DWT_DEMCR_TRCENA;
+    DWT_BASE->CTRL |= DWT_CTRL_CYCCNTENA;
+}
+
+/**
+ * @brief Returns the current value of the cycle counter.
+ */
+static inline uint32 dwt_cycles(void) {
+    return DWT_BASE->CYCCNT;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -41,6 +41,7 @@ extern "C" {
 /* Roger clark. replaced by line below #include <series/exti.h>  */      /* provides EXTI_BASE */
 #include "port/include/exti.h"
 #include <libmaple/libmaple_types.h>
+#include <libmaple/util.h>
 
 /*
  * Register map and base pointer.
@@ -108,6 +109,27 @@ typedef enum exti_trigger_mode {
     EXTI_RISING_FALLING  /**< Trigger on both the rising and falling edges */
 } exti_trigger_mode;
 
+/**
+ * @brief An external interrupt, as queued in deferred mode.
+ * @see exti_set_deferred()
+ */
+typedef struct exti_event {
+    uint32 cycles;      /**< DWT cycle count when the IRQ started */
+    exti_num num;       /**< EXTI line */
+} exti_event;
+
+/**
+ * @brief Number of events the deferred queue holds. This must be a
+ *        power of two.
+ * @see exti_set_deferred()
+ */
+#ifndef EXTI_QUEUE_SIZE
+#define EXTI_QUEUE_SIZE 64
+#endif
+#if !IS_POWER_OF_TWO(EXTI_QUEUE_SIZE)
+#error "EXTI_QUEUE_SIZE must be a power of two"
+#endif
+
 /*
  * Routines
  */
@@ -122,6 +144,12 @@ void exti_attach_callback(exti_num num,
                           void *arg,
                           exti_trigger_mode mode);
 void exti_detach_interrupt(exti_num num);
+void exti_set_deferred(exti_num num, int deferred);
+int exti_get_event(exti_event *event);
+uint32 exti_run_deferred(void);
+uint32 exti_event_count(exti_num num);
+uint32 exti_lost_count(exti_num num);
+void exti_reset_counts(exti_num num);
 
 /**
  * @brief Set the GPIO port for an EXTI line.
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * The MIT License
+ *
+ * Copyright (c) 2016 Lembed
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *****************************************************************************/
+
+/**
+ * @file libmaple/include/libmaple/host_sim.h
+ * @brief Simulated STM32F1 peripherals for host (Linux) builds
+ *
+ * When libmaple is built with LIBMAPLE_HOST defined (see
+ * variants/host/Makefile), the peripheral and system control address
+ * ranges are backed by ordinary memory mapped at the same addresses,
+ * so the register map pointers (USART1_BASE, SYSTICK_BASE, ...) work
+ * unchanged. The pages are kept inaccessible; every register access
+ * traps, is single-stepped, and gives the peripheral models a chance
+ * to react: SysTick and the DWT cycle counter follow the host's
+ * monotonic clock, USART data registers are connected to file
+ * descriptors, GPIO outputs can be traced, timer events are raised
+ * by hand, external interrupts come from writes to EXTI SWIER, and
+ * clock "ready" flags come up as soon as the clock is turned on.
+ * Bit-band accesses are forwarded to the register they alias.
+ *
+ * Interrupt handlers run from a 1 kHz timer signal and after register
+ * accesses, one at a time, whenever PRIMASK (host_primask) is clear.
+ * They run inside the signal handlers, on top of whatever the program
+ * was doing, libc calls included. So a handler, and any callback it
+ * runs, may only use async-signal-safe calls (signal-safety(7)), such
+ * as write(2): no stdio (printf(), puts(), fflush()), no heap
+ * (malloc(), new, growing a String), and no exit(). Most of these
+ * aren't safe in a handler on the chip either. A system reset
+ * (SCB AIRCR SYSRESETREQ) ends the program without flushing stdio.
+ *
+ * The models are configured from the environment when
+ * host_sim_init() runs:
+ *
+ * - HOST_USART1 .. HOST_UART5: where the port's TX and RX go. One of
+ *   "stdio" (stdout and stdin; the default for USART1), "loop" (TX
+ *   feeds back into RX), "pty" (a new pseudo-terminal, whose name is
+ *   printed on stderr), "null" (the default for the others), or a path
+ *   to open, e.g. a FIFO.
+ * - HOST_TRACE: comma-separated list of things to log on stderr;
+ *   "gpio" logs GPIO output changes, "irq" logs interrupt handlers.
+ *
+ * Register accesses cost a couple of signals each, so time spent on
+ * them is not representative of the hardware; code that doesn't touch
+ * peripherals runs at full speed. DMA is not simulated.
+ */
+
+#ifndef _LIBMAPLE_HOST_SIM_H_
+#define _LIBMAPLE_HOST_SIM_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <libmaple/libmaple_types.h>
+
+/** Nonzero while interrupts are disabled (PRIMASK). */
+extern volatile uint32 host_primask;
+/** Exception number being handled (IPSR), or 0. */
+extern volatile uint32 host_ipsr;
+
+/**
+ * @brief Map the simulated peripherals and start the clock.
+ *
+ * Must run before anything touches a peripheral register; the host
+ * board's init() calls it first thing. Calling it again does nothing.
+ */
+void host_sim_init(void);
+
+/** @brief Enable interrupts, running any that are pending. */
+void host_irq_enable(void);
+
+/** @brief Disable interrupts. */
+static inline void host_irq_disable(void) {
+    host_primask = 1;
+    __asm__ __volatile__("" : : : "memory");
+}
+
+/**
+ * @brief Busy-wait the given number of microseconds.
+ *
+ * Interrupts keep running while we wait, as they would on the chip.
+ */
+void host_delay_us(uint32 us);
+
+/** @brief CPU cycles (at F_CPU) since host_sim_init(). */
+uint64 host_sim_cycles(void);
+
+/**
+ * @brief Drive a GPIO input.
+ * @param port  GPIO port base address, e.g. GPIOA_BASE.
+ * @param bit   Pin number within the port.
+ * @param level 0 or 1 to drive the pin, or -1 to let IDR follow ODR
+ *              again (the default).
+ */
+void host_gpio_input(void *port, uint8 bit, int level);
+
+/**
+ * @brief Set what the next conversions on an ADC channel return.
+ * @param adc     ADC base address, e.g. ADC1_BASE.
+ * @param channel Channel number.
+ * @param value   12-bit conversion result.
+ */
+void host_adc_input(void *adc, uint8 channel, uint16 value);
+
+/**
+ * @brief Capture a value on a timer channel.
+ *
+ * Sets CCRx and CCxIF, and CCxOF if CCxIF was still set. Timer
+ * counters don't run in the simulation; this stands in for an edge.
+ *
+ * @param timer   Timer base address, e.g. TIMER1_BASE.
+ * @param channel Channel, 1 to 4.
+ * @param value   Counter value to capture.
+ */
+void host_timer_capture(void *timer, uint8 channel, uint16 value);
+
+/**
+ * @brief Raise a timer's update event (UIF), as on a counter overflow.
+ * @param timer Timer base address, e.g. TIMER1_BASE.
+ */
+void host_timer_update(void *timer);
+
+/** Number of register accesses the simulation has trapped. */
+extern volatile uint64 host_sim_traps;
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
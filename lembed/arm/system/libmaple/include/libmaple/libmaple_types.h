@@ -57,6 +57,16 @@ typedef void (*voidArgumentFuncPtr)(void *);
 #define __packed __attribute__((__packed__))
 #define __deprecated __attribute__((__deprecated__))
 #define __weak __attribute__((weak))
+#ifdef LIBMAPLE_HOST
+/* The host C library's __always_inline already includes "inline",
+ * which libmaple spells out itself. Its only other user gets the
+ * keyword back here. */
+#include <sys/cdefs.h>
+#undef __always_inline
+#undef __extern_always_inline
+#define __extern_always_inline \
+    extern __inline __attribute__((__always_inline__, __gnu_inline__))
+#endif
 #ifndef __always_inline
 #define __always_inline __attribute__((always_inline))
 #endif
@@ -52,6 +52,9 @@ extern "C" {
 
 #include <libmaple/libmaple_types.h>
 #include <libmaple/util.h>
+#ifdef LIBMAPLE_HOST
+#include <libmaple/host_sim.h>
+#endif
 
 /** NVIC register map type. */
 typedef struct nvic_reg_map {
@@ -111,7 +114,11 @@ void nvic_sys_reset();
  */
 static inline __always_inline void nvic_globalirq_enable()
 {
+#ifdef LIBMAPLE_HOST
+    host_irq_enable();
+#else
     asm volatile("cpsie i");
+#endif
 }
 
 /**
@@ -119,7 +126,43 @@ static inline __always_inline void nvic_globalirq_enable()
  */
 static inline __always_inline void nvic_globalirq_disable()
 {
+#ifdef LIBMAPLE_HOST
+    host_irq_disable();
+#else
     asm volatile("cpsid i");
+#endif
+}
+
+/**
+ * @brief Returns nonzero if interrupts are disabled (PRIMASK is set).
+ *
+ * Use it to put the interrupt state back after a section that called
+ * nvic_globalirq_disable().
+ */
+static inline __always_inline uint32 nvic_globalirq_masked()
+{
+#ifdef LIBMAPLE_HOST
+    return host_primask;
+#else
+    uint32 primask;
+    asm volatile("mrs %0, primask" : "=r" (primask));
+    return primask & 1;
+#endif
+}
+
+/**
+ * @brief Returns the number of the exception being handled (IPSR),
+ *        or 0 when not in an exception handler.
+ */
+static inline __always_inline uint32 nvic_active_exception()
+{
+#ifdef LIBMAPLE_HOST
+    return host_ipsr;
+#else
+    uint32 ipsr;
+    asm volatile("mrs %0, ipsr" : "=r" (ipsr));
+    return ipsr & 0x1FF;
+#endif
 }
 
 /**
@@ -26,10 +26,17 @@
 
 /**
  * @file libmaple/include/libmaple/ring_buffer.h
- * @brief Simple circular buffer
+ * @brief Lock-free single-producer, single-consumer circular buffer
  *
- * This implementation is not thread-safe.  In particular, none of
- * these functions is guaranteed re-entrant.
+ * One producer (e.g. an interrupt handler) and one consumer (e.g. the
+ * main loop) may use the same ring buffer concurrently without
+ * masking interrupts, provided the producer only calls the insert
+ * and write functions and the consumer only calls the remove, read,
+ * peek and reset functions. rb_push_insert() is the exception: it
+ * removes on the producer's side, so a concurrent consumer may lose
+ * a byte. Apart from that, none of these functions is re-entrant.
+ *
+ * The buffer size must be a power of two, up to 32768.
  */
 
 #ifndef _LIBMAPLE_RING_BUFFER_H_
@@ -40,21 +47,36 @@ extern "C"{
 #endif
 
 #include <libmaple/libmaple_types.h>
+#include <string.h>
+
+/*
+ * Each side must finish with the buffer memory before it publishes
+ * its new index. On the (single-core) STM32, interrupt handlers see
+ * the CPU's memory accesses in program order, so stopping the
+ * compiler from reordering them is enough. Elsewhere (host tests),
+ * use a full barrier.
+ */
+#ifdef __arm__
+#define rb_barrier() __asm__ __volatile__("" : : : "memory")
+#else
+#define rb_barrier() __sync_synchronize()
+#endif
 
 /**
  * Ring buffer type.
  *
- * The buffer is empty when head == tail.
- *
- * The buffer is full when the head is one byte in front of the tail,
- * modulo buffer length.
+ * head and tail count the items ever removed and inserted, modulo
+ * 2^16, so the buffer is empty when head == tail and full when
+ * tail - head is the buffer size. Every slot is usable. An item's
+ * index into buf is its count, masked with mask.
  *
- * One byte is left free to distinguish empty from full. */
+ * Only the consumer writes head, and only the producer writes tail.
+ */
 typedef struct ring_buffer {
-    volatile uint8 *buf; /**< Buffer items are stored into */
-    uint16 head;         /**< Index of the next item to remove */
-    uint16 tail;         /**< Index where the next item will get inserted */
-    uint16 size;         /**< Buffer capacity minus one */
+    volatile uint8 *buf;   /**< Buffer items are stored into */
+    volatile uint16 head;  /**< Number of items removed */
+    volatile uint16 tail;  /**< Number of items inserted */
+    uint16 mask;           /**< Buffer size minus one */
 } ring_buffer;
 
 /**
@@ -62,31 +84,40 @@ typedef struct ring_buffer {
  *
  *  @param rb   Instance to initialise
  *
- *  @param size Number of items in buf.  The ring buffer will always
- *              leave one element unoccupied, so the maximum number of
- *              elements it can store will be size - 1.  Thus, size
- *              must be at least 2.
+ *  @param size Number of items in buf. This must be a power of two,
+ *              at most 32768; the ring buffer can hold size items.
  *
  *  @param buf  Buffer to store items into
  */
 static inline void rb_init(ring_buffer *rb, uint16 size, uint8 *buf) {
     rb->head = 0;
     rb->tail = 0;
-    rb->size = size - 1;
+    rb->mask = size - 1;
     rb->buf = buf;
 }
 
+/**
+ * @brief Return the number of items a ring buffer can hold.
+ * @param rb Buffer whose capacity to return.
+ */
+static inline uint16 rb_capacity(ring_buffer *rb) {
+    return rb->mask + 1;
+}
+
 /**
  * @brief Return the number of elements stored in the ring buffer.
  * @param rb Buffer whose elements to count.
  */
 static inline uint16 rb_full_count(ring_buffer *rb) {
-    __io ring_buffer *arb = rb;
-    int32 size = arb->tail - arb->head;
-    if (arb->tail < arb->head) {
-        size += arb->size + 1;
-    }
-    return (uint16)size;
+    return (uint16)(rb->tail - rb->head);
+}
+
+/**
+ * @brief Return the number of elements that can still be inserted.
+ * @param rb Buffer whose free space to count.
+ */
+static inline uint16 rb_room(ring_buffer *rb) {
+    return rb_capacity(rb) - rb_full_count(rb);
 }
 
 /**
@@ -94,8 +125,7 @@ static inline uint16 rb_full_count(ring_buffer *rb) {
  * @param rb Buffer to test.
  */
 static inline int rb_is_full(ring_buffer *rb) {
-    return (rb->tail + 1 == rb->head) ||
-        (rb->tail == rb->size && rb->head == 0);
+    return rb_full_count(rb) > rb->mask;
 }
 
 /**
@@ -108,12 +138,14 @@ static inline int rb_is_empty(ring_buffer *rb) {
 
 /**
  * Append element onto the end of a ring buffer.
- * @param rb Buffer to append onto.
+ * @param rb Buffer to append onto, must not be full.
  * @param element Value to append.
  */
 static inline void rb_insert(ring_buffer *rb, uint8 element) {
-    rb->buf[rb->tail] = element;
-    rb->tail = (rb->tail == rb->size) ? 0 : rb->tail + 1;
+    uint16 tail = rb->tail;
+    rb->buf[tail & rb->mask] = element;
+    rb_barrier();
+    rb->tail = tail + 1;
 }
 
 /**
@@ -121,8 +153,10 @@ static inline void rb_insert(ring_buffer *rb, uint8 element) {
  * @param rb Buffer to remove from, must contain at least one element.
  */
 static inline uint8 rb_remove(ring_buffer *rb) {
-    uint8 ch = rb->buf[rb->head];
-    rb->head = (rb->head == rb->size) ? 0 : rb->head + 1;
+    uint16 head = rb->head;
+    uint8 ch = rb->buf[head & rb->mask];
+    rb_barrier();
+    rb->head = head + 1;
     return ch;
 }
 
@@ -141,7 +175,7 @@ static inline int rb_peek(ring_buffer *rb)
 	}
 	else
 	{
-		return rb->buf[rb->head];
+		return rb->buf[rb->head & rb->mask];
 	}
 }
 
@@ -198,7 +232,123 @@ static inline int rb_push_insert(ring_buffer *rb, uint8 element) {
  * @param rb Ring buffer to discard all items from.
  */
 static inline void rb_reset(ring_buffer *rb) {
-    rb->tail = rb->head;
+    rb->head = rb->tail;
+}
+
+/*
+ * Bulk access
+ */
+
+/**
+ * @brief Find the longest contiguous run of items at the front of a
+ *        ring buffer. Consumer side.
+ *
+ * The items may be used in place, then released with
+ * rb_read_commit().
+ *
+ * @param rb   Buffer to look into.
+ * @param span Set to the address of the first item.
+ * @return Number of items at *span.
+ */
+static inline uint16 rb_read_span(ring_buffer *rb, uint8 **span) {
+    uint16 head = rb->head;
+    uint16 count = (uint16)(rb->tail - head);
+    uint16 end = rb_capacity(rb) - (head & rb->mask);
+
+    rb_barrier();
+    *span = (uint8*)&rb->buf[head & rb->mask];
+    return count < end ? count : end;
+}
+
+/**
+ * @brief Release items at the front of a ring buffer. Consumer side.
+ * @param rb  Buffer to remove from.
+ * @param len Number of items to drop; at most rb_full_count(rb).
+ */
+static inline void rb_read_commit(ring_buffer *rb, uint16 len) {
+    rb_barrier();
+    rb->head += len;
+}
+
+/**
+ * @brief Find the longest contiguous run of free slots at the end of
+ *        a ring buffer. Producer side.
+ *
+ * The slots may be filled in place, then published with
+ * rb_write_commit().
+ *
+ * @param rb   Buffer to look into.
+ * @param span Set to the address of the first free slot.
+ * @return Number of free slots at *span.
+ */
+static inline uint16 rb_write_span(ring_buffer *rb, uint8 **span) {
+    uint16 tail = rb->tail;
+    uint16 room = rb_capacity(rb) - (uint16)(tail - rb->head);
+    uint16 end = rb_capacity(rb) - (tail & rb->mask);
+
+    rb_barrier();
+    *span = (uint8*)&rb->buf[tail & rb->mask];
+    return room < end ? room : end;
+}
+
+/**
+ * @brief Publish items stored at the end of a ring buffer. Producer
+ *        side.
+ * @param rb  Buffer to append onto.
+ * @param len Number of items written; at most rb_room(rb).
+ */
+static inline void rb_write_commit(ring_buffer *rb, uint16 len) {
+    rb_barrier();
+    rb->tail += len;
+}
+
+/**
+ * @brief Append as many items as fit onto a ring buffer. Producer
+ *        side.
+ * @param rb  Buffer to append onto.
+ * @param buf Items to append.
+ * @param len Number of items in buf.
+ * @return Number of items appended.
+ */
+static inline uint16 rb_write(ring_buffer *rb, const uint8 *buf, uint16 len) {
+    uint16 done = 0;
+    uint8 *span;
+    uint16 n;
+
+    /* At most two passes: up to the end of buf, then from its start. */
+    while (done < len && (n = rb_write_span(rb, &span)) != 0) {
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(span, buf + done, n);
+        rb_write_commit(rb, n);
+        done += n;
+    }
+    return done;
+}
+
+/**
+ * @brief Remove up to len items from the front of a ring buffer.
+ *        Consumer side.
+ * @param rb  Buffer to remove from.
+ * @param buf Where to store the items.
+ * @param len Maximum number of items to remove.
+ * @return Number of items removed.
+ */
+static inline uint16 rb_read(ring_buffer *rb, uint8 *buf, uint16 len) {
+    uint16 done = 0;
+    uint8 *span;
+    uint16 n;
+
+    while (done < len && (n = rb_read_span(rb, &span)) != 0) {
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(buf + done, span, n);
+        rb_read_commit(rb, n);
+        done += n;
+    }
+    return done;
 }
 
 #ifdef __cplusplus
@@ -309,6 +309,8 @@ void spi_slave_enable(spi_dev *dev,
                       spi_mode mode,
                       uint32 flags);
 
+void spi_reconfigure(spi_dev *dev, uint32 cr1_config);
+
 uint32 spi_tx(spi_dev *dev, const void *buf, uint32 len);
 
 /**
@@ -38,6 +38,7 @@ extern "C"{
 
 #include <libmaple/libmaple_types.h>
 #include <libmaple/util.h>
+#include <libmaple/dwt.h>
 
 /** SysTick register map type */
 typedef struct systick_reg_map {
@@ -73,20 +74,109 @@ typedef struct systick_reg_map {
 #define SYSTICK_CVR_SKEW                BIT(30)
 #define SYSTICK_CVR_TENMS               0xFFFFFF
 
+/** Largest value the reload value register takes */
+#define SYSTICK_MAX_RELOAD              0xFFFFFF
+
+/**
+ * @brief Timebase anchor.
+ *
+ * The SysTick handler keeps the DWT cycle count at a millisecond
+ * boundary. Readers extend the 32-bit counter from there, so the
+ * timebase stays right as long as SysTick runs at least once per
+ * counter wrap; even in tickless mode it runs every 2^24 cycles.
+ *
+ * There are two copies: the handler fills in the one not in use, then
+ * bumps systick_timebase_gen to switch over, so a reader that is
+ * interrupted (or that interrupts the handler) sees a whole anchor.
+ */
+typedef struct systick_timebase {
+    uint64 cycles;              /**< Extended cycle count at the anchor */
+    uint64 millis;              /**< Milliseconds elapsed at the anchor */
+} systick_timebase;
+
+extern volatile systick_timebase systick_timebase_anchor[2];
+extern volatile uint32 systick_timebase_gen;
+extern uint32 systick_cycles_per_ms;
+extern uint32 systick_cycles_per_us;
+extern volatile uint32 systick_tickless_mode;
+
 /** System elapsed time, in milliseconds */
 extern volatile uint32 systick_uptime_millis;
 
+/*
+ * Take a consistent snapshot of the anchor. Returns the number of
+ * cycles since the anchor, and the anchor's cycle count and
+ * milliseconds in *cycles and *millis.
+ */
+static inline uint32 systick_timebase_read(uint64 *cycles, uint64 *millis) {
+    uint32 gen;
+    uint32 delta;
+
+    do {
+        const volatile systick_timebase *tb;
+        gen = systick_timebase_gen;
+        tb = &systick_timebase_anchor[gen & 1];
+        *cycles = tb->cycles;
+        *millis = tb->millis;
+        delta = dwt_cycles() - (uint32)*cycles;
+    } while (gen != systick_timebase_gen);
+    return delta;
+}
+
 /**
  * @brief Returns the system uptime, in milliseconds.
+ *
+ * Normally this is a plain load of the tick count; in tickless
+ * mode it is worked out from the cycle counter instead.
  */
 static inline uint32 systick_uptime(void) {
+    if (systick_tickless_mode) {
+        uint64 cycles, millis;
+        uint32 delta = systick_timebase_read(&cycles, &millis);
+        return (uint32)millis + delta / systick_cycles_per_ms;
+    }
     return systick_uptime_millis;
 }
 
+/**
+ * @brief Returns the number of core clock cycles since systick_init().
+ *
+ * This is the DWT cycle counter, extended to 64 bits.
+ */
+static inline uint64 systick_cycles(void) {
+    uint64 cycles, millis;
+    uint32 delta = systick_timebase_read(&cycles, &millis);
+    return cycles + delta;
+}
+
+/**
+ * @brief Returns the system uptime, in microseconds.
+ */
+static inline uint64 systick_uptime_micros(void) {
+    uint64 cycles, millis;
+    uint32 delta = systick_timebase_read(&cycles, &millis);
+    return millis * 1000 + delta / systick_cycles_per_us;
+}
+
+/**
+ * @brief Returns the system uptime, in nanoseconds.
+ *
+ * The resolution is one core clock cycle.
+ */
+static inline uint64 systick_uptime_nanos(void) {
+    uint64 cycles, millis;
+    uint32 delta = systick_timebase_read(&cycles, &millis);
+    uint32 us = delta / systick_cycles_per_us;
+    uint32 rem = delta - us * systick_cycles_per_us;
+    return (millis * 1000 + us) * 1000 + rem * 1000 / systick_cycles_per_us;
+}
 
 void systick_init(uint32 reload_val);
 void systick_disable();
 void systick_enable();
+void systick_set_tickless(uint32 enable);
+void systick_schedule(uint64 deadline);
+void systick_attach_callback(void (*callback)(void));
 
 /**
  * @brief Returns the current value of the SysTick counter.
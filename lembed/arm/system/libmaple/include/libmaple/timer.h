@@ -43,6 +43,7 @@ extern "C" {
 #include <libmaple/rcc.h>
 #include <libmaple/nvic.h>
 #include <libmaple/bitband.h>
+#include <libmaple/dma.h>
 
 /*
  * Register maps
@@ -127,6 +128,8 @@ typedef struct timer_dev {
     timer_reg_map regs;         /**< Register map */
     rcc_clk_id clk_id;          /**< RCC clock information */
     timer_type type;            /**< Timer's type */
+    struct timer_capture *capture; /**< Active input captures; see
+                                      timer_capture_start() */
     voidFuncPtr handlers[];     /**<
                                  * Don't touch these. Use these instead:
                                  * @see timer_attach_interrupt()
@@ -564,8 +567,12 @@ typedef enum timer_mode {
      * values, the corresponding interrupt is fired. */
     TIMER_OUTPUT_COMPARE,
 
-    /* TIMER_INPUT_CAPTURE, TODO: In this mode, the timer can measure the
-     *                            pulse lengths of input signals */
+    /**
+     * The channel's compare register latches the counter on each
+     * rising edge of its input, and the channel interrupt fires.
+     * @see timer_capture_start() */
+    TIMER_INPUT_CAPTURE,
+
     /* TIMER_ONE_PULSE, TODO: In this mode, the timer can generate a single
      *                        pulse on a GPIO pin for a specified amount of
      *                        time. */
@@ -1079,6 +1086,100 @@ static inline void timer_oc_set_mode(timer_dev *dev,
     *ccmr = tmp;
 }
 
+/*
+ * Input capture
+ */
+
+/**
+ * @brief Pulse measurement on a timer input channel.
+ *
+ * The channel captures the counter on alternate rising and falling
+ * edges, and its interrupt turns consecutive captures into the length
+ * of the last high pulse, low pulse and period. The timer's update
+ * interrupt extends the counter to 32 bits, so pulses may span many
+ * counter overflows; the prescaler and reload value are left alone,
+ * and the timer's other channels can keep generating PWM. Results are
+ * in timer ticks: PSC + 1 timer clock cycles each.
+ *
+ * Any number of a timer's channels can capture at once. A capture
+ * that misses an edge (the input changed faster than the interrupt
+ * could follow) drops the measurement that edge belonged to.
+ *
+ * With buf set, the channel instead captures only rising edges, or
+ * falling edges if level is 1, and DMA stores the raw 16-bit counter
+ * values in buf, wrapping around at the end. No interrupts are used;
+ * differences between consecutive entries, modulo the reload value
+ * plus one, give the periods. See timer_capture_dma_pos().
+ *
+ * Fill in the fields up to buf_size and call timer_capture_start().
+ * The structure must stay valid until timer_capture_stop().
+ *
+ * Availability: timers of type TIMER_ADVANCED and TIMER_GENERAL. DMA
+ * mode: channels with a DMA request (not TIM3_CH2, TIM4_CH4, TIM8).
+ */
+typedef struct timer_capture {
+    timer_dev *dev;             /**< Timer */
+    uint8 channel;              /**< Channel, 1 to 4 */
+    uint8 level;                /**< Current input level, if known (0
+                                   or 1); saves waiting for an edge */
+    uint8 filter;               /**< Input filter, 0 to 15 (ICxF) */
+    volatile uint16 *buf;       /**< DMA buffer for raw captures, or NULL */
+    uint16 buf_size;            /**< Captures buf can hold */
+
+    /* Results, in timer ticks. nr_high and nr_low count the
+     * measurements; each new one overwrites the last. */
+    volatile uint32 high;       /**< Length of the last high pulse */
+    volatile uint32 low;        /**< Length of the last low pulse */
+    volatile uint32 period;     /**< Time between the last two rising edges */
+    volatile uint32 nr_high;    /**< High pulses measured */
+    volatile uint32 nr_low;     /**< Low pulses measured */
+
+    /* Private */
+    struct timer_capture *next;
+    uint32 base;                /* Extended count at the last update */
+    uint32 rise;                /* Extended count at the last rising edge */
+    uint32 fall;                /* ... and falling edge */
+    volatile uint8 state;       /* TIMER_CAPTURE_* flags */
+    dma_dev *dma;
+    dma_tube tube;
+} timer_capture;
+
+/* timer_capture.state */
+#define TIMER_CAPTURE_HIGH              BIT(0) /* Last edge was rising */
+#define TIMER_CAPTURE_HAVE_RISE         BIT(1)
+#define TIMER_CAPTURE_HAVE_FALL         BIT(2)
+
+int timer_capture_start(timer_capture *cap);
+void timer_capture_stop(timer_capture *cap);
+timer_capture* timer_capture_find(timer_dev *dev, uint8 channel);
+
+/**
+ * @brief Input level after the last edge a capture saw.
+ * @param cap Capture, in interrupt mode.
+ * @return 1 after a rising edge, 0 after a falling edge.
+ */
+static inline uint8 timer_capture_level(timer_capture *cap) {
+    return cap->state & TIMER_CAPTURE_HIGH;
+}
+
+/**
+ * @brief Index in buf of the next capture in DMA mode.
+ * @param cap Capture, in DMA mode.
+ */
+static inline uint16 timer_capture_dma_pos(timer_capture *cap) {
+    uint16 left = dma_tube_regs(cap->dma, cap->tube)->CNDTR;
+    return cap->buf_size - left;
+}
+
+/*
+ * Compare value streaming
+ */
+
+int timer_dma_stream_start(timer_dev *dev, uint8 channel, uint8 nr_channels,
+                           const uint16 *buf, uint16 len, int circular);
+void timer_dma_stream_stop(timer_dev *dev);
+uint16 timer_dma_stream_left(timer_dev *dev);
+
 /*
  * Old, erroneous bit definitions from previous releases, kept for
  * backwards compatibility:
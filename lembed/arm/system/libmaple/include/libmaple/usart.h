@@ -43,6 +43,8 @@ extern "C" {
 #include <libmaple/rcc.h>
 #include <libmaple/nvic.h>
 #include <libmaple/ring_buffer.h>
+#include <libmaple/dma.h>
+#include <libmaple/dma_ring.h>
 
 /* Roger clark. Replaced with line below #include <series/usart.h>*/
 #include "port/include/usart.h"
@@ -377,22 +379,71 @@ typedef struct usart_reg_map {
  * Devices
  */
 
+/*
+ * Buffer sizes. These must be powers of two, at most 32768 (see
+ * ring_buffer). USART_RX_BUF_SIZE and
+ * USART_TX_BUF_SIZE set the default for every port; USARTn_RX_BUF_SIZE
+ * etc. override it for a single port.
+ */
+
 #ifndef USART_RX_BUF_SIZE
 #define USART_RX_BUF_SIZE               64
 #endif
 
+#ifndef USART_TX_BUF_SIZE
+#define USART_TX_BUF_SIZE               64
+#endif
+
+#if !IS_POWER_OF_TWO(USART_RX_BUF_SIZE) || USART_RX_BUF_SIZE > 32768
+#error "USART_RX_BUF_SIZE must be a power of two, at most 32768"
+#endif
+#if !IS_POWER_OF_TWO(USART_TX_BUF_SIZE) || USART_TX_BUF_SIZE > 32768
+#error "USART_TX_BUF_SIZE must be a power of two, at most 32768"
+#endif
+
+/** Events reported to a USART's DMA event handler. */
+typedef enum usart_dma_event {
+    USART_DMA_RX_HALF,          /**< RX buffer's first half was filled */
+    USART_DMA_RX_FULL,          /**< RX buffer's second half was filled */
+    USART_DMA_RX_IDLE,          /**< RX line went idle after a frame */
+    USART_DMA_TX_DONE,          /**< TX block finished */
+} usart_dma_event;
+
+/**
+ * @brief USART DMA state.
+ * @see usart_dma_rx_enable()
+ * @see usart_dma_tx_enable()
+ */
+typedef struct usart_dma {
+    dma_dev *dma_dev;               /**< DMA controller serving the USART */
+    dma_tube rx_tube;               /**< RX tube */
+    enum dma_request_src rx_req;    /**< RX request source */
+    dma_tube tx_tube;               /**< TX tube */
+    enum dma_request_src tx_req;    /**< TX request source */
+    dma_ring rx;                    /**< Circular RX buffer */
+    __io uint32 *rx_cndtr;          /**< RX tube's CNDTR register */
+    volatile uint16 tx_len;         /**< TX block in flight, 0 if idle */
+    uint8 rx_on;                    /**< Nonzero if RX goes through DMA */
+    uint8 tx_on;                    /**< Nonzero if TX goes through DMA */
+    void (*handler)(usart_dma_event); /**< User event handler, or NULL */
+    voidFuncPtr rx_isr;             /**< For internal use */
+    voidFuncPtr tx_isr;             /**< For internal use */
+} usart_dma;
+
 /** USART device type */
 typedef struct usart_dev {
   usart_reg_map *regs;             /**< Register map */
   ring_buffer *rb;                 /**< RX ring buffer */
   uint32 max_baud;                 /**< @brief Deprecated.
                                       * Maximum baud rate. */
-  uint8 rx_buf[USART_RX_BUF_SIZE]; /**< @brief Deprecated.
-                                      * Actual RX buffer used by rb.
-                                      * This field will be removed in
-                                      * a future release. */
   rcc_clk_id clk_id;               /**< RCC clock information */
   nvic_irq_num irq_num;            /**< USART NVIC interrupt */
+  ring_buffer *wb;                 /**< TX ring buffer, drained by the
+                                      * TXE interrupt */
+  usart_dma *dma;                  /**< DMA state, or NULL if the USART
+                                      * has no DMA requests */
+  volatile uint8 rx_held;          /**< Nonzero while usart_rx_span()'s
+                                      * bytes are in use; see there */
 } usart_dev;
 
 void usart_init(usart_dev *dev);
@@ -421,8 +472,26 @@ void usart_disable(usart_dev *dev);
 void usart_foreach(void (*fn)(usart_dev *dev));
 uint32 usart_tx(usart_dev *dev, const uint8 *buf, uint32 len);
 uint32 usart_rx(usart_dev *dev, uint8 *buf, uint32 len);
+void usart_tx_flush(usart_dev *dev);
 void usart_putudec(usart_dev *dev, uint32 val);
 
+int usart_dma_rx_enable(usart_dev *dev, uint8 *buf, uint16 size);
+void usart_dma_rx_disable(usart_dev *dev);
+int usart_dma_tx_enable(usart_dev *dev);
+void usart_dma_tx_disable(usart_dev *dev);
+void usart_dma_attach_handler(usart_dev *dev,
+                              void (*handler)(usart_dma_event));
+
+/**
+ * @brief Check whether a serial port receives through DMA.
+ * @param dev Serial port to check
+ * @see usart_dma_rx_enable()
+ */
+static inline int usart_dma_rx_on(usart_dev *dev)
+{
+  return dev->dma && dev->dma->rx_on;
+}
+
 /**
  * @brief Disable all serial ports.
  */
@@ -434,8 +503,8 @@ static inline void usart_disable_all(void)
 /**
  * @brief Transmit one character on a serial port.
  *
- * This function blocks until the character has been successfully
- * transmitted.
+ * This function blocks until the character has been queued for
+ * transmission.
  *
  * @param dev Serial port to send on.
  * @param byte Byte to transmit.
@@ -449,7 +518,8 @@ static inline void usart_putc(usart_dev* dev, uint8 byte)
 /**
  * @brief Transmit a character string on a serial port.
  *
- * This function blocks until str is completely transmitted.
+ * This function blocks until str is completely queued for
+ * transmission.
  *
  * @param dev Serial port to send on
  * @param str String to send
@@ -474,6 +544,10 @@ static inline void usart_putstr(usart_dev *dev, const char* str)
  */
 static inline uint8 usart_getc(usart_dev *dev)
 {
+  if (usart_dma_rx_on(dev)) {
+    return dma_ring_remove(&dev->dma->rx);
+  }
+  dev->rx_held = 0;
   return rb_remove(dev->rb);
 }
 
@@ -485,6 +559,9 @@ static inline uint8 usart_getc(usart_dev *dev)
  */
 static inline int usart_peek(usart_dev *dev)
 {
+  if (usart_dma_rx_on(dev)) {
+    return dma_ring_peek(&dev->dma->rx, dev->dma->rx_cndtr);
+  }
   return rb_peek(dev->rb);
 }
 
@@ -496,15 +573,89 @@ static inline int usart_peek(usart_dev *dev)
  */
 static inline uint32 usart_data_available(usart_dev *dev)
 {
+  if (usart_dma_rx_on(dev)) {
+    return dma_ring_count(&dev->dma->rx, dev->dma->rx_cndtr);
+  }
   return rb_full_count(dev->rb);
 }
 
+/**
+ * @brief Find the longest contiguous run of received bytes.
+ *
+ * The bytes may be used in place, then released with
+ * usart_rx_commit(). Until then, the RX interrupt keeps its hands off
+ * them: when the buffer is full, it drops new bytes instead of
+ * pushing the oldest ones out. Reading with usart_getc() or
+ * usart_rx() gives the span up as well. Circular DMA can't be held back that
+ * way; if it gets a whole buffer ahead, usart_rx_commit() says so.
+ *
+ * @param dev  Serial port to look into
+ * @param span Set to the address of the first received byte
+ * @return Number of bytes at *span.
+ */
+static inline uint32 usart_rx_span(usart_dev *dev, uint8 **span)
+{
+  if (usart_dma_rx_on(dev)) {
+    return dma_ring_span(&dev->dma->rx, dev->dma->rx_cndtr, span);
+  }
+  uint32 n;
+
+  /* Hold before looking, so the span can't start at an evicted byte,
+   * but don't hold an empty span that may never be committed */
+  dev->rx_held = 1;
+  n = rb_read_span(dev->rb, span);
+  if (!n) {
+    dev->rx_held = 0;
+  }
+  return n;
+}
+
+/**
+ * @brief Release received bytes found with usart_rx_span().
+ * @param dev Serial port to remove from
+ * @param len Number of bytes to drop
+ * @return 1 if the bytes were intact until now, 0 if RX DMA had
+ *         overwritten some of them.
+ */
+static inline int usart_rx_commit(usart_dev *dev, uint32 len)
+{
+  if (usart_dma_rx_on(dev)) {
+    return dma_ring_commit(&dev->dma->rx, dev->dma->rx_cndtr, len);
+  }
+  rb_read_commit(dev->rb, (uint16)len);
+  dev->rx_held = 0;
+  return 1;
+}
+
+/**
+ * @brief Return the number of bytes waiting in a serial port's TX buffer.
+ * @param dev Serial port to check
+ * @return Number of bytes queued but not yet written to DR.
+ */
+static inline uint32 usart_tx_pending(usart_dev *dev)
+{
+  return rb_full_count(dev->wb);
+}
+
+/**
+ * @brief Return the free space in a serial port's TX buffer.
+ * @param dev Serial port to check
+ * @return Number of bytes usart_tx() can queue without blocking.
+ */
+static inline uint32 usart_tx_room(usart_dev *dev)
+{
+  return rb_room(dev->wb);
+}
+
 /**
  * @brief Discard the contents of a serial port's RX buffer.
  * @param dev Serial port whose buffer to empty.
  */
 static inline void usart_reset_rx(usart_dev *dev)
 {
+  if (usart_dma_rx_on(dev)) {
+    dma_ring_reset(&dev->dma->rx, dev->dma->rx_cndtr);
+  }
   rb_reset(dev->rb);
 }
 
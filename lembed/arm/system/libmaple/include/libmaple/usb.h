@@ -153,6 +153,8 @@ typedef struct usblib_dev {
     usb_dev_state state;
     usb_dev_state prevState;
     rcc_clk_id clk_id;
+    void (*sof_hook)(void);     /* Called on every start of frame, if
+                                 * USB_ISR_MSK includes SOF */
 } usblib_dev;
 
 extern usblib_dev *USBLIB;
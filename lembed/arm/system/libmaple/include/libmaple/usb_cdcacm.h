@@ -37,6 +37,7 @@
 #include <libmaple/libmaple_types.h>
 #include <libmaple/gpio.h>
 #include <libmaple/usb.h>
+#include <libmaple/util.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -93,6 +94,20 @@ extern "C" {
 #define USB_CDCACM_RX_ADDR              0x110
 #define USB_CDCACM_RX_EPSIZE            0x40
 
+/* Second TX packet buffer, used if USB_CDCACM_TX_DBL_BUF is defined.
+ * The endpoint then alternates between the two buffers, so the next
+ * packet can be loaded while the previous one goes out. */
+#define USB_CDCACM_TX_ADDR1             0x150
+
+/* Bytes queued by usb_cdcacm_tx(); must be a power of two, at most
+ * 32768 (see ring_buffer). */
+#ifndef USB_CDCACM_TX_BUF_SIZE
+#define USB_CDCACM_TX_BUF_SIZE          512
+#endif
+#if !IS_POWER_OF_TWO(USB_CDCACM_TX_BUF_SIZE) || USB_CDCACM_TX_BUF_SIZE > 32768
+#error "USB_CDCACM_TX_BUF_SIZE must be a power of two, at most 32768"
+#endif
+
 #ifndef __cplusplus
 #define USB_CDCACM_DECLARE_DEV_DESC(vid, pid)                           \
   {                                                                     \
@@ -125,9 +140,12 @@ uint32 usb_cdcacm_tx(const uint8* buf, uint32 len);
 uint32 usb_cdcacm_rx(uint8* buf, uint32 len);
 uint32 usb_cdcacm_peek(uint8* buf, uint32 len);
 uint32 usb_cdcacm_peek_ex(uint8* buf, uint32 offset, uint32 len);
+uint32 usb_cdcacm_rx_span(uint8** span);   /* unread bytes, in place */
+void   usb_cdcacm_rx_commit(uint32 len);   /* release them */
 
 uint32 usb_cdcacm_data_available(void); /* in RX buffer */
-uint16 usb_cdcacm_get_pending(void);
+uint16 usb_cdcacm_get_pending(void);    /* queued or in flight */
+uint32 usb_cdcacm_tx_room(void);        /* free space in TX buffer */
 uint8 usb_cdcacm_is_transmitting(void);
 
 uint8 usb_cdcacm_get_dtr(void);
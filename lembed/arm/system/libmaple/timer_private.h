@@ -100,10 +100,15 @@
  *
  * These decode TIMx_DIER and TIMx_SR, then dispatch to the user-level
  * IRQ handlers. They also clean up TIMx_SR afterwards, so the user
- * doesn't have to deal with register details.
+ * doesn't have to deal with register details. Input captures (see
+ * timer_capture_start()) get the first look, in _timer_capture_irq().
  *
  * Notes:
  *
+ * - TIMx_SR flags are cleared by writing 0 and unaffected by writing 1,
+ *   so the routines write the complement of what they handled rather
+ *   than read-modify-write, which could lose a flag set in between.
+ *
  * - These dispatch routines make use of the fact that DIER interrupt
  *   enable bits and SR interrupt flags have common bit positions.
  *   Thus, ANDing DIER and SR lets us check if an interrupt is enabled
@@ -113,6 +118,11 @@
  *   there aren't any measurements to prove that this is actually a
  *   good idea.  Profile-directed optimizations are definitely wanted. */
 
+/* update is nonzero on the vector that owns the update event: on
+ * advanced timers, both the UP and CC vectors see UIF, but only the
+ * UP vector counts the overflow. */
+void _timer_capture_irq(timer_dev *dev, int update);
+
 /* A special-case dispatch routine for timers which only serve a
  * single interrupt on a given IRQ line.
  *
@@ -129,7 +139,7 @@ static inline __always_inline void dispatch_single_irq(timer_dev *dev,
         void (*handler)(void) = dev->handlers[iid];
         if (handler) {
             handler();
-            regs->SR &= ~irq_mask;
+            regs->SR = ~irq_mask;
         }
     }
 }
@@ -150,6 +160,9 @@ static inline __always_inline void dispatch_adv_brk(timer_dev *dev) {
 }
 
 static inline __always_inline void dispatch_adv_up(timer_dev *dev) {
+    if (dev->capture) {
+        _timer_capture_irq(dev, 1);
+    }
     dispatch_single_irq(dev, TIMER_UPDATE_INTERRUPT, TIMER_SR_UIF);
 }
 
@@ -165,12 +178,17 @@ static inline __always_inline void dispatch_adv_trg_com(timer_dev *dev) {
     handle_irq(dsr, TIMER_SR_TIF,   hs, TIMER_TRG_INTERRUPT, handled);
     handle_irq(dsr, TIMER_SR_COMIF, hs, TIMER_COM_INTERRUPT, handled);
 
-    regs->SR &= ~handled;
+    regs->SR = ~handled;
 }
 
 static inline __always_inline void dispatch_adv_cc(timer_dev *dev) {
     timer_adv_reg_map *regs = (dev->regs).adv;
-    uint32 dsr = regs->DIER & regs->SR;
+    uint32 dsr;
+
+    if (dev->capture) {
+        _timer_capture_irq(dev, 0);
+    }
+    dsr = regs->DIER & regs->SR;
     void (**hs)(void) = dev->handlers;
     uint32 handled = 0;
 
@@ -179,12 +197,17 @@ static inline __always_inline void dispatch_adv_cc(timer_dev *dev) {
     handle_irq(dsr, TIMER_SR_CC2IF, hs, TIMER_CC2_INTERRUPT, handled);
     handle_irq(dsr, TIMER_SR_CC1IF, hs, TIMER_CC1_INTERRUPT, handled);
 
-    regs->SR &= ~handled;
+    regs->SR = ~handled;
 }
 
 static inline __always_inline void dispatch_general(timer_dev *dev) {
     timer_gen_reg_map *regs = (dev->regs).gen;
-    uint32 dsr = regs->DIER & regs->SR;
+    uint32 dsr;
+
+    if (dev->capture) {
+        _timer_capture_irq(dev, 1);
+    }
+    dsr = regs->DIER & regs->SR;
     void (**hs)(void) = dev->handlers;
     uint32 handled = 0;
 
@@ -195,7 +218,7 @@ static inline __always_inline void dispatch_general(timer_dev *dev) {
     handle_irq(dsr, TIMER_SR_CC1IF, hs, TIMER_CC1_INTERRUPT,    handled);
     handle_irq(dsr, TIMER_SR_UIF,   hs, TIMER_UPDATE_INTERRUPT, handled);
 
-    regs->SR &= ~handled;
+    regs->SR = ~handled;
 }
 
 /* On F1 (XL-density), F2, and F4, TIM9 and TIM12 are restricted
@@ -211,7 +234,7 @@ static inline __always_inline void dispatch_tim_9_12(timer_dev *dev) {
     handle_irq(dsr, TIMER_SR_CC1IF, hs, TIMER_CC1_INTERRUPT,    handled);
     handle_irq(dsr, TIMER_SR_UIF,   hs, TIMER_UPDATE_INTERRUPT, handled);
 
-    regs->SR &= ~handled;
+    regs->SR = ~handled;
 }
 
 /* On F1 (XL-density), F2, and F4, timers 10, 11, 13, and 14 are
@@ -225,7 +248,7 @@ static inline __always_inline void dispatch_tim_10_11_13_14(timer_dev *dev) {
     handle_irq(dsr, TIMER_SR_CC1IF, hs, TIMER_CC1_INTERRUPT,    handled);
     handle_irq(dsr, TIMER_SR_UIF,   hs, TIMER_UPDATE_INTERRUPT, handled);
 
-    regs->SR &= ~handled;
+    regs->SR = ~handled;
 }
 
 static inline __always_inline void dispatch_basic(timer_dev *dev) {
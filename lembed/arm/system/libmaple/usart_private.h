@@ -36,23 +36,61 @@
 
 #include <libmaple/ring_buffer.h>
 #include <libmaple/usart.h>
+#include <libmaple/bitband.h>
 
-static inline __always_inline void usart_irq(ring_buffer *rb, usart_reg_map *regs) {
-    /* We can get RXNE and ORE interrupts here. Only RXNE signifies
-     * availability of a byte in DR.
+void _usart_dma_rx_idle(usart_dma *dma);
+
+static inline __always_inline void usart_irq(usart_dev *dev,
+                                             ring_buffer *rb, ring_buffer *wb,
+                                             usart_dma *dma,
+                                             usart_reg_map *regs) {
+    uint32 sr = regs->SR;
+    uint32 cr1 = regs->CR1;
+
+    /* We can get RXNE, IDLE, TXE and ORE interrupts here. Only RXNE
+     * signifies availability of a byte in DR.
      *
      * See table 198 (sec 27.4, p809) in STM document RM0008 rev 15.
-     * We enable RXNEIE. */
-    if (regs->SR & USART_SR_RXNE) {
+     * We enable RXNEIE unless RX goes through DMA, in which case we
+     * enable IDLEIE instead. TXEIE is on whenever wb is nonempty.
+     *
+     * With RX DMA, RXNE is set briefly before the DMA reads DR, so
+     * leave it alone unless RXNEIE says it's ours. */
+    if ((sr & USART_SR_RXNE) && (cr1 & USART_CR1_RXNEIE)) {
 #ifdef USART_SAFE_INSERT
         /* If the buffer is full and the user defines USART_SAFE_INSERT,
          * ignore new bytes. */
         rb_safe_insert(rb, (uint8)regs->DR);
 #else
-        /* By default, push bytes around in the ring buffer. */
-        rb_push_insert(rb, (uint8)regs->DR);
+        /* By default, push bytes around in the ring buffer, unless
+         * the reader is using them in place (usart_rx_span()). */
+        if (dev->rx_held) {
+            rb_safe_insert(rb, (uint8)regs->DR);
+        } else {
+            rb_push_insert(rb, (uint8)regs->DR);
+        }
 #endif
     }
+
+    /* IDLE is cleared by reading SR, then DR. If RXNE is set, the DMA
+     * is about to read DR for us. */
+    if ((sr & USART_SR_IDLE) && (cr1 & USART_CR1_IDLEIE)) {
+        if (!(sr & USART_SR_RXNE)) {
+            (void)regs->DR;
+        }
+        _usart_dma_rx_idle(dma);
+    }
+
+    /* TXE stays set as long as DR is empty, so only act on it while
+     * TXEIE is on. Once wb runs dry, turn TXEIE off again; usart_tx()
+     * turns it back on after queueing more bytes. */
+    if ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) {
+        if (!rb_is_empty(wb)) {
+            regs->DR = rb_remove(wb);
+        } else {
+            bb_peri_set_bit(&regs->CR1, USART_CR1_TXEIE_BIT, 0);
+        }
+    }
 }
 
 uint32 _usart_clock_freq(usart_dev *dev);
@@ -583,7 +583,9 @@ static inline uint16 usb_get_ep_tx_buf1_count(uint8 ep)
 
 static inline void usb_set_ep_tx_buf1_count(uint8 ep, uint16 count)
 {
-    usb_set_ep_rx_count(ep, count);
+    /* Unlike an RX count, this is a plain byte count. */
+    volatile uint32 *txc = usb_ep_tx_buf1_count_ptr(ep);
+    *txc = count;
 }
 static inline uint32* usb_get_ep_rx_buf0_addr_ptr(uint8 ep)
 {
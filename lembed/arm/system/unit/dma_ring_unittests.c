@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <string.h>
+#include "unittests.h"
+#include <libmaple/dma_ring.h>
+
+/* A stand-in for a DMA tube in circular mode: it writes into the
+ * ring's buffer and counts CNDTR down from size to 1, then reloads.
+ * Like the real thing, it raises half-transfer and transfer-complete
+ * events, on which we call dma_ring_update() as the ISR would. */
+typedef struct sim_dma {
+    dma_ring *dr;
+    uint8 *buf;
+    uint16 size;
+    volatile uint32 cndtr;
+    uint8 next;                 /* Next byte value to send */
+    int irqs;                   /* Deliver HT/TC events? */
+} sim_dma;
+
+static void sim_init(sim_dma *sim, dma_ring *dr, uint8 *buf, uint16 size)
+{
+    sim->dr = dr;
+    sim->buf = buf;
+    sim->size = size;
+    sim->cndtr = size;
+    sim->next = 0;
+    sim->irqs = 1;
+    dma_ring_init(dr, buf, size);
+}
+
+static void sim_transfer(sim_dma *sim, int n)
+{
+    while (n--) {
+        sim->buf[sim->size - sim->cndtr] = sim->next++;
+        if (--sim->cndtr == 0) {
+            sim->cndtr = sim->size;
+            if (sim->irqs) {
+                dma_ring_update(sim->dr, &sim->cndtr);
+            }
+        } else if (sim->cndtr == sim->size / 2 && sim->irqs) {
+            dma_ring_update(sim->dr, &sim->cndtr);
+        }
+    }
+}
+
+/* Read up to n bytes, checking they continue the sequence. Returns
+ * the number of bytes read, or -1 on a sequence error. */
+static int sim_read(sim_dma *sim, uint8 *expect, int n)
+{
+    int got = 0;
+    while (got < n && dma_ring_count(sim->dr, &sim->cndtr)) {
+        if (dma_ring_remove(sim->dr) != (*expect)++) {
+            return -1;
+        }
+        got++;
+    }
+    return got;
+}
+
+int main()
+{
+    int status = 0;
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+
+        COMMENT("Test positions against CNDTR");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        TEST(dma_ring_pos(&dr, 16) == 0);
+        TEST(dma_ring_pos(&dr, 1) == 15);
+        TEST(dma_ring_pos(&dr, 8) == 8);
+        TEST(dma_ring_pos(&dr, 0) == 0);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 0);
+        TEST(dma_ring_peek(&dr, &sim.cndtr) == -1);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 expect = 0;
+
+        COMMENT("Test counting without events in between");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim.irqs = 0;
+        sim_transfer(&sim, 5);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 5);
+        TEST(dma_ring_peek(&dr, &sim.cndtr) == 0);
+        TEST(sim_read(&sim, &expect, 3) == 3);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 2);
+        sim_transfer(&sim, 10);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 12);
+        TEST(sim_read(&sim, &expect, 100) == 12);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 0);
+        TEST(dr.overruns == 0);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 expect = 0;
+
+        COMMENT("Test wrapping around the end of the buffer");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim_transfer(&sim, 14);
+        TEST(sim_read(&sim, &expect, 14) == 14);
+        sim_transfer(&sim, 6);
+        TEST(dma_ring_pos(&dr, sim.cndtr) == 4);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 6);
+        TEST(sim_read(&sim, &expect, 100) == 6);
+        TEST(dr.tail == 20);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 expect = 0;
+
+        COMMENT("Test a full buffer");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim_transfer(&sim, 16);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 16);
+        TEST(sim_read(&sim, &expect, 100) == 16);
+        TEST(dr.overruns == 0);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 expect;
+        uint32 count;
+
+        COMMENT("Test overrun detection");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim_transfer(&sim, 40);
+        count = dma_ring_count(&dr, &sim.cndtr);
+        TEST(dr.overruns == 1);
+        TEST(count == 8);
+        expect = 32;
+        TEST(sim_read(&sim, &expect, 100) == 8);
+        TEST(expect == 40);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[64];
+        uint8 expect = 0;
+        uint32 total = 0;
+        int chunk = 1, ok = 1;
+
+        COMMENT("Test a long stream with uneven reads");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        /* The reader sometimes falls behind, but never by a whole buffer. */
+        while (total < 100000) {
+            int got;
+            sim_transfer(&sim, chunk);
+            got = sim_read(&sim, &expect, chunk + (chunk * 7) % 9 - 4);
+            if (got < 0) {
+                ok = 0;
+                break;
+            }
+            total += got;
+            chunk = chunk % 31 + 1;
+        }
+        total += sim_read(&sim, &expect, 1000);
+        TEST(ok);
+        TEST(dr.overruns == 0);
+        TEST(dr.tail == dr.head + ((dma_ring_pos(&dr, sim.cndtr) - dr.head) & dr.mask));
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 0);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 expect = 0;
+
+        COMMENT("Test discarding unread bytes");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim_transfer(&sim, 11);
+        dma_ring_reset(&dr, &sim.cndtr);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 0);
+        sim_transfer(&sim, 3);
+        expect = 11;
+        TEST(sim_read(&sim, &expect, 100) == 3);
+    }
+
+    {
+        dma_ring dr;
+        sim_dma sim;
+        uint8 buf[16];
+        uint8 *span;
+        uint8 expect;
+
+        COMMENT("Test holding bytes in place");
+        sim_init(&sim, &dr, buf, sizeof(buf));
+        sim_transfer(&sim, 6);
+        TEST(dma_ring_span(&dr, &sim.cndtr, &span) == 6);
+        TEST(span[0] == 0 && span[5] == 5);
+        sim_transfer(&sim, 10);
+        TEST(dma_ring_commit(&dr, &sim.cndtr, 4) == 1);
+        TEST(dma_ring_span(&dr, &sim.cndtr, &span) == 12);
+        TEST(span[0] == 4);
+        sim_transfer(&sim, 5);
+        TEST(dma_ring_commit(&dr, &sim.cndtr, 12) == 0);
+        TEST(dr.tail == 16);
+
+        COMMENT("Test an overrun skipping ahead while bytes are held");
+        TEST(dma_ring_span(&dr, &sim.cndtr, &span) == 5);
+        sim_transfer(&sim, 20);
+        TEST(dma_ring_count(&dr, &sim.cndtr) == 8);
+        TEST(dma_ring_commit(&dr, &sim.cndtr, 3) == 0);
+        expect = 33;
+        TEST(sim_read(&sim, &expect, 100) == 8);
+        TEST(expect == 41);
+    }
+
+    if (status != 0)
+        fprintf(stdout, "\n\nSome tests FAILED!\n");
+
+    return status;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unittests.h"
+#include <libmaple/exti.h>
+#include <libmaple/host_sim.h>
+
+/* Runs on the host simulation board (variants/host), which raises an
+ * EXTI line when software sets its SWIER bit, as the chip does. */
+
+static exti_num order[EXTI_QUEUE_SIZE];
+static int ran;
+
+static void on_edge(void *arg) {
+    if (ran < EXTI_QUEUE_SIZE) {
+        order[ran] = (exti_num)(uintptr_t)arg;
+    }
+    ran++;
+}
+
+/* Raise the lines in mask together, then let the IRQs run. */
+static void raise(uint32 mask) {
+    host_irq_disable();
+    EXTI_BASE->SWIER = mask;
+    host_irq_enable();
+}
+
+void setup() {
+    int status = 0;
+    exti_event event;
+    uint32 i;
+    int ok;
+
+    exti_attach_callback(EXTI0, EXTI_PA, on_edge, (void*)EXTI0, EXTI_RISING);
+    exti_attach_callback(EXTI5, EXTI_PA, on_edge, (void*)EXTI5, EXTI_RISING);
+    exti_attach_callback(EXTI9, EXTI_PA, on_edge, (void*)EXTI9, EXTI_RISING);
+    exti_attach_callback(EXTI7, EXTI_PA, NULL, NULL, EXTI_RISING);
+
+    COMMENT("Test an edge running its handler in the IRQ");
+    ran = 0;
+    raise(1U << EXTI0);
+    TEST(ran == 1 && order[0] == EXTI0);
+    TEST(EXTI_BASE->PR == 0);
+
+    COMMENT("Test shared lines running highest first");
+    ran = 0;
+    raise((1U << EXTI5) | (1U << EXTI9));
+    TEST(ran == 2 && order[0] == EXTI9 && order[1] == EXTI5);
+
+    COMMENT("Test a line without a handler having its pending bit cleared");
+    raise(1U << EXTI7);
+    TEST(EXTI_BASE->PR == 0);
+    TEST(exti_event_count(EXTI7) == 1);
+
+    COMMENT("Test queueing events in order");
+    exti_set_deferred(EXTI0, 1);
+    exti_set_deferred(EXTI5, 1);
+    ran = 0;
+    raise(1U << EXTI5);
+    raise(1U << EXTI0);
+    raise(1U << EXTI5);
+    TEST(ran == 0);
+    TEST(exti_get_event(&event) && event.num == EXTI5);
+    TEST(exti_run_deferred() == 2);
+    TEST(ran == 2 && order[0] == EXTI0 && order[1] == EXTI5);
+    TEST(!exti_get_event(&event));
+
+    COMMENT("Test a full queue losing new events");
+    exti_reset_counts(EXTI0);
+    for (i = 0; i < EXTI_QUEUE_SIZE + 3; i++) {
+        raise(1U << EXTI0);
+    }
+    TEST(exti_event_count(EXTI0) == EXTI_QUEUE_SIZE + 3);
+    TEST(exti_lost_count(EXTI0) == 3);
+    ok = 1;
+    for (i = 0; i < EXTI_QUEUE_SIZE; i++) {
+        ok &= exti_get_event(&event) && event.num == EXTI0;
+    }
+    TEST(ok);
+    TEST(!exti_get_event(&event));
+
+    COMMENT("Test the queue carrying on after wrapping around");
+    raise(1U << EXTI5);
+    ran = 0;
+    TEST(exti_run_deferred() == 1 && ran == 1 && order[0] == EXTI5);
+
+    fflush(stdout);
+    exit(status);
+}
+
+void loop() {
+}
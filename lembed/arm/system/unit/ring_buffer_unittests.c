@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "unittests.h"
+#include <libmaple/ring_buffer.h>
+
+/* Bytes moved between the threads in the concurrent test. */
+#define STREAM_LEN 2000000UL
+
+static ring_buffer shared_rb;
+static uint8 shared_buf[256];
+static volatile int consumer_ok;
+
+/* Sends 0, 1, 2, ... in chunks of varying size, yielding while the
+ * buffer is full (the host may have a single CPU). */
+static void *producer(void *arg)
+{
+    uint8 chunk[97];
+    uint32 sent = 0;
+    uint32 n = 1;
+    uint8 next = 0;
+    uint16 i;
+
+    (void)arg;
+    while (sent < STREAM_LEN) {
+        uint16 len = (uint16)(n % sizeof(chunk)) + 1;
+        uint16 done = 0;
+
+        if (len > STREAM_LEN - sent) {
+            len = (uint16)(STREAM_LEN - sent);
+        }
+        for (i = 0; i < len; i++) {
+            chunk[i] = next++;
+        }
+        while (done < len && consumer_ok) {
+            uint16 put;
+            if (n & 1) {
+                put = rb_write(&shared_rb, chunk + done, len - done);
+            } else {
+                put = rb_safe_insert(&shared_rb, chunk[done]);
+            }
+            if (!put) {
+                sched_yield();
+            }
+            done += put;
+        }
+        sent += len;
+        n = n * 1103515245 + 12345;
+    }
+    return NULL;
+}
+
+/* Checks that the bytes arrive in order, mixing bulk, span and
+ * single-byte reads. */
+static void *consumer(void *arg)
+{
+    uint8 chunk[61];
+    uint32 got = 0;
+    uint32 n = 7;
+    uint8 expect = 0;
+    uint16 len, i;
+    uint8 *span;
+
+    (void)arg;
+    while (got < STREAM_LEN) {
+        switch (n % 3) {
+        case 0:
+            len = rb_read(&shared_rb, chunk, (uint16)(n % sizeof(chunk)) + 1);
+            for (i = 0; i < len; i++) {
+                if (chunk[i] != expect++) {
+                    consumer_ok = 0;
+                }
+            }
+            break;
+        case 1:
+            len = rb_read_span(&shared_rb, &span);
+            for (i = 0; i < len; i++) {
+                if (span[i] != expect++) {
+                    consumer_ok = 0;
+                }
+            }
+            rb_read_commit(&shared_rb, len);
+            break;
+        default:
+            len = 0;
+            if (!rb_is_empty(&shared_rb)) {
+                if (rb_remove(&shared_rb) != expect++) {
+                    consumer_ok = 0;
+                }
+                len = 1;
+            }
+            break;
+        }
+        if (!consumer_ok) {
+            break;
+        }
+        if (!len) {
+            sched_yield();
+        }
+        got += len;
+        n = n * 1103515245 + 12345;
+    }
+    return NULL;
+}
+
+int main()
+{
+    int status = 0;
+
+    {
+        ring_buffer rb;
+        uint8 buf[8];
+        int i;
+
+        COMMENT("Test single-item operations");
+        rb_init(&rb, sizeof(buf), buf);
+        TEST(rb_capacity(&rb) == 8);
+        TEST(rb_is_empty(&rb));
+        TEST(rb_peek(&rb) == -1);
+        TEST(rb_safe_remove(&rb) == -1);
+        for (i = 0; i < 8; i++) {
+            TEST(rb_safe_insert(&rb, i));
+        }
+        TEST(rb_is_full(&rb));
+        TEST(rb_full_count(&rb) == 8);
+        TEST(rb_room(&rb) == 0);
+        TEST(!rb_safe_insert(&rb, 8));
+        TEST(rb_push_insert(&rb, 8) == 0);
+        TEST(rb_peek(&rb) == 1);
+        TEST(rb_remove(&rb) == 1);
+        TEST(rb_full_count(&rb) == 7);
+        rb_reset(&rb);
+        TEST(rb_is_empty(&rb));
+        TEST(rb_room(&rb) == 8);
+    }
+
+    {
+        ring_buffer rb;
+        uint8 buf[16];
+        uint8 in[40], out[40];
+        int i;
+
+        COMMENT("Test bulk reads and writes across the end of the buffer");
+        for (i = 0; i < 40; i++) {
+            in[i] = i;
+        }
+        rb_init(&rb, sizeof(buf), buf);
+        TEST(rb_write(&rb, in, 11) == 11);
+        TEST(rb_read(&rb, out, 11) == 11);
+        TEST(rb_write(&rb, in, 40) == 16);
+        TEST(rb_is_full(&rb));
+        TEST(rb_write(&rb, in, 1) == 0);
+        memset(out, 0, sizeof(out));
+        TEST(rb_read(&rb, out, 40) == 16);
+        TEST(memcmp(in, out, 16) == 0);
+        TEST(rb_read(&rb, out, 40) == 0);
+    }
+
+    {
+        ring_buffer rb;
+        uint8 buf[16];
+        uint8 *span;
+
+        COMMENT("Test contiguous spans");
+        rb_init(&rb, sizeof(buf), buf);
+        TEST(rb_write_span(&rb, &span) == 16 && span == buf);
+        TEST(rb_read_span(&rb, &span) == 0);
+        rb_write_commit(&rb, 12);
+        rb_read_commit(&rb, 12);
+        TEST(rb_write_span(&rb, &span) == 4 && span == buf + 12);
+        span[0] = 'a';
+        span[1] = 'b';
+        rb_write_commit(&rb, 2);
+        TEST(rb_read_span(&rb, &span) == 2 && span == buf + 12);
+        TEST(span[0] == 'a' && span[1] == 'b');
+        rb_write_commit(&rb, 2);
+        TEST(rb_write_span(&rb, &span) == 12 && span == buf);
+        TEST(rb_read_span(&rb, &span) == 4);
+    }
+
+    {
+        ring_buffer rb;
+        uint8 buf[4];
+        int i;
+
+        COMMENT("Test the counters wrapping around");
+        rb_init(&rb, sizeof(buf), buf);
+        rb.head = rb.tail = 0xFFFE;
+        for (i = 0; i < 4; i++) {
+            rb_insert(&rb, 10 + i);
+        }
+        TEST(rb.tail == 2);
+        TEST(rb_is_full(&rb));
+        TEST(rb_full_count(&rb) == 4);
+        TEST(rb_remove(&rb) == 10);
+        TEST(rb_remove(&rb) == 11);
+        TEST(rb_remove(&rb) == 12);
+        TEST(rb_remove(&rb) == 13);
+        TEST(rb_is_empty(&rb));
+    }
+
+    {
+        pthread_t prod, cons;
+
+        COMMENT("Test a producer and a consumer thread");
+        rb_init(&shared_rb, sizeof(shared_buf), shared_buf);
+        consumer_ok = 1;
+        pthread_create(&cons, NULL, consumer, NULL);
+        pthread_create(&prod, NULL, producer, NULL);
+        pthread_join(prod, NULL);
+        pthread_join(cons, NULL);
+        TEST(consumer_ok);
+        TEST(rb_is_empty(&shared_rb));
+    }
+
+    if (status != 0)
+        fprintf(stdout, "\n\nSome tests FAILED!\n");
+
+    return status;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unittests.h"
+#include <libmaple/systick.h>
+#include <libmaple/dwt.h>
+#include <libmaple/host_sim.h>
+
+/* Runs on the host simulation board (variants/host), where SysTick
+ * and the DWT cycle counter follow the host's clock. CYCCNT can be
+ * written there as on the chip, which lets a test jump to just short
+ * of a wrap instead of waiting a minute for one. */
+
+#define CYCLES_PER_MS   (F_CPU / 1000)
+
+/* Slack for the host running us late */
+#define LATE_MS         50
+
+static volatile uint32 callbacks;
+
+static void on_tick(void) {
+    callbacks++;
+}
+
+/* Move CYCCNT on to ms milliseconds short of wrapping, as if the
+ * time in between had passed. */
+static void near_wrap(uint32 ms) {
+    host_irq_disable();
+    DWT_BASE->CYCCNT = 0U - ms * CYCLES_PER_MS;
+    host_irq_enable();
+}
+
+/* Read the clocks for ms milliseconds; returns nonzero if neither
+ * ever went backwards. */
+static int monotonic(uint32 ms) {
+    uint64 end = host_sim_cycles() + (uint64)ms * CYCLES_PER_MS;
+    uint64 us = micros64(), ns = nanos();
+    int ok = 1;
+
+    while (host_sim_cycles() < end) {
+        uint64 us2 = micros64(), ns2 = nanos();
+        ok &= us2 >= us && ns2 >= ns;
+        us = us2;
+        ns = ns2;
+    }
+    return ok;
+}
+
+static uint64 anchor_cycles(void) {
+    return systick_timebase_anchor[systick_timebase_gen & 1].cycles;
+}
+
+void setup() {
+    int status = 0;
+    uint64 c0, c1, u0, u1, n;
+    uint32 m0, m1;
+
+    systick_attach_callback(on_tick);
+
+    COMMENT("Test micros64(), nanos() and millis() agreeing");
+    u0 = micros64();
+    n = nanos();
+    u1 = micros64();
+    TEST(u0 * 1000 <= n && n < (u1 + 1) * 1000);
+    m0 = millis();
+    TEST(micros64() / 1000 - m0 <= LATE_MS);
+
+    COMMENT("Test the cycle count carrying across a CYCCNT wrap");
+    near_wrap(2);
+    c0 = systick_cycles();
+    u0 = micros64();
+    TEST(monotonic(6));
+    c1 = systick_cycles();
+    u1 = micros64();
+    TEST((c1 >> 32) == (c0 >> 32) + 1);
+    TEST(u1 - u0 >= 6000 && u1 - u0 < (6 + LATE_MS) * 1000);
+    delay(2);
+    TEST((anchor_cycles() >> 32) == (c1 >> 32));
+
+    COMMENT("Test tickless millis() carrying on from the tick");
+    m0 = millis();
+    systick_set_tickless(1);
+    m1 = millis();
+    TEST(m1 - m0 <= 1);
+    callbacks = 0;
+    delay(10);
+    TEST(millis() - m1 >= 10 && millis() - m1 < 10 + LATE_MS);
+    TEST(callbacks == 0);
+
+    COMMENT("Test a tickless deadline");
+    systick_schedule(systick_cycles() + 5 * CYCLES_PER_MS);
+    delay(10);
+    TEST(callbacks == 1);
+
+    COMMENT("Test tickless millis() across a CYCCNT wrap");
+    near_wrap(2);
+    c0 = systick_cycles();
+    m0 = millis();
+    TEST(monotonic(6));
+    c1 = systick_cycles();
+    m1 = millis();
+    TEST((c1 >> 32) == (c0 >> 32) + 1);
+    TEST(m1 - m0 >= 6 && m1 - m0 < 6 + LATE_MS);
+
+    COMMENT("Test the tick coming back");
+    m0 = millis();
+    systick_set_tickless(0);
+    TEST(millis() - m0 <= 1);
+    callbacks = 0;
+    delay(10);
+    TEST(systick_uptime_millis - m0 >= 10);
+    TEST(callbacks >= 5);
+
+    fflush(stdout);
+    exit(status);
+}
+
+void loop() {
+}
@@ -0,0 +1,2 @@
+// API compatibility
+#include "variant.h"
\ No newline at end of file